@@ -105,6 +105,18 @@ TEST_CASE("Invalid Parser","Constructor"){
         REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), "-t requires an argument");
     }
 
+    {
+        CommandLineParser cmdP(factoryMock.get());
+        ArgumentHolder ah{"prog", "-m", "TEST1", "-f", "inputfile.graph", "-o", "outputfile.graph", "-j", "0"};
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), "-j must be a whole number >0, got 0");
+    }
+
+    {
+        CommandLineParser cmdP(factoryMock.get());
+        ArgumentHolder ah{"prog", "-m", "TEST1", "-f", "inputfile.graph", "-o", "outputfile.graph", "-ck", "-5"};
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), "-ck must be a number of seconds, got -5");
+    }
+
 
     {
         CommandLineParser cmdP(factoryMock.get());
@@ -179,9 +191,40 @@ TEST_CASE("Valid Parser","CheckValues"){
         REQUIRE(cmdP.isValid());
         REQUIRE(cmdP.simpleMode());
         REQUIRE(cmdP.getTimingFile() == "timings.csv");
+        REQUIRE(cmdP.getThreadCount() == 0);
         REQUIRE(parsers[0]->getHelp() == TestParser::formatTestHelpString(false, true));
         REQUIRE(parsers[1]->getHelp() == TestParser::formatTestHelpString(false, false));
     }
+    SECTION("Parser test1 used, thread count")
+    {
+        CommandLineParser cmdP(factoryMock.get());
+        ArgumentHolder ah{"prog", "-m", "TEST1", "-f", "inputfile.graph", "-o", "outputfile.graph", "-j", "3"};
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.isValid());
+        REQUIRE(cmdP.getThreadCount() == 3);
+        REQUIRE(cmdP.getCheckpointFile().empty());
+        REQUIRE_FALSE(cmdP.resume());
+    }
+    SECTION("Parser test1 used, checkpoint")
+    {
+        CommandLineParser cmdP(factoryMock.get());
+        ArgumentHolder ah{"prog", "-m", "TEST1", "-f", "inputfile.graph", "-o", "outputfile.graph", "-ck", "1.5"};
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.isValid());
+        REQUIRE(cmdP.getCheckpointFile() == "outputfile.graph.checkpoint");
+        REQUIRE(cmdP.getCheckpointInterval() == Approx(1.5));
+        REQUIRE_FALSE(cmdP.resume());
+    }
+    SECTION("Parser test1 used, resume")
+    {
+        CommandLineParser cmdP(factoryMock.get());
+        ArgumentHolder ah{"prog", "-m", "TEST1", "-f", "inputfile.graph", "-o", "outputfile.graph", "--resume"};
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.isValid());
+        REQUIRE(cmdP.getCheckpointFile() == "outputfile.graph.checkpoint");
+        REQUIRE(cmdP.getCheckpointInterval() == Approx(600.0));
+        REQUIRE(cmdP.resume());
+    }
 
 }
 
@@ -53,4 +53,18 @@ TEST_CASE("ExportParser Success", "Read successfully")
         parser.parse(ah.argc(), ah.argv());
         REQUIRE(parser.getExportMode() == ExportParser::POINTMAP_LINKS_CSV);
     }
+
+    SECTION("Correctly parse mode pointmap-data-columnar")
+    {
+        ArgumentHolder ah{"prog", "-em", "pointmap-data-columnar"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getExportMode() == ExportParser::POINTMAP_DATA_COLUMNAR);
+    }
+
+    SECTION("Correctly parse mode shapegraph-map-columnar")
+    {
+        ArgumentHolder ah{"prog", "-em", "shapegraph-map-columnar"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getExportMode() == ExportParser::SHAPEGRAPH_MAP_COLUMNAR);
+    }
 }
@@ -0,0 +1,130 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include "depthmapXcli/generateparser.h"
+#include "depthmapXcli/modeparserregistry.h"
+#include "depthmapXcli/performancewriter.h"
+#include "salalib/mgraph.h"
+#include "argumentholder.h"
+#include "selfcleaningfile.h"
+
+TEST_CASE("GenerateParserFail", "Error cases")
+{
+    SECTION("Missing argument to gt")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("-gt requires an argument"));
+    }
+
+    SECTION("rubbish input to -gt")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "foo", "-gs", "4"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("Invalid plan type (-gt): foo"));
+    }
+
+    SECTION("Plan type (-gt) provided twice")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "floorplate", "-gt", "voronoi", "-gs", "4"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("-gt can only be used once"));
+    }
+
+    SECTION("Zero size")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "floorplate", "-gs", "0"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("-gs must be a whole number >0, got 0"));
+    }
+
+    SECTION("Complexity out of range")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "floorplate", "-gs", "4", "-gc", "1.5"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("-gc must be a number from 0 to 1, got 1.5"));
+    }
+
+    SECTION("rubbish input to -gm")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "floorplate", "-gs", "4", "-gm", "data"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("Invalid output map (-gm) type: data"));
+    }
+
+    SECTION("Don't provide plan type")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gs", "4"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("A plan type (-gt) is required"));
+    }
+
+    SECTION("Don't provide plan size")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "voronoi"};
+        REQUIRE_THROWS_WITH(parser.parse(int(ah.argc()), ah.argv()), Catch::Contains("A plan size (-gs) is required"));
+    }
+}
+
+TEST_CASE("GenerateParserSuccess", "Read successfully")
+{
+    SECTION("Defaults")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gt", "cityblocks", "-gs", "10"};
+        parser.parse(int(ah.argc()), ah.argv());
+        REQUIRE(parser.getParameters().type == depthmapX::SyntheticPlanType::CITY_BLOCKS);
+        REQUIRE(parser.getParameters().size == 10);
+        REQUIRE(parser.getParameters().seed == 0);
+        REQUIRE(parser.getParameters().complexity == Approx(0.5));
+        REQUIRE(parser.getParameters().density == Approx(0.5));
+        REQUIRE(parser.getOutputMapType() == ShapeMap::DRAWINGMAP);
+        REQUIRE(parser.getMapName() == "cityblocks");
+    }
+
+    SECTION("Everything given")
+    {
+        GenerateParser parser;
+        ArgumentHolder ah{"prog", "-gn", "streets", "-gt", "voronoi", "-gs", "1000", "-gr", "42", "-gc", "0.25",
+                          "-gd", "0.75", "-gm", "segment"};
+        parser.parse(int(ah.argc()), ah.argv());
+        REQUIRE(parser.getParameters().type == depthmapX::SyntheticPlanType::VORONOI_STREETS);
+        REQUIRE(parser.getParameters().size == 1000);
+        REQUIRE(parser.getParameters().seed == 42);
+        REQUIRE(parser.getParameters().complexity == Approx(0.25));
+        REQUIRE(parser.getParameters().density == Approx(0.75));
+        REQUIRE(parser.getOutputMapType() == ShapeMap::SEGMENTMAP);
+        REQUIRE(parser.getMapName() == "streets");
+    }
+}
+
+TEST_CASE("Generate a plan into a new graph", "")
+{
+    SelfCleaningFile output("generated.graph");
+    PerformanceWriter perfWriter("");
+    ModeParserRegistry registry;
+    CommandLineParser cmdP(registry);
+    ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", output.Filename(), "-m", "GENERATE",
+                      "-gt", "streetgrid", "-gs", "3", "-gc", "0", "-gm", "axial"};
+    cmdP.parse(int(ah.argc()), ah.argv());
+    cmdP.run(perfWriter);
+
+    MetaGraph graph;
+    REQUIRE(graph.readFromFile(output.Filename()) == MetaGraph::OK);
+    REQUIRE(graph.getLineFileCount() == 1);
+    REQUIRE(graph.getDisplayedShapeGraph().getShapeCount() == 8);
+}
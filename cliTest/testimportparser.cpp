@@ -34,4 +34,12 @@ TEST_CASE("Import args valid", "valid")
         REQUIRE(cmdP.getFilesToImport()[0] == "importfile1");
         REQUIRE(cmdP.getFilesToImport()[1] == "importfile2");
     }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile.dxf", "-o", "outfile", "-m", "IMPORT", "-iil", "walls", "-iil", "doors"};
+        ImportParser cmdP;
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.getLayersToImport().size() == 2);
+        REQUIRE(cmdP.getLayersToImport()[0] == "walls");
+        REQUIRE(cmdP.getLayersToImport()[1] == "doors");
+    }
 }
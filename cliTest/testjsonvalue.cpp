@@ -0,0 +1,60 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../depthmapXcli/jsonvalue.h"
+#include "genlib/exceptions.h"
+
+#include <cmath>
+
+TEST_CASE("JSON values are read", "")
+{
+    JsonValue value = JsonValue::parse(" {\"op\": \"value\", \"id\": 12, \"at\": [[1.5, -2e1], [3, 4]],"
+                                       " \"polygon\": false, \"name\": \"a \\\"b\\\"\\n\\u00e9\", \"x\": null} ");
+    REQUIRE(value.getType() == JsonValue::Type::OBJECT);
+    REQUIRE(value.get("op").asString() == "value");
+    REQUIRE(value.get("id").asNumber() == 12);
+    REQUIRE(value.get("at").asArray().size() == 2);
+    REQUIRE(value.get("at").asArray()[0].asArray()[1].asNumber() == -20.0);
+    REQUIRE_FALSE(value.get("polygon").asBool());
+    REQUIRE(value.get("name").asString() == "a \"b\"\n\xc3\xa9");
+    REQUIRE(value.get("x").isNull());
+    REQUIRE(value.has("x"));
+    REQUIRE_FALSE(value.has("y"));
+
+    REQUIRE_THROWS_WITH(value.get("y"), Catch::Contains("Missing \"y\""));
+    REQUIRE_THROWS_WITH(value.get("op").asNumber(), Catch::Contains("Expected a number, not a string"));
+}
+
+TEST_CASE("JSON values are written back out", "")
+{
+    std::string text = "{\"id\":\"a\\tb\",\"at\":[1.5,-20,true,null],\"empty\":{}}";
+    REQUIRE(JsonValue::parse(text).toString() == text);
+    REQUIRE(JsonValue::number(0.1) == "0.1");
+    REQUIRE(JsonValue::number(std::nan("")) == "null");
+    REQUIRE(JsonValue::quote(std::string("\x01", 1)) == "\"\\u0001\"");
+}
+
+TEST_CASE("Text that is not JSON", "")
+{
+    REQUIRE_THROWS_AS(JsonValue::parse(""), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("{\"op\":}"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("{\"op\":\"ping\""), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("[1,2] 3"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("{op:1}"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("-"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(JsonValue::parse("\"\\x\""), depthmapX::RuntimeException);
+    REQUIRE_THROWS_WITH(JsonValue::parse("[1,,2]"), Catch::Contains("at character 4"));
+}
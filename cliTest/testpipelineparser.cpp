@@ -0,0 +1,161 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../depthmapXcli/pipelineparser.h"
+#include "../depthmapXcli/modeparserregistry.h"
+#include "../depthmapXcli/performancewriter.h"
+#include "argumentholder.h"
+#include "selfcleaningfile.h"
+#include <fstream>
+
+TEST_CASE("Pipeline args valid", "valid")
+{
+    SelfCleaningFile script("pipeline.txt");
+    {
+        std::ofstream stream(script.Filename());
+        stream << "# make the graph\n"
+               << "-m VISPREP -pg 0.5 -pp 1.0,1.0\n"
+               << "\n"
+               << "  -m VGA  -vm metric -vr n\n"
+               << "checkpoint \"after metric.graph\"\n"
+               << "checkpoint\n";
+    }
+    ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+    PipelineParser cmdP;
+    cmdP.parse(ah.argc(), ah.argv());
+    REQUIRE(cmdP.getScriptFile() == script.Filename());
+    REQUIRE(cmdP.getSteps().size() == 4);
+    REQUIRE(cmdP.getSteps()[0] == (std::vector<std::string>{"-m", "VISPREP", "-pg", "0.5", "-pp", "1.0,1.0"}));
+    REQUIRE(cmdP.getSteps()[1] == (std::vector<std::string>{"-m", "VGA", "-vm", "metric", "-vr", "n"}));
+    REQUIRE(cmdP.getSteps()[2] == (std::vector<std::string>{"checkpoint", "after metric.graph"}));
+    REQUIRE(cmdP.getSteps()[3] == (std::vector<std::string>{"checkpoint"}));
+}
+
+TEST_CASE("Pipeline args invalid", "")
+{
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE"};
+        PipelineParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("-ps for the pipeline script is required"));
+    }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE", "-ps"};
+        PipelineParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("-ps requires an argument"));
+    }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE", "-ps", "nonexistent.txt"};
+        PipelineParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("Failed to open pipeline script"));
+    }
+    {
+        SelfCleaningFile script("pipeline.txt");
+        {
+            std::ofstream stream(script.Filename());
+            stream << "# nothing to do\n\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+        PipelineParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("has no steps"));
+    }
+    {
+        SelfCleaningFile script("pipeline.txt");
+        {
+            std::ofstream stream(script.Filename());
+            stream << "checkpoint one.graph two.graph\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+        PipelineParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("at most one file name"));
+    }
+    REQUIRE_THROWS_WITH(PipelineParser::splitArguments("-m EXPORT -o \"out.csv"),
+                        Catch::Contains("Unterminated quotes"));
+}
+
+TEST_CASE("Pipeline steps are checked before running", "")
+{
+    // the input file does not exist, so reaching the point of loading it would fail differently
+    SelfCleaningFile script("pipeline.txt");
+    PerformanceWriter perfWriter("");
+    {
+        {
+            std::ofstream stream(script.Filename());
+            stream << "-m VGA -vm metric -vr n\n"
+                   << "-m VGA -vm nonsense\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+        ModeParserRegistry registry;
+        CommandLineParser cmdP(registry);
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE_THROWS_WITH(cmdP.run(perfWriter), Catch::Contains("Step 2: Invalid VGA mode: nonsense"));
+    }
+    {
+        {
+            std::ofstream stream(script.Filename());
+            stream << "-m PIPELINE -ps " << script.Filename() << "\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+        ModeParserRegistry registry;
+        CommandLineParser cmdP(registry);
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE_THROWS_WITH(cmdP.run(perfWriter), Catch::Contains("a pipeline can not run another pipeline"));
+    }
+    {
+        {
+            std::ofstream stream(script.Filename());
+            stream << "-m SERVER\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", "outfile", "-m", "PIPELINE", "-ps", script.Filename()};
+        ModeParserRegistry registry;
+        CommandLineParser cmdP(registry);
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE_THROWS_WITH(cmdP.run(perfWriter), Catch::Contains("Step 1: a pipeline can not run a server"));
+    }
+}
+
+TEST_CASE("Pipelines only start without a graph when they make one", "")
+{
+    SelfCleaningFile script("pipeline.txt");
+    SelfCleaningFile output("pipelineout.graph");
+    SelfCleaningFile checkpoint("pipelineout.graph.checkpoint");
+    PerformanceWriter perfWriter("");
+    {
+        {
+            std::ofstream stream(script.Filename());
+            stream << "-m AXIAL -xa n\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", output.Filename(), "-m", "PIPELINE", "-ps", script.Filename()};
+        ModeParserRegistry registry;
+        CommandLineParser cmdP(registry);
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE_THROWS_WITH(cmdP.run(perfWriter), Catch::Contains("Failed to load graph from file nonexistent.graph"));
+    }
+    {
+        // the checkpoint the tulip analysis leaves is removed once the result is written
+        {
+            std::ofstream stream(script.Filename());
+            stream << "-m GENERATE -gt streetgrid -gs 4 -gm segment\n"
+                   << "-m SEGMENT -st tulip -sr n -srt steps -stb 1024 -ck 0\n";
+        }
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", output.Filename(), "-m", "PIPELINE", "-ps", script.Filename()};
+        ModeParserRegistry registry;
+        CommandLineParser cmdP(registry);
+        cmdP.parse(ah.argc(), ah.argv());
+        cmdP.run(perfWriter);
+        REQUIRE(std::ifstream(output.Filename()).good());
+        REQUIRE_FALSE(std::ifstream(checkpoint.Filename()).good());
+    }
+}
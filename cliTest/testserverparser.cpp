@@ -0,0 +1,275 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../depthmapXcli/analysisserver.h"
+#include "../depthmapXcli/serverparser.h"
+#include "argumentholder.h"
+#include "selfcleaningfile.h"
+#include "modules/segmentshortestpaths/core/segmcontractionhierarchy.h"
+#include "salalib/mgraph.h"
+#include "salalib/syntheticplans.h"
+
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    std::unique_ptr<MetaGraph> makeVgaGraph(Point2f &openPoint)
+    {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::SyntheticPlan plan = depthmapX::generateFloorplate(2, 0, 0.0);
+        depthmapX::addSyntheticDrawing(*graph, plan, "Floorplate");
+        graph->addNewPointMap("Floorplate VGA");
+        PointMap &map = graph->getPointMaps().back();
+        map.setGrid(1.0);
+        map.makePoints(plan.openPoint, 0);
+        map.sparkGraph2(nullptr, false, -1);
+        openPoint = map.depixelate(map.pixelate(plan.openPoint));
+        return graph;
+    }
+
+    std::unique_ptr<MetaGraph> makeSegmentGraph()
+    {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::addSyntheticDrawing(*graph, depthmapX::generateVoronoiStreets(30, 5, 0.5), "Streets");
+        graph->convertDrawingToSegment(nullptr, "Streets segment");
+        return graph;
+    }
+
+    std::string pointJson(const Point2f &point)
+    {
+        return "[" + JsonValue::number(point.x) + "," + JsonValue::number(point.y) + "]";
+    }
+}
+
+TEST_CASE("Server args", "")
+{
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "SERVER"};
+        ServerParser cmdP;
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.getGraphFiles().empty());
+        REQUIRE(cmdP.getSocketPath().empty());
+    }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "SERVER", "-sg", "other.graph", "-sg",
+                          "third.graph", "-ss", "/tmp/depthmapX.sock"};
+        ServerParser cmdP;
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.getGraphFiles() == std::vector<std::string>({"other.graph", "third.graph"}));
+        REQUIRE(cmdP.getSocketPath() == "/tmp/depthmapX.sock");
+    }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "SERVER", "-ss", "a.sock", "-ss", "b.sock"};
+        ServerParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("-ss can only be used once"));
+    }
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "SERVER", "-sg"};
+        ServerParser cmdP;
+        REQUIRE_THROWS_WITH(cmdP.parse(ah.argc(), ah.argv()), Catch::Contains("-sg requires an argument"));
+    }
+    REQUIRE(AnalysisServer::graphName("some/folder/gallery.graph") == "gallery");
+    REQUIRE(AnalysisServer::graphName("gallery") == "gallery");
+}
+
+TEST_CASE("Server requests", "")
+{
+    Point2f openPoint;
+    AnalysisServer server(2);
+    server.addGraph("floorplate", makeVgaGraph(openPoint));
+    server.addGraph("streets", makeSegmentGraph());
+
+    REQUIRE(server.handle("{\"id\":\"a\",\"op\":\"ping\"}") == "{\"id\":\"a\",\"ok\":true}");
+    REQUIRE(server.handle("{\"op\":\"ping\"") == "{\"id\":null,\"error\":\"Invalid JSON at character 13: expected '}'\"}");
+    REQUIRE(server.handle("{\"id\":1,\"op\":\"fly\"}") == "{\"id\":1,\"error\":\"Unknown op fly\"}");
+    REQUIRE(server.handle("{\"id\":2,\"op\":\"value\",\"graph\":\"nowhere\",\"at\":[]}") ==
+            "{\"id\":2,\"error\":\"No graph named nowhere\"}");
+
+    JsonValue graphs = JsonValue::parse(server.handle("{\"id\":3,\"op\":\"graphs\"}")).get("graphs");
+    REQUIRE(graphs.asArray().size() == 2);
+    REQUIRE(graphs.asArray()[0].get("name").asString() == "floorplate");
+    REQUIRE(graphs.asArray()[0].get("maps").asArray()[0].get("type").asString() == "point");
+    REQUIRE(graphs.asArray()[1].get("maps").asArray()[0].get("type").asString() == "segment");
+
+    // the first graph added is the one asked about if none is named
+    std::string at = "[" + pointJson(openPoint) + ",[-1000,-1000]]";
+    JsonValue refs = JsonValue::parse(server.handle("{\"id\":4,\"op\":\"value\",\"at\":" + at + "}")).get("values");
+    REQUIRE(refs.asArray()[0].asNumber() > 0);
+    REQUIRE(refs.asArray()[1].isNull());
+    REQUIRE(JsonValue::parse(server.handle("{\"id\":5,\"op\":\"value\",\"column\":\"Nothing\",\"at\":[]}"))
+                .get("error")
+                .asString() == "No column named Nothing");
+
+    JsonValue depth = JsonValue::parse(server.handle("{\"id\":6,\"op\":\"stepdepth\",\"type\":\"visual\",\"from\":[" +
+                                                     pointJson(openPoint) + "],\"at\":" + at + "}"));
+    REQUIRE(depth.get("column").asString() == "Visual Step Depth");
+    REQUIRE(depth.get("max").asNumber() > 0);
+    REQUIRE(depth.get("values").asArray()[0].asNumber() == 0);
+    REQUIRE(depth.get("values").asArray()[1].isNull());
+    JsonValue values = JsonValue::parse(server.handle("{\"id\":7,\"op\":\"value\",\"map\":\"Floorplate VGA\","
+                                                      "\"column\":\"Visual Step Depth\",\"at\":" + at + "}"));
+    REQUIRE(values.get("values").asArray()[0].asNumber() == 0);
+    REQUIRE(JsonValue::parse(server.handle("{\"id\":8,\"op\":\"stepdepth\",\"type\":\"topological\",\"from\":[" +
+                                           pointJson(openPoint) + "]}"))
+                .get("error")
+                .asString() == "No topological step depth for point maps");
+
+    JsonValue isovist = JsonValue::parse(server.handle("{\"id\":9,\"op\":\"isovist\",\"at\":" + pointJson(openPoint) + "}"));
+    REQUIRE(isovist.get("measures").get("Isovist Area").asNumber() > 0);
+    REQUIRE(isovist.get("polygon").asArray().size() > 2);
+    JsonValue partial = JsonValue::parse(server.handle("{\"id\":10,\"op\":\"isovist\",\"at\":" + pointJson(openPoint) +
+                                                       ",\"angle\":90,\"fov\":60,\"polygon\":false}"));
+    REQUIRE(partial.get("measures").get("Isovist Area").asNumber() <
+            isovist.get("measures").get("Isovist Area").asNumber());
+    REQUIRE_FALSE(partial.has("polygon"));
+
+    // the same path as the hierarchy gives on a map of its own, whether the server has to make the
+    // hierarchy for the request or has it already
+    auto streets = makeSegmentGraph();
+    const ShapeGraph &segmentMap = streets->getDisplayedShapeGraph();
+    SegmentContractionHierarchy hierarchy(SegmentContractionHierarchy::CostType::METRIC);
+    REQUIRE(hierarchy.build(segmentMap));
+    int destination = 1;
+    while (hierarchy.findPath(0, destination).segments.size() < 3)
+    {
+        destination++;
+    }
+    SegmentContractionHierarchy::Path expected = hierarchy.findPath(0, destination);
+    int from = segmentMap.getShapeRefFromIndex(0)->first;
+    int to = segmentMap.getShapeRefFromIndex(size_t(destination))->first;
+    for (int i = 0; i < 2; i++)
+    {
+        JsonValue path = JsonValue::parse(server.handle("{\"id\":11,\"op\":\"path\",\"graph\":\"streets\",\"from\":" +
+                                                        std::to_string(from) + ",\"to\":" + std::to_string(to) + "}"));
+        REQUIRE(path.get("found").asBool());
+        const std::vector<JsonValue> &segments = path.get("segments").asArray();
+        const std::vector<JsonValue> &costs = path.get("costs").asArray();
+        REQUIRE(segments.size() == expected.segments.size());
+        for (size_t j = 0; j < segments.size(); j++)
+        {
+            REQUIRE(segments[j].asNumber() == segmentMap.getShapeRefFromIndex(size_t(expected.segments[j]))->first);
+            REQUIRE(costs[j].asNumber() == Approx(expected.costs[j]));
+        }
+    }
+    REQUIRE(JsonValue::parse(server.handle("{\"id\":12,\"op\":\"path\",\"graph\":\"streets\",\"from\":-5,\"to\":1}"))
+                .get("error")
+                .asString() == "No segment at -5");
+    REQUIRE(JsonValue::parse(server.handle("{\"id\":12,\"op\":\"path\",\"from\":0,\"to\":1}")).get("error").asString() ==
+            "Paths can only be found on segment maps");
+}
+
+TEST_CASE("Server answers what it reads until shut down", "")
+{
+    Point2f openPoint;
+    AnalysisServer server(4);
+    server.addGraph("floorplate", makeVgaGraph(openPoint));
+
+    std::stringstream input;
+    for (int i = 0; i < 20; i++)
+    {
+        input << "{\"id\":" << i << ",\"op\":\"value\",\"at\":[" << pointJson(openPoint) << "]}\n";
+    }
+    input << "\n"
+          << "not json\n"
+          << "{\"id\":\"stop\",\"op\":\"shutdown\"}\n"
+          << "{\"id\":\"late\",\"op\":\"ping\"}\n";
+    std::stringstream output;
+    server.serve(input, output);
+    REQUIRE(server.isShutDown());
+
+    std::set<std::string> ids;
+    std::string line;
+    while (std::getline(output, line))
+    {
+        JsonValue response = JsonValue::parse(line);
+        INFO(line);
+        REQUIRE(ids.insert(response.get("id").toString()).second);
+        if (response.get("id").getType() == JsonValue::Type::NUMBER)
+        {
+            REQUIRE(response.get("values").asArray()[0].asNumber() > 0);
+        }
+    }
+    // every request up to the shutdown is answered, the bad line with no id to give
+    REQUIRE(ids.size() == 22);
+    REQUIRE(ids.count("null") == 1);
+    REQUIRE(ids.count("\"stop\"") == 1);
+    REQUIRE(ids.count("\"late\"") == 0);
+}
+
+TEST_CASE("Server reads a graph from a file from several threads at once", "")
+{
+    Point2f openPoint;
+    std::unique_ptr<MetaGraph> original = makeVgaGraph(openPoint);
+    // only the point maps the graph says it has are written
+    original->setState(original->getState() | MetaGraph::POINTMAPS);
+    SelfCleaningFile graphFile("servertest.graph");
+    REQUIRE(original->write(graphFile.Filename(), METAGRAPH_VERSION, false) == MetaGraph::OK);
+
+    // every point of the map, and its connectivity in the graph as it was made
+    const PointMap &originalMap = original->getDisplayedPointMap();
+    const AttributeTable &originalTable = originalMap.getAttributeTable();
+    size_t originalColumn = originalTable.getColumnIndex("Connectivity");
+    std::string at;
+    std::vector<float> expected;
+    for (auto iter = originalTable.begin(); iter != originalTable.end(); iter++)
+    {
+        at += (at.empty() ? "[" : ",") + pointJson(originalMap.depixelate(PixelRef(iter->getKey().value)));
+        expected.push_back(iter->getRow().getValue(originalColumn));
+    }
+    at += "]";
+
+    // the whole number columns of a graph read from a file are compact, and reading them from several
+    // threads at once leaves them so
+    std::unique_ptr<MetaGraph> graph = AnalysisServer::readGraph(graphFile.Filename());
+    const AttributeTable &table = graph->getDisplayedPointMap().getAttributeTable();
+    size_t column = table.getColumnIndex("Connectivity");
+    REQUIRE(table.getColumnStorage(column) != AttributeColumnEncoding::FLOAT32);
+    AnalysisServer server(4);
+    server.addGraph("floorplate", std::move(graph));
+
+    std::vector<std::vector<std::string>> responses(8);
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < responses.size(); i++)
+    {
+        clients.emplace_back([&server, &responses, &at, i]() {
+            for (int j = 0; j < 20; j++)
+            {
+                responses[i].push_back(server.handle("{\"id\":" + std::to_string(i) +
+                                                     ",\"op\":\"value\",\"column\":\"Connectivity\",\"at\":" + at + "}"));
+            }
+        });
+    }
+    for (auto &client : clients)
+    {
+        client.join();
+    }
+
+    for (auto &clientResponses : responses)
+    {
+        for (auto &response : clientResponses)
+        {
+            JsonValue values = JsonValue::parse(response).get("values");
+            REQUIRE(values.asArray().size() == expected.size());
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                REQUIRE(values.asArray()[i].asNumber() == expected[i]);
+            }
+        }
+    }
+    REQUIRE(table.getColumnStorage(column) != AttributeColumnEncoding::FLOAT32);
+}
@@ -15,6 +15,9 @@
 
 #include <catch.hpp>
 #include "depthmapXcli/visprepparser.h"
+#include "depthmapXcli/modeparserregistry.h"
+#include "depthmapXcli/performancewriter.h"
+#include "genlib/exceptions.h"
 #include "argumentholder.h"
 #include "selfcleaningfile.h"
 
@@ -214,3 +217,61 @@ TEST_CASE("VisprepParserUnmakeSuccess", "Read successfully - Unmake")
     REQUIRE(parser.getUnmakeGraph());
     REQUIRE(parser.getRemoveLinksWhenUnmaking());
 }
+
+TEST_CASE("VisprepParserMemoryBudget", "Memory budget")
+{
+    SECTION("Valid budget")
+    {
+        VisPrepParser parser;
+        ArgumentHolder ah{"prog", "-pg", "0.5", "-pp", "1,2", "-pm", "--memory-budget", "1.5G"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getMakeGraph());
+        REQUIRE(parser.getMemoryBudget() == size_t(1.5 * 1024 * 1024 * 1024));
+    }
+
+    SECTION("No budget")
+    {
+        VisPrepParser parser;
+        ArgumentHolder ah{"prog", "-pg", "0.5", "-pp", "1,2", "-pm"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getMemoryBudget() == 0);
+    }
+
+    SECTION("Rubbish memory budget")
+    {
+        VisPrepParser parser;
+        ArgumentHolder ah{"prog", "-pm", "--memory-budget", "4X"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("--memory-budget must be a size such as 512M or 4G, got 4X"));
+    }
+
+    SECTION("Memory budget without making the graph")
+    {
+        VisPrepParser parser;
+        ArgumentHolder ah{"prog", "-pg", "1", "-pp", "1,1", "--memory-budget", "4G"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("--memory-budget can only be used together with -pm"));
+    }
+}
+
+TEST_CASE("VisprepOverMemoryBudget", "Making a graph that does not fit in the memory budget")
+{
+    SelfCleaningFile input("visprepbudget.graph");
+    SelfCleaningFile output("visprepbudgetout.graph");
+    PerformanceWriter perfWriter("");
+    ModeParserRegistry registry;
+    {
+        // a single 100 by 100 block to fill
+        CommandLineParser cmdP(registry);
+        ArgumentHolder ah{"prog", "-f", "nonexistent.graph", "-o", input.Filename(), "-m", "GENERATE",
+                          "-gt", "streetgrid", "-gs", "1", "-gc", "0"};
+        cmdP.parse(ah.argc(), ah.argv());
+        cmdP.run(perfWriter);
+    }
+
+    CommandLineParser cmdP(registry);
+    ArgumentHolder ah{"prog", "-f", input.Filename(), "-o", output.Filename(), "-m", "VISPREP",
+                      "-pg", "2", "-pp", "50,50", "-pm", "--memory-budget", "1K"};
+    cmdP.parse(ah.argc(), ah.argv());
+    REQUIRE_THROWS_WITH(cmdP.run(perfWriter), Catch::Contains("more than the memory budget of"));
+    std::ifstream written(output.Filename());
+    REQUIRE_FALSE(written.good());
+}
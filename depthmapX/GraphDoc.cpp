@@ -636,6 +636,7 @@ void QGraphDoc::OnFileExport()
    QString template_string = tr("Tab-delimited text file (*.txt)\n");
    if (mode < 3) {
 	   template_string += tr("Comma separated values file (*.csv)\n");
+	   template_string += tr("depthmapX columnar file (*.dxcol)\n");
 	   template_string += tr("Graph file (*.graph)\n");
 	   template_string += tr("MapInfo file (*.mif)\n");
 	   template_string += tr("Pajek (*.net)\n");
@@ -661,7 +662,7 @@ void QGraphDoc::OnFileExport()
    QFilePath filepath(outfile);
    QString ext = filepath.m_ext;
 
-   if (ext != tr("MIF") && ext != tr("GRAPH") && ext != tr("NET")) 
+   if (ext != tr("MIF") && ext != tr("GRAPH") && ext != tr("NET") && ext != tr("DXCOL"))
    {
        std::ofstream stream(outfile.toLatin1());
        char delimiter = '\t';
@@ -691,6 +692,26 @@ void QGraphDoc::OnFileExport()
        }
        stream.close();
     }
+    else if (ext == tr("DXCOL")) {
+        if (mode >= 3) {
+           QMessageBox::warning(this, tr("Notice"), tr("Sorry, depthmapX only supports exporting VGA, axial and shape data to columnar files"), QMessageBox::Ok, QMessageBox::Ok);
+            return;
+        }
+        std::ofstream stream(outfile.toLatin1(), std::ios::binary | std::ios::out);
+        if (stream.fail() || stream.bad()) {
+	        QMessageBox::warning(this, tr("Notice"), tr("Sorry, unable to open file for export"), QMessageBox::Ok, QMessageBox::Ok);
+            return;
+        }
+        if (mode == 0) {
+           m_meta_graph->getDisplayedShapeGraph().outputColumnar(stream);
+        }
+        else if (mode == 1) {
+           m_meta_graph->getDisplayedDataMap().outputColumnar(stream);
+        }
+        else if (mode == 2) {
+           m_meta_graph->getDisplayedPointMap().outputSummaryColumnar(stream);
+        }
+    }
     else if (ext == tr("GRAPH")) {
         if (mode >= 3) {
            QMessageBox::warning(this, tr("Notice"), tr("Sorry, depthmapX only supports exporting VGA, axial and shape data to graph files"), QMessageBox::Ok, QMessageBox::Ok);
@@ -27,8 +27,20 @@ GeneralPage::GeneralPage(Settings &settings, QWidget *parent)
     simpleModeCheckBox->setChecked(m_simpleVersion);
     connect(simpleModeCheckBox, &QCheckBox::stateChanged, [=] () {m_simpleVersion = !m_simpleVersion;});
 
+    QLabel *threadCountLabel = new QLabel(tr("Analysis threads"));
+    QSpinBox *threadCountSpinBox = new QSpinBox;
+    threadCountSpinBox->setRange(0, 256);
+    threadCountSpinBox->setSpecialValueText(tr("All cores"));
+    threadCountSpinBox->setToolTip(tr("The number of threads the analyses are spread over"));
+    threadCountSpinBox->setValue(m_threadCount);
+    connect(threadCountSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), [=] (int value) {m_threadCount = value;});
+    QHBoxLayout *threadCountLayout = new QHBoxLayout;
+    threadCountLayout->addWidget(threadCountLabel);
+    threadCountLayout->addWidget(threadCountSpinBox);
+
     QVBoxLayout *configLayout = new QVBoxLayout;
     configLayout->addWidget(simpleModeCheckBox);
+    configLayout->addLayout(threadCountLayout);
     configGroup->setLayout(configLayout);
 
     QVBoxLayout *mainLayout = new QVBoxLayout;
@@ -23,12 +23,15 @@ class GeneralPage : public SettingsPage
 {
 private:
     bool m_simpleVersion = false;    
+    int m_threadCount = 0;
     void readSettings(Settings &settings) {
         m_simpleVersion = settings.readSetting(SettingTag::simpleVersion, true).toBool();
+        m_threadCount = settings.readSetting(SettingTag::threadCount, 0).toInt();
     }
 public:
     GeneralPage(Settings &settings, QWidget *parent = 0);
     virtual void writeSettings(Settings &settings) override {
         settings.writeSetting(SettingTag::simpleVersion, m_simpleVersion);
+        settings.writeSetting(SettingTag::threadCount, m_threadCount);
     }
 };
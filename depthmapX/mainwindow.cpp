@@ -23,6 +23,7 @@
 #include "depthmapX/views/tableview/tableview.h"
 #include "dialogs/AboutDlg.h"
 #include "dialogs/settings/settingsdialog.h"
+#include "genlib/parallel.h"
 
 #include <QtGui>
 #include <QDesktopServices>
@@ -2125,6 +2126,7 @@ void MainWindow::readSettings()
     m_background = settings->readSetting(SettingTag::backgroundColour, qRgb(0,0,0)).toInt();
     m_simpleVersion = settings->readSetting(SettingTag::simpleVersion, true).toBool();
     m_defaultMapWindowIsLegacy = settings->readSetting(SettingTag::legacyMapWindow, false).toBool();
+    depthmapX::setThreadCount(size_t(std::max(0, settings->readSetting(SettingTag::threadCount, 0).toInt())));
     if (settings->readSetting(SettingTag::mwMaximised, true).toBool())
     {
          setWindowState(Qt::WindowMaximized);
@@ -93,10 +93,10 @@ bool QPlotView::eventFilter(QObject *object, QEvent *e) {
                 if (pDoc->m_meta_graph->viewingProcessed()) {
                     AttributeTable &table = pDoc->m_meta_graph->getAttributeTable();
 
-                    auto xRange =
-                        getIndexItemsInValueRange(idx_x, table, dataX(hit_point.x() - 2), dataX(hit_point.x() + 2));
-                    auto yRange =
-                        getIndexItemsInValueRange(idx_y, table, dataY(hit_point.y() + 2), dataY(hit_point.y() - 2));
+                    auto xRange = getIndexItemsInValueRange(idx_x, table, m_x_axis, idx_revision,
+                                                            dataX(hit_point.x() - 2), dataX(hit_point.x() + 2));
+                    auto yRange = getIndexItemsInValueRange(idx_y, table, m_y_axis, idx_revision,
+                                                            dataY(hit_point.y() + 2), dataY(hit_point.y() - 2));
 
                     // work out anything near this point...
                     std::set<AttributeKey> xkeys;
@@ -468,6 +468,7 @@ void QPlotView::RedoIndices() {
         AttributeTable &table = pDoc->m_meta_graph->getAttributeTable();
         idx_x = makeAttributeIndex(table, m_x_axis);
         idx_y = makeAttributeIndex(table, m_y_axis);
+        idx_revision = table.getColumnOrderRevision();
     }
 }
 
@@ -598,10 +599,10 @@ void QPlotView::mouseReleaseEvent(QMouseEvent *e) {
 
     AttributeTable &table = pDoc->m_meta_graph->getAttributeTable();
 
-    auto xRange =
-        getIndexItemsInValueRange(idx_x, table, dataX(m_drag_rect_a.left() - 2), dataX(m_drag_rect_a.right() + 2));
-    auto yRange =
-        getIndexItemsInValueRange(idx_y, table, dataY(m_drag_rect_a.bottom() + 2), dataY(m_drag_rect_a.top() - 2));
+    auto xRange = getIndexItemsInValueRange(idx_x, table, m_x_axis, idx_revision,
+                                            dataX(m_drag_rect_a.left() - 2), dataX(m_drag_rect_a.right() + 2));
+    auto yRange = getIndexItemsInValueRange(idx_y, table, m_y_axis, idx_revision,
+                                            dataY(m_drag_rect_a.bottom() + 2), dataY(m_drag_rect_a.top() - 2));
 
     // Stop drag rect...
     m_drag_rect_a = QRect(0, 0, 0, 0);
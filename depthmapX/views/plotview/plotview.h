@@ -52,6 +52,8 @@ class QPlotView : public QWidget {
 
     std::vector<AttributeIndexItem> idx_x;
     std::vector<AttributeIndexItem> idx_y;
+    // the revision of the table the indices were made at
+    size_t idx_revision = 0;
     void RedoIndices();
 
     bool m_queued_redraw;
@@ -0,0 +1,952 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "analysisserver.h"
+#include "modules/segmentshortestpaths/core/segmcontractionhierarchy.h"
+#include "salalib/axialmodules/axialstepdepth.h"
+#include "salalib/isovist.h"
+#include "salalib/isovistdef.h"
+#include "salalib/mgraph.h"
+#include "salalib/segmmodules/segmmetricpd.h"
+#include "salalib/segmmodules/segmtopologicalpd.h"
+#include "salalib/segmmodules/segmtulipdepth.h"
+#include "salalib/vgamodules/vgaangulardepth.h"
+#include "salalib/vgamodules/vgametricdepth.h"
+#include "salalib/vgamodules/vgavisualglobaldepth.h"
+#include "genlib/exceptions.h"
+#include "genlib/parallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+struct AnalysisServer::Graph
+{
+    std::unique_ptr<MetaGraph> graph;
+    std::string outputFile;
+    bool hasBspTree = false;
+    // shared by the requests reading the graph, held alone by those changing it
+    std::shared_mutex mutex;
+    // the contraction hierarchies paths are found with, made on the first path asked for on each
+    // segment map for each cost
+    std::mutex hierarchyMutex;
+    std::map<std::pair<const ShapeGraph *, SegmentContractionHierarchy::CostType>,
+             std::shared_ptr<const SegmentContractionHierarchy>>
+        hierarchies;
+};
+
+// a map of a graph, as named by a request
+struct AnalysisServer::MapRef
+{
+    PointMap *pointMap = nullptr;
+    ShapeMap *shapeMap = nullptr;
+    // the same map as shapeMap if it is an axial, segment or convex map
+    ShapeGraph *shapeGraph = nullptr;
+
+    AttributeTable &getAttributeTable()
+    {
+        return pointMap ? pointMap->getAttributeTable() : shapeMap->getAttributeTable();
+    }
+    const std::string &getName() const
+    {
+        return pointMap ? pointMap->getName() : shapeMap->getName();
+    }
+};
+
+class AnalysisServer::Responder
+{
+public:
+    virtual ~Responder() {}
+    // sends a response on a line of its own, whichever thread it is called from
+    virtual void send(const std::string &response) = 0;
+};
+
+class AnalysisServer::StreamResponder : public AnalysisServer::Responder
+{
+public:
+    StreamResponder(std::ostream &output) : m_output(output) {}
+    void send(const std::string &response) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_output << response << '\n' << std::flush;
+    }
+
+private:
+    std::ostream &m_output;
+    std::mutex m_mutex;
+};
+
+class AnalysisServer::RequestQueue
+{
+public:
+    RequestQueue(AnalysisServer &server, size_t threadCount)
+    {
+        // the analyses of each request spread over as many threads as they would have on the thread
+        // starting the server
+        size_t analysisThreadCount = depthmapX::getThreadCount();
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            m_workers.emplace_back([this, &server, analysisThreadCount]() {
+                depthmapX::ScopedThreadCount scopedThreadCount(analysisThreadCount);
+                Request request;
+                while (pop(request))
+                {
+                    request.responder->send(server.respond(request.request));
+                }
+            });
+        }
+    }
+
+    // waits for the requests already given to be answered
+    ~RequestQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_wake.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    void push(JsonValue request, std::shared_ptr<Responder> responder)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back(Request{std::move(request), std::move(responder)});
+        }
+        m_wake.notify_one();
+    }
+
+private:
+    struct Request
+    {
+        JsonValue request;
+        std::shared_ptr<Responder> responder;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Request> m_requests;
+    bool m_closed = false;
+    std::vector<std::thread> m_workers;
+
+    bool pop(Request &request)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_closed || !m_requests.empty(); });
+        if (m_requests.empty())
+        {
+            return false;
+        }
+        request = std::move(m_requests.front());
+        m_requests.pop_front();
+        return true;
+    }
+};
+
+#ifndef _WIN32
+class AnalysisServer::SocketResponder : public AnalysisServer::Responder
+{
+public:
+    SocketResponder(int connection) : m_connection(connection) {}
+    // the connection is closed once the last request from it has been answered
+    ~SocketResponder() override { close(m_connection); }
+    void send(const std::string &response) override
+    {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        std::string line = response + '\n';
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t sent = 0;
+        while (sent < line.size())
+        {
+            ssize_t count = ::send(m_connection, line.data() + sent, line.size() - sent, flags);
+            if (count <= 0)
+            {
+                // the client has gone, and no one is left to tell
+                return;
+            }
+            sent += size_t(count);
+        }
+    }
+
+private:
+    int m_connection;
+    std::mutex m_mutex;
+};
+#endif
+
+namespace
+{
+    // how often the threads waiting on sockets check for a shutdown
+    const int POLL_INTERVAL_MS = 200;
+
+    Point2f toPoint(const JsonValue &value)
+    {
+        const std::vector<JsonValue> &coordinates = value.asArray();
+        if (coordinates.size() != 2)
+        {
+            throw depthmapX::RuntimeException("Expected a point as [x, y]");
+        }
+        return Point2f(coordinates[0].asNumber(), coordinates[1].asNumber());
+    }
+
+    std::string pointText(const Point2f &point)
+    {
+        std::stringstream text;
+        text << point.x << "," << point.y;
+        return text.str();
+    }
+
+    // the key of the attribute row at the point (the pixel of a point map, the shape of a shape map
+    // the point is in or on), -1 if there is none
+    int locate(const PointMap *pointMap, const ShapeMap *shapeMap, const Point2f &point)
+    {
+        if (pointMap)
+        {
+            PixelRef pixel = pointMap->pixelate(point, false);
+            if (!pointMap->includes(pixel) || !pointMap->getPoint(pixel).filled())
+            {
+                return -1;
+            }
+            return int(pixel);
+        }
+        int index = shapeMap->pointInPoly(point);
+        if (index == -1)
+        {
+            index = shapeMap->getClosestOpenGeom(point);
+        }
+        return index == -1 ? -1 : shapeMap->getShapeRefFromIndex(size_t(index))->first;
+    }
+
+    // the values of the column (the keys themselves if -1) at each of the points in the array
+    std::string valuesAt(const PointMap *pointMap, const ShapeMap *shapeMap, const AttributeTable &table, int column,
+                         const JsonValue &points)
+    {
+        std::string values = "[";
+        for (auto &point : points.asArray())
+        {
+            if (values.size() > 1)
+            {
+                values += ',';
+            }
+            int key = locate(pointMap, shapeMap, toPoint(point));
+            if (key == -1)
+            {
+                values += "null";
+            }
+            else
+            {
+                values += JsonValue::number(column == -1 ? double(key)
+                                                         : double(table.getRow(AttributeKey(key)).getValue(column)));
+            }
+        }
+        return values + "]";
+    }
+
+    int columnIndex(const AttributeTable &table, const std::string &name)
+    {
+        if (!table.hasColumn(name))
+        {
+            throw depthmapX::RuntimeException("No column named " + name);
+        }
+        return int(table.getColumnIndex(name));
+    }
+
+    std::string mapType(int type)
+    {
+        switch (type)
+        {
+        case ShapeMap::DATAMAP: return "data";
+        case ShapeMap::CONVEXMAP: return "convex";
+        case ShapeMap::ALLLINEMAP: return "allline";
+        case ShapeMap::AXIALMAP: return "axial";
+        case ShapeMap::SEGMENTMAP: return "segment";
+        default: return "shape";
+        }
+    }
+
+    std::string describeMap(const std::string &name, const std::string &type, const AttributeTable &table)
+    {
+        std::string description =
+            "{\"name\":" + JsonValue::quote(name) + ",\"type\":" + JsonValue::quote(type) + ",\"columns\":[";
+        for (size_t i = 0; i < table.getNumColumns(); i++)
+        {
+            description += (i > 0 ? "," : "") + JsonValue::quote(table.getColumnName(i));
+        }
+        return description + "]}";
+    }
+
+    // the selection a step depth starts from is only there while it runs
+    template <typename Map> class SelectionGuard
+    {
+    public:
+        SelectionGuard(Map &map) : m_map(map) { m_map.clearSel(); }
+        ~SelectionGuard() { m_map.clearSel(); }
+
+    private:
+        Map &m_map;
+    };
+}
+
+AnalysisServer::AnalysisServer(size_t threadCount) : m_threadCount(threadCount), m_shutDown(false)
+{
+    if (m_threadCount == 0)
+    {
+        m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+AnalysisServer::~AnalysisServer() {}
+
+std::unique_ptr<MetaGraph> AnalysisServer::readGraph(const std::string &filename)
+{
+    std::unique_ptr<MetaGraph> graph(new MetaGraph);
+    int result = graph->readFromFile(filename);
+    if (result != MetaGraph::OK)
+    {
+        throw depthmapX::RuntimeException("Failed to load graph from file " + filename + ", error " +
+                                          std::to_string(result));
+    }
+    return graph;
+}
+
+std::string AnalysisServer::graphName(const std::string &filename)
+{
+    size_t start = filename.find_last_of("/\\");
+    std::string name = start == std::string::npos ? filename : filename.substr(start + 1);
+    size_t extension = name.rfind('.');
+    return extension == std::string::npos || extension == 0 ? name : name.substr(0, extension);
+}
+
+void AnalysisServer::addGraph(const std::string &name, std::unique_ptr<MetaGraph> graph, const std::string &outputFile)
+{
+    std::shared_ptr<Graph> served(new Graph);
+    served->outputFile = outputFile;
+
+    // whatever the graph would otherwise make the first time it is looked at is made (or read from
+    // the file, if it was read lazily) here, so that the requests reading it at the same time do not
+    graph->ensureMapsLoaded();
+    served->hasBspTree = graph->makeBSPtree();
+    served->graph = std::move(graph);
+
+    std::lock_guard<std::mutex> lock(m_graphsMutex);
+    if (m_defaultGraph.empty())
+    {
+        m_defaultGraph = name;
+    }
+    m_graphs[name] = served;
+}
+
+std::shared_ptr<AnalysisServer::Graph> AnalysisServer::getGraph(const JsonValue &request)
+{
+    std::lock_guard<std::mutex> lock(m_graphsMutex);
+    std::string name = request.has("graph") ? request.get("graph").asString() : m_defaultGraph;
+    auto iter = m_graphs.find(name);
+    if (iter == m_graphs.end())
+    {
+        throw depthmapX::RuntimeException("No graph named " + name);
+    }
+    return iter->second;
+}
+
+AnalysisServer::MapRef AnalysisServer::findMap(MetaGraph &graph, const JsonValue &request)
+{
+    MapRef map;
+    if (!request.has("map"))
+    {
+        switch (graph.getViewClass() & MetaGraph::VIEWFRONT)
+        {
+        case MetaGraph::VIEWVGA:
+            map.pointMap = &graph.getDisplayedPointMap();
+            break;
+        case MetaGraph::VIEWAXIAL:
+            map.shapeGraph = &graph.getDisplayedShapeGraph();
+            map.shapeMap = map.shapeGraph;
+            break;
+        case MetaGraph::VIEWDATA:
+            map.shapeMap = &graph.getDisplayedDataMap();
+            break;
+        default:
+            // nothing shown, as with a graph made in memory rather than read from a file
+            if (graph.getDisplayedPointMapRef() != -1)
+            {
+                map.pointMap = &graph.getDisplayedPointMap();
+            }
+            else if (graph.getDisplayedShapeGraphRef() != -1)
+            {
+                map.shapeGraph = &graph.getDisplayedShapeGraph();
+                map.shapeMap = map.shapeGraph;
+            }
+            else
+            {
+                throw depthmapX::RuntimeException("The graph has no map to show");
+            }
+        }
+        return map;
+    }
+    const std::string &name = request.get("map").asString();
+    for (auto &pointMap : graph.getPointMaps())
+    {
+        if (pointMap.getName() == name)
+        {
+            map.pointMap = &pointMap;
+            return map;
+        }
+    }
+    for (auto &shapeGraph : graph.getShapeGraphs())
+    {
+        if (shapeGraph->getName() == name)
+        {
+            map.shapeGraph = shapeGraph.get();
+            map.shapeMap = map.shapeGraph;
+            return map;
+        }
+    }
+    for (auto &dataMap : graph.getDataMaps())
+    {
+        if (dataMap.getName() == name)
+        {
+            map.shapeMap = &dataMap;
+            return map;
+        }
+    }
+    throw depthmapX::RuntimeException("No map named " + name);
+}
+
+std::string AnalysisServer::handle(const std::string &request)
+{
+    try
+    {
+        return respond(JsonValue::parse(request));
+    }
+    catch (depthmapX::RuntimeException &e)
+    {
+        return "{\"id\":null,\"error\":" + JsonValue::quote(e.what()) + "}";
+    }
+}
+
+std::string AnalysisServer::respond(const JsonValue &request)
+{
+    std::string id = request.has("id") ? request.get("id").toString() : "null";
+    std::string result;
+    try
+    {
+        const std::string &op = request.get("op").asString();
+        if (op == "ping")
+        {
+            result = "\"ok\":true";
+        }
+        else if (op == "shutdown")
+        {
+            m_shutDown = true;
+            result = "\"ok\":true";
+        }
+        else if (op == "graphs")
+        {
+            result = listGraphs();
+        }
+        else if (op == "load")
+        {
+            result = load(request);
+        }
+        else if (op == "save")
+        {
+            result = save(request);
+        }
+        else if (op == "value")
+        {
+            result = value(request);
+        }
+        else if (op == "stepdepth")
+        {
+            result = stepDepth(request);
+        }
+        else if (op == "isovist")
+        {
+            result = isovist(request);
+        }
+        else if (op == "path")
+        {
+            result = path(request);
+        }
+        else
+        {
+            throw depthmapX::RuntimeException("Unknown op " + op);
+        }
+    }
+    catch (std::exception &e)
+    {
+        // anything going wrong with one request is for its client to know about, the server carries on
+        result = "\"error\":" + JsonValue::quote(e.what());
+    }
+    return "{\"id\":" + id + "," + result + "}";
+}
+
+std::string AnalysisServer::listGraphs()
+{
+    std::vector<std::pair<std::string, std::shared_ptr<Graph>>> graphs;
+    {
+        std::lock_guard<std::mutex> lock(m_graphsMutex);
+        graphs.assign(m_graphs.begin(), m_graphs.end());
+    }
+    std::string result = "\"graphs\":[";
+    for (auto &graph : graphs)
+    {
+        std::shared_lock<std::shared_mutex> lock(graph.second->mutex);
+        MetaGraph &metaGraph = *graph.second->graph;
+        std::string maps;
+        for (auto &pointMap : metaGraph.getPointMaps())
+        {
+            maps += (maps.empty() ? "" : ",") + describeMap(pointMap.getName(), "point", pointMap.getAttributeTable());
+        }
+        for (auto &shapeGraph : metaGraph.getShapeGraphs())
+        {
+            maps += (maps.empty() ? "" : ",") + describeMap(shapeGraph->getName(), mapType(shapeGraph->getMapType()),
+                                                             shapeGraph->getAttributeTable());
+        }
+        for (auto &dataMap : metaGraph.getDataMaps())
+        {
+            maps += (maps.empty() ? "" : ",") + describeMap(dataMap.getName(), "data", dataMap.getAttributeTable());
+        }
+        result += (result.back() == '[' ? "" : ",");
+        result += "{\"name\":" + JsonValue::quote(graph.first) + ",\"maps\":[" + maps + "]}";
+    }
+    return result + "]";
+}
+
+std::string AnalysisServer::load(const JsonValue &request)
+{
+    const std::string &file = request.get("file").asString();
+    std::string name = request.has("name") ? request.get("name").asString() : graphName(file);
+    addGraph(name, readGraph(file));
+    return "\"graph\":" + JsonValue::quote(name);
+}
+
+std::string AnalysisServer::save(const JsonValue &request)
+{
+    auto graph = getGraph(request);
+    std::string file = request.has("file") ? request.get("file").asString() : graph->outputFile;
+    if (file.empty())
+    {
+        throw depthmapX::RuntimeException("No file to save the graph to");
+    }
+    std::unique_lock<std::shared_mutex> lock(graph->mutex);
+    int result = graph->graph->write(file, METAGRAPH_VERSION, false);
+    if (result != MetaGraph::OK)
+    {
+        throw depthmapX::RuntimeException("Failed to save the graph to " + file + ", error " + std::to_string(result));
+    }
+    return "\"file\":" + JsonValue::quote(file);
+}
+
+std::string AnalysisServer::value(const JsonValue &request)
+{
+    auto graph = getGraph(request);
+    std::shared_lock<std::shared_mutex> lock(graph->mutex);
+    MapRef map = findMap(*graph->graph, request);
+    const AttributeTable &table = map.getAttributeTable();
+    int column = request.has("column") ? columnIndex(table, request.get("column").asString()) : -1;
+    return "\"values\":" + valuesAt(map.pointMap, map.shapeMap, table, column, request.get("at"));
+}
+
+std::string AnalysisServer::stepDepth(const JsonValue &request)
+{
+    auto graph = getGraph(request);
+    std::unique_lock<std::shared_mutex> lock(graph->mutex);
+    MapRef map = findMap(*graph->graph, request);
+    const std::string &type = request.get("type").asString();
+    const std::vector<JsonValue> &origins = request.get("from").asArray();
+    if (origins.empty())
+    {
+        throw depthmapX::RuntimeException("Step depth needs at least one point to start from");
+    }
+
+    bool completed = false;
+    if (map.pointMap)
+    {
+        PointMap &pointMap = *map.pointMap;
+        SelectionGuard<PointMap> selection(pointMap);
+        for (auto &origin : origins)
+        {
+            Point2f point = toPoint(origin);
+            if (locate(&pointMap, nullptr, point) == -1)
+            {
+                throw depthmapX::RuntimeException("No point of " + pointMap.getName() + " at " + pointText(point));
+            }
+            QtRegion region(point, point);
+            pointMap.setCurSel(region, true);
+        }
+        if (type == "visual")
+            completed = VGAVisualGlobalDepth().run(nullptr, pointMap, false);
+        else if (type == "metric")
+            completed = VGAMetricDepth().run(nullptr, pointMap, false);
+        else if (type == "angular")
+            completed = VGAAngularDepth().run(nullptr, pointMap, false);
+        else
+            throw depthmapX::RuntimeException("No " + type + " step depth for point maps");
+    }
+    else if (map.shapeGraph)
+    {
+        ShapeGraph &shapeGraph = *map.shapeGraph;
+        SelectionGuard<ShapeGraph> selection(shapeGraph);
+        std::vector<int> keys;
+        for (auto &origin : origins)
+        {
+            // a shape given by its ref or by a point on it
+            int key = origin.getType() == JsonValue::Type::NUMBER ? int(origin.asNumber())
+                                                                  : locate(nullptr, &shapeGraph, toPoint(origin));
+            if (key == -1 || shapeGraph.getShapeIndexFromKey(key) == -1)
+            {
+                throw depthmapX::RuntimeException("No shape of " + shapeGraph.getName() + " at " + origin.toString());
+            }
+            keys.push_back(key);
+        }
+        shapeGraph.setCurSel(keys, true);
+        if (!shapeGraph.isSegmentMap() && type == "topological")
+            completed = AxialStepDepth().run(nullptr, shapeGraph, false);
+        else if (shapeGraph.isSegmentMap() && type == "topological")
+            completed = SegmentTopologicalPD().run(nullptr, shapeGraph, false);
+        else if (shapeGraph.isSegmentMap() && type == "metric")
+            completed = SegmentMetricPD().run(nullptr, shapeGraph, false);
+        else if (shapeGraph.isSegmentMap() && type == "angular")
+            completed = SegmentTulipDepth().run(nullptr, shapeGraph, false);
+        else
+            throw depthmapX::RuntimeException("No " + type + " step depth for " + mapType(shapeGraph.getMapType()) +
+                                              " maps");
+    }
+    else
+    {
+        throw depthmapX::RuntimeException("No step depth for data maps");
+    }
+    if (!completed)
+    {
+        throw depthmapX::RuntimeException("Step depth did not complete");
+    }
+
+    // the analyses show the column they write to
+    AttributeTable &table = map.getAttributeTable();
+    int column = map.pointMap ? map.pointMap->getDisplayedAttribute() : map.shapeMap->getDisplayedAttribute();
+    std::string result = "\"column\":" + JsonValue::quote(table.getColumnName(size_t(column))) +
+                         ",\"max\":" + JsonValue::number(table.getColumn(size_t(column)).getStats().max);
+    if (request.has("at"))
+    {
+        result += ",\"values\":" + valuesAt(map.pointMap, map.shapeMap, table, column, request.get("at"));
+    }
+    return result;
+}
+
+std::string AnalysisServer::isovist(const JsonValue &request)
+{
+    auto graph = getGraph(request);
+    std::shared_lock<std::shared_mutex> lock(graph->mutex);
+    if (!graph->hasBspTree)
+    {
+        throw depthmapX::RuntimeException("The graph has no drawing to make isovists from");
+    }
+    Point2f point = toPoint(request.get("at"));
+    if (!graph->graph->getRegion().contains(point))
+    {
+        throw depthmapX::RuntimeException("Point outside of the graph: " + pointText(point));
+    }
+    double angle = request.has("angle") ? request.get("angle").asNumber() * M_PI / 180.0 : 0.0;
+    double viewAngle = request.has("fov") ? request.get("fov").asNumber() * M_PI / 180.0 : 2.0 * M_PI;
+    IsovistDefinition definition(point.x, point.y, angle, viewAngle);
+
+    Isovist isovist;
+    graph->graph->makeIsovist(point, isovist, definition.getLeftAngle(), definition.getRightAngle());
+
+    AttributeTable measures;
+    AttributeRow &row = measures.addRow(AttributeKey(0));
+    isovist.setData(measures, row, false);
+    std::string result = "\"measures\":{";
+    for (size_t i = 0; i < measures.getNumColumns(); i++)
+    {
+        result += (i > 0 ? "," : "") + JsonValue::quote(measures.getColumnName(i)) + ":" +
+                  JsonValue::number(row.getValue(i));
+    }
+    result += "}";
+    if (!request.has("polygon") || request.get("polygon").asBool())
+    {
+        result += ",\"polygon\":[";
+        for (auto &vertex : isovist.getPolygon())
+        {
+            result += (result.back() == '[' ? "[" : ",[") + JsonValue::number(vertex.x) + "," +
+                      JsonValue::number(vertex.y) + "]";
+        }
+        result += "]";
+    }
+    return result;
+}
+
+std::string AnalysisServer::path(const JsonValue &request)
+{
+    auto graph = getGraph(request);
+    std::shared_lock<std::shared_mutex> lock(graph->mutex);
+    MapRef map = findMap(*graph->graph, request);
+    if (!map.shapeGraph || !map.shapeGraph->isSegmentMap())
+    {
+        throw depthmapX::RuntimeException("Paths can only be found on segment maps");
+    }
+    const ShapeGraph &segmentMap = *map.shapeGraph;
+
+    std::string cost = request.has("cost") ? request.get("cost").asString() : "metric";
+    SegmentContractionHierarchy::CostType costType;
+    if (cost == "metric")
+        costType = SegmentContractionHierarchy::CostType::METRIC;
+    else if (cost == "topological")
+        costType = SegmentContractionHierarchy::CostType::TOPOLOGICAL;
+    else
+        throw depthmapX::RuntimeException("No " + cost + " paths");
+
+    // a segment given by its ref or by a point on it
+    auto segment = [&segmentMap](const JsonValue &value) {
+        int key = value.getType() == JsonValue::Type::NUMBER ? int(value.asNumber())
+                                                             : locate(nullptr, &segmentMap, toPoint(value));
+        int index = key == -1 ? -1 : segmentMap.getShapeIndexFromKey(key);
+        if (index == -1)
+        {
+            throw depthmapX::RuntimeException("No segment at " + value.toString());
+        }
+        return index;
+    };
+    int origin = segment(request.get("from"));
+    int destination = segment(request.get("to"));
+
+    // held here as well, so that one replaced by another request while this is searching stays alive
+    std::shared_ptr<const SegmentContractionHierarchy> hierarchy;
+    {
+        std::lock_guard<std::mutex> hierarchyLock(graph->hierarchyMutex);
+        // those of maps the graph no longer has go first, another map may since have taken their place
+        std::set<const ShapeGraph *> shapeGraphs;
+        for (const auto &shapeGraph : graph->graph->getShapeGraphs())
+        {
+            shapeGraphs.insert(shapeGraph.get());
+        }
+        for (auto iter = graph->hierarchies.begin(); iter != graph->hierarchies.end();)
+        {
+            iter = shapeGraphs.count(iter->first.first) ? std::next(iter) : graph->hierarchies.erase(iter);
+        }
+        auto &made = graph->hierarchies[std::make_pair(&segmentMap, costType)];
+        if (!made || !made->isValidFor(segmentMap))
+        {
+            auto building = std::make_shared<SegmentContractionHierarchy>(costType);
+            if (!building->build(segmentMap))
+            {
+                made.reset();
+                throw depthmapX::RuntimeException("Failed to index " + segmentMap.getName() + " for paths");
+            }
+            made = building;
+        }
+        hierarchy = made;
+    }
+
+    SegmentContractionHierarchy::Path found = hierarchy->findPath(origin, destination);
+    std::string segments, costs;
+    for (size_t i = 0; i < found.segments.size(); i++)
+    {
+        segments += (i > 0 ? "," : "") + std::to_string(segmentMap.getShapeRefFromIndex(size_t(found.segments[i]))->first);
+        costs += (i > 0 ? "," : "") + JsonValue::number(found.costs[i]);
+    }
+    return std::string("\"found\":") + (found.found() ? "true" : "false") + ",\"segments\":[" + segments +
+           "],\"costs\":[" + costs + "]";
+}
+
+bool AnalysisServer::receive(const std::string &line, const std::shared_ptr<Responder> &responder, RequestQueue &queue)
+{
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+    {
+        return !m_shutDown;
+    }
+    JsonValue request;
+    try
+    {
+        request = JsonValue::parse(line);
+        if (request.has("op") && request.get("op").getType() == JsonValue::Type::STRING &&
+            request.get("op").asString() == "shutdown")
+        {
+            // taken here rather than by a worker, so that no more is read
+            std::string response = respond(request);
+            std::lock_guard<std::mutex> lock(m_shutdownMutex);
+            if (m_shutdownResponse)
+            {
+                responder->send(response);
+            }
+            else
+            {
+                m_shutdownResponse = [responder, response]() { responder->send(response); };
+            }
+            return false;
+        }
+    }
+    catch (depthmapX::RuntimeException &e)
+    {
+        responder->send("{\"id\":null,\"error\":" + JsonValue::quote(e.what()) + "}");
+        return !m_shutDown;
+    }
+    queue.push(std::move(request), responder);
+    return !m_shutDown;
+}
+
+void AnalysisServer::sendShutdownResponse()
+{
+    std::lock_guard<std::mutex> lock(m_shutdownMutex);
+    if (m_shutdownResponse)
+    {
+        m_shutdownResponse();
+        m_shutdownResponse = nullptr;
+    }
+}
+
+void AnalysisServer::serve(std::istream &input, std::ostream &output)
+{
+    std::shared_ptr<Responder> responder(new StreamResponder(output));
+    {
+        RequestQueue queue(*this, m_threadCount);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (!receive(line, responder, queue))
+            {
+                break;
+            }
+        }
+    }
+    sendShutdownResponse();
+}
+
+#ifndef _WIN32
+
+void AnalysisServer::serveConnection(int connection, RequestQueue &queue)
+{
+    std::shared_ptr<Responder> responder(new SocketResponder(connection));
+    std::string pending;
+    char buffer[4096];
+    while (!m_shutDown)
+    {
+        pollfd ready = {connection, POLLIN, 0};
+        if (poll(&ready, 1, POLL_INTERVAL_MS) <= 0)
+        {
+            continue;
+        }
+        ssize_t count = recv(connection, buffer, sizeof(buffer), 0);
+        if (count <= 0)
+        {
+            // the client is done, a last request without a line ending is still answered
+            receive(pending, responder, queue);
+            return;
+        }
+        pending.append(buffer, size_t(count));
+        size_t start = 0;
+        for (size_t end = pending.find('\n'); end != std::string::npos; end = pending.find('\n', start))
+        {
+            if (!receive(pending.substr(start, end - start), responder, queue))
+            {
+                return;
+            }
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+}
+
+void AnalysisServer::serveSocket(const std::string &path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        throw depthmapX::RuntimeException("Not a usable socket path: " + path);
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    // a socket left behind by a server that did not shut down is taken over, anything else is not
+    struct stat existing;
+    if (stat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+    {
+        unlink(path.c_str());
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        throw depthmapX::RuntimeException("Failed to listen on " + path + ": " + error);
+    }
+
+    {
+        std::vector<std::thread> connections;
+        RequestQueue queue(*this, m_threadCount);
+        while (!m_shutDown)
+        {
+            pollfd ready = {listener, POLLIN, 0};
+            if (poll(&ready, 1, POLL_INTERVAL_MS) <= 0)
+            {
+                continue;
+            }
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection >= 0)
+            {
+                connections.emplace_back([this, connection, &queue]() { serveConnection(connection, queue); });
+            }
+        }
+        for (auto &connection : connections)
+        {
+            connection.join();
+        }
+    }
+    sendShutdownResponse();
+    close(listener);
+    unlink(path.c_str());
+}
+
+#else
+
+void AnalysisServer::serveConnection(int, RequestQueue &) {}
+
+void AnalysisServer::serveSocket(const std::string &)
+{
+    throw depthmapX::RuntimeException("Serving on a local socket is not supported on this platform");
+}
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "jsonvalue.h"
+
+#include <atomic>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class MetaGraph;
+
+/**
+ * Keeps graphs in memory and answers requests about them, so that the graphs are read once rather
+ * than for every question asked. Requests and responses are JSON objects, one per line (see the
+ * SERVER mode in docs/commandline.md for what can be asked). Requests only reading a graph are
+ * answered at the same time as each other, those changing it (step depth adds columns) one at a
+ * time. Responses are sent as the requests are done, so not necessarily in the order they came in,
+ * and carry the "id" of their request
+ */
+class AnalysisServer
+{
+public:
+    // threadCount requests are worked on at the same time, 0 for as many as the machine has cores
+    explicit AnalysisServer(size_t threadCount = 0);
+    ~AnalysisServer();
+    AnalysisServer(const AnalysisServer &) = delete;
+    AnalysisServer &operator=(const AnalysisServer &) = delete;
+
+    // serves the graph under the name, in place of any graph of the same name. Requests not naming a
+    // graph go to the first one added. outputFile is where a save request without a file writes it
+    void addGraph(const std::string &name, std::unique_ptr<MetaGraph> graph, const std::string &outputFile = "");
+    // reads the whole of a graph file, throwing RuntimeException if it cannot
+    static std::unique_ptr<MetaGraph> readGraph(const std::string &filename);
+    // the name a graph is served under if not given one: its file name without folders or extension
+    static std::string graphName(const std::string &filename);
+
+    // the response to a single request
+    std::string handle(const std::string &request);
+    // answers the requests read from input, writing the responses to output, until the input ends
+    // or a shutdown request
+    void serve(std::istream &input, std::ostream &output);
+    // as serve for any number of clients connecting to a UNIX domain socket made at path, until one
+    // of them sends a shutdown request
+    void serveSocket(const std::string &path);
+
+    bool isShutDown() const { return m_shutDown; }
+
+private:
+    struct Graph;
+    struct MapRef;
+    class Responder;
+    class StreamResponder;
+    class SocketResponder;
+    class RequestQueue;
+
+    size_t m_threadCount;
+    std::atomic<bool> m_shutDown;
+    std::mutex m_graphsMutex;
+    std::map<std::string, std::shared_ptr<Graph>> m_graphs;
+    std::string m_defaultGraph;
+    // the response to the shutdown request, held back until the requests before it are answered
+    std::mutex m_shutdownMutex;
+    std::function<void()> m_shutdownResponse;
+
+    // passes a line read from a client on to the workers, or answers it straight away if it cannot be
+    // read or asks for a shutdown. Returns false once the server is shutting down
+    bool receive(const std::string &line, const std::shared_ptr<Responder> &responder, RequestQueue &queue);
+    void serveConnection(int connection, RequestQueue &queue);
+    void sendShutdownResponse();
+    std::string respond(const JsonValue &request);
+
+    std::shared_ptr<Graph> getGraph(const JsonValue &request);
+    static MapRef findMap(MetaGraph &graph, const JsonValue &request);
+
+    std::string listGraphs();
+    std::string load(const JsonValue &request);
+    std::string save(const JsonValue &request);
+    std::string value(const JsonValue &request);
+    std::string stepDepth(const JsonValue &request);
+    std::string isovist(const JsonValue &request);
+    std::string path(const JsonValue &request);
+};
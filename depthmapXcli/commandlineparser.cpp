@@ -18,6 +18,8 @@
 #include "imodeparserfactory.h"
 #include "parsingutils.h"
 #include "version.h"
+#include "genlib/parallel.h"
+#include "salalib/options.h"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -25,12 +27,18 @@
 using namespace depthmapX;
 
 void CommandLineParser::printHelp(){
-    std::cout << "Usage: depthmapXcli -m <mode> -f <filename> -o <output file> [-s] [-t <times.csv>] [-p] [mode options]\n"
+    std::cout << "Usage: depthmapXcli -m <mode> -f <filename> -o <output file> [-s] [-t <times.csv>] [-p] [-j <threads>] [-ck <seconds>] [--resume] [mode options]\n"
               << "       depthmapXcli -v prints the current version\n"
               << "       depthmapXcli -h prints this help text\n"
               << "-s enables simple mode\n"
-              << "-t <times.csv> enables output of runtimes as csv file\n"
+              << "-t <times.csv> enables output of runtimes as csv file, or as a Chrome trace of the\n"
+              << "   phases with their counts and memory use if the file name ends in .json\n"
               << "-p enables text progress printing\n"
+              << "-j <threads> number of threads to run the analysis on (default: all cores)\n"
+              << "-ck <seconds> saves the progress of long analyses (VGA global visibility, segment tulip)\n"
+              << "   every <seconds> to <output file>.checkpoint, removed once the result is written\n"
+              << "--resume carries on from <output file>.checkpoint, left by an earlier run with -ck on the\n"
+              << "   same input and options that did not finish\n"
 
               << "Possible modes are:\n";
               std::for_each(_parserFactory.getModeParsers().begin(), _parserFactory.getModeParsers().end(), [](const ModeParserVec::value_type &p)->void{ std::cout << "  " << p->getModeName() << "\n"; });
@@ -45,7 +53,7 @@ void CommandLineParser::printVersion(){
 
 
 CommandLineParser::CommandLineParser(const IModeParserFactory &parserFactory)
-    :  m_simpleMode(false), _parserFactory(parserFactory), _modeParser(0)
+    :  m_simpleMode(false), m_printProgress(false), m_threadCount(0), m_checkpointInterval(-1.0), m_resume(false), _parserFactory(parserFactory), _modeParser(0)
 {}
 
 void CommandLineParser::parse(size_t argc, char *argv[])
@@ -113,6 +121,28 @@ void CommandLineParser::parse(size_t argc, char *argv[])
         {
             m_printProgress = true;
         }
+        else if ( std::strcmp("-j", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-j", i)
+            if (!has_only_digits(argv[i]) || std::atoi(argv[i]) <= 0)
+            {
+                throw CommandLineException(std::string("-j must be a whole number >0, got ") + argv[i]);
+            }
+            m_threadCount = std::atoi(argv[i]);
+        }
+        else if ( std::strcmp("-ck", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-ck", i)
+            if (!has_only_digits_dots(argv[i]))
+            {
+                throw CommandLineException(std::string("-ck must be a number of seconds, got ") + argv[i]);
+            }
+            m_checkpointInterval = std::atof(argv[i]);
+        }
+        else if ( std::strcmp("--resume", argv[i]) == 0)
+        {
+            m_resume = true;
+        }
         ++i;
     }
 
@@ -132,12 +162,28 @@ void CommandLineParser::parse(size_t argc, char *argv[])
     m_valid = true;
 }
 
+std::string CommandLineParser::getCheckpointFile() const
+{
+    if (m_checkpointInterval < 0 && !m_resume)
+    {
+        return std::string();
+    }
+    return m_outputFile + ".checkpoint";
+}
+
+double CommandLineParser::getCheckpointInterval() const
+{
+    // resuming keeps checkpointing, by default as often as the analyses do
+    return m_checkpointInterval < 0 ? Options().checkpoint_interval : m_checkpointInterval;
+}
+
 void CommandLineParser::run(IPerformanceSink &perfWriter) const
 {
     if (!m_valid || !_modeParser)
     {
         throw CommandLineException("Trying to run with invalid command line parameters");
     }
+    ScopedThreadCount threadCount(m_threadCount);
     _modeParser->run(*this, perfWriter);
 }
 
@@ -21,6 +21,7 @@
 class IModeParserFactory;
 class IModeParser;
 class IPerformanceSink;
+class MetaGraph;
 
 
 
@@ -37,8 +38,19 @@ public:
     bool printVersionMode() const { return m_printVersionMode; }
     bool simpleMode() const { return m_simpleMode; }
     bool printProgress() const { return m_printProgress; }
+    // 0 when not given, to use all cores
+    size_t getThreadCount() const { return m_threadCount; }
+    // where long analyses keep their progress, empty unless -ck or --resume is given
+    std::string getCheckpointFile() const;
+    double getCheckpointInterval() const;
+    bool resume() const { return m_resume; }
     const IModeParser& modeOptions() const{ return *_modeParser;};
 
+    // the graph a pipeline keeps in memory between its steps, which the modes then run on instead
+    // of reading -f and writing -o
+    void setGraph(std::shared_ptr<MetaGraph> graph) { m_graph = std::move(graph); }
+    const std::shared_ptr<MetaGraph> &getGraph() const { return m_graph; }
+
 
     void printHelp();
     void printVersion();
@@ -53,6 +65,10 @@ private:
     bool m_printVersionMode;
     bool m_simpleMode;
     bool m_printProgress;
+    size_t m_threadCount;
+    double m_checkpointInterval;
+    bool m_resume;
+    std::shared_ptr<MetaGraph> m_graph;
 
     const IModeParserFactory &_parserFactory;
     IModeParser * _modeParser;
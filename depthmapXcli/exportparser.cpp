@@ -41,6 +41,10 @@ void ExportParser::parse(int argc, char *argv[])
             {
                 m_exportMode = ExportMode::POINTMAP_DATA_CSV;
             } 
+            else if ( std::strcmp(argv[i], "pointmap-data-columnar") == 0 )
+            {
+                m_exportMode = ExportMode::POINTMAP_DATA_COLUMNAR;
+            }
             else if ( std::strcmp(argv[i], "pointmap-connections-csv") == 0 )
             {
                 m_exportMode = ExportMode::POINTMAP_CONNECTIONS_CSV;
@@ -53,6 +57,10 @@ void ExportParser::parse(int argc, char *argv[])
             {
                 m_exportMode = ExportMode::SHAPEGRAPH_MAP_CSV;
             }
+            else if ( std::strcmp(argv[i], "shapegraph-map-columnar") == 0 )
+            {
+                m_exportMode = ExportMode::SHAPEGRAPH_MAP_COLUMNAR;
+            }
             else if ( std::strcmp(argv[i], "shapegraph-map-mif") == 0 )
             {
                 m_exportMode = ExportMode::SHAPEGRAPH_MAP_MIF;
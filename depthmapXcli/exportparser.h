@@ -32,9 +32,11 @@ public:
         return    "Mode options for EXPORT:\n"\
                   "-em <export mode> one of:\n"\
                   "    pointmap-data-csv\n"\
+                  "    pointmap-data-columnar\n"\
                   "    pointmap-connections-csv\n"\
                   "    pointmap-links-csv\n"\
                   "    shapegraph-map-csv\n"\
+                  "    shapegraph-map-columnar\n"\
                   "    shapegraph-map-mif\n"\
                   "    shapegraph-connections-csv\n"\
                   "    shapegraph-links-unlinks-csv\n";
@@ -53,7 +55,9 @@ public:
         SHAPEGRAPH_MAP_CSV,
         SHAPEGRAPH_MAP_MIF,
         SHAPEGRAPH_CONNECTIONS_CSV,
-        SHAPEGRAPH_LINKS_UNLINKS_CSV
+        SHAPEGRAPH_LINKS_UNLINKS_CSV,
+        POINTMAP_DATA_COLUMNAR,
+        SHAPEGRAPH_MAP_COLUMNAR
     };
     ExportMode getExportMode() const { return m_exportMode; }
 
@@ -0,0 +1,147 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "generateparser.h"
+#include "parsingutils.h"
+#include "exceptions.h"
+#include "runmethods.h"
+#include <cstring>
+
+using namespace depthmapX;
+
+namespace
+{
+    double parseFraction(const char *flag, const char *value)
+    {
+        if (!has_only_digits_dots(value))
+        {
+            throw CommandLineException(std::string(flag) + " must be a number from 0 to 1, got " + value);
+        }
+        double fraction = std::atof(value);
+        if (fraction < 0.0 || fraction > 1.0)
+        {
+            throw CommandLineException(std::string(flag) + " must be a number from 0 to 1, got " + value);
+        }
+        return fraction;
+    }
+}
+
+void GenerateParser::parse(int argc, char **argv)
+{
+    bool typeGiven = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp("-gt", argv[i]) == 0)
+        {
+            if (typeGiven)
+            {
+                throw CommandLineException("-gt can only be used once");
+            }
+            ENFORCE_ARGUMENT("-gt", i)
+            if (std::strcmp(argv[i], "floorplate") == 0)
+            {
+                m_parameters.type = SyntheticPlanType::FLOORPLATE;
+            }
+            else if (std::strcmp(argv[i], "streetgrid") == 0)
+            {
+                m_parameters.type = SyntheticPlanType::STREET_GRID;
+            }
+            else if (std::strcmp(argv[i], "voronoi") == 0)
+            {
+                m_parameters.type = SyntheticPlanType::VORONOI_STREETS;
+            }
+            else if (std::strcmp(argv[i], "cityblocks") == 0)
+            {
+                m_parameters.type = SyntheticPlanType::CITY_BLOCKS;
+            }
+            else
+            {
+                throw CommandLineException(std::string("Invalid plan type (-gt): ") + argv[i]);
+            }
+            typeGiven = true;
+            if (m_mapName.empty())
+            {
+                m_mapName = argv[i];
+            }
+        }
+        else if (std::strcmp("-gs", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gs", i)
+            if (!has_only_digits(argv[i]) || std::atoi(argv[i]) < 1)
+            {
+                throw CommandLineException(std::string("-gs must be a whole number >0, got ") + argv[i]);
+            }
+            m_parameters.size = std::atoi(argv[i]);
+        }
+        else if (std::strcmp("-gr", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gr", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-gr must be a whole number, got ") + argv[i]);
+            }
+            m_parameters.seed = static_cast<unsigned int>(std::stoul(argv[i]));
+        }
+        else if (std::strcmp("-gc", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gc", i)
+            m_parameters.complexity = parseFraction("-gc", argv[i]);
+        }
+        else if (std::strcmp("-gd", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gd", i)
+            m_parameters.density = parseFraction("-gd", argv[i]);
+        }
+        else if (std::strcmp("-gm", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gm", i)
+            if (std::strcmp(argv[i], "drawing") == 0)
+            {
+                m_outMapType = ShapeMap::DRAWINGMAP;
+            }
+            else if (std::strcmp(argv[i], "axial") == 0)
+            {
+                m_outMapType = ShapeMap::AXIALMAP;
+            }
+            else if (std::strcmp(argv[i], "segment") == 0)
+            {
+                m_outMapType = ShapeMap::SEGMENTMAP;
+            }
+            else
+            {
+                throw CommandLineException(std::string("Invalid output map (-gm) type: ") + argv[i]);
+            }
+        }
+        else if (std::strcmp("-gn", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-gn", i)
+            m_mapName = argv[i];
+        }
+    }
+
+    if (!typeGiven)
+    {
+        throw CommandLineException("A plan type (-gt) is required");
+    }
+    if (m_parameters.size < 1)
+    {
+        throw CommandLineException("A plan size (-gs) is required");
+    }
+}
+
+void GenerateParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
+{
+    dm_runmethods::generatePlan(clp, *this, perfWriter);
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "imodeparser.h"
+#include "salalib/shapemap.h"
+#include "salalib/syntheticplans.h"
+
+class GenerateParser : public IModeParser
+{
+public:
+    GenerateParser() : m_outMapType(ShapeMap::DRAWINGMAP)
+    {
+        m_parameters.size = 0;
+    }
+
+    // IModeParser interface
+public:
+    std::string getModeName() const
+    {
+        return "GENERATE";
+    }
+
+    std::string getHelp() const
+    {
+        return  "Mode options for GENERATE (synthetic plans for benchmarks and tests):\n"\
+                "  -f is read as a graph to add the plan to if it is one, otherwise a new graph is made\n"\
+                "  -gt <type> one of:\n"\
+                "      floorplate  rooms off corridors, -gs is the number of rooms\n"\
+                "      streetgrid  a grid of street centrelines, -gs is the number of blocks on each side\n"\
+                "      voronoi     street centrelines around random cells, -gs is the number of cells\n"\
+                "      cityblocks  building outlines in blocks, -gs is the number of blocks on each side\n"\
+                "  -gs <size> the size of the plan (see -gt)\n"\
+                "  -gr <seed> seed of the random numbers (default 0)\n"\
+                "  -gc <complexity> from 0 (regular) to 1 (default 0.5)\n"\
+                "  -gd <density> from 0 to 1, how much of each block is built on (cityblocks only, default 0.5)\n"\
+                "  -gm <map> the map to make: drawing (default), axial or segment\n"\
+                "  -gn <name> name of the map (default the name of the type)\n\n";
+    }
+
+    void parse(int argc, char **argv);
+    void run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const;
+
+    const depthmapX::SyntheticPlanParameters &getParameters() const { return m_parameters; }
+    int getOutputMapType() const { return m_outMapType; }
+    const std::string &getMapName() const { return m_mapName; }
+
+private:
+    depthmapX::SyntheticPlanParameters m_parameters;
+    int m_outMapType;
+    std::string m_mapName;
+};
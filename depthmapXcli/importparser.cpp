@@ -49,6 +49,10 @@ void ImportParser::parse(int argc, char *argv[])
         } else if ( strcmp ("-iaa", argv[i]) == 0)
         {
             m_importAsAttributes = true;
+        } else if ( strcmp ("-iil", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-iil", i)
+            m_layersToImport.push_back(argv[i]);
         }
     }
 }
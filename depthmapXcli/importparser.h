@@ -39,7 +39,8 @@ public:
                 "       Possible map types:\n"\
                 "         - drawing (default, does not preserve attributes, typically for dxf files)\n"\
                 "         - data (preserves attributes, typically for csv and tsv files)\n"\
-                "   -iaa will import and attach attributes to an existing map\n";
+                "   -iaa will import and attach attributes to an existing map\n"\
+                "   -iil <layer> only import this layer of a dxf file (can be given more than once)\n";
     }
 
 public:
@@ -49,9 +50,11 @@ public:
     const std::vector<std::string> & getFilesToImport() const { return m_filesToImport; }
     const bool toImportAsAttrbiutes() const { return m_importAsAttributes; }
     const depthmapX::ImportType getImportMapType() const { return m_importMapType; }
+    const std::vector<std::string> & getLayersToImport() const { return m_layersToImport; }
 
 private:
     depthmapX::ImportType m_importMapType = depthmapX::ImportType::DRAWINGMAP;
     std::vector<std::string> m_filesToImport;
     bool m_importAsAttributes = false;
+    std::vector<std::string> m_layersToImport;
 };
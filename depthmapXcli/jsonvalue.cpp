@@ -0,0 +1,446 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "jsonvalue.h"
+#include "genlib/exceptions.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+class JsonValue::Reader
+{
+public:
+    Reader(const std::string &text) : m_text(text) {}
+
+    JsonValue readDocument()
+    {
+        JsonValue value = readValue(0);
+        skipSpace();
+        if (m_pos != m_text.size())
+        {
+            fail("unexpected text after the value");
+        }
+        return value;
+    }
+
+private:
+    // deeper than any request needs, and shallow enough not to run out of stack
+    static const int MAX_DEPTH = 64;
+
+    const std::string &m_text;
+    size_t m_pos = 0;
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw depthmapX::RuntimeException("Invalid JSON at character " + std::to_string(m_pos + 1) + ": " + message);
+    }
+
+    void skipSpace()
+    {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+        {
+            m_pos++;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == c)
+        {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    bool consumeWord(const char *word)
+    {
+        size_t length = std::strlen(word);
+        if (m_text.compare(m_pos, length, word) == 0)
+        {
+            m_pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue readValue(int depth)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            fail("nested too deeply");
+        }
+        skipSpace();
+        if (m_pos >= m_text.size())
+        {
+            fail("expected a value");
+        }
+        JsonValue value;
+        char c = m_text[m_pos];
+        if (c == '{')
+        {
+            m_pos++;
+            value.m_type = Type::OBJECT;
+            if (!consume('}'))
+            {
+                do
+                {
+                    skipSpace();
+                    if (m_pos >= m_text.size() || m_text[m_pos] != '"')
+                    {
+                        fail("expected a member name");
+                    }
+                    value.m_keys.push_back(readString());
+                    expect(':');
+                    value.m_items.push_back(readValue(depth + 1));
+                } while (consume(','));
+                expect('}');
+            }
+        }
+        else if (c == '[')
+        {
+            m_pos++;
+            value.m_type = Type::ARRAY;
+            if (!consume(']'))
+            {
+                do
+                {
+                    value.m_items.push_back(readValue(depth + 1));
+                } while (consume(','));
+                expect(']');
+            }
+        }
+        else if (c == '"')
+        {
+            value.m_type = Type::STRING;
+            value.m_string = readString();
+        }
+        else if (consumeWord("true") || consumeWord("false"))
+        {
+            value.m_type = Type::BOOLEAN;
+            value.m_bool = c == 't';
+        }
+        else if (consumeWord("null"))
+        {
+            value.m_type = Type::NUL;
+        }
+        else
+        {
+            value.m_type = Type::NUMBER;
+            value.m_number = readNumber();
+        }
+        return value;
+    }
+
+    double readNumber()
+    {
+        size_t start = m_pos;
+        if (m_pos < m_text.size() && m_text[m_pos] == '-')
+        {
+            m_pos++;
+        }
+        size_t digits = m_pos;
+        while (m_pos < m_text.size() && (std::isdigit(static_cast<unsigned char>(m_text[m_pos])) ||
+                                         std::string(".eE+-").find(m_text[m_pos]) != std::string::npos))
+        {
+            m_pos++;
+        }
+        if (m_pos == digits || !std::isdigit(static_cast<unsigned char>(m_text[digits])))
+        {
+            m_pos = start;
+            fail("expected a value");
+        }
+        std::string number = m_text.substr(start, m_pos - start);
+        char *end = nullptr;
+        double value = std::strtod(number.c_str(), &end);
+        if (*end != '\0')
+        {
+            m_pos = start;
+            fail("not a number: " + number);
+        }
+        return value;
+    }
+
+    unsigned int readHex()
+    {
+        if (m_pos + 4 > m_text.size())
+        {
+            fail("incomplete escape");
+        }
+        unsigned int code = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            char c = m_text[m_pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= unsigned(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                code |= unsigned(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                code |= unsigned(c - 'A' + 10);
+            else
+                fail("bad escape");
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string &text, unsigned int code)
+    {
+        if (code < 0x80)
+        {
+            text += char(code);
+        }
+        else if (code < 0x800)
+        {
+            text += char(0xC0 | (code >> 6));
+            text += char(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            text += char(0xE0 | (code >> 12));
+            text += char(0x80 | ((code >> 6) & 0x3F));
+            text += char(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            text += char(0xF0 | (code >> 18));
+            text += char(0x80 | ((code >> 12) & 0x3F));
+            text += char(0x80 | ((code >> 6) & 0x3F));
+            text += char(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string readString()
+    {
+        // at the opening quote
+        m_pos++;
+        std::string text;
+        while (true)
+        {
+            if (m_pos >= m_text.size())
+            {
+                fail("unterminated string");
+            }
+            char c = m_text[m_pos++];
+            if (c == '"')
+            {
+                return text;
+            }
+            if (c != '\\')
+            {
+                text += c;
+                continue;
+            }
+            if (m_pos >= m_text.size())
+            {
+                fail("unterminated string");
+            }
+            c = m_text[m_pos++];
+            switch (c)
+            {
+            case '"': text += '"'; break;
+            case '\\': text += '\\'; break;
+            case '/': text += '/'; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u':
+            {
+                unsigned int code = readHex();
+                // the second half of a surrogate pair
+                if (code >= 0xD800 && code < 0xDC00 && m_text.compare(m_pos, 2, "\\u") == 0)
+                {
+                    m_pos += 2;
+                    unsigned int low = readHex();
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(text, code);
+                break;
+            }
+            default:
+                fail("bad escape");
+            }
+        }
+    }
+};
+
+JsonValue JsonValue::parse(const std::string &text)
+{
+    return Reader(text).readDocument();
+}
+
+namespace
+{
+    const char *typeName(JsonValue::Type type)
+    {
+        switch (type)
+        {
+        case JsonValue::Type::NUL: return "null";
+        case JsonValue::Type::BOOLEAN: return "a boolean";
+        case JsonValue::Type::NUMBER: return "a number";
+        case JsonValue::Type::STRING: return "a string";
+        case JsonValue::Type::ARRAY: return "an array";
+        case JsonValue::Type::OBJECT: return "an object";
+        }
+        return "";
+    }
+
+    void requireType(const JsonValue &value, JsonValue::Type type)
+    {
+        if (value.getType() != type)
+        {
+            throw depthmapX::RuntimeException(std::string("Expected ") + typeName(type) + ", not " +
+                                              typeName(value.getType()));
+        }
+    }
+}
+
+bool JsonValue::asBool() const
+{
+    requireType(*this, Type::BOOLEAN);
+    return m_bool;
+}
+
+double JsonValue::asNumber() const
+{
+    requireType(*this, Type::NUMBER);
+    return m_number;
+}
+
+const std::string &JsonValue::asString() const
+{
+    requireType(*this, Type::STRING);
+    return m_string;
+}
+
+const std::vector<JsonValue> &JsonValue::asArray() const
+{
+    requireType(*this, Type::ARRAY);
+    return m_items;
+}
+
+bool JsonValue::has(const std::string &key) const
+{
+    if (m_type != Type::OBJECT)
+    {
+        return false;
+    }
+    for (auto &memberKey : m_keys)
+    {
+        if (memberKey == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const JsonValue &JsonValue::get(const std::string &key) const
+{
+    requireType(*this, Type::OBJECT);
+    for (size_t i = 0; i < m_keys.size(); i++)
+    {
+        if (m_keys[i] == key)
+        {
+            return m_items[i];
+        }
+    }
+    throw depthmapX::RuntimeException("Missing \"" + key + "\"");
+}
+
+std::string JsonValue::toString() const
+{
+    switch (m_type)
+    {
+    case Type::NUL: return "null";
+    case Type::BOOLEAN: return m_bool ? "true" : "false";
+    case Type::NUMBER: return number(m_number);
+    case Type::STRING: return quote(m_string);
+    case Type::ARRAY:
+    case Type::OBJECT:
+    {
+        bool object = m_type == Type::OBJECT;
+        std::string text(1, object ? '{' : '[');
+        for (size_t i = 0; i < m_items.size(); i++)
+        {
+            if (i > 0)
+            {
+                text += ',';
+            }
+            if (object)
+            {
+                text += quote(m_keys[i]) + ':';
+            }
+            text += m_items[i].toString();
+        }
+        text += object ? '}' : ']';
+        return text;
+    }
+    }
+    return "null";
+}
+
+std::string JsonValue::quote(const std::string &text)
+{
+    std::string quoted = "\"";
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"': quoted += "\\\""; break;
+        case '\\': quoted += "\\\\"; break;
+        case '\n': quoted += "\\n"; break;
+        case '\r': quoted += "\\r"; break;
+        case '\t': quoted += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", unsigned(c));
+                quoted += escape;
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string JsonValue::number(double value)
+{
+    if (!std::isfinite(value))
+    {
+        return "null";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.10g", value);
+    return text;
+}
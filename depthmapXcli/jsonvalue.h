@@ -0,0 +1,65 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A JSON value as read from the requests of the analysis server. Only as much of JSON as the
+// requests need: numbers are kept as doubles and the members of an object in the order given.
+// Anything the caller asks for that is not there or not of the type asked for throws a
+// depthmapX::RuntimeException naming it, which the server sends back as the error of the request
+class JsonValue
+{
+public:
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    JsonValue() = default;
+    // throws RuntimeException if the text is not a single JSON value
+    static JsonValue parse(const std::string &text);
+
+    Type getType() const { return m_type; }
+    bool isNull() const { return m_type == Type::NUL; }
+
+    bool asBool() const;
+    double asNumber() const;
+    const std::string &asString() const;
+    // the elements of an array
+    const std::vector<JsonValue> &asArray() const;
+
+    // the members of an object
+    bool has(const std::string &key) const;
+    const JsonValue &get(const std::string &key) const;
+
+    // the value written back out as compact JSON
+    std::string toString() const;
+
+    // text as a JSON string, with the quotes
+    static std::string quote(const std::string &text);
+    // a number as JSON, null if it is not finite
+    static std::string number(double value);
+
+private:
+    Type m_type = Type::NUL;
+    bool m_bool = false;
+    double m_number = 0.0;
+    std::string m_string;
+    // the elements of an array, or the values of the members of an object in the order of m_keys
+    std::vector<JsonValue> m_items;
+    std::vector<std::string> m_keys;
+
+    class Reader;
+};
@@ -25,6 +25,9 @@
 #include "exportparser.h"
 #include "stepdepthparser.h"
 #include "mapconvertparser.h"
+#include "pipelineparser.h"
+#include "generateparser.h"
+#include "serverparser.h"
 #include "modules/segmentshortestpaths/cli/segmentshortestpathparser.h"
 
 
@@ -43,5 +46,8 @@ void ModeParserRegistry::populateParsers()
     REGISTER_PARSER(StepDepthParser);
     REGISTER_PARSER(MapConvertParser);
     REGISTER_PARSER(SegmentShortestPathParser);
+    REGISTER_PARSER(PipelineParser);
+    REGISTER_PARSER(GenerateParser);
+    REGISTER_PARSER(ServerParser);
     // *********
 }
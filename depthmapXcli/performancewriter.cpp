@@ -17,10 +17,18 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include "genlib/trace.h"
 
 
-PerformanceWriter::PerformanceWriter(const std::string &filename) : m_filename(filename)
+PerformanceWriter::PerformanceWriter(const std::string &filename) : m_filename(filename), m_trace(false)
 {
+    std::string extension = ".json";
+    if (m_filename.size() > extension.size() &&
+        m_filename.compare(m_filename.size() - extension.size(), extension.size(), extension) == 0)
+    {
+        m_trace = true;
+        depthmapX::Trace::start();
+    }
 }
 
 
@@ -36,6 +44,12 @@ void PerformanceWriter::write() const
     if (!m_filename.empty())
     {
         std::ofstream outfile(m_filename);
+        if (m_trace)
+        {
+            depthmapX::Trace::stop();
+            depthmapX::Trace::writeChromeTrace(outfile);
+            return;
+        }
         outfile << "\"action\",\"duration\"\n";
         std::for_each(m_data.begin(), m_data.end(), [&outfile](const std::string& line)mutable ->void{(outfile) << line;});
         outfile << std::flush;
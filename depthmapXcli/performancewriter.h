@@ -25,7 +25,9 @@ class PerformanceWriter : public IPerformanceSink
 private:
     std::vector<std::string> m_data;
     std::string m_filename;
+    bool m_trace;
 public:
+    // a file name ending in .json gets a Chrome trace of the phases rather than a csv of the times
     PerformanceWriter(const std::string &filename);
     void addData( const std::string &message, double timeInSeconds);
     void write() const;
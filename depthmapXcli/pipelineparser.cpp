@@ -0,0 +1,250 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "pipelineparser.h"
+#include "salalib/mgraph.h"
+#include "exceptions.h"
+#include "modeparserregistry.h"
+#include "parsingutils.h"
+#include "runmethods.h"
+#include "simpletimer.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace depthmapX;
+
+namespace {
+    const std::string CHECKPOINT = "checkpoint";
+
+    bool isCheckpoint(const std::vector<std::string> &step) { return step[0] == CHECKPOINT; }
+
+    // passes on the timings of a step, marked with the step they are from
+    class StepPerformanceSink : public IPerformanceSink
+    {
+    public:
+        StepPerformanceSink(IPerformanceSink &sink, const std::string &step) : m_sink(sink), m_step(step) {}
+        void addData(const std::string &message, double timeInSeconds) {
+            m_sink.addData(m_step + ": " + message, timeInSeconds);
+        }
+
+    private:
+        IPerformanceSink &m_sink;
+        std::string m_step;
+    };
+
+    // each step has its own mode parsers, as a mode may appear in more than one step
+    struct Step {
+        std::vector<std::string> arguments;
+        std::unique_ptr<ModeParserRegistry> registry;
+        std::unique_ptr<CommandLineParser> commandLine;
+    };
+}
+
+std::vector<std::string> PipelineParser::splitArguments(const std::string &line)
+{
+    std::vector<std::string> arguments;
+    std::string argument;
+    bool inArgument = false;
+    bool inQuotes = false;
+    for (char c : line)
+    {
+        if (c == '"')
+        {
+            inQuotes = !inQuotes;
+            inArgument = true;
+        }
+        else if (!inQuotes && std::isspace(static_cast<unsigned char>(c)))
+        {
+            if (inArgument)
+            {
+                arguments.push_back(argument);
+                argument.clear();
+                inArgument = false;
+            }
+        }
+        else
+        {
+            argument += c;
+            inArgument = true;
+        }
+    }
+    if (inQuotes)
+    {
+        throw CommandLineException("Unterminated quotes in pipeline step: " + line);
+    }
+    if (inArgument)
+    {
+        arguments.push_back(argument);
+    }
+    return arguments;
+}
+
+void PipelineParser::parse(int argc, char *argv[])
+{
+    for ( int i = 1; i < argc;  )
+    {
+        if ( std::strcmp ("-ps", argv[i]) == 0)
+        {
+            if (!m_scriptFile.empty())
+            {
+                throw CommandLineException("-ps can only be used once");
+            }
+            ENFORCE_ARGUMENT("-ps", i)
+            m_scriptFile = argv[i];
+        }
+        ++i;
+    }
+    if (m_scriptFile.empty())
+    {
+        throw CommandLineException("-ps for the pipeline script is required");
+    }
+
+    std::ifstream script(m_scriptFile);
+    if (!script.good())
+    {
+        throw CommandLineException("Failed to open pipeline script " + m_scriptFile);
+    }
+    m_steps.clear();
+    std::string line;
+    while (std::getline(script, line))
+    {
+        std::vector<std::string> arguments = splitArguments(line);
+        if (arguments.empty() || arguments[0][0] == '#')
+        {
+            continue;
+        }
+        if (isCheckpoint(arguments) && arguments.size() > 2)
+        {
+            throw CommandLineException("A checkpoint takes at most one file name: " + line);
+        }
+        m_steps.push_back(arguments);
+    }
+    if (m_steps.empty())
+    {
+        throw CommandLineException("The pipeline script " + m_scriptFile + " has no steps");
+    }
+}
+
+void PipelineParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
+{
+    // all the steps are parsed before any is run, so that a mistake in the script shows up
+    // before the analysis rather than after it
+    std::vector<Step> steps(m_steps.size());
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        if (isCheckpoint(m_steps[i]))
+        {
+            continue;
+        }
+        Step &step = steps[i];
+        step.arguments = {"depthmapXcli", "-f", clp.getFileName(), "-o", clp.getOuputFile()};
+        if (clp.simpleMode())
+        {
+            step.arguments.push_back("-s");
+        }
+        if (clp.printProgress())
+        {
+            step.arguments.push_back("-p");
+        }
+        step.arguments.insert(step.arguments.end(), m_steps[i].begin(), m_steps[i].end());
+        std::vector<char *> argv;
+        for (std::string &argument : step.arguments)
+        {
+            argv.push_back(&argument[0]);
+        }
+
+        std::string stepName = "Step " + std::to_string(i + 1);
+        step.registry.reset(new ModeParserRegistry);
+        step.commandLine.reset(new CommandLineParser(*step.registry));
+        try
+        {
+            step.commandLine->parse(argv.size(), argv.data());
+        }
+        catch (CommandLineException &e)
+        {
+            throw CommandLineException(stepName + ": " + e.what());
+        }
+        if (!step.commandLine->isValid())
+        {
+            throw CommandLineException(stepName + " does not run a mode");
+        }
+        if (step.commandLine->modeOptions().getModeName() == getModeName())
+        {
+            throw CommandLineException(stepName + ": a pipeline can not run another pipeline");
+        }
+        if (step.commandLine->modeOptions().getModeName() == "SERVER")
+        {
+            throw CommandLineException(stepName + ": a pipeline can not run a server");
+        }
+    }
+
+    std::shared_ptr<MetaGraph> graph(new MetaGraph);
+    std::cout << "Loading graph " << clp.getFileName() << std::flush;
+    DO_TIMED("Load graph file", auto result = graph->readFromFile(clp.getFileName());)
+    // only a pipeline that starts by making a graph can start without one (IMPORT imports the file
+    // into the empty graph), anything else would quietly run on nothing if the file name was mistyped
+    std::string firstMode = steps[0].commandLine ? steps[0].commandLine->modeOptions().getModeName() : CHECKPOINT;
+    if (result == MetaGraph::NOT_A_GRAPH && (firstMode == "IMPORT" || firstMode == "GENERATE"))
+    {
+        std::cout << " not a graph, starting with an empty one\n" << std::flush;
+    }
+    else if (result != MetaGraph::OK)
+    {
+        throw depthmapX::RuntimeException("Failed to load graph from file " + clp.getFileName() + ", error " +
+                                          std::to_string(result));
+    }
+    else
+    {
+        std::cout << " ok\n" << std::flush;
+    }
+
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        if (isCheckpoint(m_steps[i]))
+        {
+            std::string fileName = m_steps[i].size() > 1 ? m_steps[i][1] : clp.getOuputFile();
+            std::cout << "Writing checkpoint " << fileName << std::flush;
+            DO_TIMED("Writing checkpoint", graph->write(fileName.c_str(), METAGRAPH_VERSION, false))
+            std::cout << " ok\n" << std::flush;
+            continue;
+        }
+        const CommandLineParser &commandLine = *steps[i].commandLine;
+        std::string stepName = "Step " + std::to_string(i + 1) + " " + commandLine.modeOptions().getModeName();
+        std::cout << stepName << "\n" << std::flush;
+        steps[i].commandLine->setGraph(graph);
+        StepPerformanceSink stepPerfWriter(perfWriter, stepName);
+        depthmapX::TracePhase stepPhase(stepName);
+        commandLine.run(stepPerfWriter);
+        stepPhase.end();
+        std::cout << "\n" << std::flush;
+    }
+
+    std::cout << "Writing graph " << clp.getOuputFile() << std::flush;
+    DO_TIMED("Writing graph", graph->write(clp.getOuputFile().c_str(), METAGRAPH_VERSION, false))
+    std::cout << " ok" << std::endl;
+
+    // the steps leave the checkpoints of their analyses for the result written here
+    for (const Step &step : steps)
+    {
+        if (step.commandLine && !step.commandLine->getCheckpointFile().empty())
+        {
+            std::remove(step.commandLine->getCheckpointFile().c_str());
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "imodeparser.h"
+#include "commandlineparser.h"
+#include <string>
+#include <vector>
+
+class PipelineParser : public IModeParser
+{
+public:
+    virtual std::string getModeName() const
+    {
+        return "PIPELINE";
+    }
+
+    virtual std::string getHelp() const
+    {
+        return  "Mode options for PIPELINE:\n"\
+                "   Runs the steps of a script one after the other on the graph read from -f, keeping it\n"\
+                "   in memory in between, and writes it to -o once they are all done\n"\
+                "   -ps <script file> the steps, one per line, each given as -m <mode> and its options\n"\
+                "       would be on the command line (for example -m VGA -vm metric -vr n). A line\n"\
+                "       checkpoint [file] writes the graph as it is at that point (to -o if no file\n"\
+                "       is given). Empty lines and lines starting with # are ignored\n";
+    }
+
+public:
+    virtual void parse(int argc, char *argv[]);
+    virtual void run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const;
+
+    const std::string &getScriptFile() const { return m_scriptFile; }
+    // the arguments on each line of the script
+    const std::vector<std::vector<std::string>> &getSteps() const { return m_steps; }
+
+    // splits a line of a script into its arguments, separated by whitespace unless in double quotes
+    static std::vector<std::string> splitArguments(const std::string &line);
+
+private:
+    std::string m_scriptFile;
+    std::vector<std::vector<std::string>> m_steps;
+};
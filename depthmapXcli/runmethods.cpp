@@ -21,6 +21,7 @@
 #include "exceptions.h"
 #include "simpletimer.h"
 #include "printcommunicator.h"
+#include <cstdio>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -30,10 +31,10 @@
 
 namespace dm_runmethods
 {
-    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter) {
+    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter, bool lazy) {
         std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
         std::cout << "Loading graph " << filename << std::flush;
-        DO_TIMED( "Load graph file", auto result = mgraph->readFromFile(filename);)
+        DO_TIMED( "Load graph file", auto result = mgraph->readFromFile(filename, lazy);)
         if ( result != MetaGraph::OK)
         {
             std::stringstream message;
@@ -44,6 +45,20 @@ namespace dm_runmethods
         return mgraph;
     }
 
+    std::shared_ptr<MetaGraph> loadGraph(const CommandLineParser &clp, IPerformanceSink &perfWriter, bool lazy) {
+        if (clp.getGraph()) {
+            return clp.getGraph();
+        }
+        return loadGraph(clp.getFileName(), perfWriter, lazy);
+    }
+
+    void writeGraph(const CommandLineParser &clp, MetaGraph &graph, const std::string &filename, IPerformanceSink &perfWriter) {
+        if (clp.getGraph()) {
+            return;
+        }
+        DO_TIMED("Writing graph", graph.write(filename.c_str(), METAGRAPH_VERSION, false))
+    }
+
     std::unique_ptr<Communicator> getCommunicator(const CommandLineParser &clp) {
         if (clp.printProgress()) {
             return std::unique_ptr<Communicator>(new PrintCommunicator());
@@ -51,6 +66,20 @@ namespace dm_runmethods
         return nullptr;
     }
 
+    void setCheckpointOptions(const CommandLineParser &clp, Options &options) {
+        options.checkpoint_file = clp.getCheckpointFile();
+        options.checkpoint_interval = clp.getCheckpointInterval();
+        options.resume = clp.resume();
+    }
+
+    // the checkpoint is only needed until the result is written (a pipeline writes it, and removes the
+    // checkpoints of its steps, at the end)
+    void removeCheckpoint(const CommandLineParser &clp) {
+        if (!clp.getCheckpointFile().empty() && !clp.getGraph()) {
+            std::remove(clp.getCheckpointFile().c_str());
+        }
+    }
+
     void importFiles(const CommandLineParser &cmdP, const ImportParser &parser, IPerformanceSink &perfWriter)
     {
         std::ifstream mainFileStream(cmdP.getFileName().c_str());
@@ -60,8 +89,17 @@ namespace dm_runmethods
             throw depthmapX::RuntimeException(message.str().c_str());
         }
 
-        std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
-        DO_TIMED( "Load graph file", auto result = mgraph->readFromFile(cmdP.getFileName());)
+        std::shared_ptr<MetaGraph> mgraph = cmdP.getGraph();
+        int result = MetaGraph::OK;
+        if (mgraph) {
+            // a pipeline started from a file that is not a graph has nothing in its graph until that is imported
+            if (mgraph->getState() == MetaGraph::NONE) {
+                result = MetaGraph::NOT_A_GRAPH;
+            }
+        } else {
+            mgraph.reset(new MetaGraph);
+            DO_TIMED( "Load graph file", result = mgraph->readFromFile(cmdP.getFileName());)
+        }
         if ( result != MetaGraph::OK && result != MetaGraph::NOT_A_GRAPH)
         {
             std::stringstream message;
@@ -87,7 +125,8 @@ namespace dm_runmethods
                                   getCommunicator(cmdP).get(),
                                   cmdP.getFileName(),
                                   parser.getImportMapType(),
-                                  importFileType);
+                                  importFileType,
+                                  parser.getLayersToImport());
         } else if ( result == MetaGraph::OK) {
             if(parser.toImportAsAttrbiutes()) {
 
@@ -110,13 +149,13 @@ namespace dm_runmethods
                 }
             }
         }
-        DO_TIMED("Writing graph", mgraph->write(cmdP.getOuputFile().c_str(),METAGRAPH_VERSION, false);)
+        writeGraph(cmdP, *mgraph, cmdP.getOuputFile(), perfWriter);
     }
 
     void linkGraph(const CommandLineParser &cmdP, const LinkParser &parser, IPerformanceSink &perfWriter)
     {
 
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        auto mgraph = loadGraph(cmdP, perfWriter);
 
         if (parser.getLinkMode() == LinkParser::LinkMode::UNLINK
                 && parser.getMapTypeGroup() == LinkParser::MapTypeGroup::SHAPEGRAPHS
@@ -221,12 +260,12 @@ namespace dm_runmethods
         }
 
         perfWriter.addData("Linking graph", t.getTimeInSeconds());
-        DO_TIMED("Writing graph", mgraph->write(cmdP.getOuputFile().c_str(),METAGRAPH_VERSION, false);)
+        writeGraph(cmdP, *mgraph, cmdP.getOuputFile(), perfWriter);
     }
 
     void runVga(const CommandLineParser &cmdP, const VgaParser &vgaP, const IRadiusConverter &converter, IPerformanceSink &perfWriter)
     {
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        auto mgraph = loadGraph(cmdP, perfWriter);
 
         std::unique_ptr<Options> options(new Options());
 
@@ -258,11 +297,13 @@ namespace dm_runmethods
             default:
                 throw depthmapX::SetupCheckException("Unsupported VGA mode");
         }
+        setCheckpointOptions(cmdP, *options);
         std::cout << " ok\nAnalysing graph..." << std::flush;
 
         DO_TIMED("Run VGA", mgraph->analyseGraph(getCommunicator(cmdP).get(), *options, cmdP.simpleMode() ))
         std::cout << " ok\nWriting out result..." << std::flush;
-        DO_TIMED("Writing graph", mgraph->write(cmdP.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(cmdP, *mgraph, cmdP.getOuputFile(), perfWriter);
+        removeCheckpoint(cmdP);
         std::cout << " ok" << std::endl;
     }
 
@@ -284,9 +325,10 @@ namespace dm_runmethods
             bool makeGraph,
             bool unmakeGraph,
             bool removeLinksWhenUnmaking,
+            size_t memoryBudget,
             IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         std::cout << "Initial checks... " << std::flush;
         auto state = mGraph->getState();
@@ -330,19 +372,33 @@ namespace dm_runmethods
                          for_each(fillPoints.begin(), fillPoints.end(), [&mGraph](const Point2f &point)->void{fillGraph(*mGraph, point);}))
             }
             if(makeGraph) {
+                bool compact = false;
+                if(memoryBudget > 0) {
+                    std::cout << "ok\nEstimating graph memory... " << std::flush;
+                    depthmapX::GraphMemoryEstimate estimate;
+                    DO_TIMED("Estimating graph memory", estimate = mGraph->getDisplayedPointMap().estimateGraphMemory(boundaryGraph, maxVisibility))
+                    std::cout << depthmapX::formatBytes(estimate.graphBytes) << " for the graph ("
+                              << depthmapX::formatBytes(estimate.compactGraphBytes) << " compact) and "
+                              << depthmapX::formatBytes(estimate.analysisBytes) << " for its analyses, from "
+                              << estimate.sampleCount << " of " << estimate.nodeCount << " points " << std::flush;
+                    compact = depthmapX::needsCompactGraph(estimate, memoryBudget);
+                    if(compact) {
+                        std::cout << "ok\nMaking the graph compact to fit in " << depthmapX::formatBytes(memoryBudget) << " " << std::flush;
+                    }
+                }
                 std::cout << "ok\nMaking graph... " << std::flush;
-                DO_TIMED("Making graph", mGraph->makeGraph(getCommunicator(clp).get(), boundaryGraph ? 1 : 0, maxVisibility))
+                DO_TIMED("Making graph", mGraph->makeGraph(getCommunicator(clp).get(), boundaryGraph ? 1 : 0, maxVisibility, compact))
             }
         }
 
         std::cout << " ok\nWriting out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
                 std::cout << " ok" << std::endl;
     }
 
     void runAxialAnalysis(const CommandLineParser &clp, const AxialParser &ap, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         auto state = mGraph->getState();
         if ( ap.runAllLines())
@@ -401,14 +457,14 @@ namespace dm_runmethods
 
         }
         std::cout << "Writing out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
         std::cout << " ok" << std::endl;
 
     }
 
     void runSegmentAnalysis(const CommandLineParser &clp, const SegmentParser &sp, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         auto state = mGraph->getState();
 
@@ -419,6 +475,7 @@ namespace dm_runmethods
         options.choice = sp.includeChoice();
         options.tulip_bins = sp.getTulipBins();
         options.weighted_measure_col = -1;
+        setCheckpointOptions(clp, options);
 
         if(!sp.getAttribute().empty()) {
             const ShapeGraph& map = mGraph->getDisplayedShapeGraph();
@@ -475,14 +532,15 @@ namespace dm_runmethods
         std::cout << "ok\n" << std::flush;
 
         std::cout << "Writing out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
+        removeCheckpoint(clp);
         std::cout << " ok" << std::endl;
 
     }
 
     void runAgentAnalysis(const CommandLineParser &cmdP, const AgentParser &agentP, IPerformanceSink &perfWriter) {
 
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        auto mgraph = loadGraph(cmdP, perfWriter);
 
         PointMap& currentMap = mgraph->getDisplayedPointMap();
 
@@ -575,7 +633,7 @@ namespace dm_runmethods
             // if no choice was made for an output type assume the user just
             // wants a graph file
 
-            DO_TIMED("Writing graph", mgraph->write(cmdP.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+            writeGraph(cmdP, *mgraph, cmdP.getOuputFile(), perfWriter);
         }
         else if(resultTypes.size() == 1)
         {
@@ -586,7 +644,7 @@ namespace dm_runmethods
             switch(resultTypes[0]) {
                 case AgentParser::OutputType::GRAPH:
                 {
-                    DO_TIMED("Writing graph", mgraph->write(cmdP.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+                    writeGraph(cmdP, *mgraph, cmdP.getOuputFile(), perfWriter);
                     break;
                 }
                 case AgentParser::OutputType::GATECOUNTS:
@@ -615,7 +673,7 @@ namespace dm_runmethods
 
             if(std::find(resultTypes.begin(), resultTypes.end(), AgentParser::OutputType::GRAPH) != resultTypes.end()) {
                 std::string outFile = cmdP.getOuputFile() + ".graph";
-                DO_TIMED("Writing graph", mgraph->write(outFile.c_str(),METAGRAPH_VERSION, false))
+                writeGraph(cmdP, *mgraph, outFile, perfWriter);
             }
             if(std::find(resultTypes.begin(), resultTypes.end(), AgentParser::OutputType::GATECOUNTS) != resultTypes.end()) {
                 std::string outFile = cmdP.getOuputFile() + "_gatecounts.csv";
@@ -634,7 +692,7 @@ namespace dm_runmethods
 
     void runIsovists(const CommandLineParser &clp, const std::vector<IsovistDefinition> &isovists, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         std::cout << "Making " << isovists.size() << " isovists... "  << std::flush;
         DO_TIMED("Make isovists", std::for_each(isovists.begin(), isovists.end(),
@@ -642,25 +700,37 @@ namespace dm_runmethods
                 mGraph->makeIsovist(getCommunicator(clp).get(), isovist.getLocation(), isovist.getLeftAngle(), isovist.getRightAngle(), clp.simpleMode());
             }))
         std::cout << " ok\nWriting out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
         std::cout << " ok" << std::endl;
     }
 
     void exportData(const CommandLineParser &cmdP, const ExportParser &exportP, IPerformanceSink &perfWriter ) {
 
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        // only the displayed map is exported, so only that needs to be read from the file
+        auto mgraph = loadGraph(cmdP, perfWriter, true);
 
         switch(exportP.getExportMode()) {
             case ExportParser::POINTMAP_DATA_CSV:
             {
+                mgraph->ensureMapLoaded('p', mgraph->getDisplayedPointMapRef());
                 PointMap& currentMap = mgraph->getDisplayedPointMap();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing pointmap data", currentMap.outputSummary(stream, ','))
                 stream.close();
                 break;
             }
+            case ExportParser::POINTMAP_DATA_COLUMNAR:
+            {
+                mgraph->ensureMapLoaded('p', mgraph->getDisplayedPointMapRef());
+                PointMap& currentMap = mgraph->getDisplayedPointMap();
+                std::ofstream stream(cmdP.getOuputFile().c_str(), std::ios::binary | std::ios::out);
+                DO_TIMED("Writing pointmap data", currentMap.outputSummaryColumnar(stream))
+                stream.close();
+                break;
+            }
             case ExportParser::POINTMAP_CONNECTIONS_CSV:
             {
+                mgraph->ensureMapLoaded('p', mgraph->getDisplayedPointMapRef());
                 PointMap& currentMap = mgraph->getDisplayedPointMap();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing pointmap connections", currentMap.outputConnectionsAsCSV(stream, ","))
@@ -669,6 +739,7 @@ namespace dm_runmethods
             }
             case ExportParser::POINTMAP_LINKS_CSV:
             {
+                mgraph->ensureMapLoaded('p', mgraph->getDisplayedPointMapRef());
                 PointMap& currentMap = mgraph->getDisplayedPointMap();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing pointmap connections", currentMap.outputLinksAsCSV(stream, ","))
@@ -677,14 +748,25 @@ namespace dm_runmethods
             }
             case ExportParser::SHAPEGRAPH_MAP_CSV:
             {
+                mgraph->ensureMapLoaded('x', mgraph->getDisplayedShapeGraphRef());
                 ShapeGraph& currentMap = mgraph->getDisplayedShapeGraph();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing pointmap connections", currentMap.output(stream, ','))
                 stream.close();
                 break;
             }
+            case ExportParser::SHAPEGRAPH_MAP_COLUMNAR:
+            {
+                mgraph->ensureMapLoaded('x', mgraph->getDisplayedShapeGraphRef());
+                ShapeGraph& currentMap = mgraph->getDisplayedShapeGraph();
+                std::ofstream stream(cmdP.getOuputFile().c_str(), std::ios::binary | std::ios::out);
+                DO_TIMED("Writing shapegraph data", currentMap.outputColumnar(stream))
+                stream.close();
+                break;
+            }
             case ExportParser::SHAPEGRAPH_MAP_MIF:
             {
+                mgraph->ensureMapLoaded('x', mgraph->getDisplayedShapeGraphRef());
                 ShapeGraph& currentMap = mgraph->getDisplayedShapeGraph();
                 std::string fileName = cmdP.getOuputFile().c_str();
                 std::string mifFile = fileName + ".mif";
@@ -708,6 +790,7 @@ namespace dm_runmethods
             }
             case ExportParser::SHAPEGRAPH_CONNECTIONS_CSV:
             {
+                mgraph->ensureMapLoaded('x', mgraph->getDisplayedShapeGraphRef());
                 ShapeGraph& currentMap = mgraph->getDisplayedShapeGraph();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing shapegraph connections",
@@ -718,6 +801,7 @@ namespace dm_runmethods
             }
             case ExportParser::SHAPEGRAPH_LINKS_UNLINKS_CSV:
             {
+                mgraph->ensureMapLoaded('x', mgraph->getDisplayedShapeGraphRef());
                 ShapeGraph& currentMap = mgraph->getDisplayedShapeGraph();
                 std::ofstream stream(cmdP.getOuputFile().c_str());
                 DO_TIMED("Writing shapegraph links and unlinks",
@@ -738,7 +822,7 @@ namespace dm_runmethods
             const std::vector<Point2f> &stepDepthPoints,
             IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         std::cout << "ok\nSelecting cells... " << std::flush;
 
@@ -773,13 +857,13 @@ namespace dm_runmethods
         DO_TIMED("Calculating step-depth", mGraph->analyseGraph( getCommunicator(clp).get(), options, false))
 
         std::cout << " ok\nWriting out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
                 std::cout << " ok" << std::endl;
     }
 
     void runMapConversion(const CommandLineParser &clp, const MapConvertParser &mcp, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter);
+        auto mGraph = loadGraph(clp, perfWriter);
 
         int currentMapType = mGraph->getDisplayedMapType();
 
@@ -888,7 +972,55 @@ namespace dm_runmethods
         }
 
         std::cout << " ok\nWriting out result..." << std::flush;
-        DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(),METAGRAPH_VERSION, false))
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
                 std::cout << " ok" << std::endl;
     }
+
+    void generatePlan(const CommandLineParser &clp, const GenerateParser &gp, IPerformanceSink &perfWriter)
+    {
+        // the plan is added to -f if it is a graph, and otherwise to a new one
+        std::shared_ptr<MetaGraph> mGraph = clp.getGraph();
+        if (!mGraph) {
+            mGraph.reset(new MetaGraph);
+            DO_TIMED("Load graph file", int result = mGraph->readFromFile(clp.getFileName()));
+            if (result == MetaGraph::NOT_A_GRAPH) {
+                mGraph.reset(new MetaGraph);
+            } else if (result != MetaGraph::OK) {
+                std::stringstream message;
+                message << "Failed to load graph from file " << clp.getFileName() << ", error " << result << std::flush;
+                throw depthmapX::RuntimeException(message.str().c_str());
+            }
+        }
+
+        std::cout << "Generating plan..." << std::flush;
+        depthmapX::SyntheticPlan plan;
+        DO_TIMED("Generating plan", plan = depthmapX::generateSyntheticPlan(gp.getParameters()));
+        DO_TIMED("Adding drawing", depthmapX::addSyntheticDrawing(*mGraph, plan, gp.getMapName()));
+        std::cout << " ok, " << plan.lines.size() << " lines\n" << std::flush;
+
+        switch (gp.getOutputMapType()) {
+        case ShapeMap::AXIALMAP: {
+            std::cout << "Converting to axial..." << std::flush;
+            DO_TIMED("Converting from drawing to axial",
+                     mGraph->convertDrawingToAxial(getCommunicator(clp).get(), gp.getMapName()));
+            std::cout << " ok\n" << std::flush;
+            break;
+        }
+        case ShapeMap::SEGMENTMAP: {
+            std::cout << "Converting to segment..." << std::flush;
+            DO_TIMED("Converting from drawing to segment",
+                     mGraph->convertDrawingToSegment(getCommunicator(clp).get(), gp.getMapName()));
+            std::cout << " ok\n" << std::flush;
+            break;
+        }
+        default: {
+            if (gp.getParameters().type == depthmapX::SyntheticPlanType::FLOORPLATE ||
+                    gp.getParameters().type == depthmapX::SyntheticPlanType::CITY_BLOCKS) {
+                // a VGA grid can be filled from here with VISPREP -pp
+                std::cout << "Open space at " << plan.openPoint.x << "," << plan.openPoint.y << "\n" << std::flush;
+            }
+        }
+        }
+        writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
+    }
 }
@@ -29,25 +29,33 @@
 #include "linkparser.h"
 #include "importparser.h"
 #include "stepdepthparser.h"
+#include "generateparser.h"
 #include "salalib/isovistdef.h"
+#include "genlib/trace.h"
 #include <vector>
 
 #define CONCAT_(x,y) x##y
 #define CONCAT(x,y) CONCAT_(x,y)
 #define DO_TIMED(message, code)\
     SimpleTimer CONCAT(t_, __LINE__); \
+    depthmapX::TracePhase CONCAT(p_, __LINE__)(message); \
     code; \
+    CONCAT(p_, __LINE__).end(); \
     perfWriter.addData(message, CONCAT(t_, __LINE__).getTimeInSeconds());
 
 class Line;
 class Point2f;
 
 namespace dm_runmethods{
-    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter);
+    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter, bool lazy = false);
+    // the graph a mode runs on, either the one a pipeline keeps in memory or the one read from -f
+    std::shared_ptr<MetaGraph> loadGraph(const CommandLineParser &clp, IPerformanceSink &perfWriter, bool lazy = false);
+    // writes the graph out, unless it is a pipeline's, which only writes it at checkpoints and the end
+    void writeGraph(const CommandLineParser &clp, MetaGraph &graph, const std::string &filename, IPerformanceSink &perfWriter);
     void importFiles(const CommandLineParser &cmdP, const ImportParser &parser, IPerformanceSink &perfWriter);
     void linkGraph(const CommandLineParser &cmdP, const LinkParser &parser, IPerformanceSink &perfWriter );
     void runVga(const CommandLineParser &cmdP, const VgaParser &vgaP, const IRadiusConverter &converter, IPerformanceSink &perfWriter );
-    void runVisualPrep(const CommandLineParser &clp, double gridSize, const std::vector<Point2f> &fillPoints, double maxVisibility, bool boundaryGraph, bool makeGraph, bool unmakeGraph, bool removeLinksWhenUnmaking, IPerformanceSink &perfWriter);
+    void runVisualPrep(const CommandLineParser &clp, double gridSize, const std::vector<Point2f> &fillPoints, double maxVisibility, bool boundaryGraph, bool makeGraph, bool unmakeGraph, bool removeLinksWhenUnmaking, size_t memoryBudget, IPerformanceSink &perfWriter);
     void runAxialAnalysis(const CommandLineParser& clp, const AxialParser &ap, IPerformanceSink &perfWriter);
     void runSegmentAnalysis(const CommandLineParser& clp, const SegmentParser &sp, IPerformanceSink &perfWriter);
     void runAgentAnalysis(const CommandLineParser &cmdP, const AgentParser &agentP, IPerformanceSink &perfWriter );
@@ -55,4 +63,5 @@ namespace dm_runmethods{
     void exportData(const CommandLineParser &cmdP, const ExportParser &exportP, IPerformanceSink &perfWriter );
     void runStepDepth(const CommandLineParser &clp, const StepDepthParser::StepType &stepType, const std::vector<Point2f> &stepDepthPoints, IPerformanceSink &perfWriter);
     void runMapConversion(const CommandLineParser& clp, const MapConvertParser &mcp, IPerformanceSink &perfWriter);
+    void generatePlan(const CommandLineParser &clp, const GenerateParser &gp, IPerformanceSink &perfWriter);
 }
@@ -0,0 +1,73 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "serverparser.h"
+#include "analysisserver.h"
+#include "exceptions.h"
+#include "parsingutils.h"
+#include "salalib/mgraph.h"
+#include <cstring>
+#include <iostream>
+
+using namespace depthmapX;
+
+void ServerParser::parse(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp("-sg", argv[i]) == 0)
+        {
+            ENFORCE_ARGUMENT("-sg", i)
+            m_graphFiles.push_back(argv[i]);
+        }
+        else if (std::strcmp("-ss", argv[i]) == 0)
+        {
+            if (!m_socketPath.empty())
+            {
+                throw CommandLineException("-ss can only be used once");
+            }
+            ENFORCE_ARGUMENT("-ss", i)
+            m_socketPath = argv[i];
+        }
+    }
+}
+
+void ServerParser::run(const CommandLineParser &clp, IPerformanceSink &) const
+{
+    AnalysisServer server(clp.getThreadCount());
+
+    // the standard output is kept for the responses
+    std::vector<std::string> files = {clp.getFileName()};
+    files.insert(files.end(), m_graphFiles.begin(), m_graphFiles.end());
+    for (auto &file : files)
+    {
+        std::string name = AnalysisServer::graphName(file);
+        std::cerr << "Loading graph " << file << " as " << name << std::flush;
+        server.addGraph(name, AnalysisServer::readGraph(file), file == clp.getFileName() ? clp.getOuputFile() : "");
+        std::cerr << " ok" << std::endl;
+    }
+
+    if (m_socketPath.empty())
+    {
+        std::cerr << "Serving requests from the standard input" << std::endl;
+        server.serve(std::cin, std::cout);
+    }
+    else
+    {
+        std::cerr << "Serving requests on " << m_socketPath << std::endl;
+        server.serveSocket(m_socketPath);
+    }
+    std::cerr << "Server stopped" << std::endl;
+}
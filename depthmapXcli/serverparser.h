@@ -0,0 +1,54 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "imodeparser.h"
+#include "commandlineparser.h"
+#include <string>
+#include <vector>
+
+class ServerParser : public IModeParser
+{
+public:
+    virtual std::string getModeName() const
+    {
+        return "SERVER";
+    }
+
+    virtual std::string getHelp() const
+    {
+        return  "Mode options for SERVER:\n"\
+                "   Keeps the graph read from -f in memory and answers requests about it, each a JSON\n"\
+                "   object on a line of its own, until the input ends or a shutdown request comes in.\n"\
+                "   Responses go to the standard output, anything else to the standard error. A save\n"\
+                "   request without a file writes the graph to -o\n"\
+                "   -sg <graph file> another graph to serve, named after its file without the extension.\n"\
+                "       Can be repeated\n"\
+                "   -ss <socket path> take requests from clients connecting to a UNIX domain socket made\n"\
+                "       at the path instead of from the standard input\n";
+    }
+
+public:
+    virtual void parse(int argc, char *argv[]);
+    virtual void run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const;
+
+    const std::vector<std::string> &getGraphFiles() const { return m_graphFiles; }
+    const std::string &getSocketPath() const { return m_socketPath; }
+
+private:
+    std::vector<std::string> m_graphFiles;
+    std::string m_socketPath;
+};
@@ -27,7 +27,7 @@ public:
     double getTimeInSeconds() const
     {
          auto t2 = std::chrono::high_resolution_clock::now();
-        return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(t2-m_startTime).count()) / 1000.0;
+        return std::chrono::duration<double>(t2-m_startTime).count();
     }
 
     void reset()
@@ -17,6 +17,7 @@
 #include "exceptions.h"
 #include "parsingutils.h"
 #include "salalib/entityparsing.h"
+#include "salalib/graphmemory.h"
 #include "runmethods.h"
 #include <sstream>
 #include <cstring>
@@ -123,6 +124,22 @@ void VisPrepParser::parse(int argc, char ** argv)
         {
             m_removeLinksWhenUnmaking = true;
         }
+        else if ( std::strcmp("--memory-budget", argv[i]) == 0 )
+        {
+            ENFORCE_ARGUMENT("--memory-budget", i)
+            try
+            {
+                m_memoryBudget = parseBytes(argv[i]);
+            }
+            catch (depthmapX::RuntimeException &)
+            {
+                m_memoryBudget = 0;
+            }
+            if (m_memoryBudget == 0)
+            {
+                throw CommandLineException(std::string("--memory-budget must be a size such as 512M or 4G, got ") + argv[i]);
+            }
+        }
     }
 
     if(!getMakeGraph() && !getUnmakeGraph() && m_grid <= 0 && pointFile.empty() && points.empty())
@@ -169,9 +186,13 @@ void VisPrepParser::parse(int argc, char ** argv)
     if(m_removeLinksWhenUnmaking && !m_unmakeGraph) {
         throw CommandLineException("-pl can only be used together with -pu");
     }
+
+    if(m_memoryBudget > 0 && !m_makeGraph) {
+        throw CommandLineException("--memory-budget can only be used together with -pm");
+    }
 }
 
 void VisPrepParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
 {
-    dm_runmethods::runVisualPrep(clp, m_grid, m_fillPoints, m_maxVisibility, m_boundaryGraph, m_makeGraph, m_unmakeGraph, m_removeLinksWhenUnmaking, perfWriter);
+    dm_runmethods::runVisualPrep(clp, m_grid, m_fillPoints, m_maxVisibility, m_boundaryGraph, m_makeGraph, m_unmakeGraph, m_removeLinksWhenUnmaking, m_memoryBudget, perfWriter);
 }
@@ -22,7 +22,7 @@
 class VisPrepParser : public IModeParser
 {
 public:
-    VisPrepParser() : m_grid(-1.0), m_maxVisibility(-1.0), m_boundaryGraph(false), m_makeGraph(false), m_unmakeGraph(false), m_removeLinksWhenUnmaking(false)
+    VisPrepParser() : m_grid(-1.0), m_maxVisibility(-1.0), m_boundaryGraph(false), m_makeGraph(false), m_unmakeGraph(false), m_removeLinksWhenUnmaking(false), m_memoryBudget(0)
     {}
 
     virtual std::string getModeName() const
@@ -41,7 +41,10 @@ public:
                "  -pb Make boundary graph\n" \
                "  -pm Make graph\n" \
                "  -pu Unmake graph\n" \
-               "  -pl Remove links when unmaking\n";
+               "  -pl Remove links when unmaking\n" \
+               "  --memory-budget <size> estimate the memory the graph and its analyses will need before\n" \
+               "      making it (with -pm), and make it compact or refuse to if that is more than <size>\n" \
+               "      (in bytes, or with K, M, G after it)\n";
     }
 
     virtual void parse(int argc, char** argv);
@@ -55,6 +58,8 @@ public:
     bool getMakeGraph() const { return m_makeGraph; }
     bool getUnmakeGraph() const { return m_unmakeGraph; }
     bool getRemoveLinksWhenUnmaking() const { return m_removeLinksWhenUnmaking; }
+    // 0 when not given
+    size_t getMemoryBudget() const { return m_memoryBudget; }
 
 private:
     double m_grid;
@@ -64,6 +69,7 @@ private:
     bool m_makeGraph;
     bool m_unmakeGraph;
     bool m_removeLinksWhenUnmaking;
+    size_t m_memoryBudget;
 };
 
 
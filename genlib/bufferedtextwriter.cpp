@@ -0,0 +1,82 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bufferedtextwriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace depthmapX {
+
+    namespace {
+        // room for any float or double formatted as %g, at any precision the exports use
+        const size_t FLOATING_SIZE = 64;
+    }
+
+    BufferedTextWriter::BufferedTextWriter() {}
+
+    BufferedTextWriter::BufferedTextWriter(std::ostream &stream, size_t capacity)
+        : m_stream(&stream), m_capacity(std::max(capacity, FLOATING_SIZE)), m_precision(int(stream.precision())) {
+        m_buffer.resize(m_capacity + FLOATING_SIZE);
+    }
+
+    BufferedTextWriter::BufferedTextWriter(BufferedTextWriter &&other)
+        : m_stream(other.m_stream), m_capacity(other.m_capacity), m_buffer(std::move(other.m_buffer)),
+          m_size(other.m_size), m_precision(other.m_precision) {
+        other.m_stream = nullptr;
+        other.m_size = 0;
+    }
+
+    BufferedTextWriter &BufferedTextWriter::operator=(BufferedTextWriter &&other) {
+        if (this != &other) {
+            flush();
+            m_stream = other.m_stream;
+            m_capacity = other.m_capacity;
+            m_buffer = std::move(other.m_buffer);
+            m_size = other.m_size;
+            m_precision = other.m_precision;
+            other.m_stream = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    BufferedTextWriter::~BufferedTextWriter() { flush(); }
+
+    void BufferedTextWriter::flush() {
+        if (m_stream && m_size != 0) {
+            m_stream->write(m_buffer.data(), std::streamsize(m_size));
+            m_size = 0;
+        }
+    }
+
+    void BufferedTextWriter::grow(size_t size) { m_buffer.resize(std::max(m_buffer.size() * 2, m_size + size)); }
+
+    BufferedTextWriter &BufferedTextWriter::floating(double value) {
+        int precision = std::min(m_precision, 17);
+        char *first = reserve(FLOATING_SIZE);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        m_size += size_t(std::to_chars(first, first + FLOATING_SIZE, value, std::chars_format::general, precision).ptr -
+                         first);
+#else
+        // standard libraries without floating point to_chars (e.g. libc++ for older macOS) fall back to
+        // printf, which gives the same
+        m_size += size_t(std::snprintf(first, FLOATING_SIZE, "%.*g", precision, value));
+#endif
+        return written();
+    }
+} // namespace depthmapX
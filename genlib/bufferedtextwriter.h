@@ -0,0 +1,170 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     *  Formats text into a large buffer that is written to the stream in blocks, or kept in memory if
+     *  there is no stream. Numbers are formatted with std::to_chars, giving exactly what the stream's
+     *  operator<< gives with its default flags (floats as %g at the precision set, 6 to start with, up
+     *  to the 17 digits a double holds), but without the locale and sentry work operator<< does for
+     *  every value
+     */
+    class BufferedTextWriter {
+      public:
+        // a writer that only keeps the text in memory
+        BufferedTextWriter();
+        // a writer to the stream, taking its precision from it
+        BufferedTextWriter(std::ostream &stream, size_t capacity = 1 << 20);
+        ~BufferedTextWriter();
+
+        BufferedTextWriter(const BufferedTextWriter &) = delete;
+        BufferedTextWriter &operator=(const BufferedTextWriter &) = delete;
+        // the moved from writer is left without a stream or text, so that it has nothing to flush
+        BufferedTextWriter(BufferedTextWriter &&other);
+        BufferedTextWriter &operator=(BufferedTextWriter &&other);
+
+        BufferedTextWriter &operator<<(char value) {
+            *reserve(1) = value;
+            m_size++;
+            return written();
+        }
+        BufferedTextWriter &operator<<(const char *value) { return append(value, std::strlen(value)); }
+        BufferedTextWriter &operator<<(const std::string &value) { return append(value.data(), value.size()); }
+        BufferedTextWriter &operator<<(int value) { return integer(value); }
+        BufferedTextWriter &operator<<(long value) { return integer(value); }
+        BufferedTextWriter &operator<<(long long value) { return integer(value); }
+        BufferedTextWriter &operator<<(unsigned int value) { return integer(value); }
+        BufferedTextWriter &operator<<(unsigned long value) { return integer(value); }
+        BufferedTextWriter &operator<<(unsigned long long value) { return integer(value); }
+        BufferedTextWriter &operator<<(float value) { return floating(value); }
+        BufferedTextWriter &operator<<(double value) { return floating(value); }
+
+        BufferedTextWriter &append(const char *data, size_t size) {
+            if (size != 0) {
+                std::memcpy(reserve(size), data, size);
+                m_size += size;
+            }
+            return written();
+        }
+
+        void setPrecision(int precision) { m_precision = precision; }
+        int getPrecision() const { return m_precision; }
+
+        const char *data() const { return m_buffer.data(); }
+        size_t size() const { return m_size; }
+        void clear() { m_size = 0; }
+
+        // writes out whatever is in the buffer (nothing to do without a stream)
+        void flush();
+
+        // Writes rows of cells, the cells separated by the delimiter and the rows ended by a newline,
+        // format(row, column, writer) writing a cell to the writer it is given. Tables with enough
+        // columns to be worth it are formatted a block of rows at a time with the columns spread over
+        // the threads, each into a buffer of its own, and the cells then joined up row by row
+        template <typename Format>
+        void writeRows(size_t rowCount, size_t columnCount, char delimiter, Format format,
+                       size_t threadCount = getThreadCount());
+
+      private:
+        std::ostream *m_stream = nullptr;
+        size_t m_capacity = 0;
+        std::vector<char> m_buffer;
+        size_t m_size = 0;
+        int m_precision = 6;
+
+        static constexpr size_t PARALLEL_MIN_COLUMNS = 8;
+        static constexpr size_t PARALLEL_BLOCK_ROWS = 4096;
+
+        char *reserve(size_t size) {
+            if (m_size + size > m_buffer.size()) {
+                grow(size);
+            }
+            return m_buffer.data() + m_size;
+        }
+        void grow(size_t size);
+        BufferedTextWriter &written() {
+            if (m_stream && m_size >= m_capacity) {
+                flush();
+            }
+            return *this;
+        }
+        template <typename T> BufferedTextWriter &integer(T value);
+        BufferedTextWriter &floating(double value);
+    };
+
+    template <typename T> BufferedTextWriter &BufferedTextWriter::integer(T value) {
+        // enough for any 64 bit integer and its sign
+        char *first = reserve(24);
+        m_size += size_t(std::to_chars(first, first + 24, value).ptr - first);
+        return written();
+    }
+
+    template <typename Format>
+    void BufferedTextWriter::writeRows(size_t rowCount, size_t columnCount, char delimiter, Format format,
+                                       size_t threadCount) {
+        if (threadCount <= 1 || columnCount < PARALLEL_MIN_COLUMNS || rowCount < 2) {
+            for (size_t row = 0; row < rowCount; row++) {
+                for (size_t column = 0; column < columnCount; column++) {
+                    if (column != 0) {
+                        *this << delimiter;
+                    }
+                    format(row, column, *this);
+                }
+                *this << '\n';
+            }
+            return;
+        }
+
+        std::vector<BufferedTextWriter> columns(columnCount);
+        std::vector<std::vector<size_t>> cellEnds(columnCount);
+        for (size_t blockStart = 0; blockStart < rowCount; blockStart += PARALLEL_BLOCK_ROWS) {
+            size_t blockRows = std::min(PARALLEL_BLOCK_ROWS, rowCount - blockStart);
+            parallelFor(columnCount, threadCount, [&](size_t column, size_t) {
+                BufferedTextWriter &cells = columns[column];
+                std::vector<size_t> &ends = cellEnds[column];
+                cells.clear();
+                cells.setPrecision(m_precision);
+                ends.resize(blockRows);
+                for (size_t row = 0; row < blockRows; row++) {
+                    format(blockStart + row, column, cells);
+                    ends[row] = cells.size();
+                }
+            });
+            for (size_t row = 0; row < blockRows; row++) {
+                for (size_t column = 0; column < columnCount; column++) {
+                    if (column != 0) {
+                        *this << delimiter;
+                    }
+                    size_t start = row == 0 ? 0 : cellEnds[column][row - 1];
+                    append(columns[column].data() + start, cellEnds[column][row] - start);
+                }
+                *this << '\n';
+            }
+        }
+    }
+} // namespace depthmapX
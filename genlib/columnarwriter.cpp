@@ -0,0 +1,123 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "columnarwriter.h"
+
+#include "exceptions.h"
+
+namespace depthmapX {
+
+    namespace {
+        const char MAGIC[8] = {'D', 'X', 'C', 'O', 'L', '0', '0', '1'};
+    }
+
+    ColumnarWriter::ColumnarWriter(std::ostream &stream, size_t chunkRows)
+        : m_stream(stream), m_chunkRows(chunkRows == 0 ? 1 : chunkRows) {}
+
+    void ColumnarWriter::addColumn(const std::string &name, Type type) {
+        if (m_started) {
+            throw RuntimeException("Columns can not be added once values have been");
+        }
+        m_columns.push_back(Column{name, type, std::vector<char>()});
+    }
+
+    void ColumnarWriter::append(const void *value, size_t size, Type type) {
+        if (m_finished || m_columns.empty()) {
+            throw RuntimeException("No columns to add values to");
+        }
+        // checked before anything is written, so that a rejected value leaves the stream as it was
+        Column &column = m_columns[m_nextColumn];
+        if (column.type != type) {
+            throw RuntimeException("Value of the wrong type for column " + column.name);
+        }
+        if (!m_started) {
+            writeSchema();
+        }
+        const char *bytes = static_cast<const char *>(value);
+        column.values.insert(column.values.end(), bytes, bytes + size);
+        if (++m_nextColumn == m_columns.size()) {
+            m_nextColumn = 0;
+            m_rowCount++;
+            if (++m_chunkRowCount == m_chunkRows) {
+                writeChunk();
+            }
+        }
+    }
+
+    void ColumnarWriter::finish() {
+        if (m_finished) {
+            return;
+        }
+        if (m_nextColumn != 0) {
+            throw RuntimeException("The last row is not complete");
+        }
+        if (!m_started) {
+            writeSchema();
+        }
+        writeChunk();
+        int64_t footerStart = m_position;
+        int64_t endOfChunks = -1;
+        write(&endOfChunks, sizeof(endOfChunks));
+        int64_t chunkCount = int64_t(m_chunkOffsets.size());
+        write(&chunkCount, sizeof(chunkCount));
+        write(m_chunkOffsets.data(), m_chunkOffsets.size() * sizeof(int64_t));
+        int64_t rowCount = int64_t(m_rowCount);
+        write(&rowCount, sizeof(rowCount));
+        uint32_t footerLength = uint32_t(m_position - footerStart);
+        write(&footerLength, sizeof(footerLength));
+        write(MAGIC, sizeof(MAGIC));
+        m_finished = true;
+    }
+
+    void ColumnarWriter::writeSchema() {
+        m_started = true;
+        write(MAGIC, sizeof(MAGIC));
+        uint32_t columnCount = uint32_t(m_columns.size());
+        write(&columnCount, sizeof(columnCount));
+        for (const Column &column : m_columns) {
+            write(&column.type, sizeof(column.type));
+            uint32_t length = uint32_t(column.name.size());
+            write(&length, sizeof(length));
+            write(column.name.data(), column.name.size());
+        }
+        pad();
+    }
+
+    void ColumnarWriter::writeChunk() {
+        if (m_chunkRowCount == 0) {
+            return;
+        }
+        m_chunkOffsets.push_back(m_position);
+        int64_t rowCount = int64_t(m_chunkRowCount);
+        write(&rowCount, sizeof(rowCount));
+        for (Column &column : m_columns) {
+            write(column.values.data(), column.values.size());
+            pad();
+            column.values.clear();
+        }
+        m_chunkRowCount = 0;
+    }
+
+    void ColumnarWriter::write(const void *data, size_t size) {
+        m_stream.write(static_cast<const char *>(data), std::streamsize(size));
+        m_position += int64_t(size);
+    }
+
+    void ColumnarWriter::pad() {
+        const char zeros[8] = {0};
+        write(zeros, size_t((8 - m_position % 8) % 8));
+    }
+} // namespace depthmapX
@@ -0,0 +1,84 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     *  Writes a table as typed binary columns, in the manner of Arrow's IPC file format (but without its
+     *  flatbuffer metadata, so that nothing outside the project is needed to write it):
+     *
+     *    "DXCOL001"                                  8 byte magic
+     *    schema    uint32 column count, then for each column a uint8 type, uint32 name length and the name
+     *    chunks    int64 row count, then for each column its values, padded to 8 bytes, each chunk starting
+     *              8-byte aligned
+     *    footer    int64 -1 (end of chunks), int64 chunk count, the int64 offset of each chunk from the
+     *              start, int64 total row count
+     *    uint32 footer length, "DXCOL001"
+     *
+     *  Everything is little endian (as it is written on the platforms we build for). Rows are given a
+     *  value at a time, in column order, and every chunk of rows is written out as it fills up
+     */
+    class ColumnarWriter {
+      public:
+        enum class Type : uint8_t { INT32 = 1, FLOAT32 = 2, FLOAT64 = 3 };
+
+        ColumnarWriter(std::ostream &stream, size_t chunkRows = 65536);
+
+        // all the columns have to be added before the first value
+        void addColumn(const std::string &name, Type type);
+
+        void add(int32_t value) { append(&value, sizeof(value), Type::INT32); }
+        void add(float value) { append(&value, sizeof(value), Type::FLOAT32); }
+        void add(double value) { append(&value, sizeof(value), Type::FLOAT64); }
+
+        // writes the last chunk and the footer, nothing can be added after
+        void finish();
+
+        size_t getRowCount() const { return m_rowCount; }
+
+      private:
+        struct Column {
+            std::string name;
+            Type type;
+            std::vector<char> values;
+        };
+
+        std::ostream &m_stream;
+        size_t m_chunkRows;
+        std::vector<Column> m_columns;
+        size_t m_nextColumn = 0;
+        size_t m_chunkRowCount = 0;
+        size_t m_rowCount = 0;
+        bool m_started = false;
+        bool m_finished = false;
+        int64_t m_position = 0;
+        std::vector<int64_t> m_chunkOffsets;
+
+        void append(const void *value, size_t size, Type type);
+        void writeSchema();
+        void writeChunk();
+        void write(const void *data, size_t size);
+        void pad();
+    };
+} // namespace depthmapX
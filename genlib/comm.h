@@ -20,6 +20,7 @@
 #include <fstream>
 #include <string>
 #include <chrono>
+#include <atomic>
 #include <sys/types.h>
 #include <vector>
 
@@ -66,7 +67,7 @@ class Communicator {
     enum { NUM_STEPS, CURRENT_STEP, NUM_RECORDS, CURRENT_RECORD };
 
   protected:
-    bool m_cancelled;
+    std::atomic<bool> m_cancelled;
     bool m_delete_flag;
     // nb. converted to Win32 UTF-16 Unicode path (AT 31.01.11) Linux, MacOS use UTF-8 (AT 29.04.11)
     std::string m_infilename;
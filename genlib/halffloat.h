@@ -0,0 +1,90 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace depthmapX {
+
+    // conversion between float and IEEE 754 half precision (binary16) floats, kept as their bits in a
+    // uint16_t. Converting to half rounds to the nearest (ties to even), values too large become infinite
+
+    inline uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = uint16_t((bits >> 16) & 0x8000u);
+        uint32_t exponent = (bits >> 23) & 0xFFu;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent == 0xFFu) {
+            // infinity, or NaN (keeping it a NaN)
+            return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u | (mantissa >> 13) : 0u));
+        }
+        int halfExponent = int(exponent) - 127 + 15;
+        if (halfExponent >= 0x1F) {
+            return uint16_t(sign | 0x7C00u);
+        }
+        if (halfExponent <= 0) {
+            // subnormal in half precision (or too small altogether)
+            if (halfExponent < -10) {
+                return sign;
+            }
+            mantissa |= 0x800000u;
+            int shift = 14 - halfExponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+                half++;
+            }
+            return uint16_t(sign | half);
+        }
+        uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+            // may carry into the exponent, up to infinity, which is what rounding should give
+            half++;
+        }
+        return uint16_t(sign | half);
+    }
+
+    inline float halfToFloat(uint16_t half) {
+        uint32_t sign = uint32_t(half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        uint32_t bits;
+        if (exponent == 0x1Fu) {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // subnormal half, normalise it
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+} // namespace depthmapX
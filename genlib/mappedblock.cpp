@@ -0,0 +1,135 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "mappedblock.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace depthmapX {
+
+    std::shared_ptr<MappedBlock> MappedBlock::map(const std::string &filename, int64_t offset, size_t size) {
+#ifndef _WIN32
+        if (filename.empty() || offset < 0 || size == 0) {
+            return nullptr;
+        }
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return nullptr;
+        }
+        struct stat status;
+        if (::fstat(fd, &status) != 0 || int64_t(status.st_size) < offset + int64_t(size)) {
+            ::close(fd);
+            return nullptr;
+        }
+        // mappings have to start at a page boundary
+        int64_t pageSize = ::sysconf(_SC_PAGESIZE);
+        int64_t mappingOffset = offset - offset % pageSize;
+        size_t mappingSize = size_t(offset - mappingOffset) + size;
+        void *mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, off_t(mappingOffset));
+        // the mapping stays valid once the file is closed
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return nullptr;
+        }
+        std::shared_ptr<MappedBlock> block(new MappedBlock());
+        block->m_mapping = mapping;
+        block->m_mappingSize = mappingSize;
+        block->m_data = static_cast<const char *>(mapping) + (offset - mappingOffset);
+        block->m_size = size;
+        block->m_device = uint64_t(status.st_dev);
+        block->m_inode = uint64_t(status.st_ino);
+        return block;
+#else
+        return nullptr;
+#endif
+    }
+
+    std::shared_ptr<MappedBlock> MappedBlock::mapFile(const std::string &filename) {
+#ifndef _WIN32
+        struct stat status;
+        if (filename.empty() || ::stat(filename.c_str(), &status) != 0) {
+            return nullptr;
+        }
+        return map(filename, 0, size_t(status.st_size));
+#else
+        return nullptr;
+#endif
+    }
+
+    std::shared_ptr<MappedBlock> MappedBlock::read(std::istream &stream, size_t size) {
+        std::shared_ptr<MappedBlock> block(new MappedBlock());
+        block->m_buffer.resize(size);
+        stream.read(block->m_buffer.data(), std::streamsize(size));
+        if (stream.fail()) {
+            return nullptr;
+        }
+        block->m_data = block->m_buffer.data();
+        block->m_size = size;
+        return block;
+    }
+
+    std::shared_ptr<MappedBlock> MappedBlock::readAll(std::istream &stream) {
+        std::shared_ptr<MappedBlock> block(new MappedBlock());
+        const size_t chunkSize = 1 << 20;
+        size_t size = 0;
+        while (stream.good()) {
+            block->m_buffer.resize(size + chunkSize);
+            stream.read(block->m_buffer.data() + size, std::streamsize(chunkSize));
+            size += size_t(stream.gcount());
+        }
+        block->m_buffer.resize(size);
+        block->m_data = block->m_buffer.data();
+        block->m_size = size;
+        return block;
+    }
+
+    MappedBlock::~MappedBlock() {
+#ifndef _WIN32
+        if (m_mapping != nullptr) {
+            ::munmap(m_mapping, m_mappingSize);
+        }
+#endif
+    }
+
+    bool MappedBlock::isMappedFrom(const std::string &filename) const {
+#ifndef _WIN32
+        struct stat status;
+        if (m_mapping == nullptr || ::stat(filename.c_str(), &status) != 0) {
+            return false;
+        }
+        return uint64_t(status.st_dev) == m_device && uint64_t(status.st_ino) == m_inode;
+#else
+        return false;
+#endif
+    }
+
+    bool replaceFile(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+} // namespace depthmapX
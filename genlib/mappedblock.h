@@ -0,0 +1,71 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     *  A read-only block of a file held in memory, either mapped straight from the file (so that its pages
+     *  are only loaded when touched and are shared between processes mapping the same file) or, where that
+     *  is not possible, read into memory. Whatever points into it is only valid for as long as it is alive
+     */
+    class MappedBlock {
+      public:
+        // maps size bytes of the file from offset, nullptr if the file can not be mapped
+        static std::shared_ptr<MappedBlock> map(const std::string &filename, int64_t offset, size_t size);
+        // maps the whole file, nullptr if the file can not be mapped (or is empty)
+        static std::shared_ptr<MappedBlock> mapFile(const std::string &filename);
+        // reads the next size bytes of the stream, nullptr if they could not be read
+        static std::shared_ptr<MappedBlock> read(std::istream &stream, size_t size);
+        // reads the rest of the stream
+        static std::shared_ptr<MappedBlock> readAll(std::istream &stream);
+
+        ~MappedBlock();
+        MappedBlock(const MappedBlock &) = delete;
+        MappedBlock &operator=(const MappedBlock &) = delete;
+
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+        bool isMapped() const { return m_mapping != nullptr; }
+        // whether this is mapped from the file given (under whatever name), which then must not be
+        // written over in place while this is alive, only replaced
+        bool isMappedFrom(const std::string &filename) const;
+
+      private:
+        MappedBlock() {}
+
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+        // the whole mapping, which starts at a page boundary before the block
+        void *m_mapping = nullptr;
+        size_t m_mappingSize = 0;
+        uint64_t m_device = 0;
+        uint64_t m_inode = 0;
+        std::vector<char> m_buffer;
+    };
+
+    // moves the file from over the file to, so that at any time there is either the old file or the new one
+    // under that name, never neither or half of one. Blocks mapped from the old file stay valid, where
+    // writing over it in place would pull the pages from under them (in this process or any other)
+    bool replaceFile(const std::string &from, const std::string &to);
+} // namespace depthmapX
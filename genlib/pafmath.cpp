@@ -48,9 +48,41 @@ void pafsrand(unsigned int seed, int set) // = 0
 
 unsigned int pafrand(int set) // = 0
 {
-    g_rand[set] = g_mult * g_rand[set] + g_const;
+    return pafrand_r(g_rand[set]);
+}
+
+uint64_t pafrandstate(int set) // = 0
+{
+    return g_rand[set];
+}
+
+void pafsetrandstate(uint64_t state, int set) // = 0
+{
+    g_rand[set] = state;
+}
+
+// moving on n steps is applying the generator n times, i.e. state * mult^n + const * (mult^(n-1) + ... + 1),
+// which is built up by squaring in the same way as a fast power
+
+uint64_t pafrandskip(uint64_t state, uint64_t steps) {
+    uint64_t mult = g_mult, add = g_const;
+    uint64_t totalmult = 1, totaladd = 0;
+    while (steps > 0) {
+        if (steps & 1) {
+            totalmult *= mult;
+            totaladd = totaladd * mult + add;
+        }
+        add *= mult + 1;
+        mult *= mult;
+        steps >>= 1;
+    }
+    return totalmult * state + totaladd;
+}
+
+unsigned int pafrand_r(uint64_t &state) {
+    state = g_mult * state + g_const;
 
-    return (unsigned int)((g_rand[set] >> 32) & PAF_RAND_MAX);
+    return (unsigned int)((state >> 32) & PAF_RAND_MAX);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
@@ -48,6 +49,14 @@ const unsigned int PAF_RAND_MAX = 0x0FFFFFFF;
 void pafsrand(unsigned int seed, int set = 0);
 unsigned int pafrand(int set = 0);
 
+// the state of a random number set can be taken out and continued with pafrand_r,
+// for example to hand each thread its own part of the sequence (moved on with pafrandskip)
+// so that the numbers drawn are the same as if they were drawn one after the other
+uint64_t pafrandstate(int set = 0);
+void pafsetrandstate(uint64_t state, int set = 0);
+uint64_t pafrandskip(uint64_t state, uint64_t steps);
+unsigned int pafrand_r(uint64_t &state);
+
 // a random number from 0 to 1
 inline double prandom(int set = 0) { return double(pafrand(set)) / double(PAF_RAND_MAX); }
 
@@ -0,0 +1,140 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "genlib/parallel.h"
+
+namespace depthmapX {
+
+    namespace {
+        std::atomic<size_t> s_threadCount(0);
+        thread_local size_t t_threadCount = 0;
+    } // namespace
+
+    size_t getThreadCount() {
+        if (t_threadCount > 0) {
+            return t_threadCount;
+        }
+        size_t threadCount = s_threadCount;
+        if (threadCount > 0) {
+            return threadCount;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void setThreadCount(size_t threadCount) { s_threadCount = threadCount; }
+
+    ScopedThreadCount::ScopedThreadCount(size_t threadCount) : m_previous(t_threadCount) {
+        if (threadCount > 0) {
+            t_threadCount = threadCount;
+        }
+    }
+
+    ScopedThreadCount::~ScopedThreadCount() { t_threadCount = m_previous; }
+
+    ThreadPool &ThreadPool::global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::getWorkerCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_workers.size();
+    }
+
+    void ThreadPool::run(size_t slotCount, const std::function<void(size_t)> &task) {
+        if (slotCount <= 1) {
+            task(0);
+            return;
+        }
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->task = &task;
+        job->slotCount = slotCount;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // the pool only grows to what it has been asked for
+            while (m_workers.size() + 1 < slotCount) {
+                m_workers.emplace_back(&ThreadPool::work, this);
+            }
+            m_jobs.push_back(job);
+        }
+        m_wake.notify_all();
+
+        runSlot(*job, 0);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (job->nextSlot < job->slotCount) {
+            size_t slot = takeSlot(job);
+            lock.unlock();
+            runSlot(*job, slot);
+            lock.lock();
+        }
+        job->finished.wait(lock, [&job]() { return job->running == 0; });
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+    }
+
+    size_t ThreadPool::takeSlot(const std::shared_ptr<Job> &job) {
+        size_t slot = job->nextSlot++;
+        if (job->nextSlot == job->slotCount) {
+            m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), job));
+        }
+        job->running++;
+        return slot;
+    }
+
+    void ThreadPool::runSlot(Job &job, size_t slot) {
+        std::exception_ptr error;
+        try {
+            (*job.task)(slot);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error && !job.error) {
+            job.error = error;
+        }
+        // the calling thread runs slot 0 without counting it, as it is the one waiting
+        if (slot > 0 && --job.running == 0) {
+            job.finished.notify_all();
+        }
+    }
+
+    void ThreadPool::work() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return;
+            }
+            std::shared_ptr<Job> job = m_jobs.front();
+            size_t slot = takeSlot(job);
+            lock.unlock();
+            runSlot(*job, slot);
+            lock.lock();
+        }
+    }
+} // namespace depthmapX
@@ -0,0 +1,153 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "genlib/comm.h"
+#include "genlib/progressreporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace depthmapX {
+
+    // the number of threads an analysis should spread its work over: as set for the calling thread by
+    // the innermost ScopedThreadCount, otherwise as set by setThreadCount, otherwise as many as the
+    // machine has cores
+    size_t getThreadCount();
+    // 0 goes back to as many as the machine has cores
+    void setThreadCount(size_t threadCount);
+
+    // sets the thread count for whatever runs on the calling thread while it is in scope, so that an
+    // analysis can be given its own. 0 leaves the count as it was
+    class ScopedThreadCount {
+      public:
+        explicit ScopedThreadCount(size_t threadCount);
+        ~ScopedThreadCount();
+        ScopedThreadCount(const ScopedThreadCount &) = delete;
+        ScopedThreadCount &operator=(const ScopedThreadCount &) = delete;
+
+      private:
+        size_t m_previous;
+    };
+
+    /**
+     *  The threads all parallel work in depthmapX is run on, kept for the lifetime of the program
+     *  rather than started for each loop. A job is run as a number of slots at the same time, the
+     *  first on the calling thread and the others on whichever pool threads are free. Once done with
+     *  its own slot the calling thread takes back any slots no pool thread has got to yet, so a job
+     *  never waits on threads busy with other work, and jobs can be started from within jobs
+     */
+    class ThreadPool {
+      public:
+        static ThreadPool &global();
+
+        ThreadPool() = default;
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // calls task(slot) for every slot from 0 to slotCount - 1 and waits for all of them. The
+        // first exception thrown by a slot is rethrown here once they have all finished
+        void run(size_t slotCount, const std::function<void(size_t)> &task);
+
+        size_t getWorkerCount();
+
+      private:
+        struct Job {
+            const std::function<void(size_t)> *task;
+            size_t slotCount;
+            size_t nextSlot = 1;
+            size_t running = 0;
+            std::exception_ptr error;
+            std::condition_variable finished;
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<std::shared_ptr<Job>> m_jobs;
+        std::vector<std::thread> m_workers;
+        bool m_stopping = false;
+
+        void work();
+        // takes the next slot of the job, with the mutex locked
+        size_t takeSlot(const std::shared_ptr<Job> &job);
+        void runSlot(Job &job, size_t slot);
+    };
+
+    // calls func(index, thread) for every index from 0 to count - 1, spread over threadCount threads
+    // of the pool. Indices are handed out one at a time so that uneven work evens out. The calling
+    // thread takes part as thread 0, so it is the one to report progress or check for cancellation
+    // from. The first exception thrown stops any further indices being handed out and is rethrown here
+    template <typename Func> void parallelFor(size_t count, size_t threadCount, Func func) {
+        threadCount = std::max(size_t(1), std::min(threadCount, count));
+        std::atomic<size_t> next(0);
+        std::function<void(size_t)> worker = [&](size_t thread) {
+            try {
+                for (size_t index = next++; index < count; index = next++) {
+                    func(index, thread);
+                }
+            } catch (...) {
+                next = count;
+                throw;
+            }
+        };
+        if (threadCount == 1) {
+            worker(0);
+            return;
+        }
+        ThreadPool::global().run(threadCount, worker);
+    }
+
+    // as above, checking the communicator for cancellation before each index (throwing
+    // Communicator::CancelledException once the running indices are done) and reporting the number of
+    // indices done from all threads as the CURRENT_RECORD
+    template <typename Func> void parallelFor(size_t count, size_t threadCount, Communicator *comm, Func func) {
+        if (!comm) {
+            parallelFor(count, threadCount, func);
+            return;
+        }
+        ProgressReporter progress(comm);
+        parallelFor(count, threadCount, [&](size_t index, size_t thread) {
+            progress.checkCancelled();
+            func(index, thread);
+            progress.increment();
+        });
+    }
+
+    // combines func(index, total) for every index from 0 to count - 1, each thread adding to a total
+    // of its own started from init (which has to leave anything combined with it unchanged). The
+    // totals are combined in thread order, though which indices each thread took varies from run to run
+    template <typename T, typename Func, typename Combine>
+    T parallelReduce(size_t count, size_t threadCount, T init, Func func, Combine combine) {
+        threadCount = std::max(size_t(1), std::min(threadCount, count));
+        std::vector<T> totals(threadCount, init);
+        parallelFor(count, threadCount, [&](size_t index, size_t thread) { func(index, totals[thread]); });
+        T total = totals[0];
+        for (size_t thread = 1; thread < threadCount; thread++) {
+            total = combine(total, totals[thread]);
+        }
+        return total;
+    }
+} // namespace depthmapX
@@ -0,0 +1,51 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "genlib/progressreporter.h"
+
+#include <chrono>
+
+namespace depthmapX {
+
+    ProgressReporter::ProgressReporter(Communicator *comm, time_t interval) : m_comm(comm), m_done(0) {
+        if (m_comm) {
+            m_reporter = std::thread(&ProgressReporter::report, this, interval);
+        }
+    }
+
+    ProgressReporter::~ProgressReporter() {
+        if (m_reporter.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_stop.notify_one();
+            m_reporter.join();
+        }
+    }
+
+    void ProgressReporter::report(time_t interval) {
+        size_t reported = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop.wait_for(lock, std::chrono::milliseconds(interval), [this]() { return m_stopping; })) {
+            size_t done = getDone();
+            if (done != reported) {
+                reported = done;
+                m_comm->CommPostMessage(Communicator::CURRENT_RECORD, int(done));
+            }
+        }
+    }
+} // namespace depthmapX
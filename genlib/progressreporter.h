@@ -0,0 +1,65 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "genlib/comm.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace depthmapX {
+
+    /**
+     *  Reports the progress of an analysis loop to its communicator from a thread of its own, so that
+     *  the loop only has to keep a count and never looks at the clock. Every interval the reporter
+     *  posts the count as the CURRENT_RECORD if it has changed, the same message the loops used to
+     *  post themselves. Nothing is started without a communicator. The communicator gets no other
+     *  messages from the loop while the reporter exists, so post NUM_RECORDS before making one
+     */
+    class ProgressReporter {
+      public:
+        explicit ProgressReporter(Communicator *comm, time_t interval = 500);
+        ~ProgressReporter();
+        ProgressReporter(const ProgressReporter &) = delete;
+        ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+        // safe to call from any number of threads at once
+        void increment(size_t count = 1) { m_done.fetch_add(count, std::memory_order_relaxed); }
+        // for loops that keep their own count, from one thread only
+        void update(size_t done) { m_done.store(done, std::memory_order_relaxed); }
+        size_t getDone() const { return m_done.load(std::memory_order_relaxed); }
+
+        bool isCancelled() const { return m_comm && m_comm->IsCancelled(); }
+        void checkCancelled() const {
+            if (isCancelled()) {
+                throw Communicator::CancelledException();
+            }
+        }
+
+      private:
+        Communicator *m_comm;
+        std::atomic<size_t> m_done;
+        std::mutex m_mutex;
+        std::condition_variable m_stop;
+        bool m_stopping = false;
+        std::thread m_reporter;
+
+        void report(time_t interval);
+    };
+} // namespace depthmapX
@@ -0,0 +1,55 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     *  A view of a contiguous range of values owned by someone else, along the lines of C++20's std::span.
+     *  It is only valid for as long as the underlying storage is not resized or freed.
+     */
+    template <typename T> class Span {
+      public:
+        Span() : m_data(nullptr), m_size(0) {}
+        Span(T *data, size_t size) : m_data(data), m_size(size) {}
+        template <typename V> Span(std::vector<V> &vec) : m_data(vec.data()), m_size(vec.size()) {}
+        template <typename V> Span(const std::vector<V> &vec) : m_data(vec.data()), m_size(vec.size()) {}
+
+        T *data() const { return m_data; }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        T &operator[](size_t index) const { return m_data[index]; }
+        T &at(size_t index) const {
+            if (index >= m_size) {
+                throw std::out_of_range("Span index out of range");
+            }
+            return m_data[index];
+        }
+
+        T *begin() const { return m_data; }
+        T *end() const { return m_data + m_size; }
+
+      private:
+        T *m_data;
+        size_t m_size;
+    };
+} // namespace depthmapX
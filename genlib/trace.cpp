@@ -0,0 +1,178 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "trace.h"
+
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace depthmapX {
+
+    std::atomic<bool> Trace::s_enabled(false);
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+        using Counts = std::vector<std::pair<std::string, int64_t>>;
+
+        struct Phase {
+            std::string name;
+            double start;
+            double duration;
+            size_t peakMemory;
+            Counts counts;
+        };
+
+        // the phases of one thread, which only that thread adds to
+        struct ThreadTrace {
+            size_t id;
+            std::vector<Phase> open;
+            std::vector<Phase> done;
+        };
+
+        std::mutex threadsMutex;
+        // kept for as long as the process runs, as the threads point to theirs
+        std::vector<std::unique_ptr<ThreadTrace>> threads;
+        Clock::time_point origin = Clock::now();
+
+        ThreadTrace &threadTrace() {
+            thread_local ThreadTrace *trace = nullptr;
+            if (!trace) {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                threads.emplace_back(new ThreadTrace{threads.size(), {}, {}});
+                trace = threads.back().get();
+            }
+            return *trace;
+        }
+
+        double microsecondsSinceStart() {
+            return std::chrono::duration<double, std::micro>(Clock::now() - origin).count();
+        }
+
+        void writeString(std::ostream &stream, const std::string &value) {
+            stream << '"';
+            for (char c : value) {
+                if (c == '"' || c == '\\') {
+                    stream << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    stream << ' ';
+                } else {
+                    stream << c;
+                }
+            }
+            stream << '"';
+        }
+    } // namespace
+
+    void Trace::start() {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (auto &thread : threads) {
+            thread->open.clear();
+            thread->done.clear();
+        }
+        origin = Clock::now();
+        s_enabled = true;
+    }
+
+    void Trace::stop() { s_enabled = false; }
+
+    void Trace::beginPhase(const std::string &name) {
+        threadTrace().open.push_back(Phase{name, microsecondsSinceStart(), 0.0, 0, {}});
+    }
+
+    void Trace::endPhase() {
+        ThreadTrace &trace = threadTrace();
+        if (trace.open.empty()) {
+            return;
+        }
+        Phase phase = std::move(trace.open.back());
+        trace.open.pop_back();
+        phase.duration = microsecondsSinceStart() - phase.start;
+        phase.peakMemory = getPeakResidentMemory();
+        trace.done.push_back(std::move(phase));
+    }
+
+    void Trace::addCount(const std::string &name, int64_t value) {
+        ThreadTrace &trace = threadTrace();
+        if (trace.open.empty()) {
+            return;
+        }
+        Counts &counts = trace.open.back().counts;
+        for (auto &count : counts) {
+            if (count.first == name) {
+                count.second += value;
+                return;
+            }
+        }
+        counts.emplace_back(name, value);
+    }
+
+    void Trace::writeChromeTrace(std::ostream &stream) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        std::ios_base::fmtflags flags = stream.flags();
+        std::streamsize precision = stream.precision();
+        // times in microseconds, down to the nanosecond
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto &thread : threads) {
+            for (const Phase &phase : thread->done) {
+                stream << (first ? "\n" : ",\n");
+                first = false;
+                stream << "{\"name\":";
+                writeString(stream, phase.name);
+                stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id << ",\"ts\":" << phase.start
+                       << ",\"dur\":" << phase.duration << ",\"args\":{";
+                for (const auto &count : phase.counts) {
+                    writeString(stream, count.first);
+                    stream << ":" << count.second << ",";
+                }
+                stream << "\"peak resident memory (MB)\":" << double(phase.peakMemory) / (1024.0 * 1024.0) << "}}";
+                // the memory as a counter track as well, sampled at the end of each phase
+                stream << ",\n{\"name\":\"memory\",\"ph\":\"C\",\"pid\":1,\"tid\":" << thread->id
+                       << ",\"ts\":" << phase.start + phase.duration
+                       << ",\"args\":{\"peak resident (MB)\":" << double(phase.peakMemory) / (1024.0 * 1024.0)
+                       << "}}";
+            }
+        }
+        stream << "\n]}\n" << std::flush;
+        stream.flags(flags);
+        stream.precision(precision);
+    }
+
+    size_t Trace::getPeakResidentMemory() {
+#ifdef _WIN32
+        return 0;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#ifdef __APPLE__
+        return size_t(usage.ru_maxrss);
+#else
+        return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+} // namespace depthmapX
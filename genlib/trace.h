@@ -0,0 +1,88 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2020, depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace depthmapX {
+
+    /**
+     *  Records nested phases of work on each thread, the counts of what was done in them (nodes
+     *  visited, edges relaxed...) and the peak memory use of the process as each phase ends, to be
+     *  written out as a Chrome trace (for chrome://tracing or Perfetto). Nothing is recorded unless
+     *  tracing has been started, so that a phase costs no more than a flag check otherwise. Counts
+     *  are meant to be kept in locals and added to the phase once, not for every node
+     */
+    class Trace {
+      public:
+        // clears anything recorded before, so only call this when no phases are open
+        static void start();
+        static void stop();
+        static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+        static void beginPhase(const std::string &name);
+        static void endPhase();
+        // adds the value to the count of that name in the innermost phase open on this thread
+        static void addCount(const std::string &name, int64_t value);
+
+        // writes everything recorded as Chrome trace JSON, once the threads recording are done
+        static void writeChromeTrace(std::ostream &stream);
+
+        // the most memory the process has had resident so far in bytes, or 0 where it can not be told
+        static size_t getPeakResidentMemory();
+
+      private:
+        static std::atomic<bool> s_enabled;
+    };
+
+    // a phase from its construction to its destruction or a call to end(), whichever comes first
+    class TracePhase {
+      public:
+        TracePhase(const char *name) : m_open(Trace::isEnabled()) {
+            if (m_open) {
+                Trace::beginPhase(name);
+            }
+        }
+        TracePhase(const std::string &name) : m_open(Trace::isEnabled()) {
+            if (m_open) {
+                Trace::beginPhase(name);
+            }
+        }
+        ~TracePhase() { end(); }
+
+        TracePhase(const TracePhase &) = delete;
+        TracePhase &operator=(const TracePhase &) = delete;
+
+        void addCount(const char *name, int64_t value) {
+            if (m_open) {
+                Trace::addCount(name, value);
+            }
+        }
+        void end() {
+            if (m_open) {
+                Trace::endPhase();
+                m_open = false;
+            }
+        }
+
+      private:
+        bool m_open;
+    };
+} // namespace depthmapX
@@ -0,0 +1,106 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/bufferedtextwriter.h>
+#include <limits>
+#include <sstream>
+
+TEST_CASE("Buffered text writer formats as streams do", "") {
+    using namespace depthmapX;
+
+    std::vector<double> values{0.0,     -0.0,   1.0,      -1.0,       0.1,        1.0 / 3.0,  123456789.0,
+                               1e-7,    1e21,   7.044333, 2.5e-310,   65592.0,    -1234.5678, 0.000123456,
+                               std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+    for (int precision : {1, 6, 8, 12, 17}) {
+        std::stringstream expected;
+        expected.precision(precision);
+        std::stringstream actual;
+        actual.precision(precision);
+        {
+            BufferedTextWriter writer(actual, 16);
+            for (double value : values) {
+                expected << value << ',' << float(value) << '\n';
+                writer << value << ',' << float(value) << '\n';
+            }
+            expected << 42 << ',' << -7 << ',' << size_t(123456789012) << ',' << "text" << ',' << std::string("more");
+            writer << 42 << ',' << -7 << ',' << size_t(123456789012) << ',' << "text" << ',' << std::string("more");
+        }
+        REQUIRE(actual.str() == expected.str());
+    }
+}
+
+TEST_CASE("Buffered text writer moves", "") {
+    using namespace depthmapX;
+
+    std::stringstream first;
+    std::stringstream second;
+    {
+        BufferedTextWriter writer(first, 1024);
+        writer << "one,";
+        BufferedTextWriter moved(std::move(writer));
+        moved << "two,";
+        // the moved from writer has nothing left to write when it goes
+        REQUIRE(writer.size() == 0);
+
+        BufferedTextWriter other(second, 1024);
+        other << "three,";
+        other = std::move(moved);
+        other << "four";
+        REQUIRE(second.str() == "three,");
+    }
+    REQUIRE(first.str() == "one,two,four");
+}
+
+TEST_CASE("Buffered text writer rows", "") {
+    using namespace depthmapX;
+
+    // wide enough to be formatted a column per thread, and long enough to take more than one block
+    const size_t rowCount = 5000;
+    const size_t columnCount = 12;
+    auto format = [](size_t row, size_t column, BufferedTextWriter &cell) {
+        if (column == 0) {
+            cell << row;
+        } else {
+            cell.setPrecision(column < 3 ? 12 : 8);
+            cell << float(row) / float(column);
+        }
+    };
+
+    std::stringstream expected;
+    for (size_t row = 0; row < rowCount; row++) {
+        for (size_t column = 0; column < columnCount; column++) {
+            if (column != 0) {
+                expected << '\t';
+            }
+            expected.precision(column < 3 ? 12 : 8);
+            if (column == 0) {
+                expected << row;
+            } else {
+                expected << float(row) / float(column);
+            }
+        }
+        expected << '\n';
+    }
+
+    for (size_t threadCount : {size_t(1), size_t(3)}) {
+        std::stringstream actual;
+        {
+            BufferedTextWriter writer(actual, 1024);
+            writer.writeRows(rowCount, columnCount, '\t', format, threadCount);
+        }
+        REQUIRE(actual.str() == expected.str());
+    }
+}
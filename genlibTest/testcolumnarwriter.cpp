@@ -0,0 +1,98 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/columnarwriter.h>
+#include <genlib/exceptions.h>
+#include <sstream>
+
+namespace {
+    template <typename T> T readAt(const std::string &data, size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+} // namespace
+
+TEST_CASE("Columnar writer layout", "") {
+    using namespace depthmapX;
+
+    std::stringstream stream;
+    ColumnarWriter writer(stream, 2);
+    writer.addColumn("Ref", ColumnarWriter::Type::INT32);
+    writer.addColumn("x", ColumnarWriter::Type::FLOAT64);
+    writer.addColumn("Value", ColumnarWriter::Type::FLOAT32);
+    for (int i = 0; i < 3; i++) {
+        writer.add(int32_t(i * 10));
+        writer.add(i * 0.5);
+        writer.add(float(i) + 0.25f);
+    }
+    writer.finish();
+    REQUIRE(writer.getRowCount() == 3);
+
+    std::string data = stream.str();
+    REQUIRE(data.substr(0, 8) == "DXCOL001");
+    REQUIRE(data.substr(data.size() - 8) == "DXCOL001");
+
+    // schema
+    REQUIRE(readAt<uint32_t>(data, 8) == 3);
+    REQUIRE(readAt<uint8_t>(data, 12) == 1);
+    REQUIRE(readAt<uint32_t>(data, 13) == 3);
+    REQUIRE(data.substr(17, 3) == "Ref");
+    REQUIRE(readAt<uint8_t>(data, 20) == 3);
+    REQUIRE(data.substr(25, 1) == "x");
+    REQUIRE(readAt<uint8_t>(data, 26) == 2);
+    REQUIRE(data.substr(31, 5) == "Value");
+
+    // footer, pointing back to the two chunks
+    uint32_t footerLength = readAt<uint32_t>(data, data.size() - 12);
+    size_t footer = data.size() - 12 - footerLength;
+    REQUIRE(readAt<int64_t>(data, footer) == -1);
+    REQUIRE(readAt<int64_t>(data, footer + 8) == 2);
+    REQUIRE(readAt<int64_t>(data, footer + 32) == 3);
+
+    size_t first = size_t(readAt<int64_t>(data, footer + 16));
+    REQUIRE(first == 40);
+    REQUIRE(readAt<int64_t>(data, first) == 2);
+    // the first chunk: Ref padded from 8 to 8, x 16 bytes, Value padded from 8 to 8
+    REQUIRE(readAt<int32_t>(data, first + 8) == 0);
+    REQUIRE(readAt<int32_t>(data, first + 12) == 10);
+    REQUIRE(readAt<double>(data, first + 24) == 0.5);
+    REQUIRE(readAt<float>(data, first + 36) == 1.25f);
+
+    size_t second = size_t(readAt<int64_t>(data, footer + 24));
+    REQUIRE(second == first + 40);
+    REQUIRE(readAt<int64_t>(data, second) == 1);
+    REQUIRE(readAt<int32_t>(data, second + 8) == 20);
+    REQUIRE(readAt<double>(data, second + 16) == 1.0);
+    REQUIRE(readAt<float>(data, second + 24) == 2.25f);
+    REQUIRE(footer == second + 32);
+}
+
+TEST_CASE("Columnar writer misuse", "") {
+    using namespace depthmapX;
+
+    std::stringstream stream;
+    ColumnarWriter writer(stream);
+    writer.addColumn("Ref", ColumnarWriter::Type::INT32);
+    writer.addColumn("Value", ColumnarWriter::Type::FLOAT32);
+
+    REQUIRE_THROWS_AS(writer.add(1.0), RuntimeException);
+    // nothing is written for a rejected value, not even the schema
+    REQUIRE(stream.str().empty());
+    writer.add(int32_t(1));
+    REQUIRE_THROWS_AS(writer.addColumn("Late", ColumnarWriter::Type::FLOAT32), RuntimeException);
+    REQUIRE_THROWS_AS(writer.finish(), RuntimeException);
+}
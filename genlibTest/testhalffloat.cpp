@@ -0,0 +1,44 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/halffloat.h>
+#include <cmath>
+#include <limits>
+
+TEST_CASE("Half precision floats", "") {
+    using namespace depthmapX;
+
+    // exactly representable values go there and back unchanged
+    for (float value : {0.0f, 1.0f, -1.0f, 0.5f, 0.25f, 1024.0f, 65504.0f, -2.5f, 6.103515625e-05f}) {
+        REQUIRE(halfToFloat(floatToHalf(value)) == value);
+    }
+    REQUIRE(floatToHalf(1.0f) == 0x3C00);
+    REQUIRE(floatToHalf(-2.0f) == 0xC000);
+
+    // the smallest subnormal, and a value halfway below it rounding to even (zero)
+    REQUIRE(halfToFloat(floatToHalf(5.9604644775390625e-08f)) == 5.9604644775390625e-08f);
+    REQUIRE(floatToHalf(2.98023223876953125e-08f) == 0);
+
+    // rounding to nearest, ties to even
+    REQUIRE(halfToFloat(floatToHalf(1.0f + 1.0f / 2048.0f)) == 1.0f);
+    REQUIRE(halfToFloat(floatToHalf(1.0f + 3.0f / 2048.0f)) == 1.0f + 2.0f / 1024.0f);
+    REQUIRE(std::abs(halfToFloat(floatToHalf(1.0f / 3.0f)) - 1.0f / 3.0f) < 1e-3f);
+
+    // out of range and special values
+    REQUIRE(std::isinf(halfToFloat(floatToHalf(70000.0f))));
+    REQUIRE(std::isinf(halfToFloat(floatToHalf(std::numeric_limits<float>::infinity()))));
+    REQUIRE(std::isnan(halfToFloat(floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+}
@@ -0,0 +1,39 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/pafmath.h>
+#include <vector>
+
+TEST_CASE("Test continuing the random sequence from a skipped state", "") {
+    // use the last set so that the other tests are not affected
+    const int set = 10;
+    pafsrand(1234, set);
+    uint64_t start = pafrandstate(set);
+
+    std::vector<unsigned int> sequence;
+    for (int i = 0; i < 100; i++) {
+        sequence.push_back(pafrand(set));
+    }
+
+    for (uint64_t skip : {0, 1, 2, 7, 64, 99}) {
+        uint64_t state = pafrandskip(start, skip);
+        REQUIRE(pafrand_r(state) == sequence[skip]);
+    }
+    REQUIRE(pafrandskip(start, 100) == pafrandstate(set));
+
+    pafsetrandstate(start, set);
+    REQUIRE(pafrand(set) == sequence[0]);
+}
@@ -0,0 +1,144 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/parallel.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    class CancellingCommunicator : public Communicator {
+      public:
+        mutable int lastRecord = -1;
+        void CommPostMessage(int m, int x) const override {
+            if (m == CURRENT_RECORD) {
+                lastRecord = x;
+            }
+        }
+    };
+} // namespace
+
+TEST_CASE("Test parallelFor", "") {
+    std::vector<int> calls(1000, 0);
+    depthmapX::parallelFor(calls.size(), 4, [&](size_t index, size_t) { calls[index]++; });
+    REQUIRE(std::count(calls.begin(), calls.end(), 1) == 1000);
+
+    REQUIRE_THROWS_AS(depthmapX::parallelFor(calls.size(), 4,
+                                             [&](size_t index, size_t) {
+                                                 if (index == 500) {
+                                                     throw std::runtime_error("stop");
+                                                 }
+                                             }),
+                      std::runtime_error);
+
+    // the pool is still usable after an exception
+    std::fill(calls.begin(), calls.end(), 0);
+    depthmapX::parallelFor(calls.size(), 8, [&](size_t index, size_t) { calls[index]++; });
+    REQUIRE(std::count(calls.begin(), calls.end(), 1) == 1000);
+}
+
+TEST_CASE("Test parallelFor threads", "") {
+    // each thread number is only used by one thread at a time, so per thread data needs no locking
+    std::vector<size_t> perThread(4, 0);
+    depthmapX::parallelFor(10000, 4, [&](size_t, size_t thread) { perThread[thread]++; });
+    REQUIRE(perThread.size() == 4);
+    REQUIRE(perThread[0] + perThread[1] + perThread[2] + perThread[3] == 10000);
+
+    // never more threads than indices
+    std::atomic<size_t> maxThread(0);
+    depthmapX::parallelFor(2, 16, [&](size_t, size_t thread) {
+        size_t current = maxThread;
+        while (thread > current && !maxThread.compare_exchange_weak(current, thread)) {
+        }
+    });
+    REQUIRE(maxThread < 2);
+
+    // nothing to do
+    depthmapX::parallelFor(0, 4, [&](size_t, size_t) { FAIL("called with no indices"); });
+}
+
+TEST_CASE("Test nested parallelFor", "") {
+    std::vector<std::vector<int>> calls(16, std::vector<int>(100, 0));
+    depthmapX::parallelFor(calls.size(), 4, [&](size_t outer, size_t) {
+        depthmapX::parallelFor(calls[outer].size(), 4, [&](size_t inner, size_t) { calls[outer][inner]++; });
+    });
+    for (const std::vector<int> &inner : calls) {
+        REQUIRE(std::count(inner.begin(), inner.end(), 1) == 100);
+    }
+}
+
+TEST_CASE("Test parallelFor with a communicator", "") {
+    CancellingCommunicator comm;
+    std::vector<int> calls(1000, 0);
+    depthmapX::parallelFor(calls.size(), 4, &comm, [&](size_t index, size_t) { calls[index]++; });
+    REQUIRE(std::count(calls.begin(), calls.end(), 1) == 1000);
+
+    // cancelled part way through, the rest are not run
+    std::atomic<size_t> done(0);
+    REQUIRE_THROWS_AS(depthmapX::parallelFor(calls.size(), 4, &comm,
+                                             [&](size_t index, size_t) {
+                                                 done++;
+                                                 if (index == 100) {
+                                                     comm.Cancel();
+                                                 }
+                                             }),
+                      Communicator::CancelledException);
+    REQUIRE(done < calls.size());
+
+    // no communicator at all
+    std::fill(calls.begin(), calls.end(), 0);
+    depthmapX::parallelFor(calls.size(), 4, nullptr, [&](size_t index, size_t) { calls[index]++; });
+    REQUIRE(std::count(calls.begin(), calls.end(), 1) == 1000);
+}
+
+TEST_CASE("Test parallelReduce", "") {
+    for (size_t threadCount : {1, 3, 8}) {
+        int64_t sum = depthmapX::parallelReduce(
+            size_t(1000), threadCount, int64_t(0), [](size_t index, int64_t &total) { total += int64_t(index); },
+            [](int64_t a, int64_t b) { return a + b; });
+        REQUIRE(sum == 999 * 1000 / 2);
+
+        size_t maxIndex = depthmapX::parallelReduce(
+            size_t(1000), threadCount, size_t(0), [](size_t index, size_t &total) { total = std::max(total, index); },
+            [](size_t a, size_t b) { return std::max(a, b); });
+        REQUIRE(maxIndex == 999);
+    }
+    int nothing = depthmapX::parallelReduce(
+        size_t(0), 4, 7, [](size_t, int &) {}, [](int a, int b) { return a + b; });
+    REQUIRE(nothing == 7);
+}
+
+TEST_CASE("Test the thread count", "") {
+    size_t hardware = depthmapX::getThreadCount();
+    REQUIRE(hardware >= 1);
+
+    depthmapX::setThreadCount(3);
+    REQUIRE(depthmapX::getThreadCount() == 3);
+    {
+        depthmapX::ScopedThreadCount scoped(2);
+        REQUIRE(depthmapX::getThreadCount() == 2);
+        {
+            // 0 keeps what is there
+            depthmapX::ScopedThreadCount unchanged(0);
+            REQUIRE(depthmapX::getThreadCount() == 2);
+        }
+        REQUIRE(depthmapX::getThreadCount() == 2);
+    }
+    REQUIRE(depthmapX::getThreadCount() == 3);
+    depthmapX::setThreadCount(0);
+    REQUIRE(depthmapX::getThreadCount() == hardware);
+}
@@ -0,0 +1,101 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/progressreporter.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    class RecordingCommunicator : public Communicator {
+      public:
+        mutable std::mutex mutex;
+        mutable std::vector<int> records;
+        void CommPostMessage(int m, int x) const override {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (m == CURRENT_RECORD) {
+                records.push_back(x);
+            }
+        }
+        std::vector<int> getRecords() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return records;
+        }
+    };
+
+    bool waitForRecord(const RecordingCommunicator &comm, int record) {
+        for (int i = 0; i < 500; i++) {
+            std::vector<int> records = comm.getRecords();
+            if (!records.empty() && records.back() == record) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return false;
+    }
+} // namespace
+
+TEST_CASE("Test the progress reporter posts the count", "") {
+    RecordingCommunicator comm;
+    {
+        depthmapX::ProgressReporter progress(&comm, 1);
+        progress.increment();
+        progress.increment(4);
+        REQUIRE(progress.getDone() == 5);
+        REQUIRE(waitForRecord(comm, 5));
+
+        progress.update(12);
+        REQUIRE(waitForRecord(comm, 12));
+    }
+    // nothing is posted twice unless it has changed, and nothing after the reporter is gone
+    std::vector<int> records = comm.getRecords();
+    REQUIRE(records == std::vector<int>({5, 12}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(comm.getRecords().size() == 2);
+}
+
+TEST_CASE("Test the progress reporter from many threads", "") {
+    RecordingCommunicator comm;
+    depthmapX::ProgressReporter progress(&comm, 1);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&progress]() {
+            for (int j = 0; j < 1000; j++) {
+                progress.increment();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    REQUIRE(progress.getDone() == 4000);
+    REQUIRE(waitForRecord(comm, 4000));
+}
+
+TEST_CASE("Test the progress reporter cancellation", "") {
+    depthmapX::ProgressReporter noComm(nullptr);
+    noComm.increment();
+    REQUIRE_FALSE(noComm.isCancelled());
+    REQUIRE_NOTHROW(noComm.checkCancelled());
+
+    RecordingCommunicator comm;
+    depthmapX::ProgressReporter progress(&comm);
+    REQUIRE_NOTHROW(progress.checkCancelled());
+    comm.Cancel();
+    REQUIRE(progress.isCancelled());
+    REQUIRE_THROWS_AS(progress.checkCancelled(), Communicator::CancelledException);
+}
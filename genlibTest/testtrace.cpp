@@ -0,0 +1,72 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include <genlib/trace.h>
+#include <sstream>
+#include <thread>
+
+TEST_CASE("Trace records nothing unless started", "") {
+    using namespace depthmapX;
+
+    Trace::start();
+    Trace::stop();
+    {
+        TracePhase phase("Not recorded");
+        phase.addCount("nodes", 1);
+    }
+    std::stringstream stream;
+    Trace::writeChromeTrace(stream);
+    REQUIRE(stream.str() == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n");
+}
+
+TEST_CASE("Trace of nested phases and counts", "") {
+    using namespace depthmapX;
+
+    Trace::start();
+    {
+        TracePhase outer("Outer \"phase\"");
+        {
+            TracePhase inner("Inner");
+            inner.addCount("nodes visited", 3);
+            inner.addCount("nodes visited", 4);
+            inner.addCount("edges relaxed", 2);
+        }
+        // counts outside of any phase on a thread are dropped
+        std::thread([]() { Trace::addCount("lost", 1); }).join();
+        outer.end();
+        outer.end();
+    }
+    Trace::stop();
+
+    std::stringstream stream;
+    stream.precision(2);
+    Trace::writeChromeTrace(stream);
+    std::string trace = stream.str();
+
+    // the inner phase ends first, so comes first
+    size_t inner = trace.find("{\"name\":\"Inner\",\"ph\":\"X\"");
+    size_t outer = trace.find("{\"name\":\"Outer \\\"phase\\\"\",\"ph\":\"X\"");
+    REQUIRE(inner != std::string::npos);
+    REQUIRE(outer != std::string::npos);
+    REQUIRE(inner < outer);
+    REQUIRE(trace.find("\"args\":{\"nodes visited\":7,\"edges relaxed\":2,\"peak resident memory (MB)\":") ==
+            trace.find("\"args\":", inner));
+    REQUIRE(trace.find("lost") == std::string::npos);
+    REQUIRE(trace.find("{\"name\":\"memory\",\"ph\":\"C\"") != std::string::npos);
+    // the stream is left as it was given
+    REQUIRE(stream.precision() == 2);
+    REQUIRE((stream.flags() & std::ios_base::fixed) == 0);
+}
@@ -89,7 +89,7 @@ void SegmentShortestPathParser::parse(int argc, char **argv) {
 }
 
 void SegmentShortestPathParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const {
-    auto mGraph = dm_runmethods::loadGraph(clp.getFileName().c_str(), perfWriter);
+    auto mGraph = dm_runmethods::loadGraph(clp, perfWriter);
 
     std::cout << "ok\nSelecting cells... " << std::flush;
 
@@ -133,6 +133,6 @@ void SegmentShortestPathParser::run(const CommandLineParser &clp, IPerformanceSi
     }
 
     std::cout << " ok\nWriting out result..." << std::flush;
-    DO_TIMED("Writing graph", mGraph->write(clp.getOuputFile().c_str(), METAGRAPH_VERSION, false))
+    dm_runmethods::writeGraph(clp, *mGraph, clp.getOuputFile(), perfWriter);
     std::cout << " ok" << std::endl;
 }
@@ -0,0 +1,426 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "segmcontractionhierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+    const double INF_COST = std::numeric_limits<double>::infinity();
+
+    // limits on the witness search, beyond these a shortcut is added anyway
+    // which keeps the hierarchy correct, only slightly larger. Estimating
+    // the priority of a segment can make do with a rougher search
+    const int MAX_WITNESS_SETTLED = 50;
+    const int MAX_WITNESS_SETTLED_ESTIMATE = 10;
+
+    struct Arc {
+        int target;
+        double cost;
+        int middle;
+    };
+
+    typedef std::pair<double, int> QueueItem;
+    typedef std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> MinQueue;
+
+    // the graph that remains while segments are being contracted, contracted
+    // segments are removed from it along with the arcs pointing to them
+    class ContractionGraph {
+      public:
+        std::vector<std::vector<Arc>> arcs;
+        std::vector<bool> contracted;
+        std::vector<int> contractedNeighbours;
+
+      private:
+        std::vector<double> m_witnessDist;
+        std::vector<int> m_touched;
+        std::vector<QueueItem> m_witnessHeap;
+        std::vector<char> m_isTarget;
+
+      public:
+        ContractionGraph(size_t size)
+            : arcs(size), contracted(size, false), contractedNeighbours(size, 0), m_witnessDist(size, INF_COST),
+              m_isTarget(size, false) {}
+
+        void addOrImproveArc(int from, int to, double cost, int middle) {
+            for (Arc &arc : arcs[from]) {
+                if (arc.target == to) {
+                    if (cost < arc.cost) {
+                        arc.cost = cost;
+                        arc.middle = middle;
+                    }
+                    return;
+                }
+            }
+            arcs[from].push_back(Arc{to, cost, middle});
+        }
+
+        // bounded dijkstra from 'source' avoiding 'avoid', leaves the distances in m_witnessDist.
+        // Stops early once all the segments flagged in m_isTarget have been settled
+        void witnessSearch(int source, int avoid, double maxCost, int targetCount, int maxSettled) {
+            for (int touched : m_touched) {
+                m_witnessDist[touched] = INF_COST;
+            }
+            m_touched.clear();
+
+            std::vector<QueueItem> &heap = m_witnessHeap;
+            heap.clear();
+            m_witnessDist[source] = 0.0;
+            m_touched.push_back(source);
+            heap.push_back(QueueItem(0.0, source));
+            int settled = 0;
+            while (!heap.empty() && targetCount > 0) {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<QueueItem>());
+                QueueItem item = heap.back();
+                heap.pop_back();
+                if (item.first > m_witnessDist[item.second]) {
+                    continue;
+                }
+                if (item.first > maxCost || ++settled > maxSettled) {
+                    break;
+                }
+                if (m_isTarget[item.second]) {
+                    targetCount--;
+                }
+                for (const Arc &arc : arcs[item.second]) {
+                    if (arc.target == avoid) {
+                        continue;
+                    }
+                    double cost = item.first + arc.cost;
+                    if (cost < m_witnessDist[arc.target]) {
+                        if (m_witnessDist[arc.target] == INF_COST) {
+                            m_touched.push_back(arc.target);
+                        }
+                        m_witnessDist[arc.target] = cost;
+                        heap.push_back(QueueItem(cost, arc.target));
+                        std::push_heap(heap.begin(), heap.end(), std::greater<QueueItem>());
+                    }
+                }
+            }
+        }
+
+        // work out (and optionally add) the shortcuts required to remove 'segment'
+        int contract(int segment, bool simulate) {
+            std::vector<Arc> neighbours = arcs[segment];
+            int shortcuts = 0;
+            for (size_t i = 0; i + 1 < neighbours.size(); i++) {
+                double maxCost = 0.0;
+                for (size_t j = i + 1; j < neighbours.size(); j++) {
+                    maxCost = std::max(maxCost, neighbours[i].cost + neighbours[j].cost);
+                    m_isTarget[neighbours[j].target] = true;
+                }
+                witnessSearch(neighbours[i].target, segment, maxCost, int(neighbours.size() - i - 1),
+                              simulate ? MAX_WITNESS_SETTLED_ESTIMATE : MAX_WITNESS_SETTLED);
+                for (size_t j = i + 1; j < neighbours.size(); j++) {
+                    m_isTarget[neighbours[j].target] = false;
+                    double viaCost = neighbours[i].cost + neighbours[j].cost;
+                    if (m_witnessDist[neighbours[j].target] <= viaCost) {
+                        continue;
+                    }
+                    shortcuts++;
+                    if (!simulate) {
+                        addOrImproveArc(neighbours[i].target, neighbours[j].target, viaCost, segment);
+                        addOrImproveArc(neighbours[j].target, neighbours[i].target, viaCost, segment);
+                    }
+                }
+            }
+            return shortcuts;
+        }
+
+        // take a contracted segment out of the remaining graph
+        void remove(int segment) {
+            contracted[segment] = true;
+            for (const Arc &arc : arcs[segment]) {
+                std::vector<Arc> &targetArcs = arcs[arc.target];
+                targetArcs.erase(std::remove_if(targetArcs.begin(), targetArcs.end(),
+                                                [segment](const Arc &other) { return other.target == segment; }),
+                                 targetArcs.end());
+                contractedNeighbours[arc.target]++;
+            }
+            arcs[segment].clear();
+        }
+
+        int priority(int segment) {
+            int degree = int(arcs[segment].size());
+            return contract(segment, true) - degree + contractedNeighbours[segment];
+        }
+    };
+
+    double edgeCost(SegmentContractionHierarchy::CostType costType, const std::vector<float> &segmentData, int from,
+                    int to) {
+        if (costType == SegmentContractionHierarchy::CostType::METRIC) {
+            return (segmentData[from] + segmentData[to]) * 0.5;
+        }
+        return segmentData[from] == segmentData[to] ? 0.0 : 1.0;
+    }
+
+    struct SearchLabel {
+        double cost;
+        int parent;
+    };
+} // namespace
+
+std::vector<float> SegmentContractionHierarchy::readSegmentData(const ShapeGraph &map) const {
+    size_t segmentCount = map.getShapeCount();
+    std::vector<float> segmentData;
+    segmentData.reserve(segmentCount);
+    const AttributeTable &attributes = map.getAttributeTable();
+    size_t dataCol = attributes.getColumnIndex(m_costType == CostType::METRIC ? "Segment Length" : "Axial Line Ref");
+    for (size_t i = 0; i < segmentCount; i++) {
+        segmentData.push_back(map.getAttributeRowFromShapeIndex(i).getValue(dataCol));
+    }
+    return segmentData;
+}
+
+uint64_t SegmentContractionHierarchy::fingerprint(const ShapeGraph &map, const std::vector<float> &segmentData) {
+    // FNV-1a over every segment's value and connections in order
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](uint64_t value) {
+        for (int byte = 0; byte < 8; byte++) {
+            hash = (hash ^ ((value >> (byte * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    };
+    const std::vector<Connector> &connectors = map.getConnections();
+    for (size_t i = 0; i < segmentData.size() && i < connectors.size(); i++) {
+        uint32_t bits;
+        std::memcpy(&bits, &segmentData[i], sizeof(bits));
+        add(bits);
+        for (auto *segconns : {&connectors[i].m_back_segconns, &connectors[i].m_forward_segconns}) {
+            add(segconns->size());
+            for (auto &segconn : *segconns) {
+                add(uint64_t(uint32_t(segconn.first.ref)));
+            }
+        }
+    }
+    add(connectors.size());
+    return hash;
+}
+
+bool SegmentContractionHierarchy::isValidFor(const ShapeGraph &map) const {
+    return !m_rank.empty() && m_segmentCount == map.getShapeCount() &&
+           m_fingerprint == fingerprint(map, readSegmentData(map));
+}
+
+void SegmentContractionHierarchy::setPathAttributes(ShapeGraph &map, int origin, const Path &path, size_t costCol,
+                                                    size_t orderCol) {
+    if (!path.found()) {
+        // same as the full search, only the origin is marked
+        map.getAttributeRowFromShapeIndex(origin).setValue(costCol, 0).setValue(orderCol, 0);
+        return;
+    }
+    for (size_t i = 0; i < path.segments.size(); i++) {
+        map.getAttributeRowFromShapeIndex(path.segments[i]).setValue(costCol, path.costs[i]).setValue(orderCol, i);
+    }
+}
+
+size_t SegmentContractionHierarchy::getShortcutCount() const {
+    return std::count_if(m_edges.begin(), m_edges.end(), [](const UpwardEdge &edge) { return edge.middle != -1; });
+}
+
+bool SegmentContractionHierarchy::build(const ShapeGraph &map, Communicator *comm) {
+    if (map.getMapType() != ShapeMap::SEGMENTMAP) {
+        return false;
+    }
+
+    size_t segmentCount = map.getShapeCount();
+    std::vector<float> segmentData = readSegmentData(map);
+
+    time_t atime = 0;
+    if (comm) {
+        qtimer(atime, 0);
+        comm->CommPostMessage(Communicator::NUM_RECORDS, segmentCount);
+    }
+
+    ContractionGraph graph(segmentCount);
+    const std::vector<Connector> &connectors = map.getConnections();
+    for (size_t i = 0; i < segmentCount; i++) {
+        for (auto *segconns : {&connectors[i].m_back_segconns, &connectors[i].m_forward_segconns}) {
+            for (auto &segconn : *segconns) {
+                int to = segconn.first.ref;
+                if (to == int(i)) {
+                    continue;
+                }
+                double cost = edgeCost(m_costType, segmentData, i, to);
+                graph.addOrImproveArc(i, to, cost, -1);
+                graph.addOrImproveArc(to, i, cost, -1);
+            }
+        }
+    }
+
+    // order the segments by edge difference, updating the priorities lazily
+    MinQueue queue;
+    for (size_t i = 0; i < segmentCount; i++) {
+        queue.push(QueueItem(graph.priority(i), i));
+    }
+
+    std::vector<int> rank(segmentCount, -1);
+    std::vector<std::vector<Arc>> upward(segmentCount);
+    int currentRank = 0;
+    while (!queue.empty()) {
+        QueueItem item = queue.top();
+        queue.pop();
+        int segment = item.second;
+        if (graph.contracted[segment]) {
+            continue;
+        }
+        double newPriority = graph.priority(segment);
+        if (!queue.empty() && newPriority > queue.top().first) {
+            queue.push(QueueItem(newPriority, segment));
+            continue;
+        }
+
+        upward[segment] = graph.arcs[segment];
+        graph.contract(segment, false);
+        graph.remove(segment);
+        rank[segment] = currentRank++;
+
+        if (comm) {
+            if (qtimer(atime, 500)) {
+                if (comm->IsCancelled()) {
+                    throw Communicator::CancelledException();
+                }
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, currentRank);
+            }
+        }
+    }
+
+    m_rank = std::move(rank);
+    m_firstEdge.assign(segmentCount + 1, 0);
+    m_edges.clear();
+    for (size_t i = 0; i < segmentCount; i++) {
+        m_firstEdge[i] = m_edges.size();
+        for (const Arc &arc : upward[i]) {
+            m_edges.push_back(UpwardEdge{arc.target, arc.cost, arc.middle});
+        }
+    }
+    m_firstEdge[segmentCount] = m_edges.size();
+    m_segmentCount = segmentCount;
+    m_fingerprint = fingerprint(map, segmentData);
+
+    return true;
+}
+
+const SegmentContractionHierarchy::UpwardEdge *SegmentContractionHierarchy::findUpwardEdge(int from, int to) const {
+    // edges are only stored from the lower ranked end
+    if (m_rank[from] > m_rank[to]) {
+        std::swap(from, to);
+    }
+    for (size_t e = m_firstEdge[from]; e < m_firstEdge[from + 1]; e++) {
+        if (m_edges[e].target == to) {
+            return &m_edges[e];
+        }
+    }
+    return nullptr;
+}
+
+void SegmentContractionHierarchy::unpackEdge(int from, int to, std::vector<int> &segments) const {
+    const UpwardEdge *edge = findUpwardEdge(from, to);
+    if (edge->middle == -1) {
+        segments.push_back(to);
+        return;
+    }
+    int middle = edge->middle;
+    unpackEdge(from, middle, segments);
+    unpackEdge(middle, to, segments);
+}
+
+SegmentContractionHierarchy::Path SegmentContractionHierarchy::findPath(int origin, int destination) const {
+    Path path;
+    if (origin < 0 || destination < 0 || size_t(origin) >= m_segmentCount || size_t(destination) >= m_segmentCount) {
+        return path;
+    }
+
+    // both searches only go upwards in rank, and as the segment graph is symmetric they share the same edges
+    std::unordered_map<int, SearchLabel> labels[2];
+    MinQueue queues[2];
+    labels[0][origin] = SearchLabel{0.0, -1};
+    labels[1][destination] = SearchLabel{0.0, -1};
+    queues[0].push(QueueItem(0.0, origin));
+    queues[1].push(QueueItem(0.0, destination));
+
+    double bestCost = INF_COST;
+    int meeting = -1;
+    if (origin == destination) {
+        bestCost = 0.0;
+        meeting = origin;
+    }
+
+    int side = 0;
+    while (!queues[0].empty() || !queues[1].empty()) {
+        if (queues[side].empty()) {
+            side = 1 - side;
+        }
+        MinQueue &queue = queues[side];
+        if (queue.top().first >= bestCost) {
+            // nothing better can come from this side any more
+            queue = MinQueue();
+            side = 1 - side;
+            continue;
+        }
+        QueueItem item = queue.top();
+        queue.pop();
+        int segment = item.second;
+        if (item.first > labels[side][segment].cost) {
+            continue;
+        }
+        auto other = labels[1 - side].find(segment);
+        if (other != labels[1 - side].end() && item.first + other->second.cost < bestCost) {
+            bestCost = item.first + other->second.cost;
+            meeting = segment;
+        }
+        for (size_t e = m_firstEdge[segment]; e < m_firstEdge[segment + 1]; e++) {
+            const UpwardEdge &edge = m_edges[e];
+            double cost = item.first + edge.cost;
+            auto label = labels[side].find(edge.target);
+            if (label == labels[side].end() || cost < label->second.cost) {
+                labels[side][edge.target] = SearchLabel{cost, segment};
+                queue.push(QueueItem(cost, edge.target));
+            }
+        }
+        side = 1 - side;
+    }
+
+    if (meeting == -1) {
+        return path;
+    }
+
+    // the upward chain from the origin to the meeting segment...
+    std::vector<int> chain;
+    for (int segment = meeting; segment != -1; segment = labels[0][segment].parent) {
+        chain.push_back(segment);
+    }
+    std::reverse(chain.begin(), chain.end());
+    // ...followed by the chain down to the destination
+    for (int segment = labels[1][meeting].parent; segment != -1; segment = labels[1][segment].parent) {
+        chain.push_back(segment);
+    }
+
+    path.segments.push_back(chain.front());
+    for (size_t i = 1; i < chain.size(); i++) {
+        unpackEdge(chain[i - 1], chain[i], path.segments);
+    }
+
+    path.costs.push_back(0.0);
+    for (size_t i = 1; i < path.segments.size(); i++) {
+        path.costs.push_back(path.costs.back() + findUpwardEdge(path.segments[i - 1], path.segments[i])->cost);
+    }
+
+    return path;
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/axialmap.h"
+
+#include "genlib/comm.h"
+
+#include <cstdint>
+#include <vector>
+
+// A contraction hierarchy over the segment-to-segment graph of a segment map.
+// Building it is a one-off preprocessing step, after which point-to-point
+// queries only need a small bidirectional search over the upward edges.
+// The index is a snapshot: if the segment map, its connections or the values
+// the costs come from change it has to be rebuilt (see isValidFor).
+
+class SegmentContractionHierarchy {
+  public:
+    enum class CostType {
+        METRIC,     // midpoint to midpoint distance along the segments
+        TOPOLOGICAL // one step every time the path changes axial line
+    };
+
+    struct Path {
+        // segment indices from origin to destination (inclusive), empty if unreachable
+        std::vector<int> segments;
+        // accumulated cost at each segment of the path
+        std::vector<double> costs;
+        bool found() const { return !segments.empty(); }
+    };
+
+  private:
+    struct UpwardEdge {
+        int target;
+        double cost;
+        // the contracted segment this shortcut bypasses, -1 if it is an original connection
+        int middle;
+    };
+
+    CostType m_costType;
+    size_t m_segmentCount = 0;
+    // of the connections and cost values the hierarchy was built from
+    uint64_t m_fingerprint = 0;
+    std::vector<int> m_rank;
+    // upward edges stored packed, the edges of segment i are
+    // m_edges[m_firstEdge[i]] to m_edges[m_firstEdge[i + 1] - 1]
+    std::vector<size_t> m_firstEdge;
+    std::vector<UpwardEdge> m_edges;
+
+    const UpwardEdge *findUpwardEdge(int from, int to) const;
+    void unpackEdge(int from, int to, std::vector<int> &segments) const;
+    // the value of each segment its costs come from: the length for metric and the axial line for topological
+    std::vector<float> readSegmentData(const ShapeGraph &map) const;
+    static uint64_t fingerprint(const ShapeGraph &map, const std::vector<float> &segmentData);
+
+  public:
+    SegmentContractionHierarchy(CostType costType) : m_costType(costType) {}
+    // returns false if the map is not a segment map or the process was cancelled
+    bool build(const ShapeGraph &map, Communicator *comm = nullptr);
+    Path findPath(int origin, int destination) const;
+
+    CostType getCostType() const { return m_costType; }
+    size_t getShortcutCount() const;
+    // whether the map still has the segments, connections and costs the hierarchy was built from,
+    // checked against a fingerprint of them: one pass over the map, far less than building again
+    bool isValidFor(const ShapeGraph &map) const;
+
+    // write the accumulated costs and the order of the path into the map. Segments off the path
+    // are expected to have been reset to -1 already (which is what insertOrResetColumn does)
+    static void setPathAttributes(ShapeGraph &map, int origin, const Path &path, size_t costCol, size_t orderCol);
+};
@@ -20,7 +20,7 @@
 
 #include "genlib/stringutils.h"
 
-bool SegmentMetricShortestPath::run(Communicator *) {
+bool SegmentMetricShortestPath::run(Communicator *comm) {
 
     AttributeTable &attributes = m_map.getAttributeTable();
     int shapeCount = m_map.getShapeCount();
@@ -30,6 +30,24 @@ bool SegmentMetricShortestPath::run(Communicator *) {
     int dist_col = attributes.insertOrResetColumn("Metric Shortest Path Distance");
     int path_col = attributes.insertOrResetColumn("Metric Shortest Path Order");
 
+    auto &selected = m_map.getSelSet();
+    if (selected.size() != 2) {
+        return false;
+    }
+    int refFrom = *selected.begin();
+    int refTo = *selected.rbegin();
+
+    if (m_hierarchy != nullptr && m_hierarchy->getCostType() == SegmentContractionHierarchy::CostType::METRIC) {
+        if (!m_hierarchy->isValidFor(m_map) && !m_hierarchy->build(m_map, comm)) {
+            return false;
+        }
+        SegmentContractionHierarchy::setPathAttributes(m_map, refFrom, m_hierarchy->findPath(refFrom, refTo),
+                                                       dist_col, path_col);
+        m_map.overrideDisplayedAttribute(-2);
+        m_map.setDisplayedAttribute(path_col);
+        return retvar;
+    }
+
     // record axial line refs for topological analysis
     std::vector<int> axialrefs;
     // quick through to find the longest seg length
@@ -51,13 +69,6 @@ bool SegmentMetricShortestPath::run(Communicator *) {
     std::vector<int> list[512]; // 512 bins!
     int open = 0;
 
-    auto &selected = m_map.getSelSet();
-    if (selected.size() != 2) {
-        return false;
-    }
-    int refFrom = *selected.begin();
-    int refTo = *selected.rbegin();
-
     seen[refFrom] = 0;
     open++;
     double length = seglengths[refFrom];
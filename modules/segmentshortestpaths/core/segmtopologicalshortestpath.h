@@ -18,16 +18,24 @@
 
 #pragma once
 
+#include "segmcontractionhierarchy.h"
+
 #include "salalib/segmmodules/segmhelpers.h"
 
 #include "salalib/ianalysis.h"
 
+#include <memory>
+
 class SegmentTopologicalShortestPath : public IAnalysis {
   private:
     ShapeGraph &m_map;
+    // optional index for repeated queries, (re)built on first use if it does not match the map. Shared
+    // with whoever keeps it between queries, so that it lives for as long as the analysis runs
+    std::shared_ptr<SegmentContractionHierarchy> m_hierarchy;
 
   public:
-    SegmentTopologicalShortestPath(ShapeGraph &map) : m_map(map) {}
+    SegmentTopologicalShortestPath(ShapeGraph &map, std::shared_ptr<SegmentContractionHierarchy> hierarchy = nullptr)
+        : m_map(map), m_hierarchy(std::move(hierarchy)) {}
     std::string getAnalysisName() const override { return "Topological Shortest Path"; }
     bool run(Communicator *comm) override;
 };
@@ -48,7 +48,7 @@ bool SegmentTulipShortestPath::run(Communicator *) {
 
     int opencount = 0;
 
-    int row = std::distance(m_map.getAllShapes().begin(), m_map.getAllShapes().find(refFrom));
+    int row = m_map.getShapeIndexFromKey(refFrom);
     if (row != -1) {
         bins[0].push_back(SegmentData(0, row, SegmentRef(), 0, 0.0, 0));
         opencount++;
@@ -20,99 +20,189 @@
 #include "salalib/axialmap.h"
 #include "salalib/mapconverter.h"
 
-TEST_CASE("Shortest paths working examples", "") {
+namespace {
     const float EPSILON = 0.001;
 
-    // construct an axial map which will result in three different paths for the three types
-    ShapeGraph axialMap("Dummy drawing map", ShapeMap::AXIALMAP);
-    axialMap.initialiseAttributesAxial();
-    std::vector<Line> lines;
-    lines.push_back(Line(Point2f(1.05000000, 1.00000000), Point2f(3.60000000, 1.00000000)));
-    lines.push_back(Line(Point2f(3.43455142, 2.92439257), Point2f(4.15448579, 3.75607430)));
-    lines.push_back(Line(Point2f(2.40000000, 3.00000000), Point2f(3.60000000, 3.00000000)));
-    lines.push_back(Line(Point2f(1.15022677, 0.90136061), Point2f(1.34977323, 2.09863939)));
-    lines.push_back(Line(Point2f(3.50000000, 3.10000000), Point2f(3.50000000, 0.90000000)));
-    lines.push_back(Line(Point2f(1.24560093, 1.95201016), Point2f(2.11199711, 2.42593102)));
-    lines.push_back(Line(Point2f(1.96351621, 2.29850806), Point2f(2.56074850, 3.07943312)));
-
-    lines.push_back(Line(Point2f(1.28848772, 1.91061952), Point2f(1.75546653, 2.84134127)));
-    lines.push_back(Line(Point2f(1.61521977, 2.72198377), Point2f(2.59540115, 3.02997701)));
-    lines.push_back(Line(Point2f(1.23737734, 1.07071068), Point2f(0.45955989, 0.29289322)));
-    for (Line line : lines) {
-        axialMap.makeLineShape(line);
+    // an axial map which will result in three different paths for the three types
+    std::vector<Line> makeLines() {
+        std::vector<Line> lines;
+        lines.push_back(Line(Point2f(1.05000000, 1.00000000), Point2f(3.60000000, 1.00000000)));
+        lines.push_back(Line(Point2f(3.43455142, 2.92439257), Point2f(4.15448579, 3.75607430)));
+        lines.push_back(Line(Point2f(2.40000000, 3.00000000), Point2f(3.60000000, 3.00000000)));
+        lines.push_back(Line(Point2f(1.15022677, 0.90136061), Point2f(1.34977323, 2.09863939)));
+        lines.push_back(Line(Point2f(3.50000000, 3.10000000), Point2f(3.50000000, 0.90000000)));
+        lines.push_back(Line(Point2f(1.24560093, 1.95201016), Point2f(2.11199711, 2.42593102)));
+        lines.push_back(Line(Point2f(1.96351621, 2.29850806), Point2f(2.56074850, 3.07943312)));
+
+        lines.push_back(Line(Point2f(1.28848772, 1.91061952), Point2f(1.75546653, 2.84134127)));
+        lines.push_back(Line(Point2f(1.61521977, 2.72198377), Point2f(2.59540115, 3.02997701)));
+        lines.push_back(Line(Point2f(1.23737734, 1.07071068), Point2f(0.45955989, 0.29289322)));
+        return lines;
     }
-    axialMap.makeConnections();
 
-    REQUIRE(axialMap.getShapeCount() == 10);
+    // the segment map of the lines with the two ends of the paths (lines 1 and 9) selected
+    std::unique_ptr<ShapeGraph> makeSegmentMap(const std::vector<Line> &lines) {
+        ShapeGraph axialMap("Dummy drawing map", ShapeMap::AXIALMAP);
+        axialMap.initialiseAttributesAxial();
+        for (Line line : lines) {
+            axialMap.makeLineShape(line);
+        }
+        axialMap.makeConnections();
+
+        REQUIRE(axialMap.getShapeCount() == 10);
+
+        std::unique_ptr<ShapeGraph> segmentMap =
+            MapConverter::convertAxialToSegment(nullptr, axialMap, "Dummy segment map", true, true, 0.4);
 
-    std::unique_ptr<ShapeGraph> segmentMap =
-        MapConverter::convertAxialToSegment(nullptr, axialMap, "Dummy segment map", true, true, 0.4);
+        REQUIRE(segmentMap->getShapeCount() == 10);
 
-    REQUIRE(segmentMap->getShapeCount() == 10);
+        // select the two edges
+        QtRegion selRegion(lines[1].midpoint(), lines[1].midpoint());
+        segmentMap->setCurSel(selRegion, false);
+        selRegion.bottom_left = lines[9].midpoint();
+        selRegion.top_right = lines[9].midpoint();
+        segmentMap->setCurSel(selRegion, true);
+        REQUIRE(segmentMap->getSelCount() == 2);
+        return segmentMap;
+    }
 
-    // select the two edges
-    QtRegion selRegion(lines[1].midpoint(), lines[1].midpoint());
-    segmentMap->setCurSel(selRegion, false);
-    selRegion.bottom_left = lines[9].midpoint();
-    selRegion.top_right = lines[9].midpoint();
-    segmentMap->setCurSel(selRegion, true);
-    REQUIRE(segmentMap->getSelCount() == 2);
+    // the expected values of each line's segment
+    const std::vector<double> expectedMetricDistances = {-1, 0, 1, 3.57756, -1, 2.67689, 1.89156, -1, -1, 4.58446};
+    const std::vector<int> expectedMetricOrder = {-1, 0, 1, 4, -1, 3, 2, -1, -1, 5};
+    const std::vector<double> expectedTopologicalDepths = {2, 0, -1, -1, 1, -1, -1, -1, -1, 3};
+    const std::vector<int> expectedTopologicalOrder = {2, 0, -1, -1, 1, -1, -1, -1, -1, 3};
+
+    void requirePathValues(ShapeGraph &segmentMap, const std::vector<Line> &lines, const std::string &valueColumn,
+                           const std::string &orderColumn, const std::vector<double> &expectedValues,
+                           const std::vector<int> &expectedOrder) {
+        REQUIRE(segmentMap.getAttributeTable().hasColumn(valueColumn));
+        REQUIRE(segmentMap.getAttributeTable().hasColumn(orderColumn));
+        int valueColIdx = segmentMap.getAttributeTable().getColumnIndex(valueColumn);
+        int orderColIdx = segmentMap.getAttributeTable().getColumnIndex(orderColumn);
+        for (int i = 0; i < lines.size(); i++) {
+            QtRegion selRegion(lines[i].midpoint(), lines[i].midpoint());
+            AttributeRow &shapeRow =
+                segmentMap.getAttributeRowFromShapeIndex(segmentMap.getShapesInRegion(selRegion).begin()->first);
+            REQUIRE(shapeRow.getValue(valueColIdx) == Approx(expectedValues[i]).epsilon(EPSILON));
+            REQUIRE(shapeRow.getValue(orderColIdx) == expectedOrder[i]);
+        }
+    }
+} // namespace
+
+TEST_CASE("Shortest paths working examples", "") {
+    std::vector<Line> lines = makeLines();
+    std::unique_ptr<ShapeGraph> segmentMap = makeSegmentMap(lines);
 
     {
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Angular Shortest Path Angle"));
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Angular Shortest Path Order"));
         SegmentTulipShortestPath(*segmentMap.get()).run(nullptr);
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Angular Shortest Path Angle"));
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Angular Shortest Path Order"));
-        int angleColIdx = segmentMap->getAttributeTable().getColumnIndex("Angular Shortest Path Angle");
-        int orderColIdx = segmentMap->getAttributeTable().getColumnIndex("Angular Shortest Path Order");
         std::vector<double> expectedAngles = {-1, 0, 0.54297, 1.42969, -1, -1, -1, 1.24219, 0.734375, 1.82422};
         std::vector<int> expectedOrder = {-1, 0, 1, 4, -1, -1, -1, 3, 2, 5};
-        for (int i = 0; i < lines.size(); i++) {
-            QtRegion selRegion(lines[i].midpoint(), lines[i].midpoint());
-            AttributeRow &shapeRow =
-                segmentMap->getAttributeRowFromShapeIndex(segmentMap->getShapesInRegion(selRegion).begin()->first);
-
-            REQUIRE(shapeRow.getValue(angleColIdx) == Approx(expectedAngles[i]).epsilon(EPSILON));
-            REQUIRE(shapeRow.getValue(orderColIdx) == expectedOrder[i]);
-        }
+        requirePathValues(*segmentMap, lines, "Angular Shortest Path Angle", "Angular Shortest Path Order",
+                          expectedAngles, expectedOrder);
     }
 
     {
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Metric Shortest Path Distance"));
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Metric Shortest Path Order"));
         SegmentMetricShortestPath(*segmentMap.get()).run(nullptr);
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Metric Shortest Path Distance"));
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Metric Shortest Path Order"));
-        int distanceColIdx = segmentMap->getAttributeTable().getColumnIndex("Metric Shortest Path Distance");
-        int orderColIdx = segmentMap->getAttributeTable().getColumnIndex("Metric Shortest Path Order");
-        std::vector<double> expectedDistances = {-1, 0, 1, 3.57756, -1, 2.67689, 1.89156, -1, -1, 4.58446};
-        std::vector<int> expectedOrder = {-1, 0, 1, 4, -1, 3, 2, -1, -1, 5};
-        for (int i = 0; i < lines.size(); i++) {
-            QtRegion selRegion(lines[i].midpoint(), lines[i].midpoint());
-            AttributeRow &shapeRow =
-                segmentMap->getAttributeRowFromShapeIndex(segmentMap->getShapesInRegion(selRegion).begin()->first);
-            REQUIRE(shapeRow.getValue(distanceColIdx) == Approx(expectedDistances[i]).epsilon(EPSILON));
-            REQUIRE(shapeRow.getValue(orderColIdx) == expectedOrder[i]);
-        }
+        requirePathValues(*segmentMap, lines, "Metric Shortest Path Distance", "Metric Shortest Path Order",
+                          expectedMetricDistances, expectedMetricOrder);
     }
 
     {
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Topological Shortest Path Depth"));
         REQUIRE_FALSE(segmentMap->getAttributeTable().hasColumn("Topological Shortest Path Order"));
         SegmentTopologicalShortestPath(*segmentMap.get()).run(nullptr);
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Topological Shortest Path Depth"));
-        REQUIRE(segmentMap->getAttributeTable().hasColumn("Topological Shortest Path Order"));
-        int depthColIdx = segmentMap->getAttributeTable().getColumnIndex("Topological Shortest Path Depth");
-        int orderColIdx = segmentMap->getAttributeTable().getColumnIndex("Topological Shortest Path Order");
-        std::vector<double> expectedDepths = {2, 0, -1, -1, 1, -1, -1, -1, -1, 3};
-        std::vector<int> expectedOrder = {2, 0, -1, -1, 1, -1, -1, -1, -1, 3};
-        for (int i = 0; i < lines.size(); i++) {
-            QtRegion selRegion(lines[i].midpoint(), lines[i].midpoint());
-            AttributeRow &shapeRow =
-                segmentMap->getAttributeRowFromShapeIndex(segmentMap->getShapesInRegion(selRegion).begin()->first);
-            REQUIRE(shapeRow.getValue(depthColIdx) == Approx(expectedDepths[i]).epsilon(EPSILON));
-            REQUIRE(shapeRow.getValue(orderColIdx) == expectedOrder[i]);
+        requirePathValues(*segmentMap, lines, "Topological Shortest Path Depth", "Topological Shortest Path Order",
+                          expectedTopologicalDepths, expectedTopologicalOrder);
+    }
+}
+
+TEST_CASE("Shortest paths through a contraction hierarchy", "") {
+    std::vector<Line> lines = makeLines();
+    std::unique_ptr<ShapeGraph> segmentMap = makeSegmentMap(lines);
+
+    SECTION("Metric") {
+        auto hierarchy = std::make_shared<SegmentContractionHierarchy>(SegmentContractionHierarchy::CostType::METRIC);
+        REQUIRE_FALSE(hierarchy->isValidFor(*segmentMap));
+        SegmentMetricShortestPath(*segmentMap, hierarchy).run(nullptr);
+        REQUIRE(hierarchy->isValidFor(*segmentMap));
+        requirePathValues(*segmentMap, lines, "Metric Shortest Path Distance", "Metric Shortest Path Order",
+                          expectedMetricDistances, expectedMetricOrder);
+    }
+
+    SECTION("Topological") {
+        auto hierarchy =
+            std::make_shared<SegmentContractionHierarchy>(SegmentContractionHierarchy::CostType::TOPOLOGICAL);
+        SegmentTopologicalShortestPath(*segmentMap, hierarchy).run(nullptr);
+        requirePathValues(*segmentMap, lines, "Topological Shortest Path Depth", "Topological Shortest Path Order",
+                          expectedTopologicalDepths, expectedTopologicalOrder);
+    }
+
+    SECTION("Changed costs") {
+        SegmentContractionHierarchy hierarchy(SegmentContractionHierarchy::CostType::METRIC);
+        REQUIRE(hierarchy.build(*segmentMap));
+        REQUIRE(hierarchy.isValidFor(*segmentMap));
+        // same segments and connections, but a cost the hierarchy was not built with
+        AttributeRow &row = segmentMap->getAttributeRowFromShapeIndex(0);
+        row.setValue("Segment Length", row.getValue("Segment Length") * 2);
+        REQUIRE_FALSE(hierarchy.isValidFor(*segmentMap));
+        // the topological costs do not depend on it
+        SegmentContractionHierarchy topological(SegmentContractionHierarchy::CostType::TOPOLOGICAL);
+        REQUIRE(topological.build(*segmentMap));
+        row.setValue("Segment Length", row.getValue("Segment Length") / 2);
+        REQUIRE(topological.isValidFor(*segmentMap));
+    }
+
+    SECTION("All pairs against a plain search") {
+        SegmentContractionHierarchy hierarchy(SegmentContractionHierarchy::CostType::METRIC);
+        REQUIRE(hierarchy.build(*segmentMap));
+
+        size_t segmentCount = segmentMap->getShapeCount();
+        std::vector<float> lengths;
+        for (size_t i = 0; i < segmentCount; i++) {
+            lengths.push_back(segmentMap->getAttributeRowFromShapeIndex(i).getValue("Segment Length"));
+        }
+        for (size_t origin = 0; origin < segmentCount; origin++) {
+            // plain dijkstra, small enough to simply scan for the closest open segment
+            std::vector<double> dist(segmentCount, -1);
+            std::vector<bool> done(segmentCount, false);
+            dist[origin] = 0;
+            while (true) {
+                int closest = -1;
+                for (size_t i = 0; i < segmentCount; i++) {
+                    if (!done[i] && dist[i] >= 0 && (closest == -1 || dist[i] < dist[closest])) {
+                        closest = i;
+                    }
+                }
+                if (closest == -1) {
+                    break;
+                }
+                done[closest] = true;
+                const Connector &connector = segmentMap->getConnections()[closest];
+                for (auto *segconns : {&connector.m_back_segconns, &connector.m_forward_segconns}) {
+                    for (auto &segconn : *segconns) {
+                        int to = segconn.first.ref;
+                        double cost = dist[closest] + (lengths[closest] + lengths[to]) * 0.5;
+                        if (dist[to] < 0 || cost < dist[to]) {
+                            dist[to] = cost;
+                        }
+                    }
+                }
+            }
+            for (size_t destination = 0; destination < segmentCount; destination++) {
+                SegmentContractionHierarchy::Path path = hierarchy.findPath(origin, destination);
+                if (dist[destination] < 0) {
+                    REQUIRE_FALSE(path.found());
+                } else {
+                    REQUIRE(path.found());
+                    REQUIRE(path.segments.front() == origin);
+                    REQUIRE(path.segments.back() == destination);
+                    REQUIRE(path.costs.back() == Approx(dist[destination]).epsilon(EPSILON));
+                }
+            }
         }
     }
 }
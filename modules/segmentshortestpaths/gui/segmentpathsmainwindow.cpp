@@ -24,6 +24,8 @@
 #include <QMenuBar>
 #include <QMessageBox>
 
+#include <set>
+
 bool SegmentPathsMainWindow::createMenus(MainWindow *mainWindow) {
     QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
     QMenu *segmentMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("&Segment"));
@@ -47,9 +49,52 @@ bool SegmentPathsMainWindow::createMenus(MainWindow *mainWindow) {
             [this, mainWindow] { OnShortestPath(mainWindow, PathType::TOPOLOGICAL); });
     shortestPathsMenu->addAction(topoPathAct);
 
+    shortestPathsMenu->addSeparator();
+    m_useIndexAct = new QAction(tr("Index for repeated queries"), mainWindow);
+    m_useIndexAct->setStatusTip(tr("Prepare an index on the first metric or topological query to speed up the "
+                                   "following ones"));
+    m_useIndexAct->setCheckable(true);
+    connect(m_useIndexAct, &QAction::toggled, this, [this](bool checked) {
+        if (!checked) {
+            m_hierarchies.clear();
+        }
+    });
+    shortestPathsMenu->addAction(m_useIndexAct);
+
     return true;
 }
 
+std::shared_ptr<SegmentContractionHierarchy>
+SegmentPathsMainWindow::getHierarchy(QGraphDoc *graphDoc, const ShapeGraph &map,
+                                     SegmentContractionHierarchy::CostType costType) {
+    if (m_useIndexAct == nullptr || !m_useIndexAct->isChecked()) {
+        return nullptr;
+    }
+    if (m_hierarchies.find(graphDoc) == m_hierarchies.end()) {
+        connect(graphDoc, &QObject::destroyed, this, [this, graphDoc] { m_hierarchies.erase(graphDoc); });
+    }
+    Hierarchies &docHierarchies = m_hierarchies[graphDoc];
+
+    // drop those of the maps the document no longer has
+    std::set<const ShapeGraph *> shapeGraphs;
+    for (const auto &shapeGraph : graphDoc->m_meta_graph->getShapeGraphs()) {
+        shapeGraphs.insert(shapeGraph.get());
+    }
+    for (auto *hierarchies : {&docHierarchies.metric, &docHierarchies.topological}) {
+        for (auto iter = hierarchies->begin(); iter != hierarchies->end();) {
+            iter = shapeGraphs.count(iter->first) ? std::next(iter) : hierarchies->erase(iter);
+        }
+    }
+
+    auto &hierarchy = (costType == SegmentContractionHierarchy::CostType::METRIC ? docHierarchies.metric
+                                                                                : docHierarchies.topological)[&map];
+    if (!hierarchy) {
+        // the analysis builds it in the worker thread if it does not match the map
+        hierarchy.reset(new SegmentContractionHierarchy(costType));
+    }
+    return hierarchy;
+}
+
 void SegmentPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathType) {
     QGraphDoc *graphDoc = mainWindow->activeMapDoc();
     if (graphDoc == nullptr)
@@ -77,15 +122,19 @@ void SegmentPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pat
         graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
             new SegmentTulipShortestPath(graphDoc->m_meta_graph->getDisplayedShapeGraph())));
         break;
-    case PathType::METRIC:
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
-            new SegmentMetricShortestPath(graphDoc->m_meta_graph->getDisplayedShapeGraph())));
+    case PathType::METRIC: {
+        ShapeGraph &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(new SegmentMetricShortestPath(
+            map, getHierarchy(graphDoc, map, SegmentContractionHierarchy::CostType::METRIC))));
         break;
-    case PathType::TOPOLOGICAL:
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
-            new SegmentTopologicalShortestPath(graphDoc->m_meta_graph->getDisplayedShapeGraph())));
+    }
+    case PathType::TOPOLOGICAL: {
+        ShapeGraph &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(new SegmentTopologicalShortestPath(
+            map, getHierarchy(graphDoc, map, SegmentContractionHierarchy::CostType::TOPOLOGICAL))));
         break;
     }
+    }
     graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
     graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
     graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
@@ -15,13 +15,33 @@
 
 #pragma once
 
+#include "modules/segmentshortestpaths/core/segmcontractionhierarchy.h"
+
 #include "depthmapX/imainwindowmodule.h"
 
+#include <map>
+#include <memory>
+
+class QGraphDoc;
+
 class SegmentPathsMainWindow : public IMainWindowModule {
 
   private:
     enum PathType { ANGULAR, METRIC, TOPOLOGICAL };
 
+    // contraction hierarchies kept per document and segment map so that repeated
+    // queries do not have to search the whole graph. Built on the first query,
+    // and shared with the analysis so that dropping them here while one runs is safe
+    struct Hierarchies {
+        std::map<const ShapeGraph *, std::shared_ptr<SegmentContractionHierarchy>> metric;
+        std::map<const ShapeGraph *, std::shared_ptr<SegmentContractionHierarchy>> topological;
+    };
+    QAction *m_useIndexAct = nullptr;
+    std::map<const QGraphDoc *, Hierarchies> m_hierarchies;
+
+    std::shared_ptr<SegmentContractionHierarchy> getHierarchy(QGraphDoc *graphDoc, const ShapeGraph &map,
+                                                              SegmentContractionHierarchy::CostType costType);
+
   private slots:
     void OnShortestPath(MainWindow *mainWindow, PathType pathType);
 
@@ -0,0 +1,77 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+BenchmarkRunner::BenchmarkRunner(const std::string &filter, double minSeconds, size_t minIterations)
+    : m_filter(filter), m_minSeconds(minSeconds), m_minIterations(std::max(size_t(1), minIterations))
+{
+}
+
+bool BenchmarkRunner::isSelected(const std::string &name, const std::string &input) const
+{
+    return m_filter.empty() || (name + ":" + input).find(m_filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string &name, const std::string &input, const std::function<void()> &body,
+                          const std::function<void()> &prepare)
+{
+    if (!isSelected(name, input))
+    {
+        return;
+    }
+    std::vector<double> times;
+    double total = 0.0;
+    while (times.size() < m_minIterations || total < m_minSeconds)
+    {
+        if (prepare)
+        {
+            prepare();
+        }
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        times.push_back(seconds);
+        total += seconds;
+    }
+    std::sort(times.begin(), times.end());
+    double median = times.size() % 2 == 1 ? times[times.size() / 2]
+                                          : (times[times.size() / 2 - 1] + times[times.size() / 2]) * 0.5;
+    m_results.push_back(Result{name, input, times.size(), times.front(), median, total / double(times.size())});
+
+    std::cout << std::left << std::setw(32) << name << std::setw(36) << input << std::right << std::setw(8)
+              << times.size() << std::fixed << std::setprecision(6) << std::setw(14) << times.front()
+              << std::setw(14) << median << std::defaultfloat << std::endl;
+}
+
+void BenchmarkRunner::writeJson(std::ostream &stream) const
+{
+    stream << "{\"benchmarks\":[";
+    for (size_t i = 0; i < m_results.size(); i++)
+    {
+        const Result &result = m_results[i];
+        stream << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << result.name << "\",\"input\":\"" << result.input
+               << "\",\"iterations\":" << result.iterations << std::setprecision(9)
+               << ",\"min_seconds\":" << result.minSeconds << ",\"median_seconds\":" << result.medianSeconds
+               << ",\"mean_seconds\":" << result.meanSeconds << "}";
+    }
+    stream << "\n]}\n" << std::flush;
+}
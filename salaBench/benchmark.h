@@ -0,0 +1,58 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ *  Runs benchmarks and keeps their timings. Each benchmark is run over and over until it has taken
+ *  at least the minimum time and run the minimum number of times, and the fastest, median and mean
+ *  of the runs are kept
+ */
+class BenchmarkRunner
+{
+public:
+    struct Result
+    {
+        std::string name;
+        std::string input;
+        size_t iterations;
+        double minSeconds;
+        double medianSeconds;
+        double meanSeconds;
+    };
+
+    // only benchmarks with the filter in their "name:input" are run (all of them if it is empty)
+    BenchmarkRunner(const std::string &filter, double minSeconds, size_t minIterations);
+
+    bool isSelected(const std::string &name, const std::string &input) const;
+
+    // times body, calling prepare before each run of it (untimed) to put back whatever it changed
+    void run(const std::string &name, const std::string &input, const std::function<void()> &body,
+             const std::function<void()> &prepare = std::function<void()>());
+
+    const std::vector<Result> &getResults() const { return m_results; }
+    void writeJson(std::ostream &stream) const;
+
+private:
+    std::string m_filter;
+    double m_minSeconds;
+    size_t m_minIterations;
+    std::vector<Result> m_results;
+};
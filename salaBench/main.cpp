@@ -0,0 +1,155 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "benchmark.h"
+#include "salabenchmarks.h"
+
+#include "salalib/mgraph.h"
+#include "genlib/stringutils.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    void printHelp()
+    {
+        std::cout << "Usage: salaBench [options]\n"
+                  << "Times the hot paths of salalib on the test data maps and on synthetic grids\n"
+                  << "  --filter <text>  only run the benchmarks with <text> in their \"name:input\"\n"
+                  << "  --out <file>     write the results as JSON to <file>\n"
+                  << "  --min-time <s>   run each benchmark for at least <s> seconds (default 1)\n"
+                  << "  --min-runs <n>   run each benchmark at least <n> times (default 3)\n"
+                  << "  --sizes <list>   comma separated sizes of the synthetic grids, each also giving a street\n"
+                  << "                   network of a quarter of its square in cells (default 32,64,128)\n"
+                  << "  --testdata <dir> directory of the test data maps (default " << SALABENCH_TESTDATA << ")\n"
+                  << "  -h               print this help" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string outFile;
+    double minSeconds = 1.0;
+    size_t minIterations = 3;
+    std::vector<int> sizes = {32, 64, 128};
+    std::string testdata = SALABENCH_TESTDATA;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help")
+            {
+                printHelp();
+                return 0;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument(arg + " requires an argument or is unknown");
+            }
+            std::string value = argv[++i];
+            if (arg == "--filter")
+            {
+                filter = value;
+            }
+            else if (arg == "--out")
+            {
+                outFile = value;
+            }
+            else if (arg == "--min-time")
+            {
+                minSeconds = std::stod(value);
+            }
+            else if (arg == "--min-runs")
+            {
+                minIterations = std::stoul(value);
+            }
+            else if (arg == "--sizes")
+            {
+                sizes.clear();
+                for (const std::string &size : dXstring::split(value, ',', true))
+                {
+                    sizes.push_back(std::stoi(size));
+                }
+            }
+            else if (arg == "--testdata")
+            {
+                testdata = value;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+
+        BenchmarkRunner runner(filter, minSeconds, minIterations);
+        std::cout << std::left << std::setw(32) << "benchmark" << std::setw(36) << "input" << std::right
+                  << std::setw(8) << "runs" << std::setw(14) << "min (s)" << std::setw(14) << "median (s)"
+                  << std::endl;
+
+        for (int size : sizes)
+        {
+            std::string input = "grid" + std::to_string(size);
+            std::unique_ptr<MetaGraph> graph = salabench::makeGridGraph(size);
+            salabench::runVgaBenchmarks(runner, *graph, input);
+            salabench::runExportBenchmarks(runner, *graph, input);
+            salabench::runAttributeTableBenchmarks(runner, size_t(size) * size, 16);
+
+            int cells = size * size / 4;
+            std::unique_ptr<MetaGraph> streetGraph = salabench::makeStreetGraph(cells);
+            salabench::runSegmentBenchmarks(runner, *streetGraph, "voronoi" + std::to_string(cells));
+            salabench::runSegmentPathBenchmarks(runner, *streetGraph, "voronoi" + std::to_string(cells));
+            salabench::runExportBenchmarks(runner, *streetGraph, "voronoi" + std::to_string(cells));
+        }
+
+        std::string gallery = testdata + "/gallery_connected.graph";
+        std::unique_ptr<MetaGraph> galleryGraph = salabench::loadGraph(gallery);
+        salabench::runVgaBenchmarks(runner, *galleryGraph, "gallery_connected.graph");
+        salabench::runExportBenchmarks(runner, *galleryGraph, "gallery_connected.graph");
+        galleryGraph.reset();
+
+        std::string barnsbury = testdata + "/barnsbury_extended1_segment.graph";
+        std::unique_ptr<MetaGraph> barnsburyGraph = salabench::loadGraph(barnsbury);
+        salabench::runSegmentBenchmarks(runner, *barnsburyGraph, "barnsbury_extended1_segment.graph");
+        salabench::runSegmentPathBenchmarks(runner, *barnsburyGraph, "barnsbury_extended1_segment.graph");
+        salabench::runExportBenchmarks(runner, *barnsburyGraph, "barnsbury_extended1_segment.graph");
+        barnsburyGraph.reset();
+
+        salabench::runGraphFileBenchmarks(runner, gallery, "gallery_connected.graph");
+        salabench::runGraphFileBenchmarks(runner, barnsbury, "barnsbury_extended1_segment.graph");
+
+        for (const std::string dxf : {"barnsbury_extended1.dxf", "barnsbury_extended2.dxf", "gallery.dxf"})
+        {
+            salabench::runDxfBenchmarks(runner, testdata + "/" + dxf, dxf);
+        }
+
+        if (!outFile.empty())
+        {
+            std::ofstream stream(outFile);
+            runner.writeJson(stream);
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << "\n"
+                  << "Type 'salaBench -h' for help" << std::endl;
+        return -1;
+    }
+    return 0;
+}
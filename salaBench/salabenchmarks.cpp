@@ -0,0 +1,309 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salabenchmarks.h"
+
+#include "salalib/isovist.h"
+#include "salalib/mgraph.h"
+#include "salalib/options.h"
+#include "salalib/parsers/dxfp.h"
+#include "salalib/segmmodules/segmtulip.h"
+#include "salalib/segmmodules/segmtulipdepth.h"
+#include "salalib/sparksieve2.h"
+#include "salalib/syntheticplans.h"
+#include "salalib/vgamodules/vgaangulardepth.h"
+#include "salalib/vgamodules/vgametricdepth.h"
+#include "salalib/vgamodules/vgavisualglobaldepth.h"
+
+#include "modules/segmentshortestpaths/core/segmcontractionhierarchy.h"
+
+#include "genlib/exceptions.h"
+#include "genlib/simplematrix.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace salabench {
+
+    namespace {
+        // the pillars are one cell wide, with this many cells from one to the next
+        const int GRID_PILLAR_SPACING = 4;
+        // the number of point to point queries timed together on a contraction hierarchy
+        const size_t HIERARCHY_QUERY_COUNT = 100;
+
+        void addSquare(ShapeMap &map, double minX, double minY, double maxX, double maxY) {
+            map.makePolyShape({Point2f(minX, minY), Point2f(minX, maxY), Point2f(maxX, maxY), Point2f(maxX, minY)},
+                              false);
+        }
+
+        std::vector<PixelRef> getFilledPixels(PointMap &map) {
+            std::vector<PixelRef> filled;
+            for (size_t i = 0; i < map.getCols(); i++) {
+                for (size_t j = 0; j < map.getRows(); j++) {
+                    PixelRef pixel(static_cast<short>(i), static_cast<short>(j));
+                    if (map.getPoint(pixel).filled()) {
+                        filled.push_back(pixel);
+                    }
+                }
+            }
+            return filled;
+        }
+
+        std::vector<Line> getDrawingLines(MetaGraph &graph) {
+            std::vector<Line> lines;
+            for (auto &file : graph.m_drawingFiles) {
+                for (auto &layer : file.m_spacePixels) {
+                    for (const SimpleLine &line : layer.getAllShapesAsLines()) {
+                        lines.emplace_back(line.start(), line.end());
+                    }
+                }
+            }
+            return lines;
+        }
+    } // namespace
+
+    std::unique_ptr<MetaGraph> loadGraph(const std::string &filename) {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        int result = graph->readFromFile(filename);
+        if (result != MetaGraph::OK) {
+            throw depthmapX::RuntimeException("Failed to load graph from file " + filename + ", error " +
+                                              std::to_string(result));
+        }
+        return graph;
+    }
+
+    std::unique_ptr<MetaGraph> makeGridGraph(int size) {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        graph->m_drawingFiles.emplace_back("Synthetic grid");
+        graph->m_drawingFiles.back().m_spacePixels.emplace_back("Walls");
+        ShapeMap &walls = graph->m_drawingFiles.back().m_spacePixels.back();
+
+        // the walls are on the cell edges, with the cell centres on whole numbers
+        addSquare(walls, 0.5, 0.5, size + 0.5, size + 0.5);
+        for (int x = GRID_PILLAR_SPACING / 2; x < size - 1; x += GRID_PILLAR_SPACING) {
+            for (int y = GRID_PILLAR_SPACING / 2; y < size - 1; y += GRID_PILLAR_SPACING) {
+                addSquare(walls, x + 0.5, y + 0.5, x + 1.5, y + 1.5);
+            }
+        }
+        graph->updateParentRegions(walls);
+
+        graph->addNewPointMap("Synthetic grid VGA");
+        PointMap &map = graph->getPointMaps().back();
+        map.setGrid(1.0);
+        map.makePoints(Point2f(1.01, 1.01), 0);
+        map.sparkGraph2(nullptr, false, -1);
+        return graph;
+    }
+
+    std::unique_ptr<MetaGraph> makeStreetGraph(int cells) {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::SyntheticPlan plan = depthmapX::generateVoronoiStreets(cells, 0, 0.5);
+        depthmapX::addSyntheticDrawing(*graph, plan, "Synthetic streets");
+        graph->convertDrawingToSegment(nullptr, "Synthetic streets segment");
+        return graph;
+    }
+
+    void runVgaBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input) {
+        PointMap &map = graph.getDisplayedPointMap();
+        std::vector<PixelRef> filled = getFilledPixels(map);
+        if (filled.empty()) {
+            return;
+        }
+        PixelRef origin = filled[filled.size() / 2];
+        Point2f centre = map.depixelate(origin);
+
+        // the drawing lines cropped to the quadrant each octant of the sieve looks into
+        std::vector<std::vector<Line>> octantLines(8);
+        QtRegion region = graph.getBoundingBox();
+        for (int q = 0; q < 8; q++) {
+            bool left = q % 2 == 0;
+            bool top = q < 2 || q > 5;
+            QtRegion quadrant(Point2f(left ? region.bottom_left.x : centre.x, top ? centre.y : region.bottom_left.y),
+                              Point2f(left ? centre.x : region.top_right.x, top ? region.top_right.y : centre.y));
+            for (Line line : getDrawingLines(graph)) {
+                if (line.crop(quadrant)) {
+                    octantLines[q].push_back(line);
+                }
+            }
+        }
+        runner.run("sparksieve2/block", input, [&]() {
+            for (int q = 0; q < 8; q++) {
+                sparkSieve2 sieve(centre);
+                sieve.block(octantLines[q], q);
+                sieve.collectgarbage();
+            }
+        });
+
+        // about 64 isovists from points spread over the map
+        std::vector<Point2f> isovistPoints;
+        for (size_t i = 0; i < filled.size(); i += std::max(size_t(1), filled.size() / 64)) {
+            isovistPoints.push_back(map.depixelate(filled[i]));
+        }
+        Isovist warmup;
+        graph.makeIsovist(centre, warmup); // makes the BSP tree, so that it is not part of the timing
+        runner.run("isovist/makeit", input, [&]() {
+            for (const Point2f &point : isovistPoints) {
+                Isovist isovist;
+                graph.makeIsovist(point, isovist);
+            }
+        });
+
+        // every node passing its unseen pixels on, as the visibility search does
+        VGAVisualGlobalDepth visualDepth;
+        depthmapX::RowMatrix<int> miscs(map.getRows(), map.getCols());
+        depthmapX::RowMatrix<PixelRef> extents(map.getRows(), map.getCols());
+        runner.run(
+            "node/extract-unseen", input,
+            [&]() {
+                PixelRefVector pixels;
+                for (PixelRef pixel : filled) {
+                    pixels.clear();
+                    visualDepth.extractUnseen(map.getPoint(pixel).getNode(), pixels, miscs, extents);
+                    for (PixelRef seen : pixels) {
+                        miscs(seen.y, seen.x) = 0;
+                    }
+                }
+            },
+            [&]() {
+                for (size_t i = 0; i < map.getCols(); i++) {
+                    for (size_t j = 0; j < map.getRows(); j++) {
+                        miscs(j, i) = 0;
+                        extents(j, i) = PixelRef(static_cast<short>(i), static_cast<short>(j));
+                    }
+                }
+            });
+
+        map.setCurSel(std::vector<int>{int(origin)});
+        runner.run("vga/visual-depth", input, [&]() { VGAVisualGlobalDepth().run(nullptr, map, false); });
+        runner.run("vga/metric-depth", input, [&]() { VGAMetricDepth().run(nullptr, map, false); });
+        runner.run("vga/angular-depth", input, [&]() { VGAAngularDepth().run(nullptr, map, false); });
+        map.clearSel();
+
+        // remaking the graph last, as it leaves the map without the attributes of the analyses
+        runner.run(
+            "vga/make-graph", input, [&]() { map.sparkGraph2(nullptr, false, -1); }, [&]() { map.unmake(false); });
+    }
+
+    void runSegmentBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input) {
+        ShapeGraph &map = graph.getDisplayedShapeGraph();
+        if (map.getShapeCount() == 0) {
+            return;
+        }
+        map.setCurSel(std::vector<int>{map.getShapeRefFromIndex(map.getShapeCount() / 2)->first});
+        runner.run("segment/tulip-origin", input, [&]() {
+            SegmentTulip({-1.0}, true, 1024, -1, Options::RADIUS_ANGULAR, true).run(nullptr, map, false);
+        });
+        runner.run("segment/tulip-depth", input, [&]() { SegmentTulipDepth().run(nullptr, map, false); });
+        map.clearSel();
+    }
+
+    void runSegmentPathBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input) {
+        ShapeGraph &map = graph.getDisplayedShapeGraph();
+        if (map.getShapeCount() < 2) {
+            return;
+        }
+        // the same origins and destinations every time, spread over the whole map
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<int> segment(0, int(map.getShapeCount()) - 1);
+        std::vector<std::pair<int, int>> queries(HIERARCHY_QUERY_COUNT);
+        for (auto &query : queries) {
+            query.first = segment(generator);
+            query.second = segment(generator);
+        }
+        for (auto costType : {SegmentContractionHierarchy::CostType::METRIC,
+                              SegmentContractionHierarchy::CostType::TOPOLOGICAL}) {
+            std::string name = costType == SegmentContractionHierarchy::CostType::METRIC
+                                   ? "segment/hierarchy-metric"
+                                   : "segment/hierarchy-topological";
+            if (!runner.isSelected(name, input)) {
+                continue;
+            }
+            SegmentContractionHierarchy hierarchy(costType);
+            hierarchy.build(map);
+            runner.run(name, input, [&]() {
+                for (const auto &query : queries) {
+                    hierarchy.findPath(query.first, query.second);
+                }
+            });
+        }
+    }
+
+    void runExportBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input) {
+        std::string outFile = (std::filesystem::temp_directory_path() / "salabench_export.csv").string();
+        if (!graph.getPointMaps().empty() && runner.isSelected("export/pointmap-csv", input)) {
+            PointMap &map = graph.getDisplayedPointMap();
+            runner.run("export/pointmap-csv", input, [&]() {
+                std::ofstream stream(outFile);
+                map.outputSummary(stream, ',');
+            });
+        }
+        if (!graph.getShapeGraphs().empty() && runner.isSelected("export/shapegraph-csv", input)) {
+            ShapeGraph &map = graph.getDisplayedShapeGraph();
+            runner.run("export/shapegraph-csv", input, [&]() {
+                std::ofstream stream(outFile);
+                map.output(stream, ',');
+            });
+        }
+        std::remove(outFile.c_str());
+    }
+
+    void runGraphFileBenchmarks(BenchmarkRunner &runner, const std::string &filename, const std::string &input) {
+        runner.run("graph/read", input, [&]() { loadGraph(filename); });
+
+        if (runner.isSelected("graph/write", input)) {
+            std::unique_ptr<MetaGraph> graph = loadGraph(filename);
+            std::string outFile = (std::filesystem::temp_directory_path() / "salabench_write.graph").string();
+            runner.run("graph/write", input, [&]() { graph->write(outFile, METAGRAPH_VERSION, false); });
+            std::remove(outFile.c_str());
+        }
+    }
+
+    void runDxfBenchmarks(BenchmarkRunner &runner, const std::string &filename, const std::string &input) {
+        runner.run("dxf/parse", input, [&]() {
+            std::ifstream stream(filename);
+            DxfParser parser;
+            parser.open(stream, filename);
+        });
+    }
+
+    void runAttributeTableBenchmarks(BenchmarkRunner &runner, size_t rowCount, size_t columnCount) {
+        std::string input = std::to_string(rowCount) + "x" + std::to_string(columnCount);
+        AttributeTable table;
+        auto fill = [&]() {
+            for (size_t column = 0; column < columnCount; column++) {
+                table.insertOrResetColumn("Column " + std::to_string(column));
+            }
+            for (size_t row = 0; row < rowCount; row++) {
+                table.addRow(AttributeKey(int(row)));
+            }
+        };
+        runner.run("attributetable/add-rows", input, fill, [&]() { table.clear(); });
+
+        table.clear();
+        fill();
+        runner.run("attributetable/set-values", input, [&]() {
+            AttributeStatsBatch statsBatch(table);
+            for (size_t row = 0; row < rowCount; row++) {
+                AttributeRow &values = table.getRow(AttributeKey(int(row)));
+                for (size_t column = 0; column < columnCount; column++) {
+                    values.setValue(column, float(row + column));
+                }
+            }
+        });
+    }
+
+} // namespace salabench
@@ -0,0 +1,58 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+class MetaGraph;
+
+namespace salabench {
+
+    std::unique_ptr<MetaGraph> loadGraph(const std::string &filename);
+
+    // a square plan of size by size cells with a pillar every few cells in each direction, and the
+    // visibility graph of the space around the pillars
+    std::unique_ptr<MetaGraph> makeGridGraph(int size);
+
+    // a segment map of the streets around the given number of voronoi cells
+    std::unique_ptr<MetaGraph> makeStreetGraph(int cells);
+
+    // sparkSieve2 blocking, graph making, isovists, Node::extractUnseen and the one-source searches
+    // of the VGA depth modules, on the displayed point map (which has to have its graph made)
+    void runVgaBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input);
+
+    // tulip analysis from one origin and tulip depth, on the displayed segment map
+    void runSegmentBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input);
+
+    // 100 point to point shortest path queries between random segments (the same every run), on
+    // metric and topological contraction hierarchies built from the displayed segment map beforehand
+    void runSegmentPathBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input);
+
+    // writing the displayed point map and shape graph out as text, as the EXPORT mode does
+    void runExportBenchmarks(BenchmarkRunner &runner, MetaGraph &graph, const std::string &input);
+
+    // reading the graph file and writing it back out
+    void runGraphFileBenchmarks(BenchmarkRunner &runner, const std::string &filename, const std::string &input);
+
+    void runDxfBenchmarks(BenchmarkRunner &runner, const std::string &filename, const std::string &input);
+
+    // adding rows to and setting all the values of a table of the given size
+    void runAttributeTableBenchmarks(BenchmarkRunner &runner, size_t rowCount, size_t columnCount);
+
+} // namespace salabench
@@ -0,0 +1,240 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/analysischeckpoint.h"
+#include "salalib/mgraph.h"
+#include "salalib/syntheticplans.h"
+#include "salalib/segmmodules/segmtulip.h"
+#include "salalib/vgamodules/vgavisualglobal.h"
+#include "genlib/exceptions.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // cancelled from the start, so that an analysis stops after its first origin
+    class StoppingCommunicator : public Communicator {
+      public:
+        StoppingCommunicator() { Cancel(); }
+        void CommPostMessage(int, int) const override {}
+    };
+
+    std::unique_ptr<MetaGraph> makeSegmentGraph() {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::addSyntheticDrawing(*graph, depthmapX::generateVoronoiStreets(30, 5, 0.5), "Streets");
+        graph->convertDrawingToSegment(nullptr, "Streets segment");
+        return graph;
+    }
+
+    std::unique_ptr<MetaGraph> makeVgaGraph() {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::SyntheticPlan plan = depthmapX::generateFloorplate(2, 0, 0.0);
+        depthmapX::addSyntheticDrawing(*graph, plan, "Floorplate");
+        graph->addNewPointMap("Floorplate VGA");
+        PointMap &map = graph->getPointMaps().back();
+        map.setGrid(1.0);
+        map.makePoints(plan.openPoint, 0);
+        map.sparkGraph2(nullptr, false, -1);
+        return graph;
+    }
+
+    // the same values and the same stats in every column
+    void requireSameTable(const AttributeTable &expected, const AttributeTable &actual) {
+        REQUIRE(expected.getNumColumns() == actual.getNumColumns());
+        REQUIRE(expected.getNumRows() == actual.getNumRows());
+        for (int col = 0; col < expected.getNumColumns(); col++) {
+            REQUIRE(expected.getColumnName(col) == actual.getColumnName(col));
+            const AttributeColumnStats &expectedStats = expected.getColumn(col).getStats();
+            const AttributeColumnStats &actualStats = actual.getColumn(col).getStats();
+            REQUIRE(expectedStats.min == actualStats.min);
+            REQUIRE(expectedStats.max == actualStats.max);
+            REQUIRE(expectedStats.total == actualStats.total);
+        }
+        auto actualRow = actual.begin();
+        for (auto &expectedRow : expected) {
+            REQUIRE(expectedRow.getKey().value == actualRow->getKey().value);
+            for (int col = 0; col < expected.getNumColumns(); col++) {
+                REQUIRE(expectedRow.getRow().getValue(col) == actualRow->getRow().getValue(col));
+            }
+            ++actualRow;
+        }
+    }
+} // namespace
+
+TEST_CASE("Segment tulip carries on from its checkpoint", "") {
+    const char *filename = "testsegmtulip.checkpoint";
+    std::set<double> radii = {-1.0, 0.5};
+
+    auto expected = makeSegmentGraph();
+    SegmentTulip(radii, false, 1024, -1, Options::RADIUS_ANGULAR, true)
+        .run(nullptr, expected->getDisplayedShapeGraph(), false);
+
+    // stopped after one origin each time, and then left to finish
+    StoppingCommunicator stop;
+    for (int run = 0; run < 4; run++) {
+        auto graph = makeSegmentGraph();
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, run > 0);
+        SegmentTulip analysis(radii, false, 1024, -1, Options::RADIUS_ANGULAR, true);
+        analysis.setCheckpoint(&checkpoint);
+        analysis.run(&stop, graph->getDisplayedShapeGraph(), false);
+        REQUIRE(checkpoint.getProcessed() == size_t(run + 1));
+    }
+    auto resumed = makeSegmentGraph();
+    depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+    SegmentTulip analysis(radii, false, 1024, -1, Options::RADIUS_ANGULAR, true);
+    analysis.setCheckpoint(&checkpoint);
+    analysis.run(nullptr, resumed->getDisplayedShapeGraph(), false);
+
+    requireSameTable(expected->getDisplayedShapeGraph().getAttributeTable(),
+                     resumed->getDisplayedShapeGraph().getAttributeTable());
+
+    // the checkpoint is only for the analysis that left it
+    auto other = makeSegmentGraph();
+    depthmapX::AnalysisCheckpoint otherCheckpoint(filename, 0.0, true);
+    SegmentTulip otherAnalysis(radii, false, 1024, -1, Options::RADIUS_ANGULAR, false);
+    otherAnalysis.setCheckpoint(&otherCheckpoint);
+    REQUIRE_THROWS_AS(otherAnalysis.run(nullptr, other->getDisplayedShapeGraph(), false),
+                      depthmapX::RuntimeException);
+
+    std::remove(filename);
+}
+
+TEST_CASE("VGA visual global carries on from its checkpoint", "") {
+    const char *filename = "testvgavisualglobal.checkpoint";
+
+    auto expected = makeVgaGraph();
+    VGAVisualGlobal(-1, false).run(nullptr, expected->getDisplayedPointMap(), false);
+
+    StoppingCommunicator stop;
+    for (int run = 0; run < 4; run++) {
+        auto graph = makeVgaGraph();
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, run > 0);
+        VGAVisualGlobal analysis(-1, false);
+        analysis.setCheckpoint(&checkpoint);
+        REQUIRE_THROWS_AS(analysis.run(&stop, graph->getDisplayedPointMap(), false), Communicator::CancelledException);
+    }
+    auto resumed = makeVgaGraph();
+    depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+    VGAVisualGlobal analysis(-1, false);
+    analysis.setCheckpoint(&checkpoint);
+    analysis.run(nullptr, resumed->getDisplayedPointMap(), false);
+
+    requireSameTable(expected->getDisplayedPointMap().getAttributeTable(),
+                     resumed->getDisplayedPointMap().getAttributeTable());
+
+    std::remove(filename);
+}
+
+TEST_CASE("Checkpoints that cannot be resumed", "") {
+    const char *filename = "testbadcheckpoint.checkpoint";
+    std::remove(filename);
+    REQUIRE_THROWS_AS(depthmapX::AnalysisCheckpoint(filename, 0.0, true).begin("test"), depthmapX::RuntimeException);
+
+    {
+        std::ofstream stream(filename);
+        stream << "not a checkpoint";
+    }
+    REQUIRE_THROWS_AS(depthmapX::AnalysisCheckpoint(filename, 0.0, true).begin("test"), depthmapX::RuntimeException);
+
+    {
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, false);
+        REQUIRE(checkpoint.begin("test") == 0);
+        checkpoint.recordValue(3, 1, 2.5f);
+        checkpoint.save(7, 1, {4.0});
+    }
+    depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+    REQUIRE(checkpoint.begin("test") == 7);
+    REQUIRE(checkpoint.getProcessed() == 1);
+    REQUIRE(checkpoint.getValues().size() == 1);
+    REQUIRE(checkpoint.getValues()[0].value == 2.5f);
+    REQUIRE(checkpoint.getTotals() == std::vector<double>({4.0}));
+    REQUIRE_THROWS_AS(depthmapX::AnalysisCheckpoint(filename, 0.0, true).begin("other"), depthmapX::RuntimeException);
+
+    std::remove(filename);
+}
+
+TEST_CASE("Checkpoint saves are added to the end of the file", "") {
+    const char *filename = "testappendcheckpoint.checkpoint";
+    auto fileSize = [filename]() { return std::ifstream(filename, std::ios::binary | std::ios::ate).tellg(); };
+
+    // every save is as long as the one before, it only has the values recorded since
+    std::vector<std::streamoff> sizes;
+    {
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, false);
+        REQUIRE(checkpoint.begin("test") == 0);
+        sizes.push_back(fileSize());
+        for (int origin = 0; origin < 3; origin++) {
+            checkpoint.recordValue(origin, 0, float(origin));
+            checkpoint.recordValue(origin, 1, float(origin) * 2.0f);
+            checkpoint.save(size_t(origin + 1), size_t(origin + 1), {double(origin)});
+            sizes.push_back(fileSize());
+        }
+    }
+    REQUIRE(sizes[2] - sizes[1] == sizes[1] - sizes[0]);
+    REQUIRE(sizes[3] - sizes[2] == sizes[1] - sizes[0]);
+
+    // the last save is cut short, as by a crash while writing it
+    {
+        std::ifstream in(filename, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), std::streamsize(data.size() - 6));
+    }
+    {
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+        REQUIRE(checkpoint.begin("test") == 2);
+        REQUIRE(checkpoint.getProcessed() == 2);
+        REQUIRE(checkpoint.getValues().size() == 4);
+        REQUIRE(checkpoint.getValues()[3].value == 2.0f);
+        REQUIRE(checkpoint.getTotals() == std::vector<double>({1.0}));
+        checkpoint.recordValue(2, 0, 5.0f);
+        checkpoint.save(3, 3, {5.0});
+        REQUIRE(checkpoint.getValues().empty());
+    }
+    depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+    REQUIRE(checkpoint.begin("test") == 3);
+    REQUIRE(checkpoint.getValues().size() == 5);
+    REQUIRE(checkpoint.getValues()[4].value == 5.0f);
+    REQUIRE(checkpoint.getTotals() == std::vector<double>({5.0}));
+
+    // only the last totals are needed, so the file does not keep growing with them
+    {
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, false);
+        checkpoint.begin("totals");
+        for (int origin = 0; origin < 100; origin++) {
+            checkpoint.recordValue(origin, 0, float(origin));
+            checkpoint.save(size_t(origin + 1), size_t(origin + 1), std::vector<double>(10000, double(origin)));
+        }
+        REQUIRE(fileSize() < 4 * 10000 * std::streamoff(sizeof(double)) + (1 << 20));
+    }
+    {
+        depthmapX::AnalysisCheckpoint checkpoint(filename, 0.0, true);
+        REQUIRE(checkpoint.begin("totals") == 100);
+        REQUIRE(checkpoint.getValues().size() == 100);
+        REQUIRE(checkpoint.getValues()[99].value == 99.0f);
+        REQUIRE(checkpoint.getTotals() == std::vector<double>(10000, 99.0));
+    }
+
+    // nothing saved yet, so nothing to carry on from
+    depthmapX::AnalysisCheckpoint(filename, 0.0, false).begin("test");
+    depthmapX::AnalysisCheckpoint empty(filename, 0.0, true);
+    REQUIRE(empty.begin("test") == 0);
+    REQUIRE(empty.getValues().empty());
+
+    std::remove(filename);
+}
@@ -392,6 +392,188 @@ TEST_CASE("attibute table iterations")
     REQUIRE(table.getRow(AttributeKey(1)).getValue(1) == Approx(3.2));
 }
 
+TEST_CASE("Attribute table rows out of key order")
+{
+    AttributeTable table;
+    table.getOrInsertColumn("col1");
+
+    auto& row5 = table.addRow(AttributeKey(5));
+    row5.setValue(0, 5.0f);
+    auto& row1 = table.addRow(AttributeKey(1));
+    row1.setValue(0, 1.0f);
+    auto& row3 = table.addRow(AttributeKey(3));
+    row3.setValue(0, 3.0f);
+    REQUIRE_THROWS(table.addRow(AttributeKey(3)));
+
+    // the rows are kept in key order and the references stay valid
+    std::vector<int> keys;
+    for (auto& item : table)
+    {
+        keys.push_back(item.getKey().value);
+        REQUIRE(item.getRow().getValue(0) == Approx(item.getKey().value));
+    }
+    REQUIRE(keys == std::vector<int>({1, 3, 5}));
+    REQUIRE(row5.getValue(0) == Approx(5.0f));
+    REQUIRE(table.find(AttributeKey(4)) == table.end());
+
+    // columns added later start out at -1 in every row
+    size_t col2 = table.getOrInsertColumn("col2");
+    REQUIRE(row1.getValue(col2) == -1.0f);
+    row3.setValue(col2, 6.0f);
+
+    table.removeRow(AttributeKey(1));
+    REQUIRE(table.getNumRows() == 2);
+    REQUIRE(table.getRowPtr(AttributeKey(1)) == 0);
+    REQUIRE(row3.getValue(0) == Approx(3.0f));
+    REQUIRE(row3.getValue(col2) == Approx(6.0f));
+    REQUIRE(row5.getValue(col2) == -1.0f);
+    REQUIRE(table.begin()->getKey().value == 3);
+
+    table.insertOrResetColumn("col1");
+    REQUIRE(row3.getValue(0) == -1.0f);
+    REQUIRE(row5.getValue(0) == -1.0f);
+    REQUIRE(row3.getValue(col2) == Approx(6.0f));
+}
+
+TEST_CASE("Attribute table key lookups")
+{
+    AttributeTable table;
+    table.getOrInsertColumn("col1");
+
+    auto checkKeys = [&table]() {
+        size_t rowIndex = 0;
+        for (auto& item : table)
+        {
+            REQUIRE(table.getRowIndex(item.getKey()) == rowIndex);
+            REQUIRE(&table.getRow(item.getKey()) == &item.getRow());
+            REQUIRE(table.getRowIndex(AttributeKey(item.getKey().value + 1)) ==
+                    (table.getRowPtr(AttributeKey(item.getKey().value + 1)) ? rowIndex + 1 : size_t(-1)));
+            rowIndex++;
+        }
+        REQUIRE(table.getRowIndex(AttributeKey(-5)) == size_t(-1));
+        REQUIRE(table.getRowIndex(AttributeKey(1 << 30)) == size_t(-1));
+    };
+
+    // keys with gaps, appended, inserted before the others and removed
+    for (int key = 10; key < 200; key += 3)
+    {
+        table.addRow(AttributeKey(key));
+    }
+    checkKeys();
+    table.addRow(AttributeKey(4));
+    table.addRow(AttributeKey(11));
+    checkKeys();
+    table.removeRow(AttributeKey(10));
+    checkKeys();
+
+    // keys far apart, like the pixel refs of a point map, then close together again
+    table.addRow(AttributeKey(1 << 20));
+    table.addRow(AttributeKey((1 << 20) + 1));
+    checkKeys();
+    table.removeRow(AttributeKey(1 << 20));
+    table.removeRow(AttributeKey((1 << 20) + 1));
+    table.addRow(AttributeKey(300));
+    checkKeys();
+    REQUIRE(table.getRowIndex(AttributeKey(300)) == table.getNumRows() - 1);
+}
+
+TEST_CASE("Attribute table stats batch")
+{
+    // the same writes with and without a batch, in row order over fresh columns (the deferred case)
+    // and then in any order over values already set (the cases that go back to direct updates)
+    AttributeTable direct, batched;
+    for (AttributeTable* table : {&direct, &batched}) {
+        table->getOrInsertColumn("col1");
+        table->getOrInsertColumn("col2");
+        for (int i = 0; i < 20; i++) {
+            table->addRow(AttributeKey(i * 3));
+        }
+    }
+
+    auto write = [](AttributeTable& table, int pass) {
+        for (int i = 0; i < 20; i++) {
+            AttributeKey key(pass == 0 ? i * 3 : ((i * 7) % 20) * 3);
+            float value = float((i * 13 + pass * 5) % 11) - (i % 6 == 0 ? 3.5f : 0.0f);
+            table.getRow(key).setValue(0, value);
+            if (i % 3 != 0) {
+                table.getRow(key).incrValue(1, value * 0.5f);
+            }
+        }
+    };
+
+    auto requireSameStats = [&]() {
+        for (size_t col = 0; col < 2; col++) {
+            const AttributeColumnStats& a = direct.getColumn(col).getStats();
+            const AttributeColumnStats& b = batched.getColumn(col).getStats();
+            REQUIRE(a.min == b.min);
+            REQUIRE(a.max == b.max);
+            REQUIRE(a.total == b.total);
+        }
+    };
+
+    for (int pass = 0; pass < 2; pass++) {
+        write(direct, pass);
+        {
+            AttributeStatsBatch statsBatch(batched);
+            write(batched, pass);
+        }
+        requireSameStats();
+    }
+
+    // adding a row in the middle of a batch brings the stats up to date first
+    size_t col3 = batched.insertOrResetColumn("col3");
+    {
+        AttributeStatsBatch statsBatch(batched);
+        batched.getRow(AttributeKey(0)).setValue(col3, 100.0f);
+        REQUIRE(batched.getColumn(col3).getStats().max == -1.0);
+        batched.addRow(AttributeKey(100));
+        REQUIRE(batched.getColumn(col3).getStats().max == 100.0);
+        batched.getRow(AttributeKey(100)).setValue(col3, 200.0f);
+        REQUIRE(batched.getColumn(col3).getStats().max == 100.0);
+    }
+    REQUIRE(batched.getColumn(col3).getStats().max == 200.0);
+}
+
+TEST_CASE("Attribute table column spans")
+{
+    AttributeTable table;
+    size_t col1 = table.getOrInsertColumn("col1");
+    size_t col2 = table.getOrInsertColumn("col2");
+    for (int i = 4; i >= 0; i--) {
+        table.addRow(AttributeKey(i * 10)).setValue(col1, float(i));
+    }
+
+    // values come in key order
+    auto values = table.readColumn(col1);
+    REQUIRE(values.size() == 5);
+    for (size_t i = 0; i < values.size(); i++) {
+        REQUIRE(values[i] == float(i));
+    }
+    REQUIRE_THROWS_AS(table.readColumn(2), std::out_of_range);
+
+    // writing through the span gives the same stats as writing every value through the rows
+    AttributeTable rowTable;
+    rowTable.getOrInsertColumn("col1");
+    rowTable.getOrInsertColumn("col2");
+    for (int i = 0; i < 5; i++) {
+        rowTable.addRow(AttributeKey(i * 10));
+    }
+    auto written = table.writeColumn(col2);
+    for (size_t i = 0; i < written.size(); i++) {
+        float value = i == 2 ? -1.0f : 0.1f * float(i * i);
+        written[i] = value;
+        if (value >= 0.0f) {
+            rowTable.getRow(AttributeKey(int(i) * 10)).setValue(col2, value);
+        }
+    }
+    REQUIRE(table.getRow(AttributeKey(40)).getValue(col2) == Approx(1.6f));
+    const AttributeColumnStats& stats = table.getColumn(col2).getStats();
+    const AttributeColumnStats& rowStats = rowTable.getColumn(col2).getStats();
+    REQUIRE(stats.min == rowStats.min);
+    REQUIRE(stats.max == rowStats.max);
+    REQUIRE(stats.total == rowStats.total);
+}
+
 #include <salalib/attributetablehelpers.h>
 
 TEST_CASE("Attribute Table - serialisation")
@@ -467,3 +649,87 @@ TEST_CASE("Attribute Table - serialisation")
 
 }
 
+
+TEST_CASE("Attribute Table - column encodings")
+{
+    LayerManagerImpl layerManager;
+
+    AttributeTable table;
+    size_t counts = table.getOrInsertColumn("counts");
+    size_t large = table.getOrInsertColumn("large counts");
+    size_t halves = table.getOrInsertColumn("halves");
+    size_t reals = table.getOrInsertColumn("reals");
+    size_t rounded = table.getOrInsertColumn("rounded");
+
+    for (int i = 0; i < 40; i++)
+    {
+        auto& row = table.addRow(AttributeKey(i));
+        if (i % 5 != 0)
+        {
+            row.setValue(counts, float(i));
+        }
+        row.setValue(large, float(i * 1000));
+        row.setValue(halves, i % 2 ? 0.5f : 0.25f);
+        row.setValue(reals, float(i) / 3.0f);
+        row.setValue(rounded, float(i) / 3.0f);
+    }
+
+    REQUIRE_THROWS_AS(table.setColumnEncoding(large, AttributeColumnEncoding::UINT8), std::invalid_argument);
+    table.setColumnEncoding(rounded, AttributeColumnEncoding::FLOAT16);
+    REQUIRE(table.getColumnStorage(rounded) == AttributeColumnEncoding::FLOAT16);
+    REQUIRE(table.getColumnStorage(counts) == AttributeColumnEncoding::FLOAT32);
+    REQUIRE(table.getRow(AttributeKey(7)).getValue(rounded) == Approx(7.0f / 3.0f).epsilon(0.001));
+    // reading it leaves it compact, writing to it unpacks it
+    REQUIRE(table.getColumnStorage(rounded) == AttributeColumnEncoding::FLOAT16);
+    table.getRow(AttributeKey(7)).setValue(rounded, float(7) / 3.0f);
+    REQUIRE(table.getColumnStorage(rounded) == AttributeColumnEncoding::FLOAT32);
+    REQUIRE(table.getColumnEncoding(rounded) == AttributeColumnEncoding::FLOAT16);
+
+    std::stringstream stream;
+    table.write(stream, layerManager);
+
+    AttributeTable copyTable;
+    LayerManagerImpl copyLayerManager;
+    copyTable.read(stream, copyLayerManager);
+
+    REQUIRE(copyTable.getNumRows() == 40);
+    REQUIRE(copyTable.getColumnStorage(counts) == AttributeColumnEncoding::UINT8);
+    REQUIRE(copyTable.getColumnStorage(large) == AttributeColumnEncoding::UINT16);
+    REQUIRE(copyTable.getColumnStorage(halves) == AttributeColumnEncoding::DICTIONARY);
+    REQUIRE(copyTable.getColumnStorage(reals) == AttributeColumnEncoding::FLOAT32);
+    REQUIRE(copyTable.getColumnStorage(rounded) == AttributeColumnEncoding::FLOAT16);
+    REQUIRE(copyTable.getColumnEncoding(rounded) == AttributeColumnEncoding::FLOAT16);
+    REQUIRE(copyTable.getColumnEncoding(counts) == AttributeColumnEncoding::AUTO);
+
+    // the stats come from the file, the values are read straight from the encodings
+    REQUIRE(copyTable.getColumn(counts).getStats().max == Approx(39.0));
+    REQUIRE(copyTable.getColumnStorage(counts) == AttributeColumnEncoding::UINT8);
+
+    for (int i = 0; i < 40; i++)
+    {
+        auto& row = copyTable.getRow(AttributeKey(i));
+        REQUIRE(row.getValue(counts) == (i % 5 != 0 ? float(i) : -1.0f));
+        REQUIRE(row.getValue(large) == float(i * 1000));
+        REQUIRE(row.getValue(halves) == (i % 2 ? 0.5f : 0.25f));
+        REQUIRE(row.getValue(reals) == float(i) / 3.0f);
+        REQUIRE(row.getValue(rounded) == Approx(float(i) / 3.0f).epsilon(0.001));
+    }
+    REQUIRE(copyTable.getColumnStorage(counts) == AttributeColumnEncoding::UINT8);
+    const AttributeTable& constTable = copyTable;
+    std::vector<float> decoded;
+    REQUIRE(constTable.readColumn(halves, decoded)[3] == 0.5f);
+    REQUIRE(decoded.size() == 40);
+    REQUIRE(constTable.getColumnOrder(large)[39] == 39);
+    REQUIRE(constTable.getColumnOrderRange(counts, 1.0f, 4.0f) == std::make_pair(size_t(8), size_t(12)));
+    REQUIRE(copyTable.getColumnStorage(halves) == AttributeColumnEncoding::DICTIONARY);
+
+    // the non-const readColumn unpacks, and adding a row unpacks everything
+    REQUIRE(copyTable.readColumn(halves)[3] == 0.5f);
+    REQUIRE(copyTable.getColumnStorage(halves) == AttributeColumnEncoding::FLOAT32);
+    copyTable.compactColumns();
+    copyTable.addRow(AttributeKey(100)).setValue(counts, 300.0f);
+    REQUIRE(copyTable.getColumnStorage(halves) == AttributeColumnEncoding::FLOAT32);
+    REQUIRE(copyTable.getRow(AttributeKey(3)).getValue(halves) == 0.5f);
+    copyTable.compactColumns();
+    REQUIRE(copyTable.getColumnStorage(counts) == AttributeColumnEncoding::UINT16);
+}
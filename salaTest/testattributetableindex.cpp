@@ -43,3 +43,111 @@ TEST_CASE("Check index creation")
     REQUIRE(table.getRow(AttributeKey(2)).getValue(1) == Approx(1.5));
 }
 
+
+TEST_CASE("Column order kept by the table")
+{
+    AttributeTable table;
+    table.getOrInsertColumn("col1");
+    for (int i = 0; i < 6; i++)
+    {
+        table.addRow(AttributeKey(i * 2));
+    }
+    std::vector<float> values = {3.0f, 1.0f, 2.0f, 1.0f, 5.0f, 0.5f};
+    for (int i = 0; i < 6; i++)
+    {
+        table.getRow(AttributeKey(i * 2)).setValue(0, values[i]);
+    }
+
+    auto expectedOrder = [&table]() {
+        auto column = table.readColumn(0);
+        std::vector<size_t> order(column.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&column](size_t a, size_t b) { return column[a] < column[b]; });
+        return order;
+    };
+
+    REQUIRE(table.getColumnOrder(0) == std::vector<size_t>({5, 1, 3, 2, 0, 4}));
+
+    auto range = table.getColumnOrderRange(0, 1.0f, 3.0f);
+    REQUIRE(range.first == 1);
+    REQUIRE(range.second == 5);
+    range = table.getColumnOrderRange(0, 1.5f, 1.8f);
+    REQUIRE(range.first == range.second);
+
+    // setting values moves their rows up and down the kept order
+    table.getRow(AttributeKey(8)).setValue(0, 0.1f);
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+    table.getRow(AttributeKey(2)).setValue(0, 4.0f);
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+    table.getRow(AttributeKey(0)).setValue(0, 1.0f);
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+    table.getRow(AttributeKey(10)).incrValue(0, 0.5f);
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+
+    // many writes in between make it drop the order and sort again
+    for (int i = 0; i < 100; i++)
+    {
+        table.getRow(AttributeKey((i % 6) * 2)).setValue(0, float((i * 7) % 11));
+    }
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+
+    table.addRow(AttributeKey(1)).setValue(0, 2.5f);
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+
+    auto column = table.writeColumn(0);
+    column[3] = 100.0f;
+    REQUIRE(table.getColumnOrder(0).back() == 3);
+
+    table.removeRow(AttributeKey(4));
+    REQUIRE(table.getColumnOrder(0) == expectedOrder());
+
+    REQUIRE(table.getRowIndex(AttributeKey(6)) == 3);
+    REQUIRE(table.getRowIndex(AttributeKey(5)) == size_t(-1));
+
+    auto index = makeAttributeIndex(table, 0);
+    size_t indexRevision = table.getColumnOrderRevision();
+    REQUIRE(index.size() == table.getNumRows());
+    for (size_t i = 1; i < index.size(); i++)
+    {
+        REQUIRE(index[i - 1].value < index[i].value);
+    }
+
+    auto currentValues = table.readColumn(0);
+    size_t inRange = size_t(std::count_if(currentValues.begin(), currentValues.end(), [](float value) {
+        return value >= 2.0f && value <= 7.0f;
+    }));
+    auto items = getIndexItemsInValueRange(index, table, 0, indexRevision, 2.0f, 7.0f);
+    REQUIRE(size_t(items.second - items.first) == inRange);
+    for (auto iter = items.first; iter != items.second; ++iter)
+    {
+        REQUIRE(iter->row->getValue(0) >= 2.0f);
+        REQUIRE(iter->row->getValue(0) <= 7.0f);
+    }
+
+    // once a value has changed the table order is no longer that of the index, which is then searched
+    // as it was when it was made
+    std::vector<double> indexedValues;
+    for (auto &item : index)
+    {
+        indexedValues.push_back(item.value);
+    }
+    REQUIRE(items.first != items.second);
+    items.first->mutable_row->setValue(0, 100.0f);
+    REQUIRE(table.getColumnOrderRevision() != indexRevision);
+    items = getIndexItemsInValueRange(index, table, 0, indexRevision, 2.0f, 7.0f);
+    REQUIRE(size_t(items.second - items.first) == inRange);
+    for (auto iter = items.first; iter != items.second; ++iter)
+    {
+        REQUIRE(iter->value >= 2.0f);
+        REQUIRE(iter->value <= 7.0f + 1e-6);
+        REQUIRE(indexedValues[size_t(iter - index.begin())] == iter->value);
+    }
+
+    auto keyIndex = makeAttributeIndex(table, -1);
+    auto keyItems = getIndexItemsInValueRange(keyIndex, table, -1, table.getColumnOrderRevision(), 2.0f, 7.0f);
+    REQUIRE(keyItems.second - keyItems.first == 2);
+    REQUIRE(keyItems.first->key.value == 2);
+}
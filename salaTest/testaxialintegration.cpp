@@ -0,0 +1,56 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/axialmodules/axialintegration.h"
+#include "salalib/mgraph.h"
+#include "salalib/syntheticplans.h"
+#include "genlib/pafmath.h"
+#include "genlib/parallel.h"
+
+namespace {
+    // the attribute values of an axial map of voronoi streets, after running integration and choice
+    // (weighted by line length) on the given number of threads. Choice takes the lines off the search
+    // lists in a random order, so the random numbers are started from the same seed each time
+    std::vector<std::vector<float>> axialValues(size_t threadCount) {
+        MetaGraph graph;
+        depthmapX::addSyntheticDrawing(graph, depthmapX::generateVoronoiStreets(300, 5, 0.5), "Streets");
+        REQUIRE(graph.convertDrawingToAxial(nullptr, "Streets axial"));
+        ShapeGraph &map = graph.getDisplayedShapeGraph();
+        int lineLength = int(map.getAttributeTable().getColumnIndex("Line Length"));
+
+        depthmapX::ScopedThreadCount scopedThreadCount(threadCount);
+        pafsrand(1);
+        REQUIRE(AxialIntegration({-1.0, 3.0}, lineLength, true, false, false).run(nullptr, map, false));
+
+        const AttributeTable &table = map.getAttributeTable();
+        std::vector<std::vector<float>> values;
+        for (auto &row : table) {
+            values.emplace_back();
+            for (size_t col = 0; col < table.getNumColumns(); col++) {
+                values.back().push_back(row.getRow().getValue(col));
+            }
+        }
+        return values;
+    }
+} // namespace
+
+TEST_CASE("Axial integration gives the same values on any number of threads", "") {
+    std::vector<std::vector<float>> oneThread = axialValues(1);
+    REQUIRE(oneThread.size() > 300);
+    for (size_t threadCount : {2, 4, 7}) {
+        REQUIRE(axialValues(threadCount) == oneThread);
+    }
+}
@@ -542,3 +542,115 @@ TEST_CASE("DXF Parsing (deeper blocks)")
     REQUIRE(dxfParser.getLayer(layer.c_str())->getLine(0).getEnd().x == Approx(lineEnd.x + 2*blockTranslation.x).epsilon(EPSILON));
     REQUIRE(dxfParser.getLayer(layer.c_str())->getLine(0).getEnd().y == Approx(lineEnd.y + 2*blockTranslation.y).epsilon(EPSILON));
 }
+
+TEST_CASE("DXF Parsing (layer filter)")
+{
+    std::stringstream stream;
+
+    stream << "0\nSECTION\n"
+           << "2\nENTITIES\n"
+           << "0\nLINE\n"
+           << "8\nwalls\n"
+           << "10\n0\n20\n0\n30\n0\n"
+           << "11\n1\n21\n1\n31\n0\n"
+           << "0\nLINE\n"
+           << "8\nfurniture\n"
+           << "10\n0\n20\n0\n30\n0\n"
+           << "11\n2\n21\n2\n31\n0\n"
+           << "0\nPOLYLINE\n"
+           << "8\nfurniture\n"
+           << "66\n1\n"
+           << "0\nVERTEX\n10\n0\n20\n0\n30\n0\n"
+           << "0\nVERTEX\n10\n1\n20\n0\n30\n0\n"
+           << "0\nSEQEND\n"
+           << "0\nLINE\n"
+           << "8\nwalls\n"
+           << "10\n1\n20\n1\n30\n0\n"
+           << "11\n2\n21\n1\n31\n0\n"
+           << "0\nENDSEC\n"
+           << "0\nEOF\n";
+
+    DxfParser dxfParser;
+    dxfParser.setLayerFilter({"walls"});
+    dxfParser.open(stream);
+    REQUIRE(dxfParser.numLayers() == 1);
+    REQUIRE(dxfParser.getLayer("walls")->numLines() == 2);
+    REQUIRE(dxfParser.getLayer("walls")->getLine(1).getEnd().x == 2);
+}
+
+TEST_CASE("DXF Parsing (entities in chunks)")
+{
+    // enough entities for the section to be split into a few chunks, spread over
+    // some layers, with polylines and inserts in between
+    std::stringstream text;
+    text << "0\nSECTION\n"
+         << "2\nBLOCKS\n"
+         << "0\nBLOCK\n"
+         << "2\ndoor\n"
+         << "8\n0\n"
+         << "0\nLINE\n"
+         << "8\ndoors\n"
+         << "10\n0\n20\n0\n30\n0\n"
+         << "11\n1\n21\n0\n31\n0\n"
+         << "0\nENDBLK\n"
+         << "0\nENDSEC\n"
+         << "0\nSECTION\n"
+         << "2\nENTITIES\n";
+    for (int i = 0; i < 40000; i++) {
+        text << "0\nLINE\n"
+             << "8\nlayer" << i % 3 << "\n"
+             << "10\n" << i << "\n20\n" << -i << "\n30\n0\n"
+             << "11\n" << i + 1 << "\n21\n" << i * 0.5 << "\n31\n0\n";
+        if (i % 7 == 0) {
+            text << "0\nPOLYLINE\n"
+                 << "8\nlayer1\n"
+                 << "66\n1\n"
+                 << "0\nVERTEX\n10\n" << i + 1 << "\n20\n0\n30\n0\n"
+                 << "0\nVERTEX\n10\n" << i + 1 << "\n20\n1\n30\n0\n"
+                 << "0\nVERTEX\n10\n" << i + 2 << "\n20\n1\n30\n0\n"
+                 << "0\nSEQEND\n";
+        }
+        if (i % 11 == 0) {
+            text << "0\nINSERT\n"
+                 << "8\ndoors\n"
+                 << "2\ndoor\n"
+                 << "10\n" << i << "\n20\n" << i << "\n30\n0\n";
+        }
+    }
+    text << "0\nENDSEC\n"
+         << "0\nEOF\n";
+
+    std::stringstream serialStream(text.str());
+    DxfParser serial;
+    serial.setThreadCount(1);
+    serial.open(serialStream);
+
+    std::stringstream chunkedStream(text.str());
+    DxfParser chunked;
+    chunked.setThreadCount(4);
+    chunked.open(chunkedStream);
+
+    REQUIRE(chunked.numLayers() == serial.numLayers());
+    for (auto &layer : serial.getLayers()) {
+        const DxfLayer &serialLayer = layer.second;
+        const DxfLayer &chunkedLayer = *chunked.getLayer(layer.first);
+        REQUIRE(chunkedLayer.numLines() == serialLayer.numLines());
+        REQUIRE(chunkedLayer.numPolyLines() == serialLayer.numPolyLines());
+        REQUIRE(chunkedLayer.numTotalLines() == serialLayer.numTotalLines());
+        bool sameEntities = true;
+        for (size_t i = 0; i < serialLayer.numLines(); i++) {
+            sameEntities = sameEntities && chunkedLayer.getLine(i).getStart() == serialLayer.getLine(i).getStart() &&
+                           chunkedLayer.getLine(i).getEnd() == serialLayer.getLine(i).getEnd();
+        }
+        for (size_t i = 0; i < serialLayer.numPolyLines(); i++) {
+            sameEntities = sameEntities &&
+                           chunkedLayer.getPolyLine(i).numVertices() == serialLayer.getPolyLine(i).numVertices() &&
+                           chunkedLayer.getPolyLine(i).getVertex(0) == serialLayer.getPolyLine(i).getVertex(0);
+        }
+        REQUIRE(sameEntities);
+        REQUIRE(chunkedLayer.getExtMin() == serialLayer.getExtMin());
+        REQUIRE(chunkedLayer.getExtMax() == serialLayer.getExtMax());
+    }
+    REQUIRE(serial.getLayer("layer0")->numLines() == 13334);
+    REQUIRE(serial.getLayer("doors")->numLines() == 3637);
+}
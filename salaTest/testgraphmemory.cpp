@@ -0,0 +1,129 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/graphmemory.h"
+#include "salalib/mgraph.h"
+#include "salalib/syntheticplans.h"
+#include "genlib/exceptions.h"
+
+#include <sstream>
+
+namespace {
+    std::unique_ptr<MetaGraph> makeFilledGraph() {
+        std::unique_ptr<MetaGraph> graph(new MetaGraph);
+        depthmapX::SyntheticPlan plan = depthmapX::generateFloorplate(4, 3, 0.5);
+        depthmapX::addSyntheticDrawing(*graph, plan, "Floorplate");
+        graph->addNewPointMap("Floorplate VGA");
+        PointMap &map = graph->getPointMaps().back();
+        map.setGrid(1.0);
+        map.makePoints(plan.openPoint, 0);
+        return graph;
+    }
+
+    std::string writePointMap(PointMap &map) {
+        std::stringstream stream;
+        map.write(stream);
+        return stream.str();
+    }
+} // namespace
+
+TEST_CASE("Graph memory is estimated from the nodes of a sample", "") {
+    auto graph = makeFilledGraph();
+    PointMap &map = graph->getDisplayedPointMap();
+
+    // sampling every point gives the runs of the graph as made
+    depthmapX::GraphMemoryEstimate estimate = map.estimateGraphMemory(false, -1.0, size_t(map.getFilledPointCount()));
+    REQUIRE(estimate.nodeCount == size_t(map.getFilledPointCount()));
+    REQUIRE(estimate.sampleCount == estimate.nodeCount);
+    REQUIRE(map.sparkGraph2(nullptr, false, -1.0));
+    size_t runs = 0;
+    for (auto &point : map.getPoints()) {
+        if (point.filled()) {
+            runs += point.getNode().runCount();
+        }
+    }
+    REQUIRE(estimate.runsPerNode == Approx(double(runs) / double(estimate.nodeCount)));
+    REQUIRE(estimate.compactGraphBytes < estimate.graphBytes);
+    REQUIRE(estimate.analysisBytes > 0);
+
+    // a smaller sample gives about the same
+    auto sampled = makeFilledGraph();
+    depthmapX::GraphMemoryEstimate sampledEstimate = sampled->getDisplayedPointMap().estimateGraphMemory(false, -1.0, 50);
+    REQUIRE(sampledEstimate.sampleCount <= 50);
+    REQUIRE(sampledEstimate.runsPerNode == Approx(estimate.runsPerNode).epsilon(0.25));
+}
+
+TEST_CASE("Compact graphs are the same as the usual ones", "") {
+    auto graph = makeFilledGraph();
+    REQUIRE(graph->makeGraph(nullptr, 0, -1.0));
+    auto compactGraph = makeFilledGraph();
+    REQUIRE(compactGraph->makeGraph(nullptr, 0, -1.0, true));
+
+    PointMap &map = graph->getDisplayedPointMap();
+    PointMap &compactMap = compactGraph->getDisplayedPointMap();
+    for (auto &point : compactMap.getPoints()) {
+        if (point.filled()) {
+            for (int i = 0; i < 32; i++) {
+                const PixelVecs &runs = point.getNode().bin(i).m_pixel_vecs;
+                REQUIRE((runs.empty() || runs.isView()));
+                REQUIRE(runs.allocatedSize() == 0);
+            }
+        }
+    }
+    REQUIRE(writePointMap(map) == writePointMap(compactMap));
+
+    Options options;
+    options.output_type = Options::OUTPUT_VISUAL;
+    REQUIRE(graph->analyseGraph(nullptr, options, false));
+    REQUIRE(compactGraph->analyseGraph(nullptr, options, false));
+    REQUIRE(writePointMap(map) == writePointMap(compactMap));
+}
+
+TEST_CASE("Graphs are made compact or not at all to fit in a memory budget", "") {
+    depthmapX::GraphMemoryEstimate estimate;
+    estimate.graphBytes = 1000;
+    estimate.compactGraphBytes = 600;
+    estimate.analysisBytes = 200;
+    REQUIRE_FALSE(depthmapX::needsCompactGraph(estimate, 1200));
+    REQUIRE(depthmapX::needsCompactGraph(estimate, 1199));
+    REQUIRE(depthmapX::needsCompactGraph(estimate, 800));
+    REQUIRE_THROWS_AS(depthmapX::needsCompactGraph(estimate, 799), depthmapX::RuntimeException);
+}
+
+TEST_CASE("Sizes in bytes", "") {
+    REQUIRE(depthmapX::parseBytes("1000") == 1000);
+    REQUIRE(depthmapX::parseBytes("512M") == size_t(512) << 20);
+    REQUIRE(depthmapX::parseBytes("1.5g") == size_t(3) << 29);
+    REQUIRE(depthmapX::parseBytes("2KB") == 2048);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("G"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("4X"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("4GiB"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("1.2.3G"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes(".5G"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("-1G"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("1e3"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("0x10"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes(" 12"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("12 M"), depthmapX::RuntimeException);
+    // fractions of a byte
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("12.5"), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(depthmapX::parseBytes("1.1K"), depthmapX::RuntimeException);
+    REQUIRE(depthmapX::parseBytes("12.0") == 12);
+    REQUIRE(depthmapX::parseBytes("0.5K") == 512);
+
+    REQUIRE(depthmapX::formatBytes(100) == "100 bytes");
+    REQUIRE(depthmapX::formatBytes(size_t(3) << 29) == "1.5 GB");
+}
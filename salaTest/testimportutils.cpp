@@ -0,0 +1,74 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../salalib/importutils.h"
+#include "../salalib/shapemap.h"
+#include "catch.hpp"
+#include <sstream>
+
+TEST_CASE("DelimitedReader splits rows across blocks")
+{
+    std::stringstream stream("\"x\",\"y\",name\n1,2,first\n\n3,4,\n-5.5,6e1,last");
+    // a tiny block, so that every line runs over the end of one
+    depthmapX::DelimitedReader reader(stream, ',', 3);
+    REQUIRE(reader.getColumnNames() == (std::vector<std::string>{"x", "y", "name"}));
+
+    std::vector<std::string_view> cells;
+    REQUIRE(reader.nextRow(cells));
+    REQUIRE(cells == (std::vector<std::string_view>{"1", "2", "first"}));
+    // the empty line is skipped, and there is no cell after a delimiter at the end of a line
+    REQUIRE(reader.nextRow(cells));
+    REQUIRE(cells == (std::vector<std::string_view>{"3", "4"}));
+    REQUIRE(reader.getLine() == "3,4,");
+    REQUIRE(reader.nextRow(cells));
+    REQUIRE(cells == (std::vector<std::string_view>{"-5.5", "6e1", "last"}));
+    REQUIRE_FALSE(reader.nextRow(cells));
+}
+
+TEST_CASE("Importing delimited text")
+{
+    SECTION("Points with numeric and text attributes")
+    {
+        std::stringstream stream("x,y,height,use\n"
+                                 "0,0,1.5,shop\n"
+                                 "1,+2,  7,home\n"
+                                 "0x10,3,2e1,shop\n");
+        ShapeMap shapeMap("Imported");
+        REQUIRE(depthmapX::importTxt(shapeMap, stream, ','));
+        REQUIRE(shapeMap.getAllShapes().size() == 3);
+        REQUIRE(shapeMap.getAllShapes().rbegin()->second.getPoint().x == 16);
+
+        const AttributeTable &attributes = shapeMap.getAttributeTable();
+        int heightCol = attributes.getColumnIndex("Height");
+        int useCol = attributes.getColumnIndex("Use");
+        std::vector<float> heights, uses;
+        for (auto &row : attributes) {
+            heights.push_back(row.getRow().getValue(heightCol));
+            uses.push_back(row.getRow().getValue(useCol));
+        }
+        REQUIRE(heights == (std::vector<float>{1.5f, 7.0f, 20.0f}));
+        // text is given a number for every different value
+        REQUIRE(uses == (std::vector<float>{0.0f, 1.0f, 0.0f}));
+    }
+
+    SECTION("Rows with the wrong number of cells")
+    {
+        std::stringstream stream("x1\ty1\tx2\ty2\n"
+                                 "0\t0\t1\t1\n"
+                                 "0\t0\t1\n");
+        ShapeMap shapeMap("Imported");
+        REQUIRE_THROWS_AS(depthmapX::importTxt(shapeMap, stream, '\t'), depthmapX::RuntimeException);
+    }
+}
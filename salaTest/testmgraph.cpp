@@ -16,6 +16,10 @@
 #include "catch.hpp"
 #include "salalib/mgraph.h"
 
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
 
 TEST_CASE("Test getVisibleLines", "")
 {
@@ -107,3 +111,81 @@ TEST_CASE("Test pointMaps", "")
         REQUIRE(mgraph->getDisplayedPointMapRef() == 0);
     }
 }
+
+TEST_CASE("Test lazily reading graph files", "")
+{
+    const char *filename = "testmgraphlazy.graph";
+    {
+        MetaGraph mgraph;
+        const std::vector<std::string> names{"Cartman", "Kyle", "Butters"};
+        for (size_t i = 0; i < names.size(); i++) {
+            mgraph.getDataMaps().emplace_back(names[i], ShapeMap::DATAMAP);
+            ShapeMap &dataMap = mgraph.getDataMaps().back();
+            int shapeRef = dataMap.makeLineShape(Line(Point2f(0, i), Point2f(1, i)));
+            int col = dataMap.addAttribute("Value");
+            dataMap.getAttributeTable().getRow(AttributeKey(shapeRef)).setValue(col, float(i + 1));
+        }
+        mgraph.setDisplayedDataMapRef(1);
+        mgraph.setState(MetaGraph::DATAMAPS);
+        mgraph.setViewClass(MetaGraph::SHOWSHAPETOP);
+        REQUIRE(mgraph.write(filename, METAGRAPH_VERSION) == MetaGraph::OK);
+    }
+
+    std::vector<MetaGraph::FileSection> sections = MetaGraph::readFileSections(filename);
+    REQUIRE(sections.size() == 4);
+    REQUIRE(sections[0].type == 's');
+    REQUIRE(sections[0].index == -1);
+    REQUIRE(sections[2].index == 1);
+    REQUIRE(sections[2].name == "Kyle");
+    REQUIRE(sections[1].offset < sections[2].offset);
+
+    MetaGraph mgraph;
+    REQUIRE(mgraph.readFromFile(filename, true) == MetaGraph::OK);
+    REQUIRE(mgraph.hasUnreadMaps());
+
+    SECTION("Looking at the maps does not read them")
+    {
+        REQUIRE(mgraph.getDataMaps().size() == 3);
+        REQUIRE(mgraph.getDisplayedDataMap().getAttributeTable().getNumRows() == 0);
+        REQUIRE(std::as_const(mgraph).getDisplayedDataMap().getAttributeTable().getNumRows() == 0);
+        REQUIRE(mgraph.hasUnreadMaps());
+    }
+
+    SECTION("Only the displayed map is read when asked for")
+    {
+        mgraph.ensureMapLoaded('s', int(mgraph.getDisplayedDataMapRef()));
+        const ShapeMap &dataMap = mgraph.getDisplayedDataMap();
+        REQUIRE(dataMap.getName() == "Kyle");
+        REQUIRE(dataMap.getAttributeTable().getNumRows() == 1);
+        REQUIRE(dataMap.getAttributeTable().getRow(AttributeKey(0)).getValue(0) == 2.0f);
+        REQUIRE(mgraph.hasUnreadMaps());
+    }
+
+    SECTION("All the maps of a type are read when asked for")
+    {
+        mgraph.ensureMapsLoaded('p');
+        REQUIRE(mgraph.hasUnreadMaps());
+        mgraph.ensureMapsLoaded('s');
+        std::vector<ShapeMap> &dataMaps = mgraph.getDataMaps();
+        REQUIRE(!mgraph.hasUnreadMaps());
+        REQUIRE(dataMaps.size() == 3);
+        for (size_t i = 0; i < dataMaps.size(); i++) {
+            REQUIRE(dataMaps[i].getAttributeTable().getRow(AttributeKey(0)).getValue(0) == float(i + 1));
+        }
+        REQUIRE(dataMaps[2].getName() == "Butters");
+    }
+
+    SECTION("Writing the graph over the file it was lazily read from keeps every map")
+    {
+        REQUIRE(mgraph.write(filename, METAGRAPH_VERSION) == MetaGraph::OK);
+        // written to a new file that replaced the old one
+        REQUIRE(!std::ifstream(std::string(filename) + ".new"));
+        MetaGraph reread;
+        REQUIRE(reread.readFromFile(filename) == MetaGraph::OK);
+        REQUIRE(!reread.hasUnreadMaps());
+        REQUIRE(reread.getDataMaps().size() == 3);
+        REQUIRE(reread.getDataMaps()[0].getAttributeTable().getRow(AttributeKey(0)).getValue(0) == 1.0f);
+    }
+
+    std::remove(filename);
+}
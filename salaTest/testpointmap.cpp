@@ -16,6 +16,11 @@
 #include "catch.hpp"
 #include "salalib/mgraph.h"
 
+#include "genlib/mappedblock.h"
+
+#include <cstdio>
+#include <fstream>
+
 
 TEST_CASE("Test MetaGraph construction", "")
 {
@@ -450,6 +455,59 @@ TEST_CASE("Test PointMap connections output", "")
         REQUIRE(lines == expected);
     }
 
+    SECTION("PointMap visibility graph block") {
+        std::stringstream expected;
+        pointMap.outputConnectionsAsCSV(expected);
+
+        // mapped straight from the file
+        const char *filename = "testpointmapgraph.graph";
+        {
+            std::ofstream stream(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+            pointMap.write(stream);
+        }
+        {
+            PointMap mappedMap(metaGraph->getRegion(), metaGraph->m_drawingFiles);
+            std::ifstream stream(filename, std::ios::binary | std::ios::in);
+            mappedMap.read(stream, filename);
+            REQUIRE(mappedMap.isVisibilityGraphMappedFrom(filename));
+            REQUIRE(mappedMap.getPoint(PixelRef(1, 1)).getNode().bin(0).m_pixel_vecs.isView());
+
+            std::stringstream mapped;
+            mappedMap.outputConnectionsAsCSV(mapped);
+            REQUIRE(mapped.str() == expected.str());
+
+            // replacing the file leaves the mapping of the old one as it was
+            {
+                std::ofstream replacement("testpointmapgraph.graph.new", std::ios::binary | std::ios::out);
+                replacement << "not a graph";
+            }
+            REQUIRE(depthmapX::replaceFile("testpointmapgraph.graph.new", filename));
+            REQUIRE(!mappedMap.isVisibilityGraphMappedFrom(filename));
+            REQUIRE(mappedMap.getPoint(PixelRef(1, 1)).getNode().bin(0).m_pixel_vecs.isView());
+            std::stringstream replaced;
+            mappedMap.outputConnectionsAsCSV(replaced);
+            REQUIRE(replaced.str() == expected.str());
+
+            mappedMap.ownVisibilityGraph();
+            REQUIRE(!mappedMap.isVisibilityGraphMappedFrom(filename));
+            REQUIRE(!mappedMap.getPoint(PixelRef(1, 1)).getNode().bin(0).m_pixel_vecs.isView());
+            std::stringstream owned;
+            mappedMap.outputConnectionsAsCSV(owned);
+            REQUIRE(owned.str() == expected.str());
+        }
+        std::remove(filename);
+
+        // or read in whole where there is no file to map
+        std::stringstream stream;
+        pointMap.write(stream);
+        PointMap readMap(metaGraph->getRegion(), metaGraph->m_drawingFiles);
+        readMap.read(stream);
+        REQUIRE(!readMap.isVisibilityGraphMappedFrom(filename));
+        std::stringstream read;
+        readMap.outputConnectionsAsCSV(read);
+        REQUIRE(read.str() == expected.str());
+    }
+
 }
 TEST_CASE("Direct pointmap linking - fully filled grid (no geometry)", "")
 {
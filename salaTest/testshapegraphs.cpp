@@ -18,6 +18,7 @@
 #include "../salalib/mgraph.h"
 #include "../salalib/shapemap.h"
 #include "../salalib/axialmap.h"
+#include "../salalib/alllinemap.h"
 #include "catch.hpp"
 #include <sstream>
 #include <iostream>
@@ -161,3 +162,99 @@ TEST_CASE("Testing ShapeMap::getAllLinkLines and ShapeMap::getAllUnlinkPoints()"
     REQUIRE(unlinkPoints[0].x == Approx(intersection.x).epsilon(EPSILON));
     REQUIRE(unlinkPoints[0].y == Approx(intersection.y).epsilon(EPSILON));
 }
+
+TEST_CASE("Testing ShapeMap::getAllLineConnections against ShapeMap::getLineConnections")
+{
+    const double TOLERANCE_B = 1e-12;
+
+    std::unique_ptr<ShapeGraph> shapeGraph(new ShapeGraph("Test ShapeMap"));
+
+    // a small grid of crossing lines plus a diagonal, a line that only touches another at
+    // its end and one that touches nothing
+    for (int i = 0; i < 4; i++) {
+        shapeGraph->makeLineShape(Line(Point2f(i, -0.5), Point2f(i, 3.5)));
+        shapeGraph->makeLineShape(Line(Point2f(-0.5, i), Point2f(3.5, i)));
+    }
+    shapeGraph->makeLineShape(Line(Point2f(-0.5, -0.5), Point2f(3.5, 3.5)));
+    shapeGraph->makeLineShape(Line(Point2f(3.5, 0), Point2f(5, 0)));
+    shapeGraph->makeLineShape(Line(Point2f(4.5, 2), Point2f(5, 3)));
+
+    const std::map<int, SalaShape> &shapes = shapeGraph->getAllShapes();
+    double tolerance = TOLERANCE_B * __max(shapeGraph->getRegion().height(), shapeGraph->getRegion().width());
+
+    std::vector<std::vector<int>> allConnections = shapeGraph->getAllLineConnections(tolerance);
+
+    REQUIRE(allConnections.size() == shapes.size());
+    size_t i = 0;
+    for (auto &shape : shapes) {
+        REQUIRE(allConnections[i] == shapeGraph->getLineConnections(shape.first, tolerance));
+        i++;
+    }
+    // the diagonal crosses all the other lines of the grid, the lone line crosses nothing
+    REQUIRE(allConnections[8].size() == 8);
+    REQUIRE(allConnections[10].empty());
+}
+
+TEST_CASE("Testing the line breaks found by the connection sweep against ShapeGraph::getLineBreaks")
+{
+    std::unique_ptr<ShapeGraph> shapeGraph(new ShapeGraph("Test ShapeMap"));
+    shapeGraph->initialiseAttributesAxial();
+
+    // the grid and diagonal above, with lines running in both directions so that the
+    // breaks of some have to be reversed to go from their start to their end
+    for (int i = 0; i < 4; i++) {
+        shapeGraph->makeLineShape(Line(Point2f(i, -0.5), Point2f(i + 0.25, 3.5)));
+        shapeGraph->makeLineShape(Line(Point2f(3.5, i - 0.25), Point2f(-0.5, i)));
+    }
+    shapeGraph->makeLineShape(Line(Point2f(-0.5, 3.5), Point2f(3.5, -0.5)));
+    shapeGraph->makeLineShape(Line(Point2f(3.5, 0), Point2f(5, 0)));
+    shapeGraph->makeLineShape(Line(Point2f(4.5, 2), Point2f(5, 3)));
+
+    std::vector<std::vector<std::pair<double, int>>> sweepBreaks;
+    shapeGraph->makeConnections(KeyVertices(), &sweepBreaks);
+
+    std::vector<std::vector<std::pair<double, int>>> lineBreaks = shapeGraph->getLineBreaks();
+    REQUIRE(sweepBreaks.size() == lineBreaks.size());
+    for (size_t i = 0; i < lineBreaks.size(); i++) {
+        REQUIRE(sweepBreaks[i] == lineBreaks[i]);
+    }
+    REQUIRE(sweepBreaks[8].size() == 8);
+    REQUIRE(sweepBreaks[10].empty());
+}
+
+TEST_CASE("Testing AllLineMap fewest-line map extraction")
+{
+    // an L-shaped room
+    std::vector<Point2f> corners = {Point2f(0, 0), Point2f(4, 0), Point2f(4, 1),
+                                    Point2f(1, 1), Point2f(1, 4), Point2f(0, 4)};
+
+    std::vector<SpacePixelFile> drawingFiles;
+    drawingFiles.push_back(SpacePixelFile("Drawing file"));
+    drawingFiles.back().m_spacePixels.push_back(ShapeMap("Drawing layer", ShapeMap::DRAWINGMAP));
+    ShapeMap &drawingLayer = drawingFiles.back().m_spacePixels.back();
+    for (size_t i = 0; i < corners.size(); i++) {
+        drawingLayer.makeLineShape(Line(corners[i], corners[(i + 1) % corners.size()]));
+    }
+
+    AllLineMap allLineMap(nullptr, drawingFiles, Point2f(0.5, 0.5));
+    std::unique_ptr<ShapeGraph> subsetsMap, minimalMap;
+    std::tie(subsetsMap, minimalMap) = allLineMap.extractFewestLineMaps(nullptr);
+
+    // one line along each arm is all it takes, and both have to come from the all-line map
+    REQUIRE(allLineMap.getShapeCount() == 4);
+    REQUIRE(subsetsMap->getShapeCount() == 2);
+    REQUIRE(minimalMap->getShapeCount() == 2);
+    for (auto &shape : minimalMap->getAllShapes()) {
+        const Line &line = shape.second.getLine();
+        bool found = false;
+        for (auto &allLineShape : allLineMap.getAllShapes()) {
+            const Line &allLine = allLineShape.second.getLine();
+            if (approxeq(line.start(), allLine.start(), 1e-6) && approxeq(line.end(), allLine.end(), 1e-6)) {
+                found = true;
+            }
+        }
+        REQUIRE(found);
+    }
+    // and the two have to meet
+    REQUIRE(minimalMap->getConnections()[0].m_connections.size() == 1);
+}
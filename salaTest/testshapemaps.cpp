@@ -121,3 +121,54 @@ TEST_CASE("Testing ShapeMap::getAllShapes variants")
         REQUIRE(colour.bluef() == Approx(0.2f).epsilon(EPSILON));
     }
 }
+
+TEST_CASE("Testing ShapeMap row and key lookups")
+{
+    std::unique_ptr<ShapeMap> shapeMap(new ShapeMap("Test ShapeMap"));
+
+    shapeMap->makeLineShapeWithRef(Line(Point2f(0, 0), Point2f(1, 0)), 10);
+    shapeMap->makeLineShapeWithRef(Line(Point2f(0, 1), Point2f(1, 1)), 20);
+    shapeMap->makeLineShapeWithRef(Line(Point2f(0, 2), Point2f(1, 2)), 30);
+
+    REQUIRE(shapeMap->getShapeIndexFromKey(10) == 0);
+    REQUIRE(shapeMap->getShapeIndexFromKey(30) == 2);
+    REQUIRE(shapeMap->getShapeIndexFromKey(15) == -1);
+    REQUIRE(shapeMap->getIndex(1) == 20);
+
+    SECTION("Appending a shape")
+    {
+        shapeMap->makeLineShapeWithRef(Line(Point2f(0, 3), Point2f(1, 3)), 40);
+        REQUIRE(shapeMap->getShapeIndexFromKey(40) == 3);
+        REQUIRE(shapeMap->getIndex(3) == 40);
+    }
+    SECTION("Inserting a shape before others")
+    {
+        shapeMap->makeLineShapeWithRef(Line(Point2f(0, 3), Point2f(1, 3)), 15);
+        REQUIRE(shapeMap->getShapeIndexFromKey(15) == 1);
+        REQUIRE(shapeMap->getShapeIndexFromKey(30) == 3);
+        REQUIRE(shapeMap->getIndex(2) == 20);
+    }
+    SECTION("Removing a shape")
+    {
+        shapeMap->removeShape(20);
+        REQUIRE(shapeMap->getShapeIndexFromKey(20) == -1);
+        REQUIRE(shapeMap->getShapeIndexFromKey(30) == 1);
+        REQUIRE(shapeMap->getIndex(1) == 30);
+        REQUIRE(shapeMap->getShapeRefFromIndex(2) == shapeMap->getAllShapes().end());
+    }
+    SECTION("Changing the shapes directly")
+    {
+        std::map<int, SalaShape> &shapes = shapeMap->getAllShapes();
+        shapes.erase(20);
+        shapes.insert(std::make_pair(5, SalaShape(Line(Point2f(0, 3), Point2f(1, 3)))));
+        REQUIRE(shapeMap->getShapeIndexFromKey(5) == 0);
+        REQUIRE(shapeMap->getShapeIndexFromKey(20) == -1);
+        REQUIRE(shapeMap->getShapeIndexFromKey(30) == 2);
+        REQUIRE(shapeMap->getShapeRefFromIndex(1)->first == 10);
+
+        // the next change made through the map itself indexes the shapes again
+        shapeMap->makeLineShapeWithRef(Line(Point2f(0, 4), Point2f(1, 4)), 40);
+        REQUIRE(shapeMap->getShapeIndexFromKey(40) == 3);
+        REQUIRE(shapeMap->getShapeRefFromIndex(0)->first == 5);
+    }
+}
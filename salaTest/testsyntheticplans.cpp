@@ -0,0 +1,125 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/syntheticplans.h"
+#include "salalib/mgraph.h"
+#include "genlib/exceptions.h"
+
+namespace {
+    bool samePlan(const depthmapX::SyntheticPlan &a, const depthmapX::SyntheticPlan &b) {
+        if (a.lines.size() != b.lines.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.lines.size(); i++) {
+            if (!(a.lines[i].start() == b.lines[i].start()) || !(a.lines[i].end() == b.lines[i].end())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool linesInRegion(const depthmapX::SyntheticPlan &plan) {
+        for (const Line &line : plan.lines) {
+            if (!plan.region.contains_touch(line.start()) || !plan.region.contains_touch(line.end())) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+TEST_CASE("Synthetic plans are the same for the same seed", "") {
+    using namespace depthmapX;
+    for (auto type : {SyntheticPlanType::FLOORPLATE, SyntheticPlanType::STREET_GRID,
+                      SyntheticPlanType::VORONOI_STREETS, SyntheticPlanType::CITY_BLOCKS}) {
+        SyntheticPlanParameters parameters;
+        parameters.type = type;
+        parameters.size = 12;
+        parameters.seed = 7;
+        SyntheticPlan plan = generateSyntheticPlan(parameters);
+        REQUIRE(samePlan(plan, generateSyntheticPlan(parameters)));
+        REQUIRE(linesInRegion(plan));
+        parameters.seed = 8;
+        REQUIRE_FALSE(samePlan(plan, generateSyntheticPlan(parameters)));
+    }
+}
+
+TEST_CASE("Regular synthetic plans", "") {
+    using namespace depthmapX;
+
+    // 2 bands of 2 rows with 3, 3, 2 and 2 rooms: the outline, the wall between the bands, the
+    // spine walls, the walls between rooms and the corridor walls broken by the doors
+    SyntheticPlan floorplate = generateFloorplate(10, 0, 0.0);
+    REQUIRE(floorplate.lines.size() == 4 + 1 + 4 + 6 + 14);
+    REQUIRE(floorplate.region.width() == Approx(2.0 + 3 * 4.5));
+    REQUIRE(floorplate.region.height() == Approx(2 * 10.0));
+
+    // every street of the grid is one line
+    SyntheticPlan streetGrid = generateStreetGrid(3, 0, 0.0);
+    REQUIRE(streetGrid.lines.size() == 8);
+    for (const Line &line : streetGrid.lines) {
+        REQUIRE(line.length() == Approx(300.0));
+    }
+
+    // one building in each block
+    SyntheticPlan cityBlocks = generateCityBlocks(2, 0, 0.0, 0.25);
+    REQUIRE(cityBlocks.lines.size() == 4 + 4 * 4);
+    REQUIRE(cityBlocks.lines[4].length() == Approx(85.0 * 0.5));
+    REQUIRE(generateCityBlocks(2, 0, 0.0, 0.0).lines.size() == 4);
+}
+
+TEST_CASE("Voronoi street networks", "") {
+    using namespace depthmapX;
+
+    // the bounds and the one street between the two cells
+    SyntheticPlan twoCells = generateVoronoiStreets(2, 3, 0.0);
+    REQUIRE(twoCells.lines.size() == 5);
+
+    // a planar graph of the cells, with no more than 3n - 6 edges between them
+    for (double complexity : {0.0, 1.0}) {
+        int cells = 500;
+        SyntheticPlan plan = generateVoronoiStreets(cells, 11, complexity);
+        REQUIRE(plan.lines.size() - 4 >= size_t(cells - 1));
+        REQUIRE(plan.lines.size() - 4 <= size_t(3 * cells - 6));
+        REQUIRE(linesInRegion(plan));
+    }
+}
+
+TEST_CASE("Synthetic plan parameters are checked", "") {
+    using namespace depthmapX;
+    REQUIRE_THROWS_AS(generateFloorplate(0, 0, 0.5), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(generateStreetGrid(4, 0, 1.5), depthmapX::RuntimeException);
+    REQUIRE_THROWS_AS(generateCityBlocks(4, 0, 0.5, -0.1), depthmapX::RuntimeException);
+}
+
+TEST_CASE("Synthetic plans as drawings and axial maps", "") {
+    using namespace depthmapX;
+    MetaGraph graph;
+    SyntheticPlan plan = generateStreetGrid(3, 0, 0.0);
+    ShapeMap &drawing = addSyntheticDrawing(graph, plan, "Grid");
+    REQUIRE((graph.getState() & MetaGraph::LINEDATA) != 0);
+    REQUIRE(graph.getLineFileCount() == 1);
+    REQUIRE(drawing.getShapeCount() == plan.lines.size());
+
+    REQUIRE(graph.convertDrawingToAxial(nullptr, "Grid axial"));
+    REQUIRE(graph.getDisplayedShapeGraph().getShapeCount() == 8);
+    // the horizontal and the vertical streets each cross all of the others
+    AttributeTable &table = graph.getDisplayedShapeGraph().getAttributeTable();
+    size_t connectivity = table.getColumnIndex("Connectivity");
+    for (auto &row : table) {
+        REQUIRE(row.getRow().getValue(connectivity) == 4);
+    }
+}
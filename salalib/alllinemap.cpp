@@ -2,8 +2,11 @@
 #include "salalib/axialminimiser.h"
 #include "salalib/tolerances.h"
 #include "genlib/exceptions.h"
+#include "genlib/parallel.h"
 #include <time.h>
+#include <cfloat>
 #include <iomanip>
+#include <numeric>
 
 AllLineMap::AllLineMap(Communicator *comm,
                        std::vector<SpacePixelFile> &drawingLayers,
@@ -104,21 +107,52 @@ AllLineMap::AllLineMap(Communicator *comm,
       comm->CommPostMessage( Communicator::CURRENT_RECORD, 0 );
    }
 
-   // cut out duplicates:
+   // cut out duplicates: each line absorbs any later line matching it, where only the lines
+   // starting at about the same x need to be compared (found from the lines sorted by start x)
    int removed = 0;  // for testing purposes
+   double maxdim = __max(region.width(),region.height());
+   double tolerance = maxdim * TOLERANCE_B;
+   std::vector<size_t> bystartx(axiallines.size());
+   std::iota(bystartx.begin(), bystartx.end(), 0);
+   std::sort(bystartx.begin(), bystartx.end(), [&axiallines](size_t a, size_t b) {
+      return axiallines[a].start().x < axiallines[b].start().x;
+   });
+   std::vector<bool> duplicate(axiallines.size(), false);
    for (size_t j = 0; j < axiallines.size(); j++) {
-      for (size_t k = axiallines.size() - 1; k > j; k--) {
-         double maxdim = __max(region.width(),region.height());
-         if (approxeq(axiallines[j].start(), axiallines[k].start(), maxdim * TOLERANCE_B) && approxeq(axiallines[j].end(), axiallines[k].end(), maxdim * TOLERANCE_B)) {
+      if (duplicate[j]) {
+         continue;
+      }
+      double x = axiallines[j].start().x;
+      // a little wider than the tolerance so that rounding can't leave out a match
+      double window = 2.0 * tolerance + 4.0 * DBL_EPSILON * fabs(x);
+      auto candidate = std::lower_bound(bystartx.begin(), bystartx.end(), x - window, [&axiallines](size_t a, double value) {
+         return axiallines[a].start().x < value;
+      });
+      for (; candidate != bystartx.end() && axiallines[*candidate].start().x <= x + window; ++candidate) {
+         size_t k = *candidate;
+         if (k > j && !duplicate[k] && approxeq(axiallines[j].start(), axiallines[k].start(), tolerance) && approxeq(axiallines[j].end(), axiallines[k].end(), tolerance)) {
             for (int preaxiali: preaxialdata[k]) {
                 preaxialdata[j].insert(preaxiali);
             }
-            preaxialdata.erase(preaxialdata.begin() + int(k));
-            axiallines.erase(axiallines.begin() + int(k));
+            duplicate[k] = true;
             removed++;
          }
       }
    }
+   if (removed != 0) {
+      size_t kept = 0;
+      for (size_t j = 0; j < axiallines.size(); j++) {
+         if (!duplicate[j]) {
+            if (kept != j) {
+               axiallines[kept] = axiallines[j];
+               preaxialdata[kept] = std::move(preaxialdata[j]);
+            }
+            kept++;
+         }
+      }
+      axiallines.resize(kept);
+      preaxialdata.resize(kept);
+   }
 
    region.grow(0.99); // <- this paired with crop code below to prevent error
    init(axiallines.size(), m_polygons.getRegion());  // used to be double density here
@@ -145,20 +179,14 @@ std::tuple<std::unique_ptr<ShapeGraph>, std::unique_ptr<ShapeGraph>> AllLineMap:
 
    pafsrand((unsigned int)time(NULL));
 
-   // make one rld for each radial line...
-   std::map<RadialKey, std::set<int> > radialdivisions;
+   // make one rld for each radial line (the radial lines are sorted and unique, so they can be
+   // referred to by index)...
+   std::vector<std::vector<int> > radialdivisions(m_radial_lines.size());
    size_t i;
-   for (auto& radial_line: m_radial_lines) {
-      radialdivisions.insert(std::make_pair( (RadialKey) radial_line, std::set<int>() ));
-   }
 
    // also, a list of radial lines cut by each axial line
-   std::map<int, std::set<int> > ax_radial_cuts;
-   std::map<int, std::set<int> > ax_seg_cuts;
-   for (auto shape: getAllShapes()) {
-      ax_radial_cuts.insert(std::make_pair(shape.first, std::set<int>()));
-      ax_seg_cuts.insert(std::make_pair(shape.first, std::set<int>()));
-   }
+   std::vector<std::vector<int> > ax_radial_cuts(getShapeCount());
+   std::vector<std::vector<int> > ax_seg_cuts(getShapeCount());
 
    // make divisions -- this is the slow part and the comm updates
    makeDivisions(m_poly_connections, m_radial_lines, radialdivisions, ax_radial_cuts, comm);
@@ -170,48 +198,35 @@ std::tuple<std::unique_ptr<ShapeGraph>, std::unique_ptr<ShapeGraph>> AllLineMap:
    }
 
    // a little further setting up is still required...
-   std::map<RadialKey,RadialSegment> radialsegs;
-
-   auto iter = m_radial_lines.begin();
-   if (iter != m_radial_lines.end()) {
-       // now make radial segments from the radial lines... (note, start at 1)
-       auto prevIter = m_radial_lines.begin();
-       ++iter;
-       for (;iter != m_radial_lines.end();) {
-          if (iter->vertex == prevIter->vertex && iter->ang != prevIter->ang) {
-                    radialsegs.insert(std::make_pair( (RadialKey)(*iter), (RadialSegment)(*prevIter)));
-          }
-          ++iter;
-          ++prevIter;
-       }
+   std::vector<RadialSegment> radialsegs;
+   // the radial segment each radial line starts, if any
+   std::vector<int> radialsegindex(m_radial_lines.size(), -1);
+
+   // now make radial segments from the radial lines... (note, start at 1)
+   for (i = 1; i < m_radial_lines.size(); i++) {
+      const RadialLine& radial_line = m_radial_lines[i];
+      const RadialLine& prev_radial_line = m_radial_lines[i - 1];
+      if (radial_line.vertex == prev_radial_line.vertex && radial_line.ang != prev_radial_line.ang) {
+         radialsegindex[i] = int(radialsegs.size());
+         radialsegs.push_back(RadialSegment(int(i), int(i - 1)));
+      }
    }
 
    // and segment divisors from the axial lines...
-   // TODO: (CS) Restructure this to get rid of all those brittle parallel data structure
-   auto axIter = ax_radial_cuts.begin();
-   auto axSeg = ax_seg_cuts.begin();
-   for (i = 0; i < getAllShapes().size(); i++) {
-       auto axRadCutIter = axIter->second.begin();
-       if(axRadCutIter != axIter->second.end()) {
-          auto axRadCutIterPrev = axIter->second.begin();
-          ++axRadCutIter;
-          for (size_t j = 1; j < axIter->second.size(); ++j) {
-             // note similarity to loop above
-             RadialKey& rk_end = m_radial_lines[size_t(*axRadCutIter)];
-             RadialKey& rk_start = m_radial_lines[size_t(*axRadCutIterPrev)];
-             if (rk_start.vertex == rk_end.vertex) {
-                auto radialSegIter = radialsegs.find(rk_end);
-                if (radialSegIter != radialsegs.end() && rk_start == radialSegIter->second.radial_b) {
-                   radialSegIter->second.indices.insert(axIter->first);
-                   axSeg->second.insert(std::distance(radialsegs.begin(), radialSegIter));
-                }
-             }
-             ++axRadCutIter;
-             ++axRadCutIterPrev;
-          }
+   for (i = 0; i < getShapeCount(); i++) {
+      const std::vector<int>& axRadialCut = ax_radial_cuts[i];
+      for (size_t j = 1; j < axRadialCut.size(); ++j) {
+         // note similarity to loop above
+         int rk_end = axRadialCut[j];
+         int rk_start = axRadialCut[j - 1];
+         if (m_radial_lines[size_t(rk_start)].vertex == m_radial_lines[size_t(rk_end)].vertex) {
+            int seg = radialsegindex[size_t(rk_end)];
+            if (seg != -1 && radialsegs[size_t(seg)].radial_b == rk_start) {
+               // segments are numbered in radial line order, so this list stays sorted
+               ax_seg_cuts[i].push_back(seg);
+            }
+         }
       }
-      axIter++;
-      axSeg++;
    }
 
    // and a little more setting up: key vertex relationships
@@ -256,9 +271,9 @@ std::tuple<std::unique_ptr<ShapeGraph>, std::unique_ptr<ShapeGraph>> AllLineMap:
    minimiser.fewestLongest(ax_seg_cuts, radialsegs, radialdivisions, m_radial_lines, keyvertexconns, keyvertexcounts);
 
    // make new lines here (assumes line map has only lines
-   for (int k = 0; k < int(getAllShapes().size()); k++) {
+   for (int k = 0; k < int(getShapeCount()); k++) {
       if (!minimiser.removed(k)) {
-         lines_m.push_back( depthmapX::getMapAtIndex(getAllShapes(), k)->second.getLine() );
+         lines_m.push_back( getShapeRefFromIndex(k)->second.getLine() );
       }
    }
 
@@ -287,20 +302,27 @@ std::tuple<std::unique_ptr<ShapeGraph>, std::unique_ptr<ShapeGraph>> AllLineMap:
 }
 
 void AllLineMap::makeDivisions(const std::vector<PolyConnector>& polyconnections, const std::vector<RadialLine> &radiallines,
-                               std::map<RadialKey,std::set<int> >& radialdivisions, std::map<int, std::set<int> > &axialdividers,
+                               std::vector<std::vector<int> >& radialdivisions, std::vector<std::vector<int> > &axialdividers,
                                Communicator *comm)
 {
-   time_t atime = 0;
    if (comm) {
-      qtimer( atime, 0 );
       comm->CommPostMessage( Communicator::NUM_RECORDS, polyconnections.size() );
    }
 
-   for (size_t i = 0; i < polyconnections.size(); i++) {
+   // the connections are independent of each other, so each one collects the lines dividing it
+   // and these are merged afterwards
+   std::vector<size_t> connindices(polyconnections.size());
+   std::vector<std::vector<int> > dividers(polyconnections.size());
+
+   depthmapX::parallelFor(polyconnections.size(), depthmapX::getThreadCount(), comm, [&](size_t i, size_t) {
       PixelRefVector pixels = pixelateLine(polyconnections[i].line);
       std::vector<size_t> testedshapes;
-      auto connIter = radialdivisions.find(polyconnections[i].key);
-      size_t connindex = std::distance(radialdivisions.begin(), connIter);
+      auto connIter = std::lower_bound(radiallines.begin(), radiallines.end(), polyconnections[i].key);
+      if (connIter == radiallines.end() || !(*connIter == polyconnections[i].key)) {
+         throw depthmapX::RuntimeException("Radial key not found in radial lines");
+      }
+      size_t connindex = std::distance(radiallines.begin(), connIter);
+      connindices[i] = connindex;
       double tolerance = sqrt(TOLERANCE_A);// * polyconnections[i].line.length();
       for (size_t j = 0; j < pixels.size(); j++) {
          PixelRef pix = pixels[j];
@@ -319,27 +341,12 @@ void AllLineMap::makeDivisions(const std::vector<PolyConnector>& polyconnections
                case 0:
                   break;
                case 2:
-                  {
-                     size_t index = depthmapX::findIndexFromKey(axialdividers, (int) shape.m_shape_ref);
-                     if (index != shape.m_shape_ref) {
-                        throw 1; // for the code to work later this can't be true!
-                     }
-                     axialdividers[index].insert(connindex);
-                     connIter->second.insert(shape.m_shape_ref);
-                  }
+                  dividers[i].push_back(int(shape.m_shape_ref));
                   break;
                case 1:
-                  {
-                     size_t index = depthmapX::findIndexFromKey(axialdividers, (int) shape.m_shape_ref);
-                     if (index != shape.m_shape_ref) {
-                        throw 1; // for the code to work later this can't be true!
-                     }
-                     //
-                     // this makes sure actually crosses between the line and the openspace properly
-                     if (radiallines[connindex].cuts(line)) {
-                        axialdividers[index].insert(connindex);
-                        connIter->second.insert(shape.m_shape_ref);
-                     }
+                  // this makes sure actually crosses between the line and the openspace properly
+                  if (radiallines[connindex].cuts(line)) {
+                     dividers[i].push_back(int(shape.m_shape_ref));
                   }
                   break;
                default:
@@ -348,13 +355,23 @@ void AllLineMap::makeDivisions(const std::vector<PolyConnector>& polyconnections
             }
          }
       }
-      if (comm) {
-         if (qtimer( atime, 500 )) {
-            if (comm->IsCancelled()) {
-               throw Communicator::CancelledException();
-            }
-            comm->CommPostMessage( Communicator::CURRENT_RECORD, i );
+   });
+
+   for (size_t i = 0; i < polyconnections.size(); i++) {
+      for (int ref: dividers[i]) {
+         if (getShapeIndexFromKey(ref) != ref) {
+            throw 1; // for the code to work later this can't be true!
          }
+         axialdividers[size_t(ref)].push_back(int(connindices[i]));
+         radialdivisions[connindices[i]].push_back(ref);
       }
    }
+   for (auto& divisions: radialdivisions) {
+      std::sort(divisions.begin(), divisions.end());
+      divisions.erase(std::unique(divisions.begin(), divisions.end()), divisions.end());
+   }
+   for (auto& cuts: axialdividers) {
+      std::sort(cuts.begin(), cuts.end());
+      cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+   }
 }
@@ -19,8 +19,10 @@ public:
         m_keyvertexcount = keyvertexcount;
     }
     std::tuple<std::unique_ptr<ShapeGraph>, std::unique_ptr<ShapeGraph>> extractFewestLineMaps(Communicator *comm);
+    // radialdivisions are the axial lines crossing each radial line (by index) and axialdividers are the
+    // radial lines crossed by each axial line, both sorted
     void makeDivisions(const std::vector<PolyConnector>& polyconnections, const std::vector<RadialLine> &radiallines,
-                       std::map<RadialKey, std::set<int> > &radialdivisions, std::map<int, std::set<int> > &axialdividers,
+                       std::vector<std::vector<int> > &radialdivisions, std::vector<std::vector<int> > &axialdividers,
                        Communicator *comm);
 
 };
@@ -0,0 +1,215 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/analysischeckpoint.h"
+#include "salalib/options.h"
+
+#include "genlib/exceptions.h"
+#include "genlib/mappedblock.h"
+#include "genlib/readwritehelpers.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace depthmapX {
+
+    namespace {
+        const char s_signature[] = "dXcheckpoint";
+        const int s_version = 2;
+        // ends every save, so that one cut short can be told apart
+        const uint32_t s_saveEnd = 0x65766173;
+
+        void writeString(std::ostream &stream, const std::string &str) {
+            dXreadwrite::writeVector(stream, std::vector<char>(str.begin(), str.end()));
+        }
+
+        std::string readString(std::istream &stream) {
+            std::vector<char> chars = dXreadwrite::readVector<char>(stream);
+            return std::string(chars.begin(), chars.end());
+        }
+
+        // writes the data to a new file or the end of one, and waits for it to be on the disk
+        void writeThrough(const std::string &fileName, const std::string &data, bool append) {
+            FILE *file = std::fopen(fileName.c_str(), append ? "ab" : "wb");
+            if (file == nullptr) {
+                throw RuntimeException("Failed to open the checkpoint file " + fileName);
+            }
+            bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+            written = written && _commit(_fileno(file)) == 0;
+#else
+            written = written && fsync(fileno(file)) == 0;
+#endif
+            written = std::fclose(file) == 0 && written;
+            if (!written) {
+                throw RuntimeException("Failed to write the checkpoint to " + fileName);
+            }
+        }
+    } // namespace
+
+    AnalysisCheckpoint::AnalysisCheckpoint(std::string fileName, double interval, bool resume)
+        : m_fileName(std::move(fileName)),
+          m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(interval))),
+          m_resume(resume) {}
+
+    size_t AnalysisCheckpoint::begin(const std::string &analysis) {
+        m_analysis = analysis;
+        m_lastSave = std::chrono::steady_clock::now();
+        m_next = 0;
+        m_processed = 0;
+        m_resumedValues.clear();
+        m_values.clear();
+        m_totals.clear();
+        m_anySave = false;
+        if (m_resume) {
+            readFile();
+        }
+        // the checkpoint starts again from the saves read (or none), leaving out any save cut short, so
+        // that the next ones go straight after
+        rewrite();
+        m_savedValueCount = m_resumedValues.size();
+        return m_next;
+    }
+
+    bool AnalysisCheckpoint::isDue() const { return std::chrono::steady_clock::now() - m_lastSave >= m_interval; }
+
+    void AnalysisCheckpoint::save(size_t next, size_t processed, const std::vector<double> &totals) {
+        std::string data = encodeSave(next, processed, m_values, totals);
+        writeThrough(m_fileName, data, true);
+        m_fileSize += data.size();
+        m_savedValueCount += m_values.size();
+        m_values.clear();
+        // the analysis has set these again long before it gets to a save
+        std::vector<Value>().swap(m_resumedValues);
+        m_lastSave = std::chrono::steady_clock::now();
+        m_next = next;
+        m_processed = processed;
+        m_totals = totals;
+        m_anySave = true;
+
+        // every save has all the totals, of which only the last are needed, so once those that are not
+        // needed any more make up most of the file it is written again without them
+        uint64_t needed = header().size() + m_savedValueCount * sizeof(Value) + totals.size() * sizeof(double);
+        if (m_fileSize > 2 * needed + (1 << 20)) {
+            readFile();
+            rewrite();
+            std::vector<Value>().swap(m_resumedValues);
+        }
+    }
+
+    void AnalysisCheckpoint::readFile() {
+        std::ifstream stream(m_fileName, std::ios::binary | std::ios::ate);
+        if (!stream) {
+            throw RuntimeException("There is no checkpoint to resume from at " + m_fileName);
+        }
+        uint64_t fileSize = uint64_t(stream.tellg());
+        stream.seekg(0);
+        char signature[sizeof(s_signature)] = {};
+        int version = 0;
+        stream.read(signature, sizeof(s_signature) - 1);
+        stream.read(reinterpret_cast<char *>(&version), sizeof(version));
+        if (!stream || std::string(signature) != s_signature || version != s_version) {
+            throw RuntimeException(m_fileName + " is not a checkpoint");
+        }
+        std::string checkpointAnalysis = readString(stream);
+        if (checkpointAnalysis != m_analysis) {
+            throw RuntimeException("The checkpoint at " + m_fileName + " is of a different analysis (" +
+                                   checkpointAnalysis + ") to the one being run (" + m_analysis + ")");
+        }
+        m_resumedValues.clear();
+        while (true) {
+            uint64_t length = 0;
+            if (!stream.read(reinterpret_cast<char *>(&length), sizeof(length)) ||
+                length + sizeof(s_saveEnd) > fileSize - uint64_t(stream.tellg())) {
+                // no more saves, or one cut short, the one before stands
+                break;
+            }
+            std::string data(size_t(length), '\0');
+            uint32_t end = 0;
+            stream.read(&data[0], std::streamsize(length));
+            stream.read(reinterpret_cast<char *>(&end), sizeof(end));
+            if (!stream || end != s_saveEnd) {
+                // a save not written in full
+                break;
+            }
+            std::istringstream save(data);
+            uint64_t next = 0, processed = 0;
+            std::vector<Value> values;
+            save.read(reinterpret_cast<char *>(&next), sizeof(next));
+            save.read(reinterpret_cast<char *>(&processed), sizeof(processed));
+            dXreadwrite::readIntoVector(save, values);
+            dXreadwrite::readIntoVector(save, m_totals);
+            m_next = size_t(next);
+            m_processed = size_t(processed);
+            m_resumedValues.insert(m_resumedValues.end(), values.begin(), values.end());
+            m_anySave = true;
+        }
+    }
+
+    void AnalysisCheckpoint::rewrite() {
+        std::string data = header();
+        if (m_anySave) {
+            data += encodeSave(m_next, m_processed, m_resumedValues, m_totals);
+        }
+        std::string tempFileName = m_fileName + ".new";
+        writeThrough(tempFileName, data, false);
+        if (!replaceFile(tempFileName, m_fileName)) {
+            throw RuntimeException("Failed to move the checkpoint to " + m_fileName);
+        }
+        m_fileSize = data.size();
+    }
+
+    std::string AnalysisCheckpoint::header() const {
+        std::ostringstream stream;
+        stream.write(s_signature, sizeof(s_signature) - 1);
+        stream.write(reinterpret_cast<const char *>(&s_version), sizeof(s_version));
+        writeString(stream, m_analysis);
+        return stream.str();
+    }
+
+    std::string AnalysisCheckpoint::encodeSave(size_t next, size_t processed, const std::vector<Value> &values,
+                                               const std::vector<double> &totals) {
+        std::ostringstream save;
+        uint64_t next64 = next, processed64 = processed;
+        save.write(reinterpret_cast<const char *>(&next64), sizeof(next64));
+        save.write(reinterpret_cast<const char *>(&processed64), sizeof(processed64));
+        dXreadwrite::writeVector(save, values);
+        dXreadwrite::writeVector(save, totals);
+        std::string data = save.str();
+
+        std::ostringstream stream;
+        uint64_t length = data.size();
+        stream.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        stream.write(data.data(), std::streamsize(data.size()));
+        stream.write(reinterpret_cast<const char *>(&s_saveEnd), sizeof(s_saveEnd));
+        return stream.str();
+    }
+
+    std::unique_ptr<AnalysisCheckpoint> makeCheckpoint(const Options &options) {
+        if (options.checkpoint_file.empty()) {
+            return nullptr;
+        }
+        return std::unique_ptr<AnalysisCheckpoint>(
+            new AnalysisCheckpoint(options.checkpoint_file, options.checkpoint_interval, options.resume));
+    }
+} // namespace depthmapX
@@ -0,0 +1,100 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Options;
+
+namespace depthmapX {
+
+    /**
+     *  Keeps the work of a long analysis in a file as it goes, so that a run that dies can carry on
+     *  from where it got to rather than start again. Analyses that go through their origins one after
+     *  the other save the origin to carry on from, the values they have set since the last save and
+     *  anything they total over all the origins (such as choice). Values are kept in the order they
+     *  were set, so that setting them again on resuming leaves the attribute table (stats included) as
+     *  it would have been.
+     *
+     *  Each save is added to the end of the file and is on the disk before save returns. A save cut
+     *  short by a crash is left out when resuming, which carries on from the one before. Starting and
+     *  resuming write a new file that then replaces the old one, so there is always a whole checkpoint
+     */
+    class AnalysisCheckpoint {
+      public:
+        struct Value {
+            // the row as the analysis knows it (shape index, pixel...)
+            int row;
+            int column;
+            float value;
+        };
+
+        // saves at most every interval seconds, 0 to save after every origin. When resuming the file has
+        // to be there
+        AnalysisCheckpoint(std::string fileName, double interval, bool resume);
+
+        // the analysis says what it is, with its options and the size of its map, so that a checkpoint is
+        // only ever resumed by the same analysis. When resuming this reads the checkpoint, and throws if it
+        // was for something else. Returns the origin to carry on from, 0 if starting afresh
+        size_t begin(const std::string &analysis);
+        // how many origins the checkpoint had analysed when last read or saved
+        size_t getProcessed() const { return m_processed; }
+        // the values to set again (in this order) and the totals to carry on from when resuming, until
+        // the next save
+        const std::vector<Value> &getValues() const { return m_resumedValues; }
+        const std::vector<double> &getTotals() const { return m_totals; }
+
+        void recordValue(int row, int column, float value) { m_values.push_back(Value{row, column, value}); }
+        bool isDue() const;
+        // next is the origin to carry on from, totals what the analysis has totalled so far. Only the
+        // values recorded since the last save are written (and then let go of)
+        void save(size_t next, size_t processed, const std::vector<double> &totals = std::vector<double>());
+
+        const std::string &getFileName() const { return m_fileName; }
+
+      private:
+        std::string m_fileName;
+        std::chrono::steady_clock::duration m_interval;
+        bool m_resume;
+        std::string m_analysis;
+        std::chrono::steady_clock::time_point m_lastSave;
+        size_t m_next = 0;
+        size_t m_processed = 0;
+        bool m_anySave = false;
+        std::vector<Value> m_resumedValues;
+        // recorded since the last save
+        std::vector<Value> m_values;
+        std::vector<double> m_totals;
+        // the values in the file, and how big it is
+        size_t m_savedValueCount = 0;
+        uint64_t m_fileSize = 0;
+
+        // reads the saves in the file, as far as the last one written in full
+        void readFile();
+        // writes the file again with the saves read as one
+        void rewrite();
+        std::string header() const;
+        static std::string encodeSave(size_t next, size_t processed, const std::vector<Value> &values,
+                                      const std::vector<double> &totals);
+    };
+
+    // a checkpoint as asked for in the options, none if there is no checkpoint file
+    std::unique_ptr<AnalysisCheckpoint> makeCheckpoint(const Options &options);
+} // namespace depthmapX
@@ -18,9 +18,125 @@
 #include "displayparams.h"
 #include <genlib/stringutils.h>
 #include <genlib/readwritehelpers.h>
+#include <genlib/halffloat.h>
+#include <genlib/exceptions.h>
 
 #include <sstream>
 #include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    bool isUnset(float value)
+    {
+        float unset = -1.0f;
+        return std::memcmp(&value, &unset, sizeof(float)) == 0;
+    }
+
+    bool isWholeNumber(float value, float max)
+    {
+        return value >= 0.0f && value <= max && value == std::floor(value) && !std::signbit(value);
+    }
+
+    size_t encodedWidth(AttributeColumnEncoding encoding)
+    {
+        switch (encoding)
+        {
+        case AttributeColumnEncoding::UINT8:
+        case AttributeColumnEncoding::DICTIONARY:
+            return 1;
+        case AttributeColumnEncoding::UINT16:
+        case AttributeColumnEncoding::FLOAT16:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    // the distinct values (as bits, so -0 and NaNs are kept as they are), or false if there are more
+    // than a dictionary can take
+    bool findDistinctValues(const std::vector<float> &values, std::unordered_map<uint32_t, unsigned char> &distinct)
+    {
+        for (float value: values)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            if (distinct.find(bits) == distinct.end())
+            {
+                if (distinct.size() == 256)
+                {
+                    return false;
+                }
+                distinct.insert(std::make_pair(bits, (unsigned char)distinct.size()));
+            }
+        }
+        return true;
+    }
+
+    // whether every value can be kept exactly in the encoding (FLOAT16 rounds them, but they still have
+    // to be within its range)
+    bool fitsEncoding(const std::vector<float> &values, AttributeColumnEncoding encoding)
+    {
+        switch (encoding)
+        {
+        case AttributeColumnEncoding::UINT8:
+        case AttributeColumnEncoding::UINT16:
+        {
+            float max = encoding == AttributeColumnEncoding::UINT8 ? 254.0f : 65534.0f;
+            return std::all_of(values.begin(), values.end(),
+                               [max](float value) { return isUnset(value) || isWholeNumber(value, max); });
+        }
+        case AttributeColumnEncoding::INT32:
+            return std::all_of(values.begin(), values.end(), [](float value) {
+                return isUnset(value) || (value >= -2147483648.0f && value < 2147483648.0f &&
+                                          value == std::floor(value) && !(value == 0.0f && std::signbit(value)));
+            });
+        case AttributeColumnEncoding::FLOAT16:
+            return std::all_of(values.begin(), values.end(),
+                               [](float value) { return std::isnan(value) || std::abs(value) <= 65504.0f; });
+        case AttributeColumnEncoding::DICTIONARY:
+        {
+            std::unordered_map<uint32_t, unsigned char> distinct;
+            return findDistinctValues(values, distinct);
+        }
+        default:
+            return true;
+        }
+    }
+
+    AttributeColumnEncoding chooseEncoding(const std::vector<float> &values)
+    {
+        float max = 0.0f;
+        bool wholeNumbers = true;
+        for (float value: values)
+        {
+            if (isUnset(value))
+            {
+                continue;
+            }
+            if (!isWholeNumber(value, 65534.0f))
+            {
+                wholeNumbers = false;
+                break;
+            }
+            max = std::max(max, value);
+        }
+        if (wholeNumbers)
+        {
+            return max <= 254.0f ? AttributeColumnEncoding::UINT8 : AttributeColumnEncoding::UINT16;
+        }
+        // a code per row and a float per distinct value, against a float per row
+        std::unordered_map<uint32_t, unsigned char> distinct;
+        if (findDistinctValues(values, distinct) && distinct.size() * 4 < values.size() * 3)
+        {
+            return AttributeColumnEncoding::DICTIONARY;
+        }
+        return AttributeColumnEncoding::FLOAT32;
+    }
+}
 
 const std::string &AttributeColumnImpl::getName() const
 {
@@ -88,7 +204,7 @@ void AttributeColumnImpl::setName(const std::string &name)
     m_name = name;
 }
 
-size_t AttributeColumnImpl::read(std::istream &stream)
+size_t AttributeColumnImpl::read(std::istream &stream, bool withEncoding)
 {
     m_name = dXstring::readString(stream);
     float val;
@@ -104,10 +220,14 @@ size_t AttributeColumnImpl::read(std::istream &stream)
 
     stream.read((char*)&m_displayParams,sizeof(DisplayParams));
     m_formula = dXstring::readString(stream);
+    if (withEncoding)
+    {
+        stream.read((char *)&m_encoding, sizeof(m_encoding));
+    }
     return physical_column;
 }
 
-void AttributeColumnImpl::write(std::ostream &stream, int physicalCol)
+void AttributeColumnImpl::write(std::ostream &stream, int physicalCol, bool withEncoding)
 {
     dXstring::writeString(stream, m_name);
     float min = (float)m_stats.min;
@@ -120,48 +240,92 @@ void AttributeColumnImpl::write(std::ostream &stream, int physicalCol)
     stream.write((char *)&m_locked, sizeof(bool));
     stream.write((char *)&m_displayParams, sizeof(DisplayParams));
     dXstring::writeString(stream, m_formula);
-
+    if (withEncoding)
+    {
+        stream.write((const char *)&m_encoding, sizeof(m_encoding));
+    }
 }
 
 
 // AttributeRow implementation
+AttributeRowImpl::AttributeRowImpl(AttributeTable &table, size_t rowIndex)
+    : m_colManager(&table), m_table(&table), m_rowIndex(rowIndex), m_selected(false)
+{
+    m_layerKey = 1;
+}
+
+float &AttributeRowImpl::value(size_t index)
+{
+    if (m_table == nullptr)
+    {
+        return m_data[index];
+    }
+    m_table->unpackColumn(index);
+    return m_table->m_columnData[index][m_rowIndex];
+}
+
+float AttributeRowImpl::value(size_t index) const
+{
+    if (m_table == nullptr)
+    {
+        return m_data[index];
+    }
+    return m_table->readValue(index, m_rowIndex);
+}
+
+size_t AttributeRowImpl::numValues() const
+{
+    return m_table ? m_table->m_columnData.size() : m_data.size();
+}
+
 float AttributeRowImpl::getValue(const std::string &column) const
 {
-    return getValue(m_colManager.getColumnIndex(column));
+    return getValue(m_colManager->getColumnIndex(column));
 }
 
 float AttributeRowImpl::getValue(size_t index) const
 {
     checkIndex(index);
-    return m_data[index];
+    return value(index);
 }
 
 float AttributeRowImpl::getNormalisedValue(size_t index) const
 {
     checkIndex(index);
-    auto& colStats = m_colManager.getColumn(index).getStats();
+    auto& colStats = m_colManager->getColumn(index).getStats();
     if (colStats.max == colStats.min)
     {
         return 0.5f;
     }
-    return  m_data[index] < 0 ? -1.0f : float((m_data[index] - colStats.min)/(colStats.max - colStats.min));
+    float val = value(index);
+    return  val < 0 ? -1.0f : float((val - colStats.min)/(colStats.max - colStats.min));
 }
 
 AttributeRow& AttributeRowImpl::setValue(const std::string &column, float value)
 {
-    return setValue(m_colManager.getColumnIndex(column), value);
+    return setValue(m_colManager->getColumnIndex(column), value);
 }
 
 AttributeRow& AttributeRowImpl::setValue(size_t index, float value)
 {
     checkIndex(index);
-    float oldVal = m_data[index];
-    m_data[index] = value;
+    float& val = this->value(index);
+    float oldVal = val;
     if (oldVal < 0.0f)
     {
         oldVal = 0.0f;
     }
-    m_colManager.getColumn(index).updateStats(value, oldVal);
+    // the stats go first, so a batch catching up on its stats still sees the value being replaced
+    if (m_table)
+    {
+        m_table->updateStats(index, m_rowIndex, value, oldVal);
+        m_table->updateColumnOrder(index, m_rowIndex, value);
+    }
+    else
+    {
+        m_colManager->getColumn(index).updateStats(value, oldVal);
+    }
+    val = value;
     return *this;
 }
 
@@ -190,18 +354,38 @@ void AttributeRowImpl::removeColumn(size_t index)
 void AttributeRowImpl::read(std::istream &stream)
 {
     stream.read((char *)&m_layerKey, sizeof(m_layerKey));
-    dXreadwrite::readIntoVector(stream, m_data);
+    if (m_table == nullptr)
+    {
+        dXreadwrite::readIntoVector(stream, m_data);
+        return;
+    }
+    std::vector<float> data;
+    dXreadwrite::readIntoVector(stream, data);
+    for (size_t i = 0; i < numValues(); i++)
+    {
+        value(i) = i < data.size() ? data[i] : -1.0f;
+    }
 }
 
 void AttributeRowImpl::write(std::ostream &stream)
 {
     stream.write((char *)&m_layerKey, sizeof(m_layerKey));
-    dXreadwrite::writeVector(stream, m_data);
+    if (m_table == nullptr)
+    {
+        dXreadwrite::writeVector(stream, m_data);
+        return;
+    }
+    std::vector<float> data(numValues());
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = value(i);
+    }
+    dXreadwrite::writeVector(stream, data);
 }
 
 void AttributeRowImpl::checkIndex(size_t index) const
 {
-    if( index >= m_data.size())
+    if( index >= numValues())
     {
         throw std::out_of_range("AttributeColumn index out of range");
     }
@@ -212,7 +396,7 @@ void AttributeRowImpl::checkIndex(size_t index) const
 AttributeRow &AttributeRowImpl::incrValue(size_t index, float value)
 {
     checkIndex(index);
-    float val = m_data[index];
+    float val = this->value(index);
     if ( val < 0)
     {
         setValue(index, value);
@@ -227,7 +411,109 @@ AttributeRow &AttributeRowImpl::incrValue(size_t index, float value)
 
 AttributeRow &AttributeRowImpl::incrValue(const std::string &colName, float value)
 {
-    return incrValue(m_colManager.getColumnIndex(colName), value);
+    return incrValue(m_colManager->getColumnIndex(colName), value);
+}
+
+AttributeTable::AttributeTable(AttributeTable &&other)
+    : m_rows(std::move(other.m_rows)), m_columnData(std::move(other.m_columnData)),
+      m_columnMapping(std::move(other.m_columnMapping)), m_columns(std::move(other.m_columns)),
+      m_keyColumn(std::move(other.m_keyColumn)), m_displayParams(other.m_displayParams),
+      m_statsBatchDepth(other.m_statsBatchDepth), m_deferredStats(std::move(other.m_deferredStats)),
+      m_staleStats(std::move(other.m_staleStats)), m_anyStaleStats(other.m_anyStaleStats.load()),
+      m_columnOrders(std::move(other.m_columnOrders)), m_columnOrderRevision(other.m_columnOrderRevision),
+      m_compactColumns(std::move(other.m_compactColumns)), m_numCompactColumns(other.m_numCompactColumns),
+      m_keyRows(std::move(other.m_keyRows)), m_keyRowsBase(other.m_keyRowsBase)
+{
+    other.m_numCompactColumns = 0;
+    other.m_keyRows.clear();
+    reindexRows(0);
+}
+
+AttributeTable &AttributeTable::operator=(AttributeTable &&other)
+{
+    m_rows = std::move(other.m_rows);
+    m_columnData = std::move(other.m_columnData);
+    m_columnMapping = std::move(other.m_columnMapping);
+    m_columns = std::move(other.m_columns);
+    m_keyColumn = std::move(other.m_keyColumn);
+    m_displayParams = other.m_displayParams;
+    m_statsBatchDepth = other.m_statsBatchDepth;
+    m_deferredStats = std::move(other.m_deferredStats);
+    m_staleStats = std::move(other.m_staleStats);
+    m_anyStaleStats = other.m_anyStaleStats.load();
+    m_columnOrders = std::move(other.m_columnOrders);
+    m_columnOrderRevision = other.m_columnOrderRevision;
+    m_compactColumns = std::move(other.m_compactColumns);
+    m_numCompactColumns = other.m_numCompactColumns;
+    other.m_numCompactColumns = 0;
+    m_keyRows = std::move(other.m_keyRows);
+    m_keyRowsBase = other.m_keyRowsBase;
+    other.m_keyRows.clear();
+    reindexRows(0);
+    return *this;
+}
+
+size_t AttributeTable::findRowIndex(const AttributeKey &key) const
+{
+    if (!m_keyRows.empty())
+    {
+        int64_t slot = int64_t(key.value) - m_keyRowsBase;
+        if (slot < 0 || slot >= int64_t(m_keyRows.size()) || m_keyRows[size_t(slot)] < 0)
+        {
+            return size_t(-1);
+        }
+        return size_t(m_keyRows[size_t(slot)]);
+    }
+    auto iter = std::lower_bound(m_rows.begin(), m_rows.end(), key,
+                                 [](const StorageType::value_type &row, const AttributeKey &k) { return row.first < k; });
+    if (iter == m_rows.end() || key < iter->first)
+    {
+        return size_t(-1);
+    }
+    return size_t(std::distance(m_rows.begin(), iter));
+}
+
+AttributeTable::StorageType::iterator AttributeTable::findRow(const AttributeKey &key)
+{
+    size_t rowIndex = findRowIndex(key);
+    return rowIndex == size_t(-1) ? m_rows.end() : m_rows.begin() + std::ptrdiff_t(rowIndex);
+}
+
+AttributeTable::StorageType::const_iterator AttributeTable::findRow(const AttributeKey &key) const
+{
+    size_t rowIndex = findRowIndex(key);
+    return rowIndex == size_t(-1) ? m_rows.end() : m_rows.begin() + std::ptrdiff_t(rowIndex);
+}
+
+void AttributeTable::rebuildKeyRows()
+{
+    m_keyRows.clear();
+    if (m_rows.empty())
+    {
+        return;
+    }
+    int64_t slots = int64_t(m_rows.back().first.value) - m_rows.front().first.value + 1;
+    if (!keyRowsFit(size_t(slots), m_rows.size()))
+    {
+        return;
+    }
+    m_keyRowsBase = m_rows.front().first.value;
+    m_keyRows.assign(size_t(slots), -1);
+    for (size_t i = 0; i < m_rows.size(); i++)
+    {
+        m_keyRows[size_t(m_rows[i].first.value - m_keyRowsBase)] = int(i);
+    }
+}
+
+void AttributeTable::reindexRows(size_t from)
+{
+    for (size_t i = from; i < m_rows.size(); i++)
+    {
+        AttributeRowImpl& row = *m_rows[i].second;
+        row.m_colManager = this;
+        row.m_table = this;
+        row.m_rowIndex = i;
+    }
 }
 
 AttributeRow &AttributeTable::getRow(const AttributeKey &key)
@@ -252,7 +538,7 @@ const AttributeRow& AttributeTable::getRow(const AttributeKey &key) const
 
 AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
+    auto iter = findRow(key);
     if (iter == m_rows.end())
     {
         return 0;
@@ -262,7 +548,7 @@ AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key)
 
 const AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key) const
 {
-    auto iter = m_rows.find(key);
+    auto iter = findRow(key);
     if (iter == m_rows.end())
     {
         return 0;
@@ -272,23 +558,71 @@ const AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key) const
 
 AttributeRow &AttributeTable::addRow(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
-    if (iter != m_rows.end())
+    // rows nearly always arrive in key order, so this is usually an append
+    auto iter = m_rows.end();
+    if (!m_rows.empty() && !(m_rows.back().first < key))
+    {
+        iter = std::lower_bound(m_rows.begin(), m_rows.end(), key,
+                                [](const StorageType::value_type &row, const AttributeKey &k) { return row.first < k; });
+        if (!(key < iter->first))
+        {
+            throw new std::invalid_argument("Duplicate key");
+        }
+    }
+    flushDeferredStats();
+    invalidateColumnOrders();
+    unpackColumns();
+    size_t rowIndex = std::distance(m_rows.begin(), iter);
+    for (auto& column: m_columnData)
+    {
+        column.insert(column.begin() + rowIndex, -1.0f);
+    }
+    iter = m_rows.insert(iter, std::make_pair(key, std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this, rowIndex))));
+    if (rowIndex + 1 != m_rows.size())
+    {
+        // an insert before other rows moves all of them along, which is already as much work as
+        // rebuilding the key index
+        reindexRows(rowIndex + 1);
+        rebuildKeyRows();
+    }
+    else if (m_rows.size() == 1)
     {
-        throw new std::invalid_argument("Duplicate key");
+        rebuildKeyRows();
     }
-    auto res = m_rows.insert(std::make_pair(key, std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this))));
-    return *res.first->second;
+    else if (!m_keyRows.empty())
+    {
+        size_t slot = size_t(int64_t(key.value) - m_keyRowsBase);
+        if (keyRowsFit(slot + 1, m_rows.size()))
+        {
+            m_keyRows.resize(slot + 1, -1);
+            m_keyRows[slot] = int(rowIndex);
+        }
+        else
+        {
+            m_keyRows.clear();
+        }
+    }
+    return *iter->second;
 }
 
 void AttributeTable::removeRow(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
+    auto iter = findRow(key);
     if (iter == m_rows.end())
     {
         throw new std::invalid_argument("Row does not exist");
     }
+    flushDeferredStats();
+    invalidateColumnOrders();
+    unpackColumns();
+    size_t rowIndex = std::distance(m_rows.begin(), iter);
     m_rows.erase(iter);
+    for (auto& column: m_columnData)
+    {
+        column.erase(column.begin() + rowIndex);
+    }
+    reindexRows(rowIndex);
+    rebuildKeyRows();
 }
 
 AttributeColumn &AttributeTable::getColumn(size_t index)
@@ -297,6 +631,7 @@ AttributeColumn &AttributeTable::getColumn(size_t index)
         return m_keyColumn;
     }
     checkColumnIndex(index);
+    refreshStats(index);
     return m_columns[index];
 }
 
@@ -308,13 +643,18 @@ size_t AttributeTable::insertOrResetColumn(const std::string &columnName, const
         return addColumnInternal(columnName, formula);
     }
 
-    // it exists - we need to reset it
-    m_columns[iter->second].m_stats = AttributeColumnStats();
-    m_columns[iter->second].setLock(false);
-    for (auto& row : m_rows)
+    // it exists - we need to reset it (setting every value to -1 leaves the stats as they are
+    // reset to, so the values can simply be overwritten)
+    flushDeferredStats();
+    if (iter->second < m_staleStats.size())
     {
-        row.second->setValue(iter->second, -1.0f);
+        m_staleStats[iter->second] = 0;
     }
+    invalidateColumnOrder(iter->second);
+    unpackColumn(iter->second);
+    m_columns[iter->second].m_stats = AttributeColumnStats();
+    m_columns[iter->second].setLock(false);
+    std::fill(m_columnData[iter->second].begin(), m_columnData[iter->second].end(), -1.0f);
     return iter->second;
 }
 
@@ -345,6 +685,7 @@ size_t AttributeTable::getOrInsertLockedColumn(const std::string &columnName, co
 void AttributeTable::removeColumn(size_t colIndex)
 {
     checkColumnIndex(colIndex);
+    flushDeferredStats();
     const std::string& name = m_columns[colIndex].getName();
     auto iter = m_columnMapping.find(name);
     m_columnMapping.erase(iter);
@@ -356,9 +697,24 @@ void AttributeTable::removeColumn(size_t colIndex)
         }
     }
     m_columns.erase(m_columns.begin()+colIndex);
-    for (auto& row : m_rows)
+    m_columnData.erase(m_columnData.begin()+colIndex);
+    if (colIndex < m_staleStats.size())
     {
-        row.second->removeColumn(colIndex);
+        m_staleStats.erase(m_staleStats.begin()+colIndex);
+    }
+    if (colIndex < m_columnOrders.size())
+    {
+        m_columnOrders.erase(m_columnOrders.begin()+colIndex);
+    }
+    // the columns after it move down one
+    m_columnOrderRevision = newColumnOrderRevision();
+    if (colIndex < m_compactColumns.size())
+    {
+        if (m_compactColumns[colIndex].encoding != AttributeColumnEncoding::FLOAT32)
+        {
+            m_numCompactColumns--;
+        }
+        m_compactColumns.erase(m_compactColumns.begin()+colIndex);
     }
 }
 
@@ -399,6 +755,11 @@ void AttributeTable::read(std::istream &stream, LayerManager &layerManager)
     layerManager.read(stream);
     int colcount;
     stream.read((char *)&colcount, sizeof(colcount));
+    if (colcount < 0)
+    {
+        readColumnar(stream, -colcount - 1);
+        return;
+    }
     std::map<size_t, AttributeColumnImpl> tmp;
     for (int j = 0; j < colcount; j++) {
         AttributeColumnImpl col("");
@@ -409,15 +770,80 @@ void AttributeTable::read(std::istream &stream, LayerManager &layerManager)
     {
         m_columnMapping[c.second.getName()] = m_columns.size();
         m_columns.push_back(c.second);
+        m_columnData.push_back(std::vector<float>());
     }
+    m_columnOrders.resize(m_columns.size());
 
     int rowcount, rowkey;
     stream.read((char *)&rowcount, sizeof(rowcount));
+    for (auto& column: m_columnData)
+    {
+        column.reserve(m_rows.size() + rowcount);
+    }
+    m_rows.reserve(m_rows.size() + rowcount);
     for (int i = 0; i < rowcount; i++) {
         stream.read((char *)&rowkey, sizeof(rowkey));
-        auto row = std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this));
-        row->read(stream);
-        m_rows.insert(std::make_pair(AttributeKey(rowkey),std::move(row)));
+        static_cast<AttributeRowImpl&>(addRow(AttributeKey(rowkey))).read(stream);
+    }
+
+    // ref column display params
+    stream.read((char *)&m_displayParams,sizeof(DisplayParams));
+}
+
+void AttributeTable::readColumnar(std::istream &stream, int colcount)
+{
+    std::map<size_t, AttributeColumnImpl> tmp;
+    for (int j = 0; j < colcount; j++) {
+        AttributeColumnImpl col("");
+        tmp[col.read(stream, true)] = col;
+    }
+    for (auto & c : tmp)
+    {
+        m_columnMapping[c.second.getName()] = m_columns.size();
+        m_columns.push_back(c.second);
+    }
+    m_columnOrders.resize(m_columns.size());
+
+    // the rows go in before the column arrays, so adding them does not have to fill those
+    int rowcount;
+    stream.read((char *)&rowcount, sizeof(rowcount));
+    m_rows.reserve(m_rows.size() + rowcount);
+    for (int i = 0; i < rowcount; i++) {
+        AttributeKey key(-1);
+        key.read(stream);
+        LayerManager::KeyType layerKey;
+        stream.read((char *)&layerKey, sizeof(layerKey));
+        addRow(key).setLayerKey(layerKey);
+    }
+
+    m_columnData.resize(m_columns.size());
+    m_compactColumns.resize(m_columns.size());
+    for (size_t colIndex = 0; colIndex < m_columns.size(); colIndex++)
+    {
+        AttributeColumnEncoding encoding;
+        stream.read((char *)&encoding, sizeof(encoding));
+        if (encoding == AttributeColumnEncoding::FLOAT32)
+        {
+            dXreadwrite::readIntoVector(stream, m_columnData[colIndex]);
+            if (m_columnData[colIndex].size() != m_rows.size())
+            {
+                throw depthmapX::RuntimeException("Attribute column does not match the number of rows");
+            }
+            continue;
+        }
+        // compact columns stay compact until their values are needed
+        CompactColumn& compact = m_compactColumns[colIndex];
+        compact.encoding = encoding;
+        if (encoding == AttributeColumnEncoding::DICTIONARY)
+        {
+            dXreadwrite::readIntoVector(stream, compact.dictionary);
+        }
+        dXreadwrite::readIntoVector(stream, compact.bytes);
+        if (compact.bytes.size() != encodedWidth(encoding) * m_rows.size())
+        {
+            throw depthmapX::RuntimeException("Attribute column does not match the number of rows");
+        }
+        m_numCompactColumns++;
     }
 
     // ref column display params
@@ -427,7 +853,9 @@ void AttributeTable::read(std::istream &stream, LayerManager &layerManager)
 void AttributeTable::write(std::ostream &stream, const LayerManager &layerManager)
 {
     layerManager.write(stream);
-    int colCount = (int)m_columns.size();
+    // the values are written by column, each in its own encoding. A negative column count tells these
+    // tables apart from the ones written by row before VERSION_ATTRIBUTE_COLUMNS
+    int colCount = -(int)m_columns.size() - 1;
     stream.write((char *)&colCount, sizeof(int));
 
     // TODO: For binary compatibility write the columns in alphabetical order
@@ -442,7 +870,8 @@ void AttributeTable::write(std::ostream &stream, const LayerManager &layerManage
     });
 
     for (int idx: indices) {
-        m_columns[idx].write(stream, m_columnMapping[m_columns[idx].getName()]);
+        refreshStats(idx);
+        m_columns[idx].write(stream, m_columnMapping[m_columns[idx].getName()], true);
     }
 
     int rowcount = (int)m_rows.size();
@@ -450,13 +879,53 @@ void AttributeTable::write(std::ostream &stream, const LayerManager &layerManage
     for ( auto &kvp : m_rows)
     {
         kvp.first.write(stream);
-        kvp.second->write(stream);
+        stream.write((const char *)&kvp.second->getLayerKey(), sizeof(LayerManager::KeyType));
+    }
+
+    for (size_t colIndex = 0; colIndex < m_columns.size(); colIndex++)
+    {
+        CompactColumn encoded;
+        const CompactColumn* compact = &encoded;
+        if (colIndex < m_compactColumns.size() && m_compactColumns[colIndex].encoding != AttributeColumnEncoding::FLOAT32)
+        {
+            compact = &m_compactColumns[colIndex];
+        }
+        else
+        {
+            const std::vector<float>& values = m_columnData[colIndex];
+            AttributeColumnEncoding encoding = m_columns[colIndex].getEncoding();
+            if (encoding == AttributeColumnEncoding::AUTO || !fitsEncoding(values, encoding))
+            {
+                encoding = chooseEncoding(values);
+            }
+            if (encoding == AttributeColumnEncoding::FLOAT32)
+            {
+                stream.write((const char *)&encoding, sizeof(encoding));
+                dXreadwrite::writeVector(stream, values);
+                continue;
+            }
+            encoded.encode(values, encoding);
+        }
+        stream.write((const char *)&compact->encoding, sizeof(compact->encoding));
+        if (compact->encoding == AttributeColumnEncoding::DICTIONARY)
+        {
+            dXreadwrite::writeVector(stream, compact->dictionary);
+        }
+        dXreadwrite::writeVector(stream, compact->bytes);
     }
     stream.write((const char *)&m_displayParams, sizeof(DisplayParams));
 }
 
 void AttributeTable::clear() {
+    m_deferredStats.clear();
+    m_staleStats.clear();
+    m_columnOrders.clear();
+    m_columnOrderRevision = newColumnOrderRevision();
+    m_compactColumns.clear();
+    m_numCompactColumns = 0;
     m_rows.clear();
+    m_keyRows.clear();
+    m_columnData.clear();
     m_columns.clear();
     m_columnMapping.clear();
 }
@@ -491,6 +960,7 @@ const AttributeColumn &AttributeTable::getColumn(size_t index) const
         return m_keyColumn;
     }
     checkColumnIndex(index);
+    refreshStats(index);
     return m_columns[index];
 }
 
@@ -523,9 +993,435 @@ size_t AttributeTable::addColumnInternal(const std::string &name, const std::str
     size_t colIndex = m_columns.size();
     m_columns.push_back(AttributeColumnImpl(name, formula));
     m_columnMapping[name] = colIndex;
-    for (auto& elem : m_rows)
+    m_columnData.push_back(std::vector<float>(m_rows.size(), -1.0f));
+    m_columnOrders.resize(m_columns.size());
+    return colIndex;
+}
+
+void AttributeTable::beginStatsBatch()
+{
+    m_statsBatchDepth++;
+}
+
+void AttributeTable::endStatsBatch()
+{
+    if (m_statsBatchDepth > 0 && --m_statsBatchDepth == 0)
     {
-        elem.second->addColumn();
+        flushDeferredStats();
+    }
+}
+
+void AttributeTable::updateStats(size_t colIndex, size_t rowIndex, float value, float oldVal)
+{
+    if (colIndex < m_staleStats.size() && m_staleStats[colIndex])
+    {
+        // the stats will be worked out from scratch anyway
+        return;
+    }
+    if (m_statsBatchDepth == 0)
+    {
+        m_columns[colIndex].AttributeColumnImpl::updateStats(value, oldVal);
+        return;
+    }
+    if (colIndex >= m_deferredStats.size())
+    {
+        m_deferredStats.resize(m_columns.size());
+    }
+    DeferredColumnStats& deferred = m_deferredStats[colIndex];
+    if (deferred.deferring)
+    {
+        if (oldVal == 0.0f && (deferred.written.empty() || rowIndex > deferred.lastRow))
+        {
+            if (deferred.written.empty())
+            {
+                deferred.written.assign(m_rows.size(), 0);
+            }
+            deferred.written[rowIndex] = 1;
+            deferred.lastRow = rowIndex;
+            return;
+        }
+        flushDeferredStats(colIndex);
+        deferred.deferring = false;
+    }
+    m_columns[colIndex].AttributeColumnImpl::updateStats(value, oldVal);
+}
+
+void AttributeTable::flushDeferredStats(size_t colIndex)
+{
+    DeferredColumnStats& deferred = m_deferredStats[colIndex];
+    if (colIndex < m_staleStats.size() && m_staleStats[colIndex])
+    {
+        deferred.written.clear();
+        return;
+    }
+    const std::vector<float>& column = m_columnData[colIndex];
+    for (size_t rowIndex = 0; rowIndex < deferred.written.size(); rowIndex++)
+    {
+        if (deferred.written[rowIndex])
+        {
+            m_columns[colIndex].AttributeColumnImpl::updateStats(column[rowIndex], 0.0f);
+        }
+    }
+    deferred.written.clear();
+}
+
+void AttributeTable::flushDeferredStats()
+{
+    for (size_t colIndex = 0; colIndex < m_deferredStats.size(); colIndex++)
+    {
+        flushDeferredStats(colIndex);
+    }
+    m_deferredStats.clear();
+}
+
+depthmapX::Span<const float> AttributeTable::readColumn(size_t colIndex)
+{
+    checkColumnIndex(colIndex);
+    unpackColumn(colIndex);
+    return depthmapX::Span<const float>(m_columnData[colIndex]);
+}
+
+depthmapX::Span<const float> AttributeTable::readColumn(size_t colIndex, std::vector<float> &decoded) const
+{
+    checkColumnIndex(colIndex);
+    if (!isCompact(colIndex))
+    {
+        return depthmapX::Span<const float>(m_columnData[colIndex]);
+    }
+    m_compactColumns[colIndex].decode(decoded, m_rows.size());
+    return depthmapX::Span<const float>(decoded);
+}
+
+depthmapX::Span<float> AttributeTable::writeColumn(size_t colIndex)
+{
+    checkColumnIndex(colIndex);
+    unpackColumn(colIndex);
+    if (m_staleStats.size() < m_columns.size())
+    {
+        m_staleStats.resize(m_columns.size(), 0);
+    }
+    m_staleStats[colIndex] = 1;
+    m_anyStaleStats = true;
+    invalidateColumnOrder(colIndex);
+    return depthmapX::Span<float>(m_columnData[colIndex]);
+}
+
+void AttributeTable::refreshStats(size_t colIndex) const
+{
+    if (!m_anyStaleStats)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_lazyStateMutex);
+    if (colIndex >= m_staleStats.size() || !m_staleStats[colIndex])
+    {
+        return;
+    }
+    m_staleStats[colIndex] = 0;
+    // for values written once each over unset cells the incremental stats come down to the plain
+    // minimum, maximum and (row order) total of the values that are set
+    bool anySet = false;
+    float min = 0.0f, max = 0.0f;
+    double total = 0.0;
+    for (float val: m_columnData[colIndex])
+    {
+        if (val >= 0.0f)
+        {
+            if (!anySet)
+            {
+                min = max = val;
+                anySet = true;
+            }
+            min = std::min(min, val);
+            max = std::max(max, val);
+            total += val;
+        }
+    }
+    AttributeColumnStats& stats = m_columns[colIndex].m_stats;
+    stats.min = anySet ? min : -1.0;
+    stats.max = anySet ? max : -1.0;
+    stats.total = anySet ? total : -1.0;
+    // the flag goes last, so that a reader that does not lock sees the stats it stands for
+    m_anyStaleStats = std::find(m_staleStats.begin(), m_staleStats.end(), 1) != m_staleStats.end();
+}
+
+size_t AttributeTable::getRowIndex(const AttributeKey &key) const
+{
+    return findRowIndex(key);
+}
+
+const std::vector<size_t> &AttributeTable::getColumnOrder(size_t colIndex) const
+{
+    checkColumnIndex(colIndex);
+    std::lock_guard<std::mutex> lock(m_lazyStateMutex);
+    ColumnOrder& columnOrder = m_columnOrders[colIndex];
+    columnOrder.patches = 0;
+    if (!columnOrder.valid)
+    {
+        std::vector<float> decoded;
+        depthmapX::Span<const float> values = readColumn(colIndex, decoded);
+        columnOrder.rows.resize(values.size());
+        std::iota(columnOrder.rows.begin(), columnOrder.rows.end(), size_t(0));
+        std::stable_sort(columnOrder.rows.begin(), columnOrder.rows.end(),
+                         [&values](size_t a, size_t b) { return values[a] < values[b]; });
+        columnOrder.valid = true;
+    }
+    return columnOrder.rows;
+}
+
+std::pair<size_t, size_t> AttributeTable::getColumnOrderRange(size_t colIndex, float fromValue, float toValue) const
+{
+    const std::vector<size_t>& rows = getColumnOrder(colIndex);
+    auto first = std::lower_bound(rows.begin(), rows.end(), fromValue, [this, colIndex](size_t row, float value) {
+        return readValue(colIndex, row) < value;
+    });
+    auto last = std::upper_bound(first, rows.end(), toValue, [this, colIndex](float value, size_t row) {
+        return value < readValue(colIndex, row);
+    });
+    return std::make_pair(size_t(std::distance(rows.begin(), first)), size_t(std::distance(rows.begin(), last)));
+}
+
+void AttributeTable::updateColumnOrder(size_t colIndex, size_t rowIndex, float value)
+{
+    if (colIndex >= m_columnOrders.size() || !m_columnOrders[colIndex].valid)
+    {
+        return;
+    }
+    ColumnOrder& columnOrder = m_columnOrders[colIndex];
+    const std::vector<float>& values = m_columnData[colIndex];
+    float oldValue = values[rowIndex];
+    if (value == oldValue)
+    {
+        return;
+    }
+    m_columnOrderRevision = newColumnOrderRevision();
+    // a patch moves up to the whole order along, so past a few of them a sort is cheaper
+    if (++columnOrder.patches > 64)
+    {
+        invalidateColumnOrder(colIndex);
+        return;
+    }
+    auto byValueThenRow = [&values](size_t a, size_t b) {
+        return values[a] < values[b] || (values[a] == values[b] && a < b);
+    };
+    std::vector<size_t>& rows = columnOrder.rows;
+    auto from = std::lower_bound(rows.begin(), rows.end(), rowIndex, byValueThenRow);
+    // every other row keeps its place relative to the rest, so the new place can be searched for
+    // on either side of the old one
+    auto goesBefore = [&values, value, rowIndex](size_t row) {
+        return values[row] < value || (values[row] == value && row < rowIndex);
+    };
+    if (value > oldValue)
+    {
+        auto to = std::partition_point(from + 1, rows.end(), goesBefore);
+        std::rotate(from, from + 1, to);
+    }
+    else
+    {
+        auto to = std::partition_point(rows.begin(), from, goesBefore);
+        std::rotate(to, from, from + 1);
+    }
+}
+
+void AttributeTable::invalidateColumnOrder(size_t colIndex)
+{
+    if (colIndex < m_columnOrders.size())
+    {
+        m_columnOrders[colIndex] = ColumnOrder();
+    }
+    m_columnOrderRevision = newColumnOrderRevision();
+}
+
+void AttributeTable::invalidateColumnOrders()
+{
+    for (ColumnOrder& columnOrder: m_columnOrders)
+    {
+        columnOrder = ColumnOrder();
+    }
+    m_columnOrderRevision = newColumnOrderRevision();
+}
+
+size_t AttributeTable::newColumnOrderRevision()
+{
+    // shared by all the tables, so that no two of them are ever at the same revision (and none at 0)
+    static std::atomic<size_t> nextRevision(1);
+    return nextRevision++;
+}
+
+void AttributeTable::CompactColumn::encode(const std::vector<float> &values, AttributeColumnEncoding toEncoding)
+{
+    encoding = toEncoding;
+    dictionary.clear();
+    bytes.resize(values.size() * encodedWidth(encoding));
+    unsigned char* data = bytes.data();
+    switch (encoding)
+    {
+    case AttributeColumnEncoding::UINT8:
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            data[i] = isUnset(values[i]) ? 255 : (unsigned char)values[i];
+        }
+        break;
+    case AttributeColumnEncoding::UINT16:
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            uint16_t code = isUnset(values[i]) ? 65535 : (uint16_t)values[i];
+            std::memcpy(data + i * sizeof(code), &code, sizeof(code));
+        }
+        break;
+    case AttributeColumnEncoding::INT32:
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            int32_t code = (int32_t)values[i];
+            std::memcpy(data + i * sizeof(code), &code, sizeof(code));
+        }
+        break;
+    case AttributeColumnEncoding::FLOAT16:
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            uint16_t code = depthmapX::floatToHalf(values[i]);
+            std::memcpy(data + i * sizeof(code), &code, sizeof(code));
+        }
+        break;
+    case AttributeColumnEncoding::DICTIONARY:
+    {
+        std::unordered_map<uint32_t, unsigned char> distinct;
+        findDistinctValues(values, distinct);
+        dictionary.resize(distinct.size());
+        for (auto& entry: distinct)
+        {
+            std::memcpy(&dictionary[entry.second], &entry.first, sizeof(float));
+        }
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &values[i], sizeof(bits));
+            data[i] = distinct[bits];
+        }
+        break;
+    }
+    default:
+        throw std::invalid_argument("Not a compact column encoding");
+    }
+}
+
+void AttributeTable::CompactColumn::decode(std::vector<float> &values, size_t numRows) const
+{
+    values.resize(numRows);
+    for (size_t i = 0; i < numRows; i++)
+    {
+        values[i] = valueAt(i);
+    }
+}
+
+float AttributeTable::CompactColumn::valueAt(size_t rowIndex) const
+{
+    const unsigned char* data = bytes.data();
+    switch (encoding)
+    {
+    case AttributeColumnEncoding::UINT8:
+        return data[rowIndex] == 255 ? -1.0f : float(data[rowIndex]);
+    case AttributeColumnEncoding::UINT16:
+    {
+        uint16_t code;
+        std::memcpy(&code, data + rowIndex * sizeof(code), sizeof(code));
+        return code == 65535 ? -1.0f : float(code);
+    }
+    case AttributeColumnEncoding::INT32:
+    {
+        int32_t code;
+        std::memcpy(&code, data + rowIndex * sizeof(code), sizeof(code));
+        return float(code);
+    }
+    case AttributeColumnEncoding::FLOAT16:
+    {
+        uint16_t code;
+        std::memcpy(&code, data + rowIndex * sizeof(code), sizeof(code));
+        return depthmapX::halfToFloat(code);
+    }
+    case AttributeColumnEncoding::DICTIONARY:
+        return dictionary.at(data[rowIndex]);
+    default:
+        return -1.0f;
+    }
+}
+
+void AttributeTable::setColumnEncoding(size_t colIndex, AttributeColumnEncoding encoding)
+{
+    checkColumnIndex(colIndex);
+    unpackColumn(colIndex);
+    const std::vector<float>& values = m_columnData[colIndex];
+    if (!fitsEncoding(values, encoding))
+    {
+        throw std::invalid_argument("Column values do not fit the encoding");
+    }
+    m_columns[colIndex].setEncoding(encoding);
+    packColumn(colIndex, encoding == AttributeColumnEncoding::AUTO ? chooseEncoding(values) : encoding);
+}
+
+AttributeColumnEncoding AttributeTable::getColumnEncoding(size_t colIndex) const
+{
+    checkColumnIndex(colIndex);
+    return m_columns[colIndex].getEncoding();
+}
+
+AttributeColumnEncoding AttributeTable::getColumnStorage(size_t colIndex) const
+{
+    checkColumnIndex(colIndex);
+    return colIndex < m_compactColumns.size() ? m_compactColumns[colIndex].encoding : AttributeColumnEncoding::FLOAT32;
+}
+
+void AttributeTable::compactColumns()
+{
+    for (size_t colIndex = 0; colIndex < m_columns.size(); colIndex++)
+    {
+        if (getColumnStorage(colIndex) != AttributeColumnEncoding::FLOAT32)
+        {
+            continue;
+        }
+        const std::vector<float>& values = m_columnData[colIndex];
+        AttributeColumnEncoding encoding = m_columns[colIndex].getEncoding();
+        if (encoding == AttributeColumnEncoding::AUTO || !fitsEncoding(values, encoding))
+        {
+            encoding = chooseEncoding(values);
+        }
+        packColumn(colIndex, encoding);
+    }
+}
+
+void AttributeTable::packColumn(size_t colIndex, AttributeColumnEncoding encoding)
+{
+    // the stats have to be up to date, they can not be worked out again from a compact column
+    flushDeferredStats();
+    refreshStats(colIndex);
+    if (encoding == AttributeColumnEncoding::FLOAT32)
+    {
+        return;
+    }
+    if (m_compactColumns.size() < m_columns.size())
+    {
+        m_compactColumns.resize(m_columns.size());
+    }
+    m_compactColumns[colIndex].encode(m_columnData[colIndex], encoding);
+    std::vector<float>().swap(m_columnData[colIndex]);
+    m_numCompactColumns++;
+}
+
+void AttributeTable::unpackColumn(size_t colIndex)
+{
+    if (!isCompact(colIndex))
+    {
+        return;
+    }
+    m_compactColumns[colIndex].decode(m_columnData[colIndex], m_rows.size());
+    m_compactColumns[colIndex] = CompactColumn();
+    m_numCompactColumns--;
+}
+
+void AttributeTable::unpackColumns()
+{
+    for (size_t colIndex = 0; colIndex < m_compactColumns.size() && m_numCompactColumns != 0; colIndex++)
+    {
+        unpackColumn(colIndex);
     }
-    return colIndex;
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 #include "layermanager.h"
+#include "genlib/span.h"
 #include <string>
 #include <map>
 #include <vector>
@@ -23,6 +24,8 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <salalib/displayparams.h>
 #include <salalib/mgraph_consts.h>
 
@@ -74,6 +77,24 @@ struct AttributeColumnStats
 };
 
 
+///
+/// How the values of a column are stored. FLOAT32 is a plain float per row, the others take less memory
+/// and file space for the columns that fit them: whole numbers (UINT8 and UINT16 up to 254 and 65534),
+/// columns with few distinct values (DICTIONARY, up to 256 of them) and half precision floats (FLOAT16,
+/// which rounds the values so it is never chosen automatically). Unset values (-1) fit all of them.
+/// AUTO picks the smallest encoding that keeps every value exactly
+///
+enum class AttributeColumnEncoding : char
+{
+    AUTO = 0,
+    FLOAT32,
+    INT32,
+    UINT16,
+    UINT8,
+    FLOAT16,
+    DICTIONARY
+};
+
 ///
 /// Interface to an attribute column
 ///
@@ -150,8 +171,11 @@ public:
 
     void setName(const std::string &name);
     // returns the physical column for comaptibility with the old attribute table
-    size_t read(std::istream &stream);
-    void write(std::ostream& stream, int physicalCol);
+    size_t read(std::istream &stream, bool withEncoding = false);
+    void write(std::ostream& stream, int physicalCol, bool withEncoding = false);
+
+    AttributeColumnEncoding getEncoding() const { return m_encoding; }
+    void setEncoding(AttributeColumnEncoding encoding) { m_encoding = encoding; }
 
 private:
     std::string m_name;
@@ -159,6 +183,7 @@ private:
     bool m_hidden;
     std::string m_formula;
     DisplayParams m_displayParams;
+    AttributeColumnEncoding m_encoding = AttributeColumnEncoding::AUTO;
 };
 
 // Implementation of AttributeColumn that actually links to the keys of the table
@@ -170,11 +195,16 @@ public:
 };
 
 
+class AttributeTable;
+
 // Implementation of AttributeRow
+// A row on its own keeps its values itself. The rows of an AttributeTable keep nothing but their
+// row index and read and write the values straight in the table's column arrays
 class AttributeRowImpl : public AttributeRow
 {
+    friend class AttributeTable;
 public:
-    AttributeRowImpl(const AttributeColumnManager& colManager) : m_data(colManager.getNumColumns(), -1.0), m_colManager(colManager), m_selected(false)
+    AttributeRowImpl(const AttributeColumnManager& colManager) : m_data(colManager.getNumColumns(), -1.0), m_colManager(&colManager), m_selected(false)
     {
         m_layerKey = 1;
     }
@@ -191,6 +221,7 @@ public:
     virtual AttributeRow& setSelection(bool selected);
     virtual bool isSelected() const;
 
+    // these only apply to a row on its own, the table adds and removes its columns itself
     void addColumn();
     void removeColumn(size_t index);
 
@@ -199,9 +230,17 @@ public:
 
 private:
     std::vector<float> m_data;
-    const AttributeColumnManager& m_colManager;
+    const AttributeColumnManager* m_colManager;
+    // set for the rows of a table, null for a row on its own
+    AttributeTable* m_table = nullptr;
+    size_t m_rowIndex = 0;
     bool m_selected;
 
+    AttributeRowImpl(AttributeTable& table, size_t rowIndex);
+
+    float &value(size_t index);
+    float value(size_t index) const;
+    size_t numValues() const;
     void checkIndex(size_t index) const;
 
 };
@@ -243,8 +282,9 @@ class AttributeTable : public AttributeColumnManager
 public:
     AttributeTable(){}
     virtual ~AttributeTable(){}
-    AttributeTable(AttributeTable&&) = default;
-    AttributeTable& operator =(AttributeTable&&) = default;
+    AttributeTable(AttributeTable&& other);
+    AttributeTable& operator =(AttributeTable&& other);
+    friend class AttributeRowImpl;
     AttributeTable(const AttributeTable& ) = delete;
     AttributeTable& operator =(const AttributeTable&) = delete;
 
@@ -292,6 +332,89 @@ public:
     void read(std::istream &stream, LayerManager &layerManager);
     void write(std::ostream &stream, const LayerManager &layerManager);
     void clear();
+
+    ///
+    /// \brief Stop updating the column stats on every value written, until the matching endStatsBatch
+    /// (batches can be nested, the stats are brought up to date when the outermost one ends). Meant for
+    /// analyses filling their columns in row order, see AttributeStatsBatch
+    ///
+    void beginStatsBatch();
+    void endStatsBatch();
+
+    ///
+    /// \brief The values of a column in row order, which is key order (and so shape index order for the
+    /// table of a shape map). A compact column is unpacked to floats first, so this is meant for callers
+    /// about to change the table anyway. Only valid until rows or columns are added or removed, or the
+    /// table is compacted
+    ///
+    depthmapX::Span<const float> readColumn(size_t colIndex);
+
+    ///
+    /// \brief As readColumn, but leaving the table as it is: the values of a compact column are decoded
+    /// into the given vector and the span is over that instead
+    ///
+    depthmapX::Span<const float> readColumn(size_t colIndex, std::vector<float> &decoded) const;
+
+    ///
+    /// \brief Writable values of a column in row order. The stats of the column are worked out again from
+    /// its values the next time they are asked for, the same as if every value that is set (not negative)
+    /// had been written once, in row order, through the rows
+    ///
+    depthmapX::Span<float> writeColumn(size_t colIndex);
+
+    ///
+    /// \brief The row indices of a column in increasing order of value, rows with the same value in row
+    /// order. The table keeps the order between calls and patches it as values are set through the rows,
+    /// so it is only sorted again after the rows or the whole column have changed
+    ///
+    const std::vector<size_t>& getColumnOrder(size_t colIndex) const;
+
+    ///
+    /// \brief The positions in getColumnOrder (first, last + 1) of the rows with a value in the column
+    /// from fromValue to toValue inclusive
+    ///
+    std::pair<size_t, size_t> getColumnOrderRange(size_t colIndex, float fromValue, float toValue) const;
+
+    ///
+    /// \brief Changes whenever the order of any column might (a value, a row or a column changing), and
+    /// is never the same for two tables, so that what was taken from getColumnOrder can be checked
+    /// against the table later
+    ///
+    size_t getColumnOrderRevision() const { return m_columnOrderRevision; }
+
+    ///
+    /// \brief The index of a row in row order (the order of readColumn), -1 if the key is not found
+    ///
+    size_t getRowIndex(const AttributeKey& key) const;
+
+    ///
+    /// \brief The key and the row at a row index
+    ///
+    const AttributeKey& getRowKey(size_t rowIndex) const { return m_rows[rowIndex].first; }
+    AttributeRow& getRowAt(size_t rowIndex) { return *m_rows[rowIndex].second; }
+    const AttributeRow& getRowAt(size_t rowIndex) const { return *m_rows[rowIndex].second; }
+
+    ///
+    /// \brief Set how a column is to be stored and compact it in that encoding straight away. Throws
+    /// std::invalid_argument if the values do not fit the encoding. The setting is kept in the file,
+    /// columns left on AUTO get the smallest encoding that fits them whenever the table is written
+    ///
+    void setColumnEncoding(size_t colIndex, AttributeColumnEncoding encoding);
+    AttributeColumnEncoding getColumnEncoding(size_t colIndex) const;
+
+    ///
+    /// \brief How a column is held in memory at the moment, FLOAT32 unless it is compact
+    ///
+    AttributeColumnEncoding getColumnStorage(size_t colIndex) const;
+
+    ///
+    /// \brief Compact every column in its encoding. Tables read from a file start out compact. The values
+    /// of a compact column are read straight from its encoding, it is only unpacked to floats when
+    /// something is written to it (or it is read through the non-const readColumn). Reading a table,
+    /// compact or not, does not change it, so any number of threads can read it at the same time
+    ///
+    void compactColumns();
+
     float getSelAvg(size_t columnIndex) {
         float selTotal = 0;
         int selNum = 0;
@@ -320,8 +443,11 @@ public:
     size_t getColumnSortedIndex(size_t index) const;
 
 private:
-    typedef std::map<AttributeKey, std::unique_ptr<AttributeRowImpl>> StorageType;
+    // the rows sorted by key, where the position of a row is also its index into the column arrays
+    typedef std::vector<std::pair<AttributeKey, std::unique_ptr<AttributeRowImpl>>> StorageType;
     StorageType m_rows;
+    // the values, one contiguous array per column (empty while the column is compact)
+    std::vector<std::vector<float> > m_columnData;
     std::map<std::string, size_t> m_columnMapping;
     std::vector<AttributeColumnImpl> m_columns;
     KeyColumn m_keyColumn;
@@ -330,10 +456,99 @@ private:
 private:
     void checkColumnIndex(size_t index) const;
     size_t addColumnInternal(const std::string &name, const std::string &formula);
+    StorageType::iterator findRow(const AttributeKey& key);
+    StorageType::const_iterator findRow(const AttributeKey& key) const;
+    size_t findRowIndex(const AttributeKey& key) const;
+    // point the rows from the given one onwards at their position (and at this table)
+    void reindexRows(size_t from);
+
+    // The row index of every key from the first key up, -1 for keys with no row, so that finding a row
+    // does not have to search. It is only kept while the keys are dense enough (no more slots than
+    // twice the rows plus MAX_KEY_ROWS_SLACK), which the shape maps' keys are. Tables with sparse keys,
+    // such as the point maps' pixel refs, leave it empty and search m_rows instead
+    std::vector<int> m_keyRows;
+    int m_keyRowsBase = 0;
+    static const size_t MAX_KEY_ROWS_SLACK = 1024;
+    bool keyRowsFit(size_t slots, size_t rows) const { return slots <= 2 * rows + MAX_KEY_ROWS_SLACK; }
+    void rebuildKeyRows();
+
+    // While a stats batch is open, values written in increasing row order over unset cells (the way
+    // the analyses fill their columns) are only marked. At the end the stats are updated from the
+    // marked cells in row order, which gives exactly what updating them on every write would have.
+    // Any other write to a column brings its stats up to date and goes back to updating them directly
+    struct DeferredColumnStats
+    {
+        bool deferring = true;
+        size_t lastRow = 0;
+        std::vector<char> written;
+    };
+    int m_statsBatchDepth = 0;
+    std::vector<DeferredColumnStats> m_deferredStats;
+    // columns handed out by writeColumn, their stats are out of date until refreshStats
+    mutable std::vector<char> m_staleStats;
+    // set while any column might be stale, so reading the stats only has to lock when one is
+    mutable std::atomic<bool> m_anyStaleStats{false};
+    // guards the stale stats and the column orders, the state the const reads build as they need it
+    mutable std::mutex m_lazyStateMutex;
+
+    void refreshStats(size_t colIndex) const;
+
+    // The value order of a column, built on first use. Setting a value moves its row to its new place,
+    // but a column being filled (more patches than it is asked for) is simply dropped and sorted again
+    // the next time it is needed. There is one for every column at all times, so that the orders are
+    // never moved while a reader might be holding on to one
+    struct ColumnOrder
+    {
+        bool valid = false;
+        size_t patches = 0;
+        std::vector<size_t> rows;
+    };
+    mutable std::vector<ColumnOrder> m_columnOrders;
+    size_t m_columnOrderRevision = newColumnOrderRevision();
+
+    static size_t newColumnOrderRevision();
+
+    void updateColumnOrder(size_t colIndex, size_t rowIndex, float value);
+    void invalidateColumnOrder(size_t colIndex);
+    void invalidateColumnOrders();
+
+    // The values of a column in one of the smaller encodings, codes into the dictionary for DICTIONARY
+    struct CompactColumn
+    {
+        AttributeColumnEncoding encoding = AttributeColumnEncoding::FLOAT32;
+        std::vector<unsigned char> bytes;
+        std::vector<float> dictionary;
+
+        void encode(const std::vector<float> &values, AttributeColumnEncoding toEncoding);
+        void decode(std::vector<float> &values, size_t numRows) const;
+        float valueAt(size_t rowIndex) const;
+    };
+    std::vector<CompactColumn> m_compactColumns;
+    // the number of compact columns, so the rows only look any further when there are some
+    size_t m_numCompactColumns = 0;
+
+    bool isCompact(size_t colIndex) const
+    {
+        return m_numCompactColumns != 0 && colIndex < m_compactColumns.size() &&
+               m_compactColumns[colIndex].encoding != AttributeColumnEncoding::FLOAT32;
+    }
+    float readValue(size_t colIndex, size_t rowIndex) const
+    {
+        return isCompact(colIndex) ? m_compactColumns[colIndex].valueAt(rowIndex) : m_columnData[colIndex][rowIndex];
+    }
+    void packColumn(size_t colIndex, AttributeColumnEncoding encoding);
+    void unpackColumn(size_t colIndex);
+    void unpackColumns();
+    void readColumnar(std::istream &stream, int colcount);
+
+    void updateStats(size_t colIndex, size_t rowIndex, float value, float oldVal);
+    void flushDeferredStats(size_t colIndex);
+    // brings all the stats up to date, for when the rows or columns are about to change
+    void flushDeferredStats();
 
 // warning - here be dragons!
 // This is the implementation of stl style iterators on attribute table, allowing efficient
-// iteration of rows without resorting to log(n) access via the map
+// iteration of rows without resorting to log(n) access by key
 
 
 public:
@@ -475,12 +690,43 @@ public:
 
     iterator find(AttributeKey key)
     {
-        return iterator(m_rows.find(key));
+        return iterator(findRow(key));
     }
 
-    std::pair<const AttributeKey, std::unique_ptr<AttributeRowImpl>>& back()
+    StorageType::value_type& back()
     {
-        return *m_rows.rbegin();
+        return m_rows.back();
     }
 };
 
+///
+/// Keeps a stats batch open on a table until end() is called or it goes out of scope
+///
+class AttributeStatsBatch
+{
+public:
+    AttributeStatsBatch(AttributeTable& table) : m_table(table), m_open(true)
+    {
+        m_table.beginStatsBatch();
+    }
+    ~AttributeStatsBatch()
+    {
+        end();
+    }
+    AttributeStatsBatch(const AttributeStatsBatch&) = delete;
+    AttributeStatsBatch& operator =(const AttributeStatsBatch&) = delete;
+
+    // call before anything that needs the stats (such as setting the displayed attribute)
+    void end()
+    {
+        if (m_open)
+        {
+            m_open = false;
+            m_table.endStatsBatch();
+        }
+    }
+
+private:
+    AttributeTable& m_table;
+    bool m_open;
+};
@@ -16,95 +16,77 @@
 
 #include "salalib/attributetableindex.h"
 
-std::vector<ConstAttributeIndexItem> makeAttributeIndex(const AttributeTable &table, int colIndex)
+#include <cmath>
+
+namespace
 {
-    std::vector<ConstAttributeIndexItem> index;
-    size_t numRows = table.getNumRows();
-    if (numRows == 0)
-    {
-        return index;
-    }
-    index.reserve(numRows);
-    // perturb the values to be sorted by so same values will be in order of appearence in the map
-    size_t idx = 0;
-    if ( colIndex == -1 )
+    // one pass over the rows, in key order for the key column and otherwise in the value order the
+    // table keeps for the column
+    template <typename Item, typename Table>
+    std::vector<Item> makeIndex(Table &table, int colIndex)
     {
-        double perturbationFactor = 1e-9 / numRows;
-        for (auto& item: table)
+        std::vector<Item> index;
+        size_t numRows = table.getNumRows();
+        if (numRows == 0)
         {
-            double value = (double)item.getKey().value;
-            value += idx * perturbationFactor;
-
-            index.push_back(ConstAttributeIndexItem(item.getKey(), value, item.getRow()));
-            ++idx;
+            return index;
         }
-    }
-    else if (colIndex >= 0 )
-    {
-        double perturbationFactor = table.getColumn(colIndex).getStats().max * 1e-9 / numRows;
-        for (auto & item : table)
+        if (colIndex < -1)
         {
-            double value = item.getRow().getValue(colIndex);
-            value += idx * perturbationFactor;
-
-            index.push_back(ConstAttributeIndexItem(item.getKey(), value, item.getRow()));
-            ++idx;
+            throw std::out_of_range("Column index out of range");
         }
-    }
-    else
-    {
-        throw std::out_of_range("Column index out of range");
-    }
-    std::sort(index.begin(), index.end());
-    return index;
-}
-
-std::vector<AttributeIndexItem> makeAttributeIndex(AttributeTable &table, int colIndex)
-{
-    std::vector<AttributeIndexItem> index;
-    size_t numRows = table.getNumRows();
-    if (numRows == 0)
-    {
-        return index;
-    }
-    index.reserve(numRows);
-    // perturb the values to be sorted by so same values will be in order of appearence in the map
-    size_t idx = 0;
-    if ( colIndex == -1 )
-    {
-        double perturbationFactor = 1e-9 / numRows;
-        for (auto& item: table)
+        index.reserve(numRows);
+        // perturb the values to be sorted by so same values will be in order of appearence in the map
+        if ( colIndex == -1 )
         {
-            double value = (double)item.getKey().value;
-            value += idx * perturbationFactor;
+            // the rows are kept in key order already
+            double perturbationFactor = 1e-9 / numRows;
+            size_t idx = 0;
+            for (auto& item: table)
+            {
+                double value = (double)item.getKey().value;
+                value += idx * perturbationFactor;
 
-            index.push_back(AttributeIndexItem(item.getKey(), value, item.getRow()));
-            ++idx;
+                index.push_back(Item(item.getKey(), value, item.getRow()));
+                ++idx;
+            }
         }
-    }
-    else if (colIndex >= 0 )
-    {
-        double perturbationFactor = table.getColumn(colIndex).getStats().max * 1e-9 / numRows;
-        for (auto & item : table)
+        else
         {
-            double value = item.getRow().getValue(colIndex);
-            value += idx * perturbationFactor;
+            double perturbationFactor = std::abs(table.getColumn(colIndex).getStats().max) * 1e-9 / numRows;
+            for (size_t row : table.getColumnOrder(colIndex))
+            {
+                auto &rowValues = table.getRowAt(row);
+                double value = rowValues.getValue(colIndex);
+                value += row * perturbationFactor;
 
-            index.push_back(AttributeIndexItem(item.getKey(), value, item.getRow()));
-            ++idx;
+                index.push_back(Item(table.getRowKey(row), value, rowValues));
+            }
         }
+        return index;
     }
-    else
-    {
-        throw std::out_of_range("Column index out of range");
-    }
-    std::sort(index.begin(), index.end());
-    return index;
+}
+
+std::vector<ConstAttributeIndexItem> makeAttributeIndex(const AttributeTable &table, int colIndex)
+{
+    return makeIndex<ConstAttributeIndexItem>(table, colIndex);
+}
+
+std::vector<AttributeIndexItem> makeAttributeIndex(AttributeTable &table, int colIndex)
+{
+    return makeIndex<AttributeIndexItem>(table, colIndex);
 }
 
 std::pair<std::vector<AttributeIndexItem>::iterator, std::vector<AttributeIndexItem>::iterator>
-getIndexItemsInValueRange(std::vector<AttributeIndexItem> &index, AttributeTable &table, float fromValue,
-                          float toValue) {
+getIndexItemsInValueRange(std::vector<AttributeIndexItem> &index, AttributeTable &table, int colIndex,
+                          size_t indexRevision, float fromValue, float toValue) {
+    if (colIndex >= 0 && indexRevision == table.getColumnOrderRevision() && index.size() == table.getNumRows())
+    {
+        // the index is laid out in the order the table keeps for the column, so the positions of the
+        // range in that order are its positions in the index
+        auto range = table.getColumnOrderRange(size_t(colIndex), fromValue, toValue);
+        return std::make_pair(index.begin() + std::ptrdiff_t(range.first), index.begin() + std::ptrdiff_t(range.second));
+    }
     AttributeKey dummykey(-1);
     AttributeRowImpl dummyrow(table);
     return std::pair<std::vector<AttributeIndexItem>::iterator, std::vector<AttributeIndexItem>::iterator>(
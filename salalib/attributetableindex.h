@@ -70,6 +70,10 @@ inline bool operator < (const ConstAttributeIndexItem &lhs, const ConstAttribute
 
 std::vector<ConstAttributeIndexItem> makeAttributeIndex(const AttributeTable &table, int colIndex);
 std::vector<AttributeIndexItem> makeAttributeIndex(AttributeTable &table, int colIndex);
+// the items of an index made by makeAttributeIndex(table, colIndex) with a value from fromValue to toValue.
+// indexRevision is the getColumnOrderRevision of the table when the index was made: while the table is
+// still at it, the range is found from the order the table keeps for the column, and otherwise (or for the
+// key column) by searching the values in the index, as they were when it was made
 std::pair<std::vector<AttributeIndexItem>::iterator, std::vector<AttributeIndexItem>::iterator>
-getIndexItemsInValueRange(std::vector<AttributeIndexItem> &index, AttributeTable &table, float fromValue,
-                          float toValue);
+getIndexItemsInValueRange(std::vector<AttributeIndexItem> &index, AttributeTable &table, int colIndex,
+                          size_t indexRevision, float fromValue, float toValue);
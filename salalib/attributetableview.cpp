@@ -15,6 +15,8 @@
 
 #include "attributetableview.h"
 
+#include <numeric>
+
 AttributeTableView::AttributeTableView(const AttributeTable &table) : m_table(table), m_displayColumn(-1)
 {}
 
@@ -51,6 +53,7 @@ const DisplayParams &AttributeTableView::getDisplayParams() const
 }
 
 void AttributeTableHandle::setDisplayColIndex(int columnIndex){
+    m_indexPositions.clear();
     if (columnIndex < -1)
     {
         m_mutableIndex.clear();
@@ -59,11 +62,32 @@ void AttributeTableHandle::setDisplayColIndex(int columnIndex){
     {
         // recalculate the index even if it's the same column in case stuff has changed
         m_mutableIndex = makeAttributeIndex(m_mutableTable, columnIndex);
+        m_indexPositions.resize(m_mutableIndex.size());
+        if (columnIndex == -1)
+        {
+            std::iota(m_indexPositions.begin(), m_indexPositions.end(), 0);
+        }
+        else
+        {
+            const std::vector<size_t>& order = m_mutableTable.getColumnOrder(columnIndex);
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                m_indexPositions[order[i]] = int(i);
+            }
+        }
     }
     AttributeTableView::setDisplayColIndex(columnIndex);
 }
 int AttributeTableHandle::findInIndex(const AttributeKey &key) {
 
+    // rows added or removed since the index was made can throw the positions out, so check them
+    size_t rowIndex = m_mutableTable.getRowIndex(key);
+    if (rowIndex < m_indexPositions.size()) {
+        int position = m_indexPositions[rowIndex];
+        if (m_mutableIndex[position].key.value == key.value) {
+            return position;
+        }
+    }
     auto iter = std::find_if(m_mutableIndex.begin(), m_mutableIndex.end(), index_item_key(key));
     if (iter != m_mutableIndex.end()) {
         return(std::distance(m_mutableIndex.begin(), iter));
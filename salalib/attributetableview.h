@@ -56,6 +56,8 @@ public:
 private:
     AttributeTable& m_mutableTable;
     Index m_mutableIndex;
+    // the position in the index of each row of the table, by row index
+    std::vector<int> m_indexPositions;
 
 };
 
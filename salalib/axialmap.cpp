@@ -58,7 +58,8 @@ void ShapeGraph::initialiseAttributesAxial()
 
 }
 
-void ShapeGraph::makeConnections(const KeyVertices &keyvertices)
+void ShapeGraph::makeConnections(const KeyVertices &keyvertices,
+                                 std::vector<std::vector<std::pair<double,int>>> *linebreaks)
 {
    m_connectors.clear();
    m_links.clear();
@@ -69,15 +70,18 @@ void ShapeGraph::makeConnections(const KeyVertices &keyvertices)
    int conn_col = m_attributes->getColumnIndex("Connectivity");
    int leng_col = m_attributes->getColumnIndex("Line Length");
 
+   std::vector<std::vector<int>> connections =
+         getAllLineConnections(TOLERANCE_B*__max(m_region.height(),m_region.width()), linebreaks);
+
    int i = -1;
-   for (auto shape: m_shapes) {
+   for (const auto &shape: m_shapes) {
       i++;
       int key = shape.first;
       AttributeRow &row =
           m_attributes->getRow(AttributeKey(key));
       // all indices should match...
       m_connectors.push_back( Connector() );
-      m_connectors[i].m_connections = getLineConnections( key, TOLERANCE_B*__max(m_region.height(),m_region.width()));
+      m_connectors[i].m_connections = std::move(connections[size_t(i)]);
       row.setValue(conn_col, float(m_connectors[i].m_connections.size()) );
       row.setValue(leng_col, float(shape.second.getLine().length()) );
       if (keyvertices.size()) {
@@ -308,13 +312,13 @@ void ShapeGraph::writeLinksUnlinksAsPairsCSV(std::ostream &stream, char delimite
     stream << "refA" << delimiter << "refB" << delimiter << "link" << std::endl;
 
     for (auto &link : m_links) {
-        stream << depthmapX::getMapAtIndex(m_shapes, link.a)->first << delimiter
-               << depthmapX::getMapAtIndex(m_shapes, link.b)->first << delimiter << "1" << std::endl;
+        stream << getShapeRefFromIndex(link.a)->first << delimiter
+               << getShapeRefFromIndex(link.b)->first << delimiter << "1" << std::endl;
     }
 
     for (auto &unlink : m_unlinks) {
-        stream << depthmapX::getMapAtIndex(m_shapes, unlink.a)->first << delimiter
-               << depthmapX::getMapAtIndex(m_shapes, unlink.b)->first << delimiter << "0" << std::endl;
+        stream << getShapeRefFromIndex(unlink.a)->first << delimiter
+               << getShapeRefFromIndex(unlink.b)->first << delimiter << "0" << std::endl;
     }
 }
 
@@ -374,8 +378,8 @@ void ShapeGraph::unlinkAtPoint(const Point2f& unlinkPoint) {
        for (auto jter = iter; jter != pix_shapes.end(); ++jter) {
           auto aIter = m_shapes.find(int(iter->m_shape_ref));
           auto bIter = m_shapes.find(int(jter->m_shape_ref));
-          int a = int(std::distance(m_shapes.begin(), aIter));
-          int b = int(std::distance(m_shapes.begin(), bIter));
+          int a = getShapeIndexFromKey(int(iter->m_shape_ref));
+          int b = getShapeIndexFromKey(int(jter->m_shape_ref));
           auto& connections = m_connectors[size_t(a)].m_connections;
           if (aIter != m_shapes.end() && bIter != m_shapes.end()
                   && aIter->second.isLine() && bIter->second.isLine()
@@ -563,24 +567,20 @@ void ShapeGraph::makeNewSegMap(Communicator *comm) {
 // identify the original axial line this line segment is
 // associated with
 
-void ShapeGraph::makeSegmentMap(std::vector<Line>& lines, std::vector<Connector>& connectors, double stubremoval)
+std::vector<std::vector<std::pair<double,int>>> ShapeGraph::getLineBreaks() const
 {
-   // the first (key) pair is the line / line intersection, second is the pair of associated segments for the first line
-   std::map<OrderedIntPair, std::pair<int, int>> segmentlist;
-
-   // this code relies on the polygon order being the same as the connections
+   std::vector<std::vector<std::pair<double,int>>> linebreaks(m_connectors.size());
 
    auto iter = m_shapes.begin();
    for (size_t i = 0; i < m_connectors.size(); i++) {
-      auto shape = iter->second;
-      int axialRef = iter->first;
+      const auto &shape = iter->second;
       iter++;
       if (!shape.isLine()) {
          continue;
       }
       const Line& line = shape.getLine();
-      std::vector<std::pair<double,int> > breaks; // this is a vector instead of a map because the
-                                                  // original code allowed for duplicate keys
+      std::vector<std::pair<double,int> > &breaks = linebreaks[i]; // this is a vector instead of a map because the
+                                                                    // original code allowed for duplicate keys
       int axis = line.width() >= line.height() ? XAXIS : YAXIS;
       // we need the breaks ordered from start to end of the line
       // this is automatic for XAXIS, but on YAXIS, need to know
@@ -591,13 +591,43 @@ void ShapeGraph::makeSegmentMap(std::vector<Line>& lines, std::vector<Connector>
       for (size_t j = 0; j < connections.size(); j++) {
          // find the intersection point and add...
          // note: more than one break at the same place allowed
-         auto shapeJ = depthmapX::getMapAtIndex(m_shapes, connections[j])->second;
+         const auto &shapeJ = getShapeRefFromIndex(connections[j])->second;
          if (static_cast<int>(i) != connections[j] && shapeJ.isLine()) {
             breaks.push_back(std::make_pair(parity * line.intersection_point( shapeJ.getLine(), axis, TOLERANCE_A ),
                                          connections[j]));
          }
       }
       std::sort(breaks.begin(), breaks.end());
+   }
+   return linebreaks;
+}
+
+void ShapeGraph::makeSegmentMap(std::vector<Line>& lines, std::vector<Connector>& connectors, double stubremoval,
+                                const std::vector<std::vector<std::pair<double,int>>> *sweepbreaks)
+{
+   // the first (key) pair is the line / line intersection, second is the pair of associated segments for the first line
+   std::map<OrderedIntPair, std::pair<int, int>> segmentlist;
+
+   // this code relies on the polygon order being the same as the connections
+
+   std::vector<std::vector<std::pair<double,int>>> computedbreaks;
+   if (!sweepbreaks) {
+      computedbreaks = getLineBreaks();
+   }
+   const std::vector<std::vector<std::pair<double,int>>> &linebreaks = sweepbreaks ? *sweepbreaks : computedbreaks;
+
+   auto iter = m_shapes.begin();
+   for (size_t i = 0; i < m_connectors.size(); i++) {
+      const auto &shape = iter->second;
+      int axialRef = iter->first;
+      iter++;
+      if (!shape.isLine()) {
+         continue;
+      }
+      const Line& line = shape.getLine();
+      const std::vector<std::pair<double,int> > &breaks = linebreaks[i];
+      int axis = line.width() >= line.height() ? XAXIS : YAXIS;
+      int parity = (axis == XAXIS) ? 1 : line.sign();
       // okay, now we have a list from one end of the other of lines this line connects with
       Point2f lastpoint = line.start();
       int seg_a = -1, seg_b = -1;
@@ -64,11 +64,21 @@ public:
    ShapeGraph(const std::string& name = "<axial map>", int type = ShapeMap::AXIALMAP);
    virtual ~ShapeGraph() {;}
    void initialiseAttributesAxial();
-   void makeConnections(const KeyVertices &keyvertices = KeyVertices());
+   // if linebreaks is given it is filled with the breaks of the new connections (see getLineBreaks),
+   // ready to be passed on to makeSegmentMap
+   void makeConnections(const KeyVertices &keyvertices = KeyVertices(),
+                        std::vector<std::vector<std::pair<double, int>>> *linebreaks = nullptr);
    bool stepdepth(Communicator *comm = NULL);
    // lineset and connectionset are filled in by segment map
    void makeNewSegMap(Communicator *comm);
-   void makeSegmentMap(std::vector<Line> &lines, std::vector<Connector> &connectors, double stubremoval);
+   // sweepbreaks are the breaks filled in by makeConnections, only to be passed while the connections
+   // are still the ones it made. Without them the breaks are worked out from the current connections
+   void makeSegmentMap(std::vector<Line> &lines, std::vector<Connector> &connectors, double stubremoval,
+                       const std::vector<std::vector<std::pair<double, int>>> *sweepbreaks = nullptr);
+   // where each line is crossed by the lines it is connected to, indexed by rowid. Each break is the
+   // position along the major axis of the line (times its parity) and the rowid of the crossing line
+   // and the breaks are sorted from the start of the line to its end
+   std::vector<std::vector<std::pair<double, int>>> getLineBreaks() const;
    void initialiseAttributesSegment();
    void makeSegmentConnections(std::vector<Connector> &connectionset);
    void pushAxialValues(ShapeGraph& axialmap);
@@ -31,8 +31,8 @@ AxialMinimiser::~AxialMinimiser()
 
 // Alan and Bill's algo...
 
-void AxialMinimiser::removeSubsets(std::map<int, std::set<int> >& axsegcuts, std::map<RadialKey,RadialSegment>& radialsegs,
-                                   std::map<RadialKey, std::set<int> > &rlds,  std::vector<RadialLine> &radial_lines,
+void AxialMinimiser::removeSubsets(std::vector<std::vector<int> >& axsegcuts, std::vector<RadialSegment>& radialsegs,
+                                   std::vector<std::vector<int> > &rlds,  std::vector<RadialLine> &radial_lines,
                                    std::vector<std::vector<int> >& keyvertexconns, std::vector<int>& keyvertexcounts)
 {
    bool removedflag = true;
@@ -43,9 +43,9 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int> >& axsegcuts, std
       m_radialsegcounts[x] = 0;
    }
    int y = -1;
-   for (auto axSegCut: axsegcuts) {
+   for (const auto& axSegCut: axsegcuts) {
       y++;
-      for (int cut: axSegCut.second) {
+      for (int cut: axSegCut) {
          m_radialsegcounts[cut] += 1;
       }
       m_removed[y] = false;
@@ -54,7 +54,7 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int> >& axsegcuts, std
       m_vps[y].index = y;
       double length = m_axialconns[y].m_connections.size();
       m_vps[y].value1 = (int) length;
-      length = depthmapX::getMapAtIndex(m_alllinemap->m_shapes, y)->second.getLine().length();
+      length = m_alllinemap->getShapeRefFromIndex(y)->second.getLine().length();
       m_vps[y].value2 = (float) length;
    }
 
@@ -130,7 +130,7 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int> >& axsegcuts, std
             size_t removeindex = ii;
             // now check removing it won't break any topological loops
             bool presumedvital = false;
-            auto& axSegCut = depthmapX::getMapAtIndex(axsegcuts, removeindex)->second;
+            auto& axSegCut = axsegcuts[removeindex];
             for (int cut: axSegCut) {
                if (m_radialsegcounts[cut] <= 1) {
                   presumedvital = true;
@@ -172,8 +172,8 @@ void AxialMinimiser::removeSubsets(std::map<int, std::set<int> >& axsegcuts, std
 
 // My algo... v. simple... fewest longest
 
-void AxialMinimiser::fewestLongest(std::map<int, std::set<int> > &axsegcuts, std::map<RadialKey,RadialSegment>& radialsegs,
-                                   std::map<RadialKey, std::set<int> > &rlds, std::vector<RadialLine> &radial_lines,
+void AxialMinimiser::fewestLongest(std::vector<std::vector<int> > &axsegcuts, std::vector<RadialSegment>& radialsegs,
+                                   std::vector<std::vector<int> > &rlds, std::vector<RadialLine> &radial_lines,
                                    std::vector<std::vector<int> > &keyvertexconns, std::vector<int>& keyvertexcounts)
 {
    //m_axialconns = m_alllinemap->m_connectors;
@@ -183,7 +183,7 @@ void AxialMinimiser::fewestLongest(std::map<int, std::set<int> > &axsegcuts, std
       if (!m_removed[y] && !m_vital[y]) {
          m_vps[livecount].index = (int) y;
          m_vps[livecount].value1 = (int) m_axialconns[y].m_connections.size();
-         m_vps[livecount].value2 = (float) depthmapX::getMapAtIndex(m_alllinemap->m_shapes, y)->second.getLine().length();
+         m_vps[livecount].value2 = (float) m_alllinemap->getShapeRefFromIndex(y)->second.getLine().length();
          livecount++;
       }
    }
@@ -209,7 +209,7 @@ void AxialMinimiser::fewestLongest(std::map<int, std::set<int> > &axsegcuts, std
       }
       //
       bool presumedvital = false;
-      auto &axSegCut = depthmapX::getMapAtIndex(axsegcuts, j)->second;
+      auto &axSegCut = axsegcuts[size_t(j)];
       for (int cut: axSegCut) {
          if (m_radialsegcounts[cut] <= 1) {
             presumedvital = true;
@@ -255,8 +255,8 @@ void AxialMinimiser::fewestLongest(std::map<int, std::set<int> > &axsegcuts, std
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 
-bool AxialMinimiser::checkVital(int checkindex, std::set<int> &axSegCut, std::map<RadialKey,RadialSegment>& radialsegs,
-                                std::map<RadialKey, std::set<int> > &rlds, std::vector<RadialLine>& radial_lines)
+bool AxialMinimiser::checkVital(int checkindex, const std::vector<int> &axSegCut, std::vector<RadialSegment>& radialsegs,
+                                std::vector<std::vector<int> > &rlds, std::vector<RadialLine>& radial_lines)
 {
    std::map<int,SalaShape>& axiallines = m_alllinemap->m_shapes;
 
@@ -267,22 +267,11 @@ bool AxialMinimiser::checkVital(int checkindex, std::set<int> &axSegCut, std::ma
       if (m_radialsegcounts[cut] <= 1) {
          bool nonvitalseg = false;
          vitalsegs++;
-         auto radialSegIter = depthmapX::getMapAtIndex(radialsegs, cut);
-         const RadialKey& key = radialSegIter->first;
-         RadialSegment& seg = radialSegIter->second;
-         std::set<int>& divisorsa = rlds.find(key)->second;
-         std::set<int>& divisorsb = rlds.find(seg.radial_b)->second;
-         auto iterKey = std::find(radial_lines.begin(), radial_lines.end(), key);
-         if(iterKey == radial_lines.end()) {
-             throw depthmapX::RuntimeException("Radial key not found in radial lines");
-         }
-         const RadialLine& rlinea = *iterKey;
-
-         auto iterSegB = std::find(radial_lines.begin(), radial_lines.end(), seg.radial_b);
-         if(iterSegB == radial_lines.end()) {
-             throw depthmapX::RuntimeException("Radial key not found in radial lines");
-         }
-         const RadialLine& rlineb = *iterSegB;
+         const RadialSegment& seg = radialsegs[size_t(cut)];
+         std::vector<int>& divisorsa = rlds[size_t(seg.radial_a)];
+         std::vector<int>& divisorsb = rlds[size_t(seg.radial_b)];
+         const RadialLine& rlinea = radial_lines[size_t(seg.radial_a)];
+         const RadialLine& rlineb = radial_lines[size_t(seg.radial_b)];
          for (int diva: divisorsa) {
             if (diva == checkindex || m_removed[diva]) {
                continue;
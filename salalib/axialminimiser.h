@@ -24,15 +24,16 @@ protected:
 public:
    AxialMinimiser(const AllLineMap& alllinemap, int no_of_axsegcuts, int no_of_radialsegs);
    ~AxialMinimiser();
-   void removeSubsets(std::map<int, std::set<int> > &axsegcuts, std::map<RadialKey,RadialSegment>& radialsegs,
-                      std::map<RadialKey, std::set<int> >& rlds, std::vector<RadialLine> &radial_lines,
+   // axsegcuts are the radial segments cut by each axial line and rlds the axial lines dividing each radial line
+   void removeSubsets(std::vector<std::vector<int> > &axsegcuts, std::vector<RadialSegment>& radialsegs,
+                      std::vector<std::vector<int> >& rlds, std::vector<RadialLine> &radial_lines,
                       std::vector<std::vector<int> > &keyvertexconns, std::vector<int>& keyvertexcounts);
-   void fewestLongest(std::map<int,std::set<int> >& axsegcuts, std::map<RadialKey,RadialSegment>& radialsegs,
-                      std::map<RadialKey, std::set<int> > &rlds, std::vector<RadialLine>& radial_lines,
+   void fewestLongest(std::vector<std::vector<int> >& axsegcuts, std::vector<RadialSegment>& radialsegs,
+                      std::vector<std::vector<int> > &rlds, std::vector<RadialLine>& radial_lines,
                       std::vector<std::vector<int> >& keyvertexconns, std::vector<int>& keyvertexcounts);
    // advanced topological testing:
-   bool checkVital(int checkindex, std::set<int> &axSegCut, std::map<RadialKey,RadialSegment>& radialsegs,
-                   std::map<RadialKey, std::set<int> > &rlds, std::vector<RadialLine> &radial_lines);
+   bool checkVital(int checkindex, const std::vector<int> &axSegCut, std::vector<RadialSegment>& radialsegs,
+                   std::vector<std::vector<int> > &rlds, std::vector<RadialLine> &radial_lines);
    //
    bool removed(int i) const
    { return m_removed[i]; }
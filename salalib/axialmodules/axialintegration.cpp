@@ -18,16 +18,18 @@
 
 #include "salalib/axialmodules/axialintegration.h"
 
+#include "genlib/parallel.h"
 #include "genlib/pflipper.h"
 #include "genlib/stringutils.h"
+#include "genlib/trace.h"
+
+#include <numeric>
 
 bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_version) {
     // note, from 10.0, Depthmap no longer includes *self* connections on axial lines
     // self connections are stripped out on loading graph files, as well as no longer made
 
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getShapeCount());
     }
 
@@ -53,9 +55,9 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
     std::string weighting_col_text;
     if (m_weighted_measure_col != -1) {
         weighting_col_text = attributes.getColumnName(m_weighted_measure_col);
-        for (size_t i = 0; i < map.getShapeCount(); i++) {
-            weights.push_back(map.getAttributeRowFromShapeIndex(i).getValue(m_weighted_measure_col));
-        }
+        // the rows are in shape index order
+        auto weightColumn = attributes.readColumn(m_weighted_measure_col);
+        weights.assign(weightColumn.begin(), weightColumn.begin() + map.getShapeCount());
     }
 
     // first enter the required attribute columns:
@@ -217,61 +219,140 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
         }
     }
 
-    // for choice
-    AnalysisInfo **audittrail;
-    if (m_choice) {
-        audittrail = new AnalysisInfo *[map.getShapeCount()];
-        for (size_t i = 0; i < map.getShapeCount(); i++) {
-            audittrail[i] = new AnalysisInfo[radii.size()];
-        }
-    }
-
     // n.b., for this operation we assume continuous line referencing from zero (this is silly?)
     // has already failed due to this!  when intro hand drawn fewest line (where user may have deleted)
     // it's going to get worse...
 
-    bool *covered = new bool[map.getShapeCount()];
+    depthmapX::TracePhase phase("Axial integration analysis");
 
-    size_t i = -1;
-    for (auto & iter : attributes) {
-        i++;
-        AttributeRow &row = iter.getRow();
-        for (size_t j = 0; j < map.getShapeCount(); j++) {
-            covered[j] = false;
-        }
-        if (m_choice) {
-            for (size_t k = 0; k < map.getShapeCount(); k++) {
-                audittrail[k][0].previous.ref = -1; // note, 0th member used as radius doesn't matter
-                // note, choice columns are not cleared, but cummulative over all shortest path pairs
+    const std::vector<Connector> &connectors = map.getConnections();
+    size_t shapeCount = map.getShapeCount();
+
+    // each line is analysed on its own, so the lines are spread over threads. Each thread keeps its own
+    // scratch space and choice totals (added up at the end). Setting a value also updates the stats of
+    // the column though, so the values for each line are kept and only set once all lines are done
+    std::vector<AttributeRow *> rows;
+    rows.reserve(shapeCount);
+    for (auto &iter : attributes) {
+        rows.push_back(&iter.getRow());
+    }
+    std::vector<std::vector<std::pair<int, float>>> rowValues(shapeCount);
+
+    size_t threadCount = std::max(size_t(1), std::min(depthmapX::getThreadCount(), shapeCount));
+
+    // lines are marked with the root they were covered from, so there is no need to clear between roots
+    std::vector<std::vector<size_t>> threadCovered(threadCount, std::vector<size_t>(shapeCount, size_t(-1)));
+
+    // for choice, the next line to explore is picked at random. To keep the same numbers as when the
+    // lines are analysed one after the other, each line continues the random sequence from where the
+    // previous line would have left it. That is one number for each line explored, which only depends
+    // on the radii, so it can be counted beforehand with a plain search
+    std::vector<uint64_t> randstates;
+    if (m_choice) {
+        depthmapX::TracePhase drawsPhase("Count random draws");
+        std::vector<uint64_t> draws(shapeCount, 0);
+        depthmapX::parallelFor(shapeCount, threadCount, [&](size_t i, size_t thread) {
+            if (thread == 0 && comm && comm->IsCancelled()) {
+                throw Communicator::CancelledException();
+            }
+            std::vector<size_t> &covered = threadCovered[thread];
+            pflipper<std::vector<int>> foundlist;
+            foundlist.a().push_back(int(i));
+            covered[i] = i;
+            int depth = 1;
+            for (int radius : radii) {
+                while (foundlist.a().size()) {
+                    const Connector &line = connectors[size_t(foundlist.a().back())];
+                    draws[i]++;
+                    for (int connection : line.m_connections) {
+                        if (covered[size_t(connection)] != i) {
+                            covered[size_t(connection)] = i;
+                            foundlist.b().push_back(connection);
+                        }
+                    }
+                    foundlist.a().pop_back();
+                    if (!foundlist.a().size()) {
+                        foundlist.flip();
+                        depth++;
+                        if (radius != -1 && depth > radius) {
+                            break;
+                        }
+                    }
+                }
             }
+        });
+        randstates.resize(shapeCount);
+        uint64_t randstate = pafrandstate();
+        for (size_t i = 0; i < shapeCount; i++) {
+            randstates[i] = randstate;
+            randstate = pafrandskip(randstate, draws[i]);
+        }
+        pafsetrandstate(randstate);
+        for (auto &covered : threadCovered) {
+            std::fill(covered.begin(), covered.end(), size_t(-1));
         }
+    }
+
+    // for choice, the line each line was reached from and the choice totals for each radius. Adding
+    // up doubles in another order gives slightly different totals, so to get the same choice from any
+    // number of threads the lines are split into a fixed number of blocks of consecutive lines, run a
+    // block per thread at a time. Each block adds up into totals of its own, which are then added to
+    // the choice totals in block order
+    std::vector<std::vector<int>> threadPrevious;
+    std::vector<double> choiceTotals, weightedChoiceTotals;
+    std::vector<std::vector<double>> blockChoice, blockWeightedChoice;
+    if (m_choice) {
+        threadPrevious.resize(threadCount, std::vector<int>(shapeCount, -1));
+        choiceTotals.resize(shapeCount * radii.size(), 0.0);
+        weightedChoiceTotals.resize(shapeCount * radii.size(), 0.0);
+        blockChoice.resize(threadCount, std::vector<double>(shapeCount * radii.size(), 0.0));
+        blockWeightedChoice.resize(threadCount, std::vector<double>(shapeCount * radii.size(), 0.0));
+    }
+    // for local measures
+    std::vector<std::vector<size_t>> threadNeighbourhood;
+    if (m_local) {
+        threadNeighbourhood.resize(threadCount, std::vector<size_t>(shapeCount, size_t(-1)));
+    }
+
+    // lines taken off the search lists, counted per thread
+    std::vector<int64_t> threadLinesVisited(threadCount, 0);
+    depthmapX::TracePhase searchPhase("Line searches");
+    auto analyseLine = [&](size_t i, size_t thread, double *choice, double *weightedChoice) {
+        std::vector<std::pair<int, float>> &values = rowValues[i];
+        auto setValue = [&values](int col, float value) { values.emplace_back(col, value); };
+        std::vector<size_t> &covered = threadCovered[thread];
+        int *previousLine = m_choice ? threadPrevious[thread].data() : nullptr;
+        size_t radiusCount = radii.size();
 
         if (m_local) {
+            // the total neighbourhood is the connections and their connections (which include this line)
+            std::vector<size_t> &neighbourhood = threadNeighbourhood[thread];
             double control = 0.0;
-            const std::vector<int> &connections = map.getConnections()[i].m_connections;
-            std::vector<int> totalneighbourhood;
+            size_t neighbourhoodSize = 0;
+            const std::vector<int> &connections = connectors[i].m_connections;
             for (int connection : connections) {
                 // n.b., as of Depthmap 10.0, connections[j] and i cannot coexist
-                // if (connections[j] != i) {
-                depthmapX::addIfNotExists(totalneighbourhood, connection);
-                int retro_size = 0;
-                auto &retconnectors = map.getConnections()[size_t(connection)].m_connections;
+                if (neighbourhood[size_t(connection)] != i) {
+                    neighbourhood[size_t(connection)] = i;
+                    neighbourhoodSize++;
+                }
+                auto &retconnectors = connectors[size_t(connection)].m_connections;
                 for (auto retconnector : retconnectors) {
-                    retro_size++;
-                    depthmapX::addIfNotExists(totalneighbourhood, retconnector);
+                    if (neighbourhood[size_t(retconnector)] != i) {
+                        neighbourhood[size_t(retconnector)] = i;
+                        neighbourhoodSize++;
+                    }
                 }
-                control += 1.0 / double(retro_size);
-                //}
+                control += 1.0 / double(retconnectors.size());
             }
 
             if (!simple_version) {
                 if (connections.size() > 0) {
-                    row.setValue(control_col, float(control));
-                    row.setValue(controllability_col,
-                                 float(double(connections.size()) / double(totalneighbourhood.size() - 1)));
+                    setValue(control_col, float(control));
+                    setValue(controllability_col, float(double(connections.size()) / double(neighbourhoodSize - 1)));
                 } else {
-                    row.setValue(control_col, -1);
-                    row.setValue(controllability_col, -1);
+                    setValue(control_col, -1);
+                    setValue(controllability_col, -1);
                 }
             }
         }
@@ -281,7 +362,10 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
 
         pflipper<std::vector<std::pair<int, int>>> foundlist;
         foundlist.a().push_back(std::pair<int, int>(i, -1));
-        covered[i] = true;
+        covered[i] = i;
+        if (m_choice) {
+            previousLine[i] = -1;
+        }
         int total_depth = 0, depth = 1, node_count = 1, pos = -1, previous = -1; // node_count includes this 1
         double weight = 0.0, rootweight = 0.0, total_weight = 0.0, w_total_depth = 0.0;
         if (m_weighted_measure_col != -1) {
@@ -289,6 +373,7 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
             // include this line in total weights (as per nodecount)
             total_weight += rootweight;
         }
+        uint64_t randstate = m_choice ? randstates[i] : 0;
         int index = -1;
         int r = 0;
         for (int radius : radii) {
@@ -296,16 +381,16 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                 if (!m_choice) {
                     index = foundlist.a().back().first;
                 } else {
-                    pos = pafrand() % foundlist.a().size();
+                    pos = pafrand_r(randstate) % foundlist.a().size();
                     index = foundlist.a().at(pos).first;
                     previous = foundlist.a().at(pos).second;
-                    audittrail[index][0].previous.ref =
-                        previous; // note 0th member used here: can be used individually different radius previous
+                    previousLine[index] = previous; // radius for the previous doesn't matter in this analysis
                 }
-                Connector &line = map.getConnections()[index];
+                const Connector &line = connectors[index];
+                threadLinesVisited[thread]++;
                 for (size_t k = 0; k < line.m_connections.size(); k++) {
-                    if (!covered[line.m_connections[k]]) {
-                        covered[line.m_connections[k]] = true;
+                    if (covered[line.m_connections[k]] != i) {
+                        covered[line.m_connections[k]] = i;
                         foundlist.b().push_back(std::pair<int, int>(line.m_connections[k], index));
                         if (m_weighted_measure_col != -1) {
                             // the weight is taken from the discovered node:
@@ -318,16 +403,14 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                             // (coincidentally fixes choice problem which was completely wrong)
                             size_t here = index;   // note: start counting from index as actually looking ahead here
                             while (here != i) { // not i means not the current root for the path
-                                audittrail[here][r].choice += 1;
-                                audittrail[here][r].weighted_choice += weight * rootweight;
-                                here =
-                                    audittrail[here][0].previous.ref; // <- note, just using 0th position: radius for
-                                                                      // the previous doesn't matter in this analysis
+                                choice[here * radiusCount + r] += 1;
+                                weightedChoice[here * radiusCount + r] += weight * rootweight;
+                                here = previousLine[here];
                             }
                             if (m_weighted_measure_col != -1) {
                                 // in weighted choice, root node and current node receive values:
-                                audittrail[i][r].weighted_choice += (weight * rootweight) * 0.5;
-                                audittrail[line.m_connections[k]][r].weighted_choice += (weight * rootweight) * 0.5;
+                                weightedChoice[i * radiusCount + r] += (weight * rootweight) * 0.5;
+                                weightedChoice[line.m_connections[k] * radiusCount + r] += (weight * rootweight) * 0.5;
                             }
                         }
                         total_depth += depth;
@@ -349,18 +432,18 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                 }
             }
             // set the attributes for this node:
-            row.setValue(count_col[r], float(node_count));
+            setValue(count_col[r], float(node_count));
             if (m_weighted_measure_col != -1) {
-                row.setValue(total_weight_col[r], float(total_weight));
+                setValue(total_weight_col[r], float(total_weight));
             }
             // node count > 1 to avoid divide by zero (was > 2)
             if (node_count > 1) {
                 // note -- node_count includes this one -- mean depth as per p.108 Social Logic of Space
                 double mean_depth = double(total_depth) / double(node_count - 1);
-                row.setValue(depth_col[r], float(mean_depth));
+                setValue(depth_col[r], float(mean_depth));
                 if (m_weighted_measure_col != -1) {
                     // weighted mean depth:
-                    row.setValue(w_depth_col[r], float(w_total_depth / total_weight));
+                    setValue(w_depth_col[r], float(w_total_depth / total_weight));
                 }
                 // total nodes > 2 to avoid divide by 0 (was > 3)
                 if (node_count > 2 && mean_depth > 1.0) {
@@ -369,52 +452,52 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                     double rra_d = ra / dvalue(node_count);
                     double rra_p = ra / dvalue(node_count);
                     double integ_tk = teklinteg(node_count, total_depth);
-                    row.setValue(integ_dv_col[r], float(1.0 / rra_d));
+                    setValue(integ_dv_col[r], float(1.0 / rra_d));
 
                     if (!simple_version) {
-                        row.setValue(integ_pv_col[r], float(1.0 / rra_p));
+                        setValue(integ_pv_col[r], float(1.0 / rra_p));
                         if (total_depth - node_count + 1 > 1) {
-                            row.setValue(integ_tk_col[r], float(integ_tk));
+                            setValue(integ_tk_col[r], float(integ_tk));
                         } else {
-                            row.setValue(integ_tk_col[r], -1.0f);
+                            setValue(integ_tk_col[r], -1.0f);
                         }
                     }
 
                     if (m_fulloutput) {
-                        row.setValue(ra_col[r], float(ra));
+                        setValue(ra_col[r], float(ra));
 
                         if (!simple_version) {
-                            row.setValue(rra_col[r], float(rra_d));
+                            setValue(rra_col[r], float(rra_d));
                         }
-                        row.setValue(td_col[r], float(total_depth));
+                        setValue(td_col[r], float(total_depth));
 
                         if (!simple_version) {
                             // alan's palm-tree normalisation: palmtree
                             double dmin = node_count - 1;
                             double dmax = palmtree(node_count, depth - 1);
                             if (dmax != dmin) {
-                                row.setValue(penn_norm_col[r], float((dmax - total_depth) / (dmax - dmin)));
+                                setValue(penn_norm_col[r], float((dmax - total_depth) / (dmax - dmin)));
                             }
                         }
                     }
                 } else {
-                    row.setValue(integ_dv_col[r], -1.0f);
+                    setValue(integ_dv_col[r], -1.0f);
 
                     if (!simple_version) {
-                        row.setValue(integ_pv_col[r], -1.0f);
-                        row.setValue(integ_tk_col[r], -1.0f);
+                        setValue(integ_pv_col[r], -1.0f);
+                        setValue(integ_tk_col[r], -1.0f);
                     }
                     if (m_fulloutput) {
-                        row.setValue(ra_col[r], -1.0f);
+                        setValue(ra_col[r], -1.0f);
 
                         if (!simple_version) {
-                            row.setValue(rra_col[r], -1.0f);
+                            setValue(rra_col[r], -1.0f);
                         }
 
-                        row.setValue(td_col[r], -1.0f);
+                        setValue(td_col[r], -1.0f);
 
                         if (!simple_version) {
-                            row.setValue(penn_norm_col[r], -1.0f);
+                            setValue(penn_norm_col[r], -1.0f);
                         }
                     }
                 }
@@ -441,46 +524,79 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                     } else {
                         intensity = -1;
                     }
-                    row.setValue(entropy_col[r], float(entropy));
-                    row.setValue(rel_entropy_col[r], float(rel_entropy));
-                    row.setValue(intensity_col[r], float(intensity));
-                    row.setValue(harmonic_col[r], float(harmonic));
+                    setValue(entropy_col[r], float(entropy));
+                    setValue(rel_entropy_col[r], float(rel_entropy));
+                    setValue(intensity_col[r], float(intensity));
+                    setValue(harmonic_col[r], float(harmonic));
                 }
             } else {
-                row.setValue(depth_col[r], -1.0f);
-                row.setValue(integ_dv_col[r], -1.0f);
+                setValue(depth_col[r], -1.0f);
+                setValue(integ_dv_col[r], -1.0f);
 
                 if (!simple_version) {
-                    row.setValue(integ_pv_col[r], -1.0f);
-                    row.setValue(integ_tk_col[r], -1.0f);
-                    row.setValue(entropy_col[r], -1.0f);
-                    row.setValue(rel_entropy_col[r], -1.0f);
-                    row.setValue(harmonic_col[r], -1.0f);
+                    setValue(integ_pv_col[r], -1.0f);
+                    setValue(integ_tk_col[r], -1.0f);
+                    setValue(entropy_col[r], -1.0f);
+                    setValue(rel_entropy_col[r], -1.0f);
+                    setValue(harmonic_col[r], -1.0f);
                 }
             }
             ++r;
         }
-        //
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    delete[] covered;
-                    throw Communicator::CancelledException();
+    };
+
+    if (!m_choice) {
+        depthmapX::parallelFor(shapeCount, threadCount, comm,
+                               [&](size_t i, size_t thread) { analyseLine(i, thread, nullptr, nullptr); });
+    } else {
+        size_t blockCount = std::min(shapeCount, CHOICE_BLOCKS);
+        depthmapX::ProgressReporter progress(comm);
+        for (size_t firstBlock = 0; firstBlock < blockCount; firstBlock += threadCount) {
+            size_t runBlocks = std::min(threadCount, blockCount - firstBlock);
+            depthmapX::parallelFor(runBlocks, threadCount, [&](size_t runBlock, size_t thread) {
+                size_t block = firstBlock + runBlock;
+                size_t end = (block + 1) * shapeCount / blockCount;
+                for (size_t i = block * shapeCount / blockCount; i < end; i++) {
+                    progress.checkCancelled();
+                    analyseLine(i, thread, blockChoice[runBlock].data(), blockWeightedChoice[runBlock].data());
+                    progress.increment();
+                }
+            });
+            for (size_t runBlock = 0; runBlock < runBlocks; runBlock++) {
+                std::vector<double> &choice = blockChoice[runBlock];
+                std::vector<double> &weightedChoice = blockWeightedChoice[runBlock];
+                for (size_t k = 0; k < choiceTotals.size(); k++) {
+                    choiceTotals[k] += choice[k];
+                    weightedChoiceTotals[k] += weightedChoice[k];
+                    choice[k] = 0.0;
+                    weightedChoice[k] = 0.0;
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
             }
         }
     }
-    delete[] covered;
+
+    searchPhase.addCount("origins", int64_t(shapeCount));
+    searchPhase.addCount("lines visited",
+                         std::accumulate(threadLinesVisited.begin(), threadLinesVisited.end(), int64_t(0)));
+    searchPhase.end();
+
+    // the values go in row order, so the stats only need to be worked out at the end
+    depthmapX::TracePhase valuesPhase("Attribute values and stats");
+    AttributeStatsBatch statsBatch(map.getAttributeTable());
+    for (size_t i = 0; i < shapeCount; i++) {
+        for (auto &value : rowValues[i]) {
+            rows[i]->setValue(value.first, value.second);
+        }
+        std::vector<std::pair<int, float>>().swap(rowValues[i]);
+    }
+
     if (m_choice) {
-        i = -1;
-        for (auto & iter: attributes) {
-            i++;
-            AttributeRow &row = iter.getRow();
+        for (size_t i = 0; i < shapeCount; i++) {
+            AttributeRow &row = *rows[i];
             double total_choice = 0.0, w_total_choice = 0.0;
             for (size_t r = 0; r < radii.size(); r++) {
-                total_choice += audittrail[i][r].choice;
-                w_total_choice += audittrail[i][r].weighted_choice;
+                total_choice += choiceTotals[i * radii.size() + r];
+                w_total_choice += weightedChoiceTotals[i * radii.size() + r];
                 // n.b., normalise choice according to (n-1)(n-2)/2 (maximum possible through routes)
                 double node_count = row.getValue(count_col[r]);
                 double total_weight = 0;
@@ -504,11 +620,8 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
                 }
             }
         }
-        for (size_t i = 0; i < map.getShapeCount(); i++) {
-            delete[] audittrail[i];
-        }
-        delete[] audittrail;
     }
+    statsBatch.end();
 
     map.setDisplayedAttribute(-1); // <- override if it's already showing
     map.setDisplayedAttribute(integ_dv_col.back());
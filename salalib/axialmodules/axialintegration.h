@@ -27,6 +27,8 @@ class AxialIntegration : IAxial {
     bool m_choice;
     bool m_fulloutput;
     bool m_local;
+    // the number of blocks the lines are split into for choice (see run)
+    static const size_t CHOICE_BLOCKS = 128;
 
   public:
     std::string getAnalysisName() const override { return "Angular Analysis"; }
@@ -110,13 +110,15 @@ void AxialPolygons::init(std::vector<Line>& lines, const QtRegion& region)
    for (i = 0; i < lines.size(); i++) {
       firstpass.makeLineShape(lines[i]);
    }
-   firstpass.makeConnections();
+   // the connection sweep also finds where the lines cross, which is all the segment map needs
+   std::vector<std::vector<std::pair<double,int>>> linebreaks;
+   firstpass.makeConnections(KeyVertices(), &linebreaks);
 
    lines.clear();
    std::vector<Connector> connectionset;
 
    // interesting... 1.0 may or may not work as intended
-   firstpass.makeSegmentMap(lines, connectionset, 1.0);
+   firstpass.makeSegmentMap(lines, connectionset, 1.0, &linebreaks);
 
    // now we have a set of lines and a set of connections...
    // ...for the second pass, a bit of retro fitting to my original code is
@@ -77,18 +77,15 @@ struct RadialLine : public RadialKey
    bool cuts(const Line& l) const;
 };
 
+// the space between two consecutive radial lines around the same vertex,
+// given as the indices of the two radial lines
 struct RadialSegment
 {
-   std::set<int> indices;
-   RadialKey radial_b;
-
-   RadialSegment(RadialKey& rb)
-   { radial_b = rb; }
-   RadialSegment(const RadialKey& rb)
-   { radial_b = rb; }
-   RadialSegment()
-   { radial_b = RadialKey(); }
+   int radial_a;
+   int radial_b;
 
+   RadialSegment(int ra = -1, int rb = -1)
+   { radial_a = ra; radial_b = rb; }
 };
 
 struct PolyConnector {
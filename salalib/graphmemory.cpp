@@ -0,0 +1,141 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/graphmemory.h"
+#include "salalib/ngraph.h"
+#include "salalib/pointdata.h"
+
+#include "genlib/exceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+namespace depthmapX {
+
+    namespace {
+        // what the allocator adds to every allocation, as with glibc on 64 bit
+        const size_t ALLOCATION_OVERHEAD = 16;
+        // an entry of the std::set the metric and angular analyses search with, its tree node included
+        const size_t SEARCH_ENTRY_SIZE = sizeof(MetricTriple) + 32;
+        // the columns making the graph adds (connectivity and the point moments), and the most any of the
+        // VGA analyses adds (visual global with all its measures)
+        const size_t GRAPH_COLUMNS = 3;
+        const size_t ANALYSIS_COLUMNS = 7;
+    } // namespace
+
+    GraphMemoryEstimate estimateGraphMemory(const std::vector<std::unique_ptr<Node>> &sample, size_t nodeCount,
+                                            size_t cellCount) {
+        GraphMemoryEstimate estimate;
+        estimate.nodeCount = nodeCount;
+        estimate.sampleCount = sample.size();
+
+        double runs = 0.0, runBytes = 0.0;
+        for (const auto &node : sample) {
+            runs += double(node->runCount());
+            for (int i = 0; i < 32; i++) {
+                size_t allocated = node->bin(i).m_pixel_vecs.allocatedSize();
+                if (allocated > 0) {
+                    runBytes += double(allocated + ALLOCATION_OVERHEAD);
+                }
+            }
+        }
+        if (!sample.empty()) {
+            estimate.runsPerNode = runs / double(sample.size());
+            runBytes /= double(sample.size());
+        }
+
+        double nodeBytes = double(sizeof(Node) + ALLOCATION_OVERHEAD + GRAPH_COLUMNS * sizeof(float));
+        estimate.graphBytes = size_t(double(nodeCount) * (nodeBytes + runBytes));
+        estimate.compactGraphBytes =
+            size_t(double(nodeCount) * (nodeBytes + estimate.runsPerNode * double(sizeof(PixelVec))));
+
+        // visual global marks every cell of the grid as it goes, metric and angular keep a search list of
+        // up to all the nodes
+        size_t visualGlobalBytes = cellCount * (sizeof(int) + sizeof(PixelRef)) + nodeCount * sizeof(PixelRef);
+        size_t searchBytes = nodeCount * SEARCH_ENTRY_SIZE;
+        estimate.analysisBytes = std::max(visualGlobalBytes, searchBytes) + nodeCount * ANALYSIS_COLUMNS * sizeof(float);
+        return estimate;
+    }
+
+    bool needsCompactGraph(const GraphMemoryEstimate &estimate, size_t budget) {
+        if (estimate.graphBytes + estimate.analysisBytes <= budget) {
+            return false;
+        }
+        if (estimate.compactGraphBytes + estimate.analysisBytes <= budget) {
+            return true;
+        }
+        throw RuntimeException("The graph is expected to take up " + formatBytes(estimate.compactGraphBytes) +
+                               " even when made compact, and its analyses another " +
+                               formatBytes(estimate.analysisBytes) + ", more than the memory budget of " +
+                               formatBytes(budget));
+    }
+
+    std::string formatBytes(size_t bytes) {
+        const char *units[] = {"bytes", "KB", "MB", "GB", "TB"};
+        double value = double(bytes);
+        int unit = 0;
+        while (value >= 1024.0 && unit < 4) {
+            value /= 1024.0;
+            unit++;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+        return text;
+    }
+
+    size_t parseBytes(const std::string &text) {
+        // strtod alone would also take signs, exponents, hex and so on, so the number has to be digits
+        // with at most one point in them, all of which strtod has to have read
+        size_t end = 0;
+        while (end < text.size() && (std::isdigit(static_cast<unsigned char>(text[end])) || text[end] == '.')) {
+            end++;
+        }
+        std::string number = text.substr(0, end);
+        if (number.empty() || !std::isdigit(static_cast<unsigned char>(number[0])) ||
+            std::count(number.begin(), number.end(), '.') > 1) {
+            throw RuntimeException("Not a size in bytes: " + text);
+        }
+        char *numberEnd = nullptr;
+        double value = std::strtod(number.c_str(), &numberEnd);
+        if (numberEnd != number.c_str() + number.size()) {
+            throw RuntimeException("Not a size in bytes: " + text);
+        }
+
+        // then nothing but an optional unit, with or without a B after it
+        std::string unit = text.substr(end);
+        if (!unit.empty() && (unit.back() == 'B' || unit.back() == 'b')) {
+            unit.pop_back();
+        }
+        const std::string units = "KMGT";
+        size_t power = 0;
+        if (unit.size() == 1) {
+            power = units.find(char(std::toupper(static_cast<unsigned char>(unit[0])))) + 1;
+        }
+        if (!unit.empty() && (unit.size() > 1 || power == 0)) {
+            throw RuntimeException("Not a size in bytes: " + text);
+        }
+
+        // and it has to come to a whole number of bytes
+        double bytes = value * std::pow(1024.0, double(power));
+        if (bytes != std::floor(bytes) || bytes >= double(std::numeric_limits<size_t>::max())) {
+            throw RuntimeException("Not a whole number of bytes: " + text);
+        }
+        return size_t(bytes);
+    }
+} // namespace depthmapX
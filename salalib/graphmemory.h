@@ -0,0 +1,56 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Node;
+
+namespace depthmapX {
+
+    // What a visibility graph is expected to take up once made, worked out from the nodes of a sample of
+    // its pixels. How much a node takes depends on how many runs of pixels it sees, so the sample has to
+    // be made the same way as the graph
+    struct GraphMemoryEstimate {
+        size_t nodeCount = 0;
+        size_t sampleCount = 0;
+        // averaged over the sample
+        double runsPerNode = 0.0;
+        // the graph as usually made, with the runs of each bin in an allocation of its own
+        size_t graphBytes = 0;
+        // the graph made compact, with the runs of all the nodes kept together (see PointMap::sparkGraph2)
+        size_t compactGraphBytes = 0;
+        // the most any of the VGA analyses takes on top of the graph as it runs, the columns it adds
+        // included
+        size_t analysisBytes = 0;
+    };
+
+    // the estimate for a graph of nodeCount nodes on a grid of cellCount cells
+    GraphMemoryEstimate estimateGraphMemory(const std::vector<std::unique_ptr<Node>> &sample, size_t nodeCount,
+                                            size_t cellCount);
+    // whether the graph has to be made compact for it and an analysis of it to fit in the budget. Throws
+    // RuntimeException if they would not fit either way, rather than have the machine run out of memory
+    // part of the way through
+    bool needsCompactGraph(const GraphMemoryEstimate &estimate, size_t budget);
+
+    // as "1.5 GB"
+    std::string formatBytes(size_t bytes);
+    // a number of bytes, or of kilobytes, megabytes... with a K, M, G or T after it ("512M", "1.5G"). Throws
+    // RuntimeException for anything else, or if it does not come to a whole number of bytes
+    size_t parseBytes(const std::string &text);
+} // namespace depthmapX
@@ -18,9 +18,12 @@
 #include "genlib/p2dpoly.h"
 #include <vector>
 #include <map>
+#include <string>
 
 namespace depthmapX {
-    typedef std::vector<std::string> ColumnData;
+    // the values of an imported attribute column, one for each row, as they are to be stored
+    typedef std::vector<float> ColumnData;
+    // the imported attribute columns by name
     typedef std::map<std::string, ColumnData> Table;
 
     class Polyline : public QtRegion
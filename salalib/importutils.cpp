@@ -17,14 +17,20 @@
 
 #include "genlib/stringutils.h"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <set>
 #include <sstream>
+#include <unordered_map>
 
 namespace depthmapX {
 
     const int DXFCIRCLERES = 36;
 
     bool importFile(MetaGraph &mgraph, std::istream &stream, Communicator *communicator, std::string name,
-                    ImportType mapType, ImportFileType fileType) {
+                    ImportType mapType, ImportFileType fileType, const std::vector<std::string> &dxfLayers) {
 
         // This function is still too fiddly but at least it shows the common interface for
         // drawing and data maps and how different file types may be parsed to be imported
@@ -98,13 +104,12 @@ namespace depthmapX {
         }
         case DXF: {
 
-            DxfParser dp;
+            DxfParser dp(communicator);
+            dp.setLayerFilter(std::set<std::string>(dxfLayers.begin(), dxfLayers.end()));
 
             if (communicator) {
-                dp = DxfParser(communicator);
-
                 try {
-                    stream >> dp;
+                    dp.open(stream, name);
                 } catch (Communicator::CancelledException) {
                     return 0;
                 } catch (std::logic_error &) {
@@ -115,7 +120,7 @@ namespace depthmapX {
                     return 0;
                 }
             } else {
-                dp.open(stream);
+                dp.open(stream, name);
             }
 
             for (auto &layer : dp.getLayers()) {
@@ -151,34 +156,297 @@ namespace depthmapX {
         }
     }
 
+    namespace {
+        // how the cells of a column are read
+        enum class CellType {
+            IGNORED,
+            // a coordinate, read as std::stod would
+            REAL,
+            // a ref, read as std::stoi would
+            INTEGER,
+            // an attribute read as std::stof would
+            NUMBER,
+            // an attribute that is either a number or text, the text given a category number
+            ATTRIBUTE
+        };
+
+        // skips the white space (and a '+' sign) std::strtod skips before a number
+        const char *numberStart(std::string_view cell) {
+            const char *first = cell.data();
+            const char *last = cell.data() + cell.size();
+            while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+                first++;
+            }
+            if (first != last && *first == '+' && first + 1 != last && *(first + 1) != '-' && *(first + 1) != '+') {
+                first++;
+            }
+            return first;
+        }
+
+        // reads the number at the start of the cell with from_chars, false if it has to be left to the
+        // C library to read (when it is not a plain decimal number or is out of range)
+        template <typename T> bool readNumber(std::string_view cell, T &value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            const char *first = numberStart(cell);
+            const char *last = cell.data() + cell.size();
+            std::from_chars_result result = std::from_chars(first, last, value);
+            // hexadecimal numbers are read by the C library, from_chars would stop at the x
+            return result.ec == std::errc() && (result.ptr == last || (*result.ptr != 'x' && *result.ptr != 'X'));
+#else
+            (void)cell;
+            (void)value;
+            return false;
+#endif
+        }
+
+        struct ColumnReader {
+            CellType type = CellType::IGNORED;
+            std::vector<double> reals;
+            std::vector<int> integers;
+            ColumnData values;
+            std::unordered_map<std::string, size_t> categories;
+            // the rows up to the last where the column had too many categories
+            size_t overflowRows = 0;
+
+            void read(std::string_view cell) {
+                switch (type) {
+                case CellType::IGNORED:
+                    break;
+                case CellType::REAL: {
+                    double value;
+                    if (!readNumber(cell, value)) {
+                        value = std::stod(std::string(cell));
+                    }
+                    reals.push_back(value);
+                    break;
+                }
+                case CellType::INTEGER: {
+                    int value;
+                    if (!readNumber(cell, value)) {
+                        value = std::stoi(std::string(cell));
+                    }
+                    integers.push_back(value);
+                    break;
+                }
+                case CellType::NUMBER: {
+                    float value;
+                    if (!readNumber(cell, value)) {
+                        value = std::stof(std::string(cell));
+                    }
+                    values.push_back(value);
+                    break;
+                }
+                case CellType::ATTRIBUTE:
+                    values.push_back(readAttribute(cell));
+                    break;
+                }
+            }
+
+            float readAttribute(std::string_view cell) {
+                double value = 0;
+                if (readNumber(cell, value)) {
+                    return float(value);
+                }
+                std::string cellValue(cell);
+                if (dXstring::isDouble(cellValue)) {
+                    return float(std::stod(cellValue));
+                }
+                auto cellAt = categories.find(cellValue);
+                if (cellAt != categories.end()) {
+                    return float(cellAt->second);
+                }
+
+                // TODO:
+                // It seems that the original intention here was that if we are past 32 unique
+                // values, we should stop trying to make the column categorical and fill the rest
+                // of the values with -1.0f. It's not possible to test the original implementation
+                // because the app crashes if we load a file with more than 32 unique values. When
+                // and if we have a robust implementation of an attribute table that allows for
+                // both categorical and plain string attributes this should be re-examined for a
+                // better way to classify the column as either. Meanwhile after this threshold (32)
+                // we set the whole column (up to here) to -1 so that it does not give the impression
+                // it worked when it's actually half-baked
+
+                if (categories.size() >= 32) {
+                    overflowRows = values.size() + 1;
+                    return -1.0f;
+                }
+                size_t category = categories.size();
+                categories.insert(std::make_pair(cellValue, category));
+                return float(category);
+            }
+
+            void finish() {
+                std::fill(values.begin(), values.begin() + std::min(overflowRows, values.size()), -1.0f);
+            }
+        };
+
+        // reads every row of the file into the columns, as numbers of the type given for each
+        std::vector<ColumnReader> readColumns(DelimitedReader &reader, const std::vector<CellType> &types) {
+            std::vector<ColumnReader> columns(types.size());
+            for (size_t i = 0; i < types.size(); i++) {
+                columns[i].type = types[i];
+            }
+            std::vector<std::string_view> cells;
+            while (reader.nextRow(cells)) {
+                if (cells.size() != columns.size()) {
+                    std::stringstream message;
+                    message << "Cells in line " << reader.getLine() << "not the same number as the columns"
+                            << std::flush;
+                    throw RuntimeException(message.str().c_str());
+                }
+                for (size_t i = 0; i < cells.size(); i++) {
+                    columns[i].read(cells[i]);
+                }
+            }
+            for (auto &column : columns) {
+                column.finish();
+            }
+            return columns;
+        }
+
+        // the columns of the file by name, taking the first of any with the same name
+        std::map<std::string, size_t> columnsByName(const std::vector<std::string> &names) {
+            std::map<std::string, size_t> columns;
+            for (size_t i = 0; i < names.size(); i++) {
+                columns.insert(std::make_pair(names[i], i));
+            }
+            return columns;
+        }
+    } // namespace
+
+    DelimitedReader::DelimitedReader(std::istream &stream, char delimiter, size_t blockSize)
+        : m_stream(stream), m_delimiter(delimiter), m_blockSize(blockSize == 0 ? 1 : blockSize) {
+        std::string_view header;
+        if (!nextLine(header)) {
+            return;
+        }
+        std::vector<std::string_view> names;
+        split(header, names);
+        for (auto name : names) {
+            std::string columnName(name);
+            if (!columnName.empty()) {
+                dXstring::ltrim(columnName, '\"');
+                dXstring::rtrim(columnName, '\"');
+            }
+            m_columnNames.push_back(columnName);
+        }
+    }
+
+    bool DelimitedReader::nextRow(std::vector<std::string_view> &cells) {
+        cells.clear();
+        while (nextLine(m_line)) {
+            if (!m_line.empty()) {
+                split(m_line, cells);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool DelimitedReader::nextLine(std::string_view &line) {
+        size_t searchFrom = m_start;
+        for (;;) {
+            const char *end = nullptr;
+            if (searchFrom < m_end) {
+                end = static_cast<const char *>(std::memchr(m_buffer.data() + searchFrom, '\n', m_end - searchFrom));
+            }
+            if (end != nullptr) {
+                line = std::string_view(m_buffer.data() + m_start, size_t(end - (m_buffer.data() + m_start)));
+                m_start = size_t(end - m_buffer.data()) + 1;
+                return true;
+            }
+            if (!m_stream.good()) {
+                // the last line, if it does not end with a new line
+                line = std::string_view(m_buffer.data() + m_start, m_end - m_start);
+                bool any = m_start != m_end;
+                m_start = m_end;
+                return any;
+            }
+            // move what is left of the block to the front and read the next block after it
+            size_t remaining = m_end - m_start;
+            std::memmove(m_buffer.data(), m_buffer.data() + m_start, remaining);
+            m_start = 0;
+            m_end = remaining;
+            searchFrom = remaining;
+            m_buffer.resize(remaining + m_blockSize);
+            m_stream.read(m_buffer.data() + m_end, std::streamsize(m_blockSize));
+            m_end += size_t(m_stream.gcount());
+        }
+    }
+
+    void DelimitedReader::split(std::string_view line, std::vector<std::string_view> &cells) const {
+        // as std::getline splits them, without an empty cell after a delimiter at the end
+        size_t start = 0;
+        for (size_t i = 0; i < line.size(); i++) {
+            if (line[i] == m_delimiter) {
+                cells.push_back(line.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        if (start < line.size()) {
+            cells.push_back(line.substr(start));
+        }
+    }
+
     bool importTxt(ShapeMap &shapeMap, std::istream &stream, char delimiter = '\t') {
-        Table table = csvToTable(stream, delimiter);
-        std::vector<std::string> columns;
+        DelimitedReader reader(stream, delimiter);
+        const std::vector<std::string> &names = reader.getColumnNames();
+        if (names.size() < 2) {
+            return true;
+        }
+        std::map<std::string, size_t> columns = columnsByName(names);
         int xcol = -1, ycol = -1, x1col = -1, y1col = -1, x2col = -1, y2col = -1, refcol = -1;
-        for (auto const &column : table) {
+        for (auto const &column : columns) {
             if (column.first == "x" || column.first == "easting")
-                xcol = columns.size();
+                xcol = column.second;
             else if (column.first == "y" || column.first == "northing")
-                ycol = columns.size();
+                ycol = column.second;
             else if (column.first == "x1")
-                x1col = columns.size();
+                x1col = column.second;
             else if (column.first == "x2")
-                x2col = columns.size();
+                x2col = column.second;
             else if (column.first == "y1")
-                y1col = columns.size();
+                y1col = column.second;
             else if (column.first == "y2")
-                y2col = columns.size();
+                y2col = column.second;
             else if (column.first == "Ref")
-                refcol = columns.size();
-            columns.push_back(column.first);
+                refcol = column.second;
         }
 
-        if (xcol != -1 && ycol != -1 && refcol != -1) {
+        // the columns the shapes are made from, all the others are attributes
+        std::vector<int> shapeColumns;
+        bool withRefs = refcol != -1;
+        if (xcol != -1 && ycol != -1) {
+            shapeColumns = {xcol, ycol};
+        } else if (x1col != -1 && y1col != -1 && x2col != -1 && y2col != -1) {
+            shapeColumns = {x1col, y1col, x2col, y2col};
+        } else {
+            return true;
+        }
+
+        std::vector<CellType> types(names.size(), CellType::IGNORED);
+        for (auto const &column : columns) {
+            types[column.second] = CellType::ATTRIBUTE;
+        }
+        for (int column : shapeColumns) {
+            types[size_t(column)] = CellType::REAL;
+        }
+        if (withRefs) {
+            types[size_t(refcol)] = CellType::INTEGER;
+        }
+        std::vector<ColumnReader> read = readColumns(reader, types);
+
+        Table table;
+        for (auto const &column : columns) {
+            if (types[column.second] == CellType::ATTRIBUTE) {
+                table[column.first] = std::move(read[column.second].values);
+            }
+        }
+
+        if (shapeColumns.size() == 2 && withRefs) {
             std::map<int, Point2f> points =
-                extractPointsWithRefs(table[columns[xcol]], table[columns[ycol]], table[columns[refcol]]);
-            table.erase(table.find(columns[xcol]));
-            table.erase(table.find(columns[ycol]));
-            table.erase(table.find(columns[refcol]));
+                extractPointsWithRefs(read[xcol].reals, read[ycol].reals, read[refcol].integers);
 
             QtRegion region;
 
@@ -193,10 +461,8 @@ namespace depthmapX {
             shapeMap.init(points.size(), region);
             shapeMap.importPointsWithRefs(points, table);
 
-        } else if (xcol != -1 && ycol != -1) {
-            std::vector<Point2f> points = extractPoints(table[columns[xcol]], table[columns[ycol]]);
-            table.erase(table.find(columns[xcol]));
-            table.erase(table.find(columns[ycol]));
+        } else if (shapeColumns.size() == 2) {
+            std::vector<Point2f> points = extractPoints(read[xcol].reals, read[ycol].reals);
 
             QtRegion region;
 
@@ -211,15 +477,9 @@ namespace depthmapX {
             shapeMap.init(points.size(), region);
             shapeMap.importPoints(points, table);
 
-        } else if (x1col != -1 && y1col != -1 && x2col != -1 && y2col != -1 && refcol != -1) {
-            std::map<int, Line> lines =
-                extractLinesWithRef(table[columns[x1col]], table[columns[y1col]], table[columns[x2col]],
-                                    table[columns[y2col]], table[columns[refcol]]);
-            table.erase(table.find(columns[x1col]));
-            table.erase(table.find(columns[y1col]));
-            table.erase(table.find(columns[x2col]));
-            table.erase(table.find(columns[y2col]));
-            table.erase(table.find(columns[refcol]));
+        } else if (withRefs) {
+            std::map<int, Line> lines = extractLinesWithRef(read[x1col].reals, read[y1col].reals, read[x2col].reals,
+                                                            read[y2col].reals, read[refcol].integers);
 
             QtRegion region;
 
@@ -233,13 +493,9 @@ namespace depthmapX {
 
             shapeMap.init(lines.size(), region);
             shapeMap.importLinesWithRefs(lines, table);
-        } else if (x1col != -1 && y1col != -1 && x2col != -1 && y2col != -1) {
-            std::vector<Line> lines = extractLines(table[columns[x1col]], table[columns[y1col]], table[columns[x2col]],
-                                                   table[columns[y2col]]);
-            table.erase(table.find(columns[x1col]));
-            table.erase(table.find(columns[y1col]));
-            table.erase(table.find(columns[x2col]));
-            table.erase(table.find(columns[y2col]));
+        } else {
+            std::vector<Line> lines =
+                extractLines(read[x1col].reals, read[y1col].reals, read[x2col].reals, read[y2col].reals);
 
             QtRegion region;
 
@@ -257,86 +513,38 @@ namespace depthmapX {
         return true;
     }
 
-    Table csvToTable(std::istream &stream, char delimiter = '\t') {
-
-        Table table;
-        std::vector<std::string> columns;
-
-        std::string inputline;
-        std::getline(stream, inputline);
-
-        // check for a matching delimited header line...
-        auto strings = dXstring::split(inputline, delimiter);
-        if (strings.size() < 2) {
-            // throw exception
-            return table;
-        }
-
-        for (auto &columnName : strings) {
-            if (!columnName.empty()) {
-                dXstring::ltrim(columnName, '\"');
-                dXstring::rtrim(columnName, '\"');
-            }
-            table.insert(std::make_pair(columnName, std::vector<std::string>()));
-            columns.push_back(columnName);
-        }
-
-        while (!stream.eof()) {
-            std::getline(stream, inputline);
-            if (!inputline.empty()) {
-                auto strings = dXstring::split(inputline, delimiter);
-                if (strings.size() != columns.size()) {
-                    std::stringstream message;
-                    message << "Cells in line " << inputline << "not the same number as the columns" << std::flush;
-                    throw RuntimeException(message.str().c_str());
-                }
-                if (!strings.size()) {
-                    continue;
-                }
-                for (size_t i = 0; i < strings.size(); i++) {
-                    table[columns[i]].push_back(strings[i]);
-                }
-            }
-        }
-        return table;
-    }
-
-    std::vector<Line> extractLines(ColumnData &x1col, ColumnData &y1col, ColumnData &x2col, ColumnData &y2col) {
+    std::vector<Line> extractLines(const std::vector<double> &x1col, const std::vector<double> &y1col,
+                                   const std::vector<double> &x2col, const std::vector<double> &y2col) {
         std::vector<Line> lines;
+        lines.reserve(x1col.size());
         for (size_t i = 0; i < x1col.size(); i++) {
-            double x1 = stod(x1col[i]);
-            double y1 = stod(y1col[i]);
-            double x2 = stod(x2col[i]);
-            double y2 = stod(y2col[i]);
-            lines.push_back(Line(Point2f(x1, y1), Point2f(x2, y2)));
+            lines.push_back(Line(Point2f(x1col[i], y1col[i]), Point2f(x2col[i], y2col[i])));
         }
         return lines;
     }
 
-    std::map<int, Line> extractLinesWithRef(ColumnData &x1col, ColumnData &y1col, ColumnData &x2col, ColumnData &y2col,
-                                            ColumnData &refcol) {
+    std::map<int, Line> extractLinesWithRef(const std::vector<double> &x1col, const std::vector<double> &y1col,
+                                            const std::vector<double> &x2col, const std::vector<double> &y2col,
+                                            const std::vector<int> &refcol) {
         std::map<int, Line> lines;
         for (size_t i = 0; i < x1col.size(); i++) {
-            double x1 = stod(x1col[i]);
-            double y1 = stod(y1col[i]);
-            double x2 = stod(x2col[i]);
-            double y2 = stod(y2col[i]);
-            int ref = stoi(refcol[i]);
-            lines.insert(std::make_pair(ref, Line(Point2f(x1, y1), Point2f(x2, y2))));
+            lines.insert(std::make_pair(refcol[i], Line(Point2f(x1col[i], y1col[i]), Point2f(x2col[i], y2col[i]))));
         }
         return lines;
     }
-    std::vector<Point2f> extractPoints(ColumnData &x, ColumnData &y) {
+    std::vector<Point2f> extractPoints(const std::vector<double> &x, const std::vector<double> &y) {
         std::vector<Point2f> points;
+        points.reserve(x.size());
         for (size_t i = 0; i < x.size(); i++) {
-            points.push_back(Point2f(stod(x[i]), stod(y[i])));
+            points.push_back(Point2f(x[i], y[i]));
         }
         return points;
     }
-    std::map<int, Point2f> extractPointsWithRefs(ColumnData &x, ColumnData &y, ColumnData &ref) {
+    std::map<int, Point2f> extractPointsWithRefs(const std::vector<double> &x, const std::vector<double> &y,
+                                                 const std::vector<int> &ref) {
         std::map<int, Point2f> points;
         for (size_t i = 0; i < x.size(); i++) {
-            points.insert(std::make_pair(stoi(ref[i]), Point2f(stod(x[i]), stod(y[i]))));
+            points.insert(std::make_pair(ref[i], Point2f(x[i], y[i])));
         }
         return points;
     }
@@ -429,16 +637,21 @@ namespace depthmapX {
     }
 
     bool importAttributes(AttributeTable &attributes, std::istream &stream, char delimiter = '\t') {
-        Table table = csvToTable(stream, delimiter);
+        DelimitedReader reader(stream, delimiter);
+        const std::vector<std::string> &names = reader.getColumnNames();
+        std::map<std::string, size_t> columns;
+        if (names.size() >= 2) {
+            columns = columnsByName(names);
+        }
         std::vector<std::string> outColumns;
         int refcol = -1;
-        for (auto const &column : table) {
+        for (auto const &column : columns) {
             if (column.first == "Ref")
-                refcol = outColumns.size();
+                refcol = column.second;
             else
                 outColumns.push_back(column.first);
         }
-        if(table.size() == 0) {
+        if(columns.size() == 0) {
             throw RuntimeException("No usable data found in file");
         }
         if(refcol == -1) {
@@ -447,9 +660,16 @@ namespace depthmapX {
         if(outColumns.size() < 1) {
             throw RuntimeException("No data found to join");
         }
+
+        std::vector<CellType> types(names.size(), CellType::IGNORED);
+        for (auto const &column : columns) {
+            types[column.second] = CellType::NUMBER;
+        }
+        types[size_t(refcol)] = CellType::INTEGER;
+        std::vector<ColumnReader> read = readColumns(reader, types);
+
         std::vector<AttributeRow*> inRows;
-        for(const auto& refInFile: table["Ref"]) {
-            int ref = std::stoi(refInFile);
+        for(int ref: read[refcol].integers) {
             auto iter = attributes.find(AttributeKey(ref));
             if(iter == attributes.end()) {
                 std::stringstream message;
@@ -464,9 +684,9 @@ namespace depthmapX {
 
         for(const std::string& column: outColumns) {
             int colIdx = attributes.insertOrResetColumn(column);
-            auto outRowIter = table[column].begin();
-            for(auto inRowIter = inRows.begin(); inRowIter != inRows.end(); inRowIter++, outRowIter++) {
-                (*inRowIter)->setValue(colIdx, std::stof(*outRowIter));
+            const ColumnData &values = read[columns[column]].values;
+            for(size_t i = 0; i < inRows.size(); i++) {
+                inRows[i]->setValue(colIdx, values[i]);
             }
         }
         return true;
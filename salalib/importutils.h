@@ -18,19 +18,61 @@
 #include "salalib/importtypedefs.h"
 #include "salalib/mgraph.h"
 #include "salalib/parsers/dxfp.h"
+#include <istream>
 #include <map>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace depthmapX {
+
+    /**
+     *  Reads a delimited text file a block at a time, the first line giving the names of the columns
+     *  and every line after that a row of cells. Cells are split out of the block they are in without
+     *  being copied, so that nothing more than the block and whatever the cells are parsed into is
+     *  held at any time
+     */
+    class DelimitedReader {
+      public:
+        DelimitedReader(std::istream &stream, char delimiter, size_t blockSize = 1 << 20);
+
+        // the names in the first line (without any quotes around them)
+        const std::vector<std::string> &getColumnNames() const { return m_columnNames; }
+
+        // splits the next line with anything on it into its cells, which are only valid until the
+        // next row is read. False at the end of the file
+        bool nextRow(std::vector<std::string_view> &cells);
+        // the line of the last row read
+        std::string_view getLine() const { return m_line; }
+
+      private:
+        std::istream &m_stream;
+        char m_delimiter;
+        size_t m_blockSize;
+        std::vector<char> m_buffer;
+        size_t m_start = 0;
+        size_t m_end = 0;
+        std::string_view m_line;
+        std::vector<std::string> m_columnNames;
+
+        bool nextLine(std::string_view &line);
+        void split(std::string_view line, std::vector<std::string_view> &cells) const;
+    };
+
+    // name is the file the stream reads (a dxf is read from it directly where it can be), and dxfLayers
+    // the layers of a dxf to import (all of them if none are given)
     bool importFile(MetaGraph &mgraph, std::istream &stream, Communicator *communicator, std::string name,
-                    ImportType mapType, ImportFileType fileType);
+                    ImportType mapType, ImportFileType fileType,
+                    const std::vector<std::string> &dxfLayers = std::vector<std::string>());
     bool importTxt(ShapeMap &shapeMap, std::istream &stream, char delimiter);
-    depthmapX::Table csvToTable(std::istream &stream, char delimiter);
-    std::vector<Line> extractLines(ColumnData &x1col, ColumnData &y1col, ColumnData &x2col, ColumnData &y2col);
-    std::map<int, Line> extractLinesWithRef(ColumnData &x1col, ColumnData &y1col, ColumnData &x2col, ColumnData &y2col,
-                                            ColumnData &refcol);
-    std::vector<Point2f> extractPoints(ColumnData &x, ColumnData &y);
-    std::map<int, Point2f> extractPointsWithRefs(ColumnData &x, ColumnData &y, ColumnData &ref);
+    std::vector<Line> extractLines(const std::vector<double> &x1col, const std::vector<double> &y1col,
+                                   const std::vector<double> &x2col, const std::vector<double> &y2col);
+    std::map<int, Line> extractLinesWithRef(const std::vector<double> &x1col, const std::vector<double> &y1col,
+                                            const std::vector<double> &x2col, const std::vector<double> &y2col,
+                                            const std::vector<int> &refcol);
+    std::vector<Point2f> extractPoints(const std::vector<double> &x, const std::vector<double> &y);
+    std::map<int, Point2f> extractPointsWithRefs(const std::vector<double> &x, const std::vector<double> &y,
+                                                 const std::vector<int> &ref);
     bool importDxfLayer(const DxfLayer &dxfLayer, ShapeMap &shapeMap);
     bool importAttributes(AttributeTable &attributes, std::istream &stream, char delimiter);
 } // namespace depthmapX
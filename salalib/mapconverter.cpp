@@ -4,6 +4,7 @@
 #include "genlib/exceptions.h"
 
 #include <numeric>
+#include <utility>
 
 // convert line layers to an axial map
 
@@ -107,7 +108,7 @@ std::unique_ptr<ShapeGraph> MapConverter::convertDataToAxial(Communicator *comm,
    // add all visible layers to the set of polygon lines...
 
    int count = 0;
-   for (auto shape: shapemap.getAllShapes()) {
+   for (auto shape: std::as_const(shapemap).getAllShapes()) {
       int key = shape.first;
 
       std::vector<Line> shapeLines = shape.second.getAsLines();
@@ -246,7 +247,7 @@ std::unique_ptr<ShapeGraph> MapConverter::convertDataToConvex(Communicator *, co
    int conn_col = usermap->getAttributeTable().insertOrResetLockedColumn("Connectivity");
 
    std::vector<int> lookup;
-   auto refShapes = shapemap.getAllShapes();
+   const auto &refShapes = std::as_const(shapemap).getAllShapes();
    std::map<int,float> extraAttr;
    std::vector<int> attrCols;
    AttributeTable& input = shapemap.getAttributeTable();
@@ -384,7 +385,7 @@ std::unique_ptr<ShapeGraph> MapConverter::convertDataToSegment(Communicator *com
    // add all visible layers to the set of polygon lines...
 
    int count = 0;
-   for (auto shape: shapemap.getAllShapes()) {
+   for (auto shape: std::as_const(shapemap).getAllShapes()) {
       int key = shape.first;
       std::vector<Line> shapeLines = shape.second.getAsLines();
       for(Line line: shapeLines) {
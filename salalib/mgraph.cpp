@@ -19,6 +19,7 @@
 // The meta graph 
 
 #include "salalib/alllinemap.h"
+#include "salalib/analysischeckpoint.h"
 #include "salalib/mapconverter.h"
 #include "salalib/isovist.h"
 #include "salalib/mgraph.h"
@@ -53,12 +54,17 @@
 #include "genlib/pafmath.h"
 #include "genlib/p2dpoly.h"
 #include "genlib/comm.h"
+#include "genlib/mappedblock.h"
+#include "genlib/parallel.h"
 
 #include "math.h"
 #include "time.h"
 
+#include <cstdio>
+#include <fstream>
 #include <sstream>
 #include <tuple>
+#include <utility>
 
 
 MetaGraph::MetaGraph(std::string name)
@@ -261,7 +267,7 @@ bool MetaGraph::clearPoints()
    return b_return;
 }
 
-bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double maxdist )
+bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double maxdist, bool compact )
 {
    // this is essentially a version tag, and remains for historical reasons:
    m_state |= ANGULARGRAPH;
@@ -270,7 +276,7 @@ bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double max
    
    try {
       // algorithm is now used for boundary graph option (as a simple boolean)
-      graphMade = getDisplayedPointMap().sparkGraph2(communicator, (algorithm != 0), maxdist);
+      graphMade = getDisplayedPointMap().sparkGraph2(communicator, (algorithm != 0), maxdist, compact);
    } 
    catch (Communicator::CancelledException) {
       graphMade = false;
@@ -296,6 +302,7 @@ bool MetaGraph::unmakeGraph(bool removeLinks)
 
 bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool simple_version )   // <- options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    bool analysisCompleted = false;
 
    if (options.point_depth_selection) {
@@ -353,7 +360,10 @@ bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool
               localResult = VGAVisualLocal(options.gates_only).run(communicator, getDisplayedPointMap(), simple_version);
           }
           if (options.global) {
-              globalResult = VGAVisualGlobal(options.radius, options.gates_only).run(communicator, getDisplayedPointMap(), simple_version);
+              auto checkpoint = depthmapX::makeCheckpoint(options);
+              VGAVisualGlobal analysis(options.radius, options.gates_only);
+              analysis.setCheckpoint(checkpoint.get());
+              globalResult = analysis.run(communicator, getDisplayedPointMap(), simple_version);
           }
           analysisCompleted = globalResult & localResult;
       }
@@ -509,7 +519,7 @@ int MetaGraph::makeIsovist(Communicator *communicator, const Point2f& p, double
       ShapeMap& map = m_dataMaps[shapelayer];
       // false: closed polygon, true: isovist
       int polyref = map.makePolyShape(iso.getPolygon(),false);  
-      map.getAllShapes()[polyref].setCentroid(p);
+      map.getShape(polyref).setCentroid(p);
       map.overrideDisplayedAttribute(-2);
       map.setDisplayedAttribute(-1);
       setViewClass(SHOWSHAPETOP);
@@ -561,7 +571,7 @@ int MetaGraph::makeIsovistPath(Communicator *communicator, double fov, bool simp
    bool first = true;
    if (makeBSPtree(communicator)) {
       std::set<int> selset = map->getSelSet();
-      std::map<int,SalaShape>& shapes = map->getAllShapes();
+      const std::map<int,SalaShape>& shapes = std::as_const(*map).getAllShapes();
       for (auto& shapeRef: selset) {
          const SalaShape& path = shapes.at(shapeRef);
          if (path.isLine() || path.isPolyLine()) {
@@ -592,7 +602,7 @@ int MetaGraph::makeIsovistPath(Communicator *communicator, double fov, bool simp
                }
                iso.makeit(m_bsp_root, start, m_region, angles.first, angles.second);
                int polyref = isovists->makePolyShape(iso.getPolygon(),false);  
-               isovists->getAllShapes()[polyref].setCentroid(start);
+               isovists->getShape(polyref).setCentroid(start);
                AttributeTable& table = isovists->getAttributeTable();
                AttributeRow& row = table.getRow(AttributeKey(polyref));
                iso.setData(table,row, simple_version);
@@ -607,7 +617,7 @@ int MetaGraph::makeIsovistPath(Communicator *communicator, double fov, bool simp
                   }
                   iso.makeit(m_bsp_root, start, m_region, angles.first, angles.second);
                   int polyref = isovists->makePolyShape(iso.getPolygon(),false);  
-                  isovists->getAllShapes().find(polyref)->second.setCentroid(start);
+                  isovists->getShape(polyref).setCentroid(start);
                   AttributeTable& table = isovists->getAttributeTable();
                   AttributeRow& row = table.getRow(AttributeKey(polyref));
                   iso.setData(table,row, simple_version);
@@ -625,10 +635,10 @@ int MetaGraph::makeIsovistPath(Communicator *communicator, double fov, bool simp
 }
 
 // this version uses your own isovist (and assumes no communicator required for BSP tree
-bool MetaGraph::makeIsovist(const Point2f& p, Isovist& iso)
+bool MetaGraph::makeIsovist(const Point2f& p, Isovist& iso, double startangle, double endangle)
 {
    if (makeBSPtree()) {
-      iso.makeit(m_bsp_root, p, m_region);
+      iso.makeit(m_bsp_root, p, m_region, startangle, endangle);
       return true;
    }
    return false;
@@ -1276,6 +1286,7 @@ bool MetaGraph::makeFewestLineMap( Communicator *communicator, int replace )
 
 bool MetaGraph::analyseAxial( Communicator *communicator, Options options, bool ) // options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    m_state &= ~SHAPEGRAPHS;      // Clear axial map data flag (stops accidental redraw during reload) 
 
    bool analysisCompleted = false;
@@ -1296,14 +1307,17 @@ bool MetaGraph::analyseAxial( Communicator *communicator, Options options, bool
 
 bool MetaGraph::analyseSegmentsTulip( Communicator *communicator, Options options ) // <- options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    m_state &= ~SHAPEGRAPHS;      // Clear axial map data flag (stops accidental redraw during reload)
 
    bool analysisCompleted = false;
 
    try {
-       analysisCompleted = SegmentTulip(options.radius_set, options.sel_only, options.tulip_bins, options.weighted_measure_col,
-                    options.radius_type, options.choice)
-           .run(communicator, getDisplayedShapeGraph(), false);
+       auto checkpoint = depthmapX::makeCheckpoint(options);
+       SegmentTulip analysis(options.radius_set, options.sel_only, options.tulip_bins, options.weighted_measure_col,
+                    options.radius_type, options.choice);
+       analysis.setCheckpoint(checkpoint.get());
+       analysisCompleted = analysis.run(communicator, getDisplayedShapeGraph(), false);
    }
    catch (Communicator::CancelledException) {
       analysisCompleted = false;
@@ -1316,6 +1330,7 @@ bool MetaGraph::analyseSegmentsTulip( Communicator *communicator, Options option
 
 bool MetaGraph::analyseSegmentsAngular( Communicator *communicator, Options options ) // <- options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    m_state &= ~SHAPEGRAPHS;      // Clear axial map data flag (stops accidental redraw during reload)
 
    bool analysisCompleted = false;
@@ -1334,6 +1349,7 @@ bool MetaGraph::analyseSegmentsAngular( Communicator *communicator, Options opti
 
 bool MetaGraph::analyseTopoMetMultipleRadii( Communicator *communicator, Options options ) // <- options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    m_state &= ~SHAPEGRAPHS;      // Clear axial map data flag (stops accidental redraw during reload)
 
    bool analysisCompleted = true;
@@ -1361,6 +1377,7 @@ bool MetaGraph::analyseTopoMetMultipleRadii( Communicator *communicator, Options
 
 bool MetaGraph::analyseTopoMet( Communicator *communicator, Options options ) // <- options copied to keep thread safe
 {
+   depthmapX::ScopedThreadCount threadCount(size_t(std::max(options.thread_count, 0)));
    m_state &= ~SHAPEGRAPHS;      // Clear axial map data flag (stops accidental redraw during reload) 
 
    bool analysisCompleted = false;
@@ -1479,7 +1496,7 @@ int MetaGraph::loadLineData( Communicator *communicator, int load_type )
 
 void MetaGraph::writeMapShapesAsCat(ShapeMap& map, std::ostream &stream) {
     stream << "CAT" << std::endl;
-    for (auto refShape: map.getAllShapes()) {
+    for (auto refShape: std::as_const(map).getAllShapes()) {
         SalaShape& shape = refShape.second;
         if(shape.isPolyLine() || shape.isPolygon()) {
             stream << "Begin " << (shape.isPolyLine() ? "Polyline" : "Polygon") << std::endl;
@@ -1835,7 +1852,7 @@ bool MetaGraph::pushValuesToLayer(int sourcetype, int sourcelayer, int desttype,
        PointMap &vgaMap = m_pointMaps[destlayer];
 
        // first collect the lines by pixelating them using the vga map
-       std::map<int, SalaShape> &shapeMap = sourceMap.getAllShapes();
+       const std::map<int, SalaShape> &shapeMap = std::as_const(sourceMap).getAllShapes();
        for (auto &shape : shapeMap) {
            float thisval = table_in.getRow(AttributeKey(shape.first)).getValue(col_in);
            if (shape.second.isLine()) {
@@ -1902,8 +1919,7 @@ bool MetaGraph::pushValuesToLayer(int sourcetype, int sourcelayer, int desttype,
              if (!isObjectVisible(m_shapeGraphs[destlayer]->getLayers(), iter_out->getRow())) {
                 continue;
              }
-            auto shapeMap = m_shapeGraphs[destlayer]->getAllShapes();
-            gatelist = m_dataMaps[sourcelayer].shapeInPolyList(shapeMap[key_out]);
+            gatelist = m_dataMaps[sourcelayer].shapeInPolyList(m_shapeGraphs[destlayer]->getShape(key_out));
          }
          else if (desttype == VIEWDATA) {
             if (sourcelayer == destlayer) {
@@ -1913,8 +1929,7 @@ bool MetaGraph::pushValuesToLayer(int sourcetype, int sourcelayer, int desttype,
             if (!isObjectVisible(m_dataMaps[destlayer].getLayers(), iter_out->getRow())) {
                continue;
             }
-            auto dataMap = m_dataMaps[destlayer].getAllShapes();
-            gatelist = m_dataMaps[sourcelayer].shapeInPolyList(dataMap[key_out]);
+            gatelist = m_dataMaps[sourcelayer].shapeInPolyList(m_dataMaps[destlayer].getShape(key_out));
          }
          double val = -1.0;
          int count = 0;
@@ -1995,8 +2010,7 @@ bool MetaGraph::pushValuesToLayer(int sourcetype, int sourcelayer, int desttype,
             }
             std::vector<int> gatelist;
             if (desttype == VIEWDATA) {
-               auto dataMap = m_shapeGraphs[size_t(sourcelayer)]->getAllShapes();
-               gatelist = m_dataMaps[size_t(destlayer)].shapeInPolyList(dataMap[key_in]);
+               gatelist = m_dataMaps[size_t(destlayer)].shapeInPolyList(m_shapeGraphs[size_t(sourcelayer)]->getShape(key_in));
                double thisval = iter_in->getKey().value;
                if(col_in != -1) thisval = iter_in->getRow().getValue(col_in);
                for (int gate: gatelist) {
@@ -2011,8 +2025,7 @@ bool MetaGraph::pushValuesToLayer(int sourcetype, int sourcelayer, int desttype,
                }
             }
             else if (desttype == VIEWAXIAL) {
-               auto shapeMap = m_shapeGraphs[size_t(sourcelayer)]->getAllShapes();
-               gatelist = m_shapeGraphs[size_t(destlayer)]->shapeInPolyList(shapeMap[key_in]);
+               gatelist = m_shapeGraphs[size_t(destlayer)]->shapeInPolyList(m_shapeGraphs[size_t(sourcelayer)]->getShape(key_in));
                double thisval = iter_in->getKey().value;
                if(col_in != -1) thisval = iter_in->getRow().getValue(col_in);
                for (int gate: gatelist) {
@@ -2472,7 +2485,7 @@ const AttributeTableHandle& MetaGraph::getAttributeTableHandle(int type, int lay
    return *tab;
 }
 
-int MetaGraph::readFromFile( const std::string& filename )
+int MetaGraph::readFromFile( const std::string& filename, bool lazy )
 {
 
     if (filename.empty()) {
@@ -2484,14 +2497,17 @@ int MetaGraph::readFromFile( const std::string& filename )
  #else
     std::ifstream stream( filename.c_str(), std::ios::in );
  #endif
-    int result = readFromStream(stream, filename);
+    int result = readFromStream(stream, filename, lazy);
     stream.close();
     return result;
 }
 
-int MetaGraph::readFromStream( std::istream &stream, const std::string& filename )
+int MetaGraph::readFromStream( std::istream &stream, const std::string& filename, bool lazy )
 {
    m_state = 0;   // <- clear the state out
+   m_unreadMaps.clear();
+   m_lazyFilename.clear();
+   m_allLineDataOffset = -1;
 
    // clear BSP tree if it exists:
    if (m_bsp_root) {
@@ -2511,7 +2527,9 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
    if (version > METAGRAPH_VERSION) {
       return NEWER_VERSION;
    }
-   if (version < METAGRAPH_VERSION) {
+   // from 440 on the differences are in how the attribute tables and visibility graphs are laid out,
+   // which they tell themselves
+   if (version < VERSION_ALWAYS_RECORD_BINDISTANCES) {
        std::unique_ptr<mgraph440::MetaGraph> mgraph(new mgraph440::MetaGraph);
        auto result = mgraph->read(filename);
        if ( result != mgraph440::MetaGraph::OK)
@@ -2572,6 +2590,20 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
        // file is still ok, just empty
        return OK;
    }
+   std::vector<FileSection> sections;
+   if (type == 'c') {
+      // where the table of contents is, only needed if the maps are to be read lazily
+      int64_t sectionsOffset;
+      stream.read( (char *) &sectionsOffset, sizeof(sectionsOffset) );
+      if (lazy && !filename.empty()) {
+         std::streampos mark = stream.tellg();
+         stream.seekg(sectionsOffset);
+         sections = readFileSections(stream);
+         stream.clear();
+         stream.seekg(mark);
+      }
+      stream.read( &type, 1 );
+   }
    if (type == 'v') {
 
       skipVirtualMem(stream);
@@ -2612,8 +2644,19 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
          return DAMAGED_FILE;
       }
    }
+   if (!sections.empty()) {
+      // only the names of the maps for now, each is read when first asked for
+      temp_state |= readMapsLazily(stream, sections);
+      if (stream.fail()) {
+         return DAMAGED_FILE;
+      }
+      m_lazyFilename = filename;
+      m_state = temp_state;
+      m_view_class = temp_view_class;
+      return OK;
+   }
    if (type == 'p') {
-      readPointMaps( stream );
+      readPointMaps( stream, filename );
       temp_state |= POINTMAPS;
       if (!stream.eof()) {
          stream.read( &type, 1 );         
@@ -2655,6 +2698,13 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
 
 int MetaGraph::write( const std::string& filename, int version, bool currentlayer )
 {
+   // the maps not read yet have to be read first, the file may well be the one they are in and their
+   // places in it are lost once it is replaced
+   ensureMapsLoaded();
+
+   // the graph goes to a new file that then replaces the old one, never over the old one in place:
+   // visibility graphs may be mapped from it, by this process or any other
+   std::string newFilename = filename + ".new";
    std::ofstream stream;
 
    int oldstate = m_state;
@@ -2663,7 +2713,7 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
    char type;
 
    // As of MetaGraph version 70 the disk caching has been removed
-   stream.open( filename.c_str(), std::ios::binary | std::ios::out | std::ios::trunc );
+   stream.open( newFilename.c_str(), std::ios::binary | std::ios::out | std::ios::trunc );
    if (stream.fail()) {
       if (stream.rdbuf()->is_open()) {
          stream.close();
@@ -2702,27 +2752,36 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
    stream.write(&type, 1);
    FileProperties::write(stream);
 
+   // the table of contents goes at the end, once it is known where everything is
+   std::vector<FileSection> sections;
+   type = 'c';
+   stream.write(&type, 1);
+   std::streampos sectionsMark = stream.tellp();
+   int64_t sectionsOffset = 0;
+   stream.write( (char *) &sectionsOffset, sizeof(sectionsOffset) );
+
    if (currentlayer) {
       if (m_view_class & MetaGraph::VIEWVGA) {
          type = 'p';
          stream.write(&type, 1);
-         writePointMaps( stream, true );
+         writePointMaps( stream, sections, true );
       }
       else if (m_view_class & MetaGraph::VIEWAXIAL) {
          type = 'x';
          stream.write(&type, 1);
-         writeShapeGraphs( stream, true );
+         writeShapeGraphs( stream, sections, true );
       }
       else if (m_view_class & MetaGraph::VIEWDATA) {
          type = 's';
          stream.write(&type, 1);
-         writeDataMaps( stream, true );
+         writeDataMaps( stream, sections, true );
       }
    }
    else {
       if (oldstate & LINEDATA) {
          type = 'l';
          stream.write(&type, 1);
+         sections.push_back(FileSection{'l', -1, m_name, int64_t(stream.tellp())});
          dXstring::writeString(stream, m_name);
          stream.write( (char *) &m_region, sizeof(m_region) );
 
@@ -2736,23 +2795,32 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
       if (oldstate & POINTMAPS) {
          type = 'p';
          stream.write(&type, 1);
-         writePointMaps( stream );
+         writePointMaps( stream, sections );
       }
       if (oldstate & SHAPEGRAPHS) {
          type = 'x';
          stream.write(&type, 1);
-         writeShapeGraphs( stream );
+         writeShapeGraphs( stream, sections );
       }
       if (oldstate & DATAMAPS) {
          type = 's';
          stream.write(&type, 1);
-         writeDataMaps( stream );
+         writeDataMaps( stream, sections );
       }
    }
 
+   sectionsOffset = int64_t(stream.tellp());
+   writeFileSections(stream, sections);
+   stream.seekp(sectionsMark);
+   stream.write( (char *) &sectionsOffset, sizeof(sectionsOffset) );
+
    stream.close();
 
    m_state = oldstate;
+   if (stream.fail() || !depthmapX::replaceFile(newFilename, filename)) {
+      std::remove(newFilename.c_str());
+      return DISK_ERROR;
+   }
    return OK;
 }
 
@@ -2773,6 +2841,219 @@ std::streampos MetaGraph::skipVirtualMem(std::istream& stream)
    return (stream.tellg());
 }
 
+std::vector<MetaGraph::FileSection> MetaGraph::readFileSections(const std::string& filename)
+{
+   std::ifstream stream( filename.c_str(), std::ios::binary | std::ios::in );
+   char header[3];
+   stream.read( header, 3 );
+   if (stream.fail() || header[0] != 'g' || header[1] != 'r' || header[2] != 'f') {
+      return std::vector<FileSection>();
+   }
+   int version;
+   stream.read( (char *) &version, sizeof( version ) );
+   if (version < VERSION_MAP_SECTIONS || version > METAGRAPH_VERSION) {
+      return std::vector<FileSection>();
+   }
+   int state, viewClass;
+   bool showgrid, showtext;
+   stream.read( (char *) &state, sizeof(state) );
+   stream.read( (char *) &viewClass, sizeof(viewClass) );
+   stream.read( (char *) &showgrid, sizeof(showgrid) );
+   stream.read( (char *) &showtext, sizeof(showtext) );
+
+   char type = 0;
+   stream.read( &type, 1 );
+   if (type == 'x') {
+      FileProperties properties;
+      properties.read(stream);
+      stream.read( &type, 1 );
+   }
+   if (stream.fail() || type != 'c') {
+      return std::vector<FileSection>();
+   }
+   int64_t sectionsOffset;
+   stream.read( (char *) &sectionsOffset, sizeof(sectionsOffset) );
+   stream.seekg(sectionsOffset);
+   return readFileSections(stream);
+}
+
+std::vector<MetaGraph::FileSection> MetaGraph::readFileSections(std::istream& stream)
+{
+   std::vector<FileSection> sections;
+   char type = 0;
+   stream.read( &type, 1 );
+   if (stream.fail() || type != 'c') {
+      return sections;
+   }
+   int count = 0;
+   stream.read( (char *) &count, sizeof(count) );
+   for (int i = 0; i < count && !stream.fail(); i++) {
+      FileSection section;
+      stream.read( &section.type, 1 );
+      stream.read( (char *) &section.index, sizeof(section.index) );
+      section.name = dXstring::readString(stream);
+      stream.read( (char *) &section.offset, sizeof(section.offset) );
+      sections.push_back(section);
+   }
+   if (stream.fail()) {
+      sections.clear();
+   }
+   return sections;
+}
+
+void MetaGraph::writeFileSections(std::ostream& stream, const std::vector<FileSection>& sections)
+{
+   // marked like any other section so that reading sequentially stops here
+   char type = 'c';
+   stream.write( &type, 1 );
+   int count = int(sections.size());
+   stream.write( (char *) &count, sizeof(count) );
+   for (const auto& section: sections) {
+      stream.write( &section.type, 1 );
+      stream.write( (char *) &section.index, sizeof(section.index) );
+      dXstring::writeString(stream, section.name);
+      stream.write( (char *) &section.offset, sizeof(section.offset) );
+   }
+}
+
+int MetaGraph::readMapsLazily(std::istream& stream, const std::vector<FileSection>& sections)
+{
+   int state = 0;
+   unsigned int shapeGraphCount = 0;
+   bool foundAllLineMap = false;
+   for (const auto& section: sections) {
+      if (section.index == -1) {
+         // the start of a section, where the displayed map and the number of maps are
+         stream.seekg(section.offset);
+         if (section.type == 'p') {
+            stream.read((char *) &m_displayed_pointmap, sizeof(m_displayed_pointmap));
+            state |= POINTMAPS;
+         }
+         else if (section.type == 'x') {
+            m_shapeGraphs.clear();
+            // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion problems
+            unsigned int displayed_map;
+            stream.read((char *)&displayed_map,sizeof(displayed_map));
+            m_displayed_shapegraph = int(displayed_map);
+            stream.read((char *) &shapeGraphCount, sizeof(shapeGraphCount));
+            state |= SHAPEGRAPHS;
+         }
+         else if (section.type == 's') {
+            m_dataMaps.clear();
+            // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion problems
+            unsigned int displayed_map;
+            stream.read((char *)&displayed_map,sizeof(displayed_map));
+            m_displayed_datamap = size_t(displayed_map);
+            state |= DATAMAPS;
+         }
+         continue;
+      }
+      // the map itself is only a named placeholder until it is read
+      FileSection unread = section;
+      if (section.type == 'p') {
+         m_pointMaps.push_back(PointMap(m_region, m_drawingFiles, section.name));
+         unread.index = int(m_pointMaps.size() - 1);
+      }
+      else if (section.type == 'x') {
+         if (section.index >= int(shapeGraphCount)) {
+            // the data of the all-line map after all the shape graphs
+            m_allLineDataOffset = std::streamoff(section.offset);
+            continue;
+         }
+         if (section.name == "All-Line Map" || section.name == "All Line Map") {
+            m_shapeGraphs.push_back(std::unique_ptr<AllLineMap>(new AllLineMap(section.name)));
+            if (!foundAllLineMap) {
+               foundAllLineMap = true;
+               m_all_line_map = int(m_shapeGraphs.size() - 1);
+            }
+         }
+         else {
+            m_shapeGraphs.push_back(std::unique_ptr<ShapeGraph>(new ShapeGraph(section.name)));
+         }
+         unread.index = int(m_shapeGraphs.size() - 1);
+      }
+      else if (section.type == 's') {
+         m_dataMaps.emplace_back(section.name);
+         unread.index = int(m_dataMaps.size() - 1);
+      }
+      else {
+         continue;
+      }
+      m_unreadMaps.push_back(unread);
+   }
+   return state;
+}
+
+void MetaGraph::ensureMapLoaded(char type, int index)
+{
+   if (m_unreadMaps.empty()) {
+      return;
+   }
+   auto iter = std::find_if(m_unreadMaps.begin(), m_unreadMaps.end(), [type, index](const FileSection& section) {
+      return section.type == type && section.index == index;
+   });
+   if (iter != m_unreadMaps.end()) {
+      readUnreadSection(*iter);
+      m_unreadMaps.erase(iter);
+   }
+}
+
+void MetaGraph::ensureMapsLoaded(char type)
+{
+   while (!m_unreadMaps.empty()) {
+      auto iter = std::find_if(m_unreadMaps.begin(), m_unreadMaps.end(), [type](const FileSection& section) {
+         return type == 0 || section.type == type;
+      });
+      if (iter == m_unreadMaps.end()) {
+         break;
+      }
+      readUnreadSection(*iter);
+      m_unreadMaps.erase(iter);
+   }
+}
+
+void MetaGraph::readUnreadSection(const FileSection& section)
+{
+   std::ifstream stream( m_lazyFilename.c_str(), std::ios::binary | std::ios::in );
+   stream.seekg(section.offset);
+   switch (section.type) {
+   case 'p': {
+      PointMap pointMap(m_region, m_drawingFiles);
+      pointMap.read(stream, m_lazyFilename);
+      m_pointMaps[size_t(section.index)] = std::move(pointMap);
+      break;
+   }
+   case 'x': {
+      std::unique_ptr<ShapeGraph> shapeGraph;
+      AllLineMap* alllinemap = nullptr;
+      if (section.index == m_all_line_map) {
+         alllinemap = new AllLineMap();
+         shapeGraph.reset(alllinemap);
+      }
+      else {
+         shapeGraph.reset(new ShapeGraph());
+      }
+      shapeGraph->read(stream);
+      if (alllinemap != nullptr && m_allLineDataOffset != -1) {
+         stream.seekg(m_allLineDataOffset);
+         dXreadwrite::readIntoVector(stream, alllinemap->m_poly_connections);
+         dXreadwrite::readIntoVector(stream, alllinemap->m_radial_lines);
+      }
+      m_shapeGraphs[size_t(section.index)] = std::move(shapeGraph);
+      break;
+   }
+   case 's': {
+      ShapeMap dataMap;
+      dataMap.read(stream);
+      m_dataMaps[size_t(section.index)] = std::move(dataMap);
+      break;
+   }
+   }
+   if (stream.fail()) {
+      throw depthmapX::RuntimeException("Failed to read map " + section.name + " from " + m_lazyFilename);
+   }
+}
+
 std::vector<SimpleLine> MetaGraph::getVisibleDrawingLines() {
 
     std::vector<SimpleLine> lines;
@@ -2808,26 +3089,28 @@ int MetaGraph::addNewPointMap(const std::string& name)
    return m_pointMaps.size() - 1;
 }
 
-bool MetaGraph::readPointMaps(std::istream& stream)
+bool MetaGraph::readPointMaps(std::istream& stream, const std::string& filename)
 {
    stream.read((char *) &m_displayed_pointmap, sizeof(m_displayed_pointmap));
    int count;
    stream.read((char *) &count, sizeof(count));
    for (int i = 0; i < count; i++) {
       m_pointMaps.push_back(PointMap(m_region, m_drawingFiles));
-      m_pointMaps.back().read( stream );
+      m_pointMaps.back().read( stream, filename );
    }
    return true;
 }
 
-bool MetaGraph::writePointMaps(std::ofstream& stream, bool displayedmaponly)
+bool MetaGraph::writePointMaps(std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly)
 {
+   sections.push_back(FileSection{'p', -1, std::string(), int64_t(stream.tellp())});
    if (!displayedmaponly) {
       stream.write((char *) &m_displayed_pointmap, sizeof(m_displayed_pointmap));
       int count = m_pointMaps.size();
       stream.write((char *) &count, sizeof(count));
-      for (auto& pointmap: m_pointMaps) {
-         pointmap.write( stream );
+      for (int i = 0; i < count; i++) {
+         sections.push_back(FileSection{'p', i, m_pointMaps[i].getName(), int64_t(stream.tellp())});
+         m_pointMaps[i].write( stream );
       }
    }
    else {
@@ -2839,6 +3122,7 @@ bool MetaGraph::writePointMaps(std::ofstream& stream, bool displayedmaponly)
       dummy = 1;
       stream.write((char *) &dummy, sizeof(dummy));
       //
+      sections.push_back(FileSection{'p', 0, m_pointMaps[m_displayed_pointmap].getName(), int64_t(stream.tellp())});
       m_pointMaps[m_displayed_pointmap].write(stream);
    }
    return true;
@@ -2863,8 +3147,9 @@ bool MetaGraph::readDataMaps(std::istream& stream )
     return true;
 }
 
-bool MetaGraph::writeDataMaps( std::ofstream& stream, bool displayedmaponly )
+bool MetaGraph::writeDataMaps( std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly )
 {
+   sections.push_back(FileSection{'s', -1, std::string(), int64_t(stream.tellp())});
    if (!displayedmaponly) {
       // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion problems
       unsigned int displayed_map = (unsigned int)(m_displayed_datamap);
@@ -2874,6 +3159,7 @@ bool MetaGraph::writeDataMaps( std::ofstream& stream, bool displayedmaponly )
       unsigned int count = (unsigned int) m_dataMaps.size();
       stream.write((char *) &count, sizeof(count));
       for (size_t j = 0; j < count; j++) {
+         sections.push_back(FileSection{'s', int(j), m_dataMaps[j].getName(), int64_t(stream.tellp())});
          m_dataMaps[j].write(stream);
       }
    }
@@ -2886,6 +3172,7 @@ bool MetaGraph::writeDataMaps( std::ofstream& stream, bool displayedmaponly )
       dummy = 1;
       stream.write((char *)&dummy,sizeof(dummy));
       // write map:
+      sections.push_back(FileSection{'s', 0, m_dataMaps[m_displayed_datamap].getName(), int64_t(stream.tellp())});
       m_dataMaps[m_displayed_datamap].write(stream);
    }
    return true;
@@ -2969,17 +3256,20 @@ bool MetaGraph::readShapeGraphs(std::istream& stream)
     return true;
 }
 
-bool MetaGraph::writeShapeGraphs( std::ofstream& stream, bool displayedmaponly )
+bool MetaGraph::writeShapeGraphs( std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly )
 {
+    sections.push_back(FileSection{'x', -1, std::string(), int64_t(stream.tellp())});
+    unsigned int count = 1;
     if (!displayedmaponly) {
         // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion problems
         unsigned int displayed_map = (unsigned int)(getDisplayedShapeGraphRef());
         stream.write((char *)&displayed_map,sizeof(displayed_map));
         // write maps
         // n.b. -- do not change to size_t as will cause 32-bit to 64-bit conversion problems
-        unsigned int count = (unsigned int) m_shapeGraphs.size();
+        count = (unsigned int) m_shapeGraphs.size();
         stream.write((char *) &count, sizeof(count));
         for (size_t j = 0; j < count; j++) {
+            sections.push_back(FileSection{'x', int(j), m_shapeGraphs[j]->getName(), int64_t(stream.tellp())});
             m_shapeGraphs[j]->write(stream);
         }
     }
@@ -2992,9 +3282,13 @@ bool MetaGraph::writeShapeGraphs( std::ofstream& stream, bool displayedmaponly )
         dummy = 1;
         stream.write((char *)&dummy,sizeof(dummy));
         // write map:
+        sections.push_back(FileSection{'x', 0, m_shapeGraphs[getDisplayedShapeGraphRef()]->getName(), int64_t(stream.tellp())});
         m_shapeGraphs[getDisplayedShapeGraphRef()]->write(stream);
     }
 
+    // the all-line map data follows the maps
+    sections.push_back(FileSection{'x', int(count), std::string(), int64_t(stream.tellp())});
+
     if(m_all_line_map == -1) {
         std::vector<PolyConnector> temp_poly_connections;
         std::vector<RadialLine> temp_radial_lines;
@@ -49,6 +49,18 @@ class Communicator;
 
 class MetaGraph : public FileProperties
 {
+public:
+   // An entry in the table of contents at the end of a graph file (from VERSION_MAP_SECTIONS on): where a
+   // section of the file starts (index -1) or one of its maps. The type is that of the section, 'l' for
+   // the drawing layers, 'p' point maps, 'x' shape graphs and 's' data maps. After its maps the shape
+   // graph section has the data of the all-line map, recorded as the map after the last one
+   struct FileSection
+   {
+      char type;
+      int index;
+      std::string name;
+      int64_t offset;
+   };
 private:
     QtRegion m_region;  // easier public for now
     std::string m_name;
@@ -120,13 +132,14 @@ private:
 
    void removePointMap(int i)
    {
+       ensureMapsLoaded('p');
        if (m_displayed_pointmap >= i) m_displayed_pointmap--;
        if(m_displayed_pointmap < 0) m_displayed_pointmap = 0;
        m_pointMaps.erase(m_pointMaps.begin() + i);
    }
 
-   bool readPointMaps(std::istream &stream);
-   bool writePointMaps(std::ofstream& stream, bool displayedmaponly = false );
+   bool readPointMaps(std::istream &stream, const std::string& filename = std::string());
+   bool writePointMaps(std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly = false );
 
    std::recursive_mutex mLock;
 public:
@@ -154,7 +167,7 @@ public:
    bool clearPoints();
    bool setGrid( double spacing, const Point2f& offset = Point2f() );                 // override of PointMap
    bool makePoints( const Point2f& p, int semifilled, Communicator *communicator = NULL);  // override of PointMap
-   bool makeGraph( Communicator *communicator, int algorithm, double maxdist );
+   bool makeGraph( Communicator *communicator, int algorithm, double maxdist, bool compact = false );
    bool unmakeGraph(bool removeLinks);
    bool analyseGraph(Communicator *communicator, Options options , bool simple_version); // <- options copied to keep thread safe
    //
@@ -226,7 +239,7 @@ public:
    { return m_displayed_datamap; }
 
    void removeDataMap(size_t i)
-   { if (m_displayed_datamap >= i && i > 0) m_displayed_datamap--; m_dataMaps.erase(m_dataMaps.begin() + i); }
+   { ensureMapsLoaded('s'); if (m_displayed_datamap >= i && i > 0) m_displayed_datamap--; m_dataMaps.erase(m_dataMaps.begin() + i); }
 
    void setDisplayedDataMapRef(size_t map)
    {
@@ -263,19 +276,20 @@ public:
 
    void removeShapeGraph(int i)
    {
+       ensureMapsLoaded('x');
        if (m_displayed_shapegraph >= i) m_displayed_shapegraph--;
        if(m_displayed_shapegraph < 0) m_displayed_shapegraph = 0;
        m_shapeGraphs.erase(m_shapeGraphs.begin() + i);
    }
 
    bool readShapeGraphs(std::istream &stream);
-   bool writeShapeGraphs(std::ofstream& stream, bool displayedmaponly = false );
+   bool writeShapeGraphs(std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly = false );
 
    std::vector<ShapeMap>& getDataMaps()
    { return m_dataMaps; }
 
    bool readDataMaps(std::istream &stream);
-   bool writeDataMaps(std::ofstream& stream, bool displayedmaponly = false );
+   bool writeDataMaps(std::ofstream& stream, std::vector<FileSection>& sections, bool displayedmaponly = false );
 
    //
    int getDisplayedMapType();
@@ -477,18 +491,46 @@ public:
    int makeIsovist(Communicator *communicator, const Point2f& p, double startangle = 0, double endangle = 0, bool simple_version = true);
    // returns 0: fail, 1: made isovist, 2: made isovist and added new shapemap layer
    int makeIsovistPath(Communicator *communicator, double fov_angle = 2.0 * M_PI, bool simple_version = true);
-   bool makeIsovist(const Point2f& p, Isovist& iso);
+   // makes the isovist without adding it to a map
+   bool makeIsovist(const Point2f& p, Isovist& iso, double startangle = 0, double endangle = 0);
 protected:
    // properties
 public:
    // a few read-write returns:
    enum { OK, WARN_BUGGY_VERSION, WARN_CONVERTED, NOT_A_GRAPH, DAMAGED_FILE, DISK_ERROR, NEWER_VERSION, DEPRECATED_VERSION };
    // likely to use communicator if too slow...
-   int readFromFile( const std::string& filename );
-   int readFromStream( std::istream &stream, const std::string& filename );
+   // With lazy set (and a file from VERSION_MAP_SECTIONS on) only the drawing layers and the names of
+   // the maps are read, the maps themselves are empty placeholders until ensureMapLoaded or
+   // ensureMapsLoaded reads them from the file (as writing the graph does). The getters never read,
+   // so it is only meant for looking at a map or two of a large file
+   int readFromFile( const std::string& filename, bool lazy = false );
+   int readFromStream( std::istream &stream, const std::string& filename, bool lazy = false );
    int write( const std::string& filename, int version, bool currentlayer = false);
    //
    std::vector<SimpleLine> getVisibleDrawingLines();
+
+   // the table of contents of a graph file, empty if it was written before VERSION_MAP_SECTIONS
+   static std::vector<FileSection> readFileSections(const std::string& filename);
+
+   // read the map of the section type ('p', 'x' or 's') and index given if a lazy read left it for
+   // later, or every map left (or only those of the section type given). These read from the file and
+   // throw a RuntimeException if that fails, so call them before handing the graph to anything that
+   // reads it, rather than from anywhere the graph is being looked at
+   void ensureMapLoaded(char type, int index);
+   void ensureMapsLoaded(char type = 0);
+   bool hasUnreadMaps() const
+   { return !m_unreadMaps.empty(); }
 protected:
    std::streampos skipVirtualMem(std::istream &stream);
+
+private:
+   // the file and the sections of the maps that a lazy read has not read yet
+   std::string m_lazyFilename;
+   std::vector<FileSection> m_unreadMaps;
+   std::streamoff m_allLineDataOffset = -1;
+
+   void readUnreadSection(const FileSection& section);
+   int readMapsLazily(std::istream &stream, const std::vector<FileSection>& sections);
+   static std::vector<FileSection> readFileSections(std::istream &stream);
+   static void writeFileSections(std::ostream &stream, const std::vector<FileSection>& sections);
 };
@@ -19,9 +19,12 @@
 // Human readable(ish) metagraph version changes
 
 const int VERSION_ALWAYS_RECORD_BINDISTANCES    = 440;
+const int VERSION_ATTRIBUTE_COLUMNS             = 441;
+const int VERSION_MAP_SECTIONS                  = 442;
+const int VERSION_VISIBILITY_GRAPH_BLOCK        = 443;
 
 // Current metagraph version
-const int METAGRAPH_VERSION = VERSION_ALWAYS_RECORD_BINDISTANCES;
+const int METAGRAPH_VERSION = VERSION_VISIBILITY_GRAPH_BLOCK;
 
 ///////////////////////////////////////////////////////////////////////////////
 
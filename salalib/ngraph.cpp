@@ -23,6 +23,7 @@
 #include <salalib/pointdata.h>
 #include <salalib/ngraph.h>
 #include "genlib/containerutils.h"
+#include "genlib/exceptions.h"
 
 void Node::make(const PixelRef pix, PixelRefVector *bins, float *bin_far_dists, int q_octants)
 {
@@ -206,19 +207,200 @@ std::istream& Node::read(std::istream& stream)
    return stream;
 }
 
-std::ostream& Node::write(std::ostream& stream)
+namespace {
+   // a bin in a visibility graph block, its runs and occlusions following those of the bins before
+   struct BinRecord {
+      float distance;
+      float occDistance;
+      unsigned short nodeCount;
+      char dir;
+      char unused;
+      uint32_t runCount;
+      uint32_t occlusionCount;
+   };
+
+   static_assert(sizeof(PixelVec) == 8 && sizeof(PixelRef) == 4 && sizeof(BinRecord) == 20,
+                 "visibility graph blocks are laid out assuming these sizes");
+
+   struct BlockLayout {
+      int64_t nodeCount;
+      int64_t runCount;
+      int64_t occlusionCount;
+      size_t binCount() const
+      { return size_t(nodeCount) * 32; }
+      // the offsets of the first run and occlusion of each node (and the totals after the last), the
+      // bins, the runs and the occlusions, the first three 8-byte aligned
+      size_t runOffsetsStart() const
+      { return 0; }
+      size_t occlusionOffsetsStart() const
+      { return (size_t(nodeCount) + 1) * sizeof(uint64_t); }
+      size_t binsStart() const
+      { return 2 * (size_t(nodeCount) + 1) * sizeof(uint64_t); }
+      size_t runsStart() const
+      { return binsStart() + binCount() * sizeof(BinRecord); }
+      size_t occlusionsStart() const
+      { return runsStart() + size_t(runCount) * sizeof(PixelVec); }
+      size_t size() const
+      { return occlusionsStart() + size_t(occlusionCount) * sizeof(PixelRef); }
+   };
+}
+
+std::ostream& Node::writeBlock(std::ostream& stream, const std::vector<const Node *>& nodes)
 {
-   int i;
-   for (i = 0; i < 32; i++) {
-      m_bins[i].write(stream);
+   BlockLayout layout{int64_t(nodes.size()), 0, 0};
+   for (const Node *node: nodes) {
+      for (int i = 0; i < 32; i++) {
+         layout.runCount += int64_t(node->m_bins[i].m_pixel_vecs.size());
+         layout.occlusionCount += int64_t(node->m_occlusion_bins[i].size());
+      }
    }
-
-   for (i = 0; i < 32; i++) {
-      dXreadwrite::writeVector(stream, m_occlusion_bins[i]);
+   stream.write((char *) &layout.nodeCount, sizeof(layout.nodeCount));
+   stream.write((char *) &layout.runCount, sizeof(layout.runCount));
+   stream.write((char *) &layout.occlusionCount, sizeof(layout.occlusionCount));
+
+   // pad to where the file is 8-byte aligned, so that the block can be used where it is mapped
+   char padding = char((8 - (int64_t(stream.tellp()) + 1) % 8) % 8);
+   stream.write(&padding, sizeof(padding));
+   const char zeros[8] = {0};
+   stream.write(zeros, padding);
+
+   uint64_t offset = 0;
+   for (const Node *node: nodes) {
+      stream.write((char *) &offset, sizeof(offset));
+      for (int i = 0; i < 32; i++) {
+         offset += node->m_bins[i].m_pixel_vecs.size();
+      }
+   }
+   stream.write((char *) &offset, sizeof(offset));
+   offset = 0;
+   for (const Node *node: nodes) {
+      stream.write((char *) &offset, sizeof(offset));
+      for (int i = 0; i < 32; i++) {
+         offset += node->m_occlusion_bins[i].size();
+      }
+   }
+   stream.write((char *) &offset, sizeof(offset));
+   for (const Node *node: nodes) {
+      for (int i = 0; i < 32; i++) {
+         const Bin& bin = node->m_bins[i];
+         BinRecord record{bin.m_distance, bin.m_occ_distance, bin.m_node_count, bin.m_dir, 0,
+                          uint32_t(bin.m_pixel_vecs.size()), uint32_t(node->m_occlusion_bins[i].size())};
+         stream.write((char *) &record, sizeof(record));
+      }
+   }
+   for (const Node *node: nodes) {
+      for (int i = 0; i < 32; i++) {
+         const PixelVecs& vecs = node->m_bins[i].m_pixel_vecs;
+         stream.write((const char *) vecs.begin(), std::streamsize(vecs.size() * sizeof(PixelVec)));
+      }
+   }
+   for (const Node *node: nodes) {
+      for (int i = 0; i < 32; i++) {
+         const std::vector<PixelRef>& occlusions = node->m_occlusion_bins[i];
+         stream.write((const char *) occlusions.data(), std::streamsize(occlusions.size() * sizeof(PixelRef)));
+      }
    }
    return stream;
 }
 
+std::shared_ptr<depthmapX::MappedBlock> Node::readBlock(std::istream& stream, const std::vector<Node *>& nodes,
+                                                       const std::string& filename)
+{
+   BlockLayout layout;
+   stream.read((char *) &layout.nodeCount, sizeof(layout.nodeCount));
+   stream.read((char *) &layout.runCount, sizeof(layout.runCount));
+   stream.read((char *) &layout.occlusionCount, sizeof(layout.occlusionCount));
+   char padding = 0;
+   stream.read(&padding, sizeof(padding));
+   stream.ignore(padding);
+   if (stream.fail() || layout.nodeCount != int64_t(nodes.size()) || layout.runCount < 0 || layout.occlusionCount < 0) {
+      throw depthmapX::RuntimeException("Failed to read visibility graph block");
+   }
+
+   // mapped from the file where possible, otherwise read in whole
+   std::shared_ptr<depthmapX::MappedBlock> block;
+   if (!filename.empty()) {
+      block = depthmapX::MappedBlock::map(filename, int64_t(stream.tellg()), layout.size());
+   }
+   if (block) {
+      stream.seekg(std::streamoff(layout.size()), std::ios::cur);
+   }
+   else {
+      block = depthmapX::MappedBlock::read(stream, layout.size());
+   }
+   if (!block) {
+      throw depthmapX::RuntimeException("Failed to read visibility graph block");
+   }
+
+   const uint64_t *runOffsets = reinterpret_cast<const uint64_t *>(block->data() + layout.runOffsetsStart());
+   const uint64_t *occlusionOffsets = reinterpret_cast<const uint64_t *>(block->data() + layout.occlusionOffsetsStart());
+   const BinRecord *records = reinterpret_cast<const BinRecord *>(block->data() + layout.binsStart());
+   const PixelVec *runs = reinterpret_cast<const PixelVec *>(block->data() + layout.runsStart());
+   const PixelRef *occlusions = reinterpret_cast<const PixelRef *>(block->data() + layout.occlusionsStart());
+   if (runOffsets[layout.nodeCount] != uint64_t(layout.runCount) ||
+       occlusionOffsets[layout.nodeCount] != uint64_t(layout.occlusionCount)) {
+      throw depthmapX::RuntimeException("Visibility graph block does not match its header");
+   }
+
+   const BinRecord *record = records;
+   for (size_t n = 0; n < nodes.size(); n++) {
+      Node *node = nodes[n];
+      uint64_t run = runOffsets[n];
+      uint64_t occlusion = occlusionOffsets[n];
+      if (runOffsets[n + 1] > uint64_t(layout.runCount) || occlusionOffsets[n + 1] > uint64_t(layout.occlusionCount)) {
+         throw depthmapX::RuntimeException("Visibility graph block does not match its header");
+      }
+      for (int i = 0; i < 32; i++, record++) {
+         if (run + record->runCount > runOffsets[n + 1] ||
+             occlusion + record->occlusionCount > occlusionOffsets[n + 1]) {
+            throw depthmapX::RuntimeException("Visibility graph block does not match its header");
+         }
+         Bin& bin = node->m_bins[i];
+         bin.m_distance = record->distance;
+         bin.m_occ_distance = record->occDistance;
+         bin.m_node_count = record->nodeCount;
+         bin.m_dir = record->dir;
+         bin.m_pixel_vecs.view(runs + run, record->runCount);
+         node->m_occlusion_bins[i].assign(occlusions + occlusion, occlusions + occlusion + record->occlusionCount);
+         run += record->runCount;
+         occlusion += record->occlusionCount;
+      }
+      if (run != runOffsets[n + 1] || occlusion != occlusionOffsets[n + 1]) {
+         throw depthmapX::RuntimeException("Visibility graph block does not match its header");
+      }
+   }
+   return block;
+}
+
+void Node::ownBlock()
+{
+   for (int i = 0; i < 32; i++) {
+      m_bins[i].m_pixel_vecs.own();
+   }
+}
+
+size_t Node::runCount() const
+{
+   size_t count = 0;
+   for (int i = 0; i < 32; i++) {
+      count += m_bins[i].m_pixel_vecs.size();
+   }
+   return count;
+}
+
+void Node::moveRunsInto(std::vector<PixelVec>& runs)
+{
+   for (int i = 0; i < 32; i++) {
+      PixelVecs& vecs = m_bins[i].m_pixel_vecs;
+      if (vecs.empty()) {
+         continue;
+      }
+      size_t start = runs.size();
+      runs.insert(runs.end(), vecs.begin(), vecs.end());
+      vecs.view(runs.data() + start, runs.size() - start);
+   }
+}
+
 std::ostream& operator << (std::ostream& stream, const Node& node)
 {
    for (int i = 0; i < 32; i++) {
@@ -444,33 +626,6 @@ std::istream& Bin::read(std::istream& stream)
    return stream;
 }
 
-std::ostream& Bin::write(std::ostream& stream)
-{
-   stream.write( (char *) &m_dir, sizeof(m_dir) );
-   stream.write( (char *) &m_node_count, sizeof(m_node_count) );
-
-   stream.write( (char *) &m_distance, sizeof(m_distance) );
-   stream.write( (char *) &m_occ_distance, sizeof(m_occ_distance) );
-
-   if (m_node_count) {
-
-      if (m_dir & PixelRef::DIAGONAL) {
-         m_pixel_vecs[0].write(stream,m_dir);
-      }
-      else {
-         // TODO: Remove this limitation in the next version of the .graph format
-         unsigned short length = m_pixel_vecs.size();
-         stream.write( (char *) &length, sizeof(length) );
-         m_pixel_vecs[0].write(stream,m_dir);
-         for (int i = 1; i < length; i++) {
-            m_pixel_vecs[i].write(stream,m_dir,m_pixel_vecs[i-1]);
-         }
-      }
-   }
-
-   return stream;
-}
-
 std::ostream& operator << (std::ostream& stream, const Bin& bin)
 {
    int c = 0;
@@ -514,25 +669,6 @@ std::istream& PixelVec::read(std::istream& stream, const char dir)
    return stream;
 }
 
-std::ostream& PixelVec::write(std::ostream& stream, const char dir)
-{
-   stream.write((char *) &m_start, sizeof(m_start));
-   unsigned short runlength;
-   switch (dir) {
-      case PixelRef::HORIZONTAL:
-      case PixelRef::POSDIAGONAL:
-      case PixelRef::NEGDIAGONAL:
-         runlength = m_end.x - m_start.x;
-         break;
-      case PixelRef::VERTICAL:
-         runlength = m_end.y - m_start.y;
-         break;
-   }
-   stream.write((char *) &runlength, sizeof(runlength));
-
-   return stream;
-}
-
 struct ShiftLength {
    unsigned short shift : 4;
    unsigned short runlength : 12;
@@ -561,23 +697,3 @@ std::istream& PixelVec::read(std::istream& stream, const char dir, const PixelVe
 
    return stream;
 }
-   
-std::ostream& PixelVec::write(std::ostream& stream, const char dir, const PixelVec& context)
-{
-   ShiftLength shiftlength;
-   switch (dir) {
-      case PixelRef::HORIZONTAL:
-         stream.write((char *) &(m_start.x), sizeof(m_start.x));
-         shiftlength.runlength = m_end.x - m_start.x;
-         shiftlength.shift = m_start.y - context.m_start.y;
-         break;
-      case PixelRef::VERTICAL:
-         stream.write((char *) &(m_start.y), sizeof(m_start.y));
-         shiftlength.runlength = m_end.y - m_start.y;
-         shiftlength.shift = m_start.x - context.m_start.x;
-         break;
-   }
-   stream.write((char *) &shiftlength, sizeof(shiftlength));
-
-   return stream;
-}
@@ -21,6 +21,9 @@
 
 #include "salalib/pixelref.h"
 
+#include "genlib/mappedblock.h"
+
+#include <memory>
 #include <set>
 
 class PointMap;
@@ -41,8 +44,47 @@ struct PixelVec
    //
    std::istream &read(std::istream &stream, const char dir);
    std::istream &read(std::istream &stream, const char dir, const PixelVec& context);
-   std::ostream &write(std::ostream &stream, const char dir);
-   std::ostream &write(std::ostream &stream, const char dir, const PixelVec& context);
+};
+
+// The runs of pixels a bin sees. A bin made here keeps its own, one read from a visibility graph block
+// only views those in the block, until it is changed
+class PixelVecs
+{
+public:
+   const PixelVec *begin() const
+   { return m_view ? m_view : m_vecs.data(); }
+   const PixelVec *end() const
+   { return begin() + size(); }
+   size_t size() const
+   { return m_view ? m_view_size : m_vecs.size(); }
+   bool empty() const
+   { return size() == 0; }
+   const PixelVec& operator [] (size_t i) const
+   { return begin()[i]; }
+   PixelVec& operator [] (size_t i)
+   { own(); return m_vecs[i]; }
+   PixelVec& back()
+   { own(); return m_vecs.back(); }
+   void push_back(const PixelVec& vec)
+   { own(); m_vecs.push_back(vec); }
+   void clear()
+   { m_view = nullptr; m_view_size = 0; m_vecs.clear(); }
+   PixelVecs& operator = (std::vector<PixelVec>&& vecs)
+   { m_view = nullptr; m_view_size = 0; m_vecs = std::move(vecs); return *this; }
+   void view(const PixelVec *vecs, size_t size)
+   { m_vecs = std::vector<PixelVec>(); m_view = vecs; m_view_size = size; }
+   bool isView() const
+   { return m_view != nullptr; }
+   // what the runs kept by the bin take up, nothing while viewing
+   size_t allocatedSize() const
+   { return m_vecs.capacity() * sizeof(PixelVec); }
+   // stop viewing the runs and keep a copy instead
+   void own()
+   { if (m_view) { m_vecs.assign(m_view, m_view + m_view_size); m_view = nullptr; m_view_size = 0; } }
+private:
+   std::vector<PixelVec> m_vecs;
+   const PixelVec *m_view = nullptr;
+   size_t m_view_size = 0;
 };
 
 class Bin
@@ -54,7 +96,7 @@ protected:
    float m_occ_distance;
 public:
    char m_dir;
-   std::vector<PixelVec> m_pixel_vecs;
+   PixelVecs m_pixel_vecs;
    Bin()
    { m_dir = PixelRef::NODIR; m_node_count = 0; m_distance = 0.0f; m_occ_distance = 0.0f; }
    //
@@ -87,7 +129,6 @@ public:
    PixelRef cursor() const;
    //
    std::istream &read(std::istream &stream);
-   std::ostream &write(std::ostream &stream);
    //
    friend std::ostream& operator << (std::ostream& stream, const Bin& bin);
 };
@@ -142,8 +183,25 @@ public:
    bool is_tail() const;
    PixelRef cursor() const;
    //
+   // from before VERSION_VISIBILITY_GRAPH_BLOCK each node was kept with its point
    std::istream &read(std::istream &stream);
-   std::ostream &write(std::ostream &stream);
+   //
+   // The visibility graph of a whole point map kept as one block: the bins of every node in order, with
+   // the runs of pixels they see (and their occlusions) each kept in a single array that the bins index
+   // into by offset, in compressed sparse row fashion. Nothing in it depends on where it is, so it can be
+   // mapped straight from the file and traversed where it lies. The block read is returned, as the bins
+   // of the nodes read view the runs in it
+   static std::ostream &writeBlock(std::ostream &stream, const std::vector<const Node *>& nodes);
+   static std::shared_ptr<depthmapX::MappedBlock> readBlock(std::istream &stream, const std::vector<Node *>& nodes,
+                                                            const std::string& filename = std::string());
+   // stop viewing the block read, keeping a copy of the runs instead
+   void ownBlock();
+   //
+   // the runs of all the bins
+   size_t runCount() const;
+   // appends the runs of the bins to runs, which has to have room for them so that it does not grow,
+   // and has the bins view them there rather than keep them each in their own allocation
+   void moveRunsInto(std::vector<PixelVec>& runs);
    //
    friend std::ostream& operator << (std::ostream& stream, const Node& node);
 };
@@ -53,6 +53,13 @@ struct Options
    int weighted_measure_col2;  //EFEF
     int routeweight_col;			//EFEF
    std::string output_file; // To save an output graph (for example)
+   // threads to spread the analysis over, 0 for the program wide setting
+   int thread_count;
+   // for the analyses that can carry on after being stopped: the file to keep their progress in,
+   // how often to save it (in seconds) and whether to carry on from it
+   std::string checkpoint_file;
+   double checkpoint_interval;
+   bool resume;
    // default values
    Options()
    { local = 0; global = 1; cliques = 0;
@@ -61,5 +68,7 @@ struct Options
      radius = -1; radius_type = 0;
      output_type = OUTPUT_ISOVIST; process_in_memory = false; gates_only = false; sel_only = false;
      gatelayer = -1;
-     weighted_measure_col = -1;}
+     weighted_measure_col = -1;
+     thread_count = 0;
+     checkpoint_interval = 600; resume = false;}
 };
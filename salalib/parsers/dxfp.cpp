@@ -20,12 +20,18 @@
 #include "dxfp.h"
 
 #include "genlib/comm.h"  // for communicator
-#include "genlib/stringutils.h"
+#include "genlib/parallel.h"
 
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 
 static int counter = 0;
 
@@ -53,6 +59,7 @@ DxfParser::DxfParser(Communicator *comm /* = NULL */)
    m_communicator = comm;
    m_size = 0;
    m_time = 0;
+   m_thread_count = depthmapX::getThreadCount();
 }
 
 const DxfVertex& DxfParser::getExtMin() const
@@ -65,30 +72,38 @@ const DxfVertex& DxfParser::getExtMax() const
    return m_region.getExtMax();
 }
 
-DxfLayer *DxfParser::getLayer( const std::string& layer_name ) // const <- removed as m_layers may be changed if DXF is poor
+DxfLayer *DxfParser::getLayer( std::string_view layer_name ) // const <- removed as m_layers may be changed if DXF is poor
 {
-   std::map<std::string, DxfLayer>::iterator layerIter = m_layers.find(layer_name);
+   auto layerIter = m_layers.find(layer_name);
    if (layerIter == m_layers.end()) {
-      m_layers.insert( std::pair<std::string, DxfLayer> (layer_name, DxfLayer(layer_name)));
-      return &(m_layers.find(layer_name)->second);
+      std::string name(layer_name);
+      layerIter = m_layers.insert( std::pair<std::string, DxfLayer> (name, DxfLayer(name))).first;
    }
    return &(layerIter->second);
 }
 
-DxfLineType *DxfParser::getLineType( const std::string& line_type_name )  // const <- removed as m_layers may be changed if DXF is poor
+DxfLineType *DxfParser::getLineType( std::string_view line_type_name )  // const <- removed as m_layers may be changed if DXF is poor
 {
-   static DxfLineType line_type;
-
-   line_type.m_name = line_type_name;
-
-   std::map<std::string, DxfLineType>::iterator lineTypeIter = m_line_types.find(line_type_name);
+   auto lineTypeIter = m_line_types.find(line_type_name);
    if (lineTypeIter == m_line_types.end()) {
-      m_line_types.insert( std::pair<std::string, DxfLineType> (line_type_name, line_type));
-      return &(m_line_types.find(line_type_name)->second);
+      std::string name(line_type_name);
+      lineTypeIter = m_line_types.insert( std::pair<std::string, DxfLineType> (name, DxfLineType(name))).first;
    }
    return &(lineTypeIter->second);
 }
 
+DxfBlock *DxfParser::findBlock( const std::string& block_name )
+{
+   if (m_parent != NULL) {
+      return m_parent->findBlock( block_name );
+   }
+   auto blockIter = m_blocks.find(block_name);
+   if (blockIter == m_blocks.end()) {
+      return NULL;
+   }
+   return &(blockIter->second);
+}
+
 size_t DxfParser::numLayers() const
 {
    return m_layers.size();
@@ -103,18 +118,29 @@ size_t DxfParser::numLineTypes() const
 
 std::istream& operator >> (std::istream& stream, DxfParser& dxfp)
 {
-   if (dxfp.m_communicator)
+   return dxfp.open( stream );
+}
+
+std::istream& DxfParser::open( std::istream& stream, const std::string& filename )
+{
+   std::shared_ptr<depthmapX::MappedBlock> text = depthmapX::MappedBlock::mapFile( filename );
+   if (!text) {
+      text = depthmapX::MappedBlock::readAll( stream );
+   }
+
+   if (m_communicator)
    {
-      long size = static_cast<long>(dxfp.m_communicator->GetInfileSize());
-      dxfp.m_communicator->CommPostMessage( Communicator::NUM_RECORDS, size );
+      m_communicator->CommPostMessage( Communicator::NUM_RECORDS, static_cast<long>(text->size()) );
 
-      qtimer( dxfp.m_time, 0 );
+      qtimer( m_time, 0 );
    }
 
-   return dxfp.open( stream );
+   DxfTokenStream tokens( text->data(), text->data() + text->size() );
+   open( tokens );
+   return stream;
 }
 
-std::istream& DxfParser::open( std::istream& stream )
+void DxfParser::open( DxfTokenStream& stream )
 {
    DxfToken token;
    int section = UNIDENTIFIED;
@@ -168,7 +194,7 @@ std::istream& DxfParser::open( std::istream& stream )
             section = UNIDENTIFIED;
             break;
          case ENTITIES:
-            openEntities( stream, token ); // I'm adding the token here as before the function was unsafe, but I'm not sure reuse of this token is a good idea AT 29-APR-11
+            openEntitiesInChunks( stream, token ); // I'm adding the token here as before the function was unsafe, but I'm not sure reuse of this token is a good idea AT 29-APR-11
             section = UNIDENTIFIED;
             break;
          default:
@@ -198,12 +224,11 @@ std::istream& DxfParser::open( std::istream& stream )
          m_region.merge( layer.second );
       }
    }
-   return stream;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void DxfParser::openHeader( std::istream& stream )
+void DxfParser::openHeader( DxfTokenStream& stream )
 {
    DxfToken token;
    int subsection = UNIDENTIFIED;
@@ -265,7 +290,7 @@ void DxfParser::openHeader( std::istream& stream )
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void DxfParser::openTables( std::istream& stream )
+void DxfParser::openTables( DxfTokenStream& stream )
 {
    DxfToken token;
    int subsection = UNIDENTIFIED;
@@ -359,7 +384,7 @@ void DxfParser::openTables( std::istream& stream )
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void DxfParser::openBlocks( std::istream& stream )
+void DxfParser::openBlocks( DxfTokenStream& stream )
 {
    DxfToken token;
    int subsection = UNIDENTIFIED;
@@ -420,7 +445,7 @@ void DxfParser::openBlocks( std::istream& stream )
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *block )
+void DxfParser::openEntities( DxfTokenStream& stream, DxfToken& token, DxfBlock *block )
 {
    int subsection = UNIDENTIFIED;
    if (token.code == 0) {
@@ -477,6 +502,11 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
             else {
                subsection = UNIDENTIFIED;
             }
+            if (block == NULL && !m_layer_filter.empty() && subsection != ENDSEC && subsection != UNIDENTIFIED
+                && !isOnFilteredLayer( stream )) {
+               // skip over the entity to the next one
+               subsection = UNIDENTIFIED;
+            }
             break;
          case POINT:
             stream >> token;
@@ -484,7 +514,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
             if ( point.parse( token, this ) ) {
                DxfLayer *layer = block;
                if (layer == NULL) {
-                  layer = point.m_p_layer;
+                  layer = entityLayer( point );
                }
                layer->m_points.push_back( point );
                layer->merge(point); // <- merge bounding box
@@ -500,7 +530,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
                if (line.m_start != line.m_end) {
                   DxfLayer *layer = block;
                   if (layer == NULL) {
-                     layer = line.m_p_layer;
+                     layer = entityLayer( line );
                   }
                   layer->m_lines.push_back( line );
                   layer->merge(line); // <- merge bounding box
@@ -517,7 +547,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
                if (poly_line.m_vertex_count > 0) {
                   DxfLayer *layer = block;
                   if (layer == NULL) {
-                     layer = poly_line.m_p_layer;
+                     layer = entityLayer( poly_line );
                   }
                   layer->m_poly_lines.push_back( poly_line );
                   size_t line_count = (poly_line.getAttributes() & DxfPolyLine::CLOSED) ?
@@ -537,7 +567,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
                if (lw_poly_line.m_vertex_count > 0) {
                   DxfLayer *layer = block;
                   if (layer == NULL) {
-                     layer = lw_poly_line.m_p_layer;
+                     layer = entityLayer( lw_poly_line );
                   }
                   layer->m_poly_lines.push_back( lw_poly_line );
                   size_t line_count = (lw_poly_line.getAttributes() & DxfPolyLine::CLOSED) ?
@@ -555,7 +585,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
             if ( arc.parse( token, this ) ) {
                DxfLayer *layer = block;
                if (layer == NULL) {
-                  layer = arc.m_p_layer;
+                  layer = entityLayer( arc );
                }
                layer->m_arcs.push_back( arc );
                layer->merge(arc);
@@ -569,7 +599,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
              if ( ellipse.parse( token, this ) ) {
                 DxfLayer *layer = block;
                 if (layer == NULL) {
-                   layer = ellipse.m_p_layer;
+                   layer = entityLayer( ellipse );
                 }
                 layer->m_ellipses.push_back( ellipse );
                 layer->merge(ellipse);
@@ -583,7 +613,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
             if ( circle.parse( token, this ) ) {
                DxfLayer *layer = block;
                if (layer == NULL) {
-                  layer = circle.m_p_layer;
+                  layer = entityLayer( circle );
                }
                layer->m_circles.push_back( circle );
                layer->merge(circle);
@@ -598,7 +628,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
                if (spline.numVertices() > 0) {
                   DxfLayer *layer = block;
                   if (layer == NULL) {
-                     layer = spline.m_p_layer;
+                     layer = entityLayer( spline );
                   }
                   layer->m_splines.push_back( spline );
                   size_t line_count = (spline.getAttributes() & DxfSpline::CLOSED) ?
@@ -617,7 +647,7 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
                if ( insert.m_blockName.length() ) {
                   DxfLayer *layer = block;
                   if (layer == NULL) {
-                     layer = insert.m_p_layer;
+                     layer = entityLayer( insert );
                      // we are in the entities section, unwind all the blocks
                      layer->insert( insert, this );
                   } else {
@@ -651,6 +681,152 @@ void DxfParser::openEntities( std::istream& stream, DxfToken& token, DxfBlock *b
    }
 }
 
+DxfLayer *DxfParser::entityLayer( const DxfEntity& entity )
+{
+   // entities without a layer are on layer 0
+   return entity.m_p_layer != NULL ? entity.m_p_layer : getLayer( "0" );
+}
+
+bool DxfParser::isOnFilteredLayer( DxfTokenStream stream ) const
+{
+   DxfToken token;
+   while (!stream.eof()) {
+      stream >> token;
+      if (token.code == 8) {
+         return m_layer_filter.find( token.data ) != m_layer_filter.end();
+      }
+      if (token.code == 0) {
+         break;
+      }
+   }
+   return m_layer_filter.find( std::string_view("0") ) != m_layer_filter.end();
+}
+
+void DxfParser::openEntitiesInChunks( DxfTokenStream& stream, DxfToken& token )
+{
+   // entities sections smaller than this are not worth splitting up
+   const size_t CHUNK_SIZE = 1 << 20;
+
+   if (m_thread_count <= 1 || m_parent != NULL) {
+      openEntities( stream, token );
+      return;
+   }
+
+   // find where the section can be split, at the start of an entity (but not one of the vertices
+   // of a polyline or its end) every chunk's worth of text, and where the section ends
+   std::vector<const char *> starts( 1, stream.current() );
+   DxfTokenStream scan = stream;
+   DxfToken end_token;
+   bool ended = false;
+   while (!scan.eof() && !ended) {
+      const char *token_start = scan.current();
+      scan >> end_token;
+      if (end_token.code == 0) {
+         if (end_token.data == "ENDSEC") {
+            ended = true;
+         }
+         else if (size_t(token_start - starts.back()) >= CHUNK_SIZE && end_token.data != "VERTEX" && end_token.data != "SEQEND") {
+            starts.push_back( token_start );
+         }
+      }
+   }
+   const char *section_end = scan.current();
+   if (starts.size() == 1) {
+      openEntities( stream, token );
+      return;
+   }
+
+   // the entities in blocks are copied into the chunks' layers as they are inserted, so the inserts
+   // within the blocks are all unwound first, leaving the blocks to be read from only
+   flattenBlocks();
+
+   std::vector<DxfParser> chunks( starts.size() );
+   for (auto& chunk : chunks) {
+      chunk.m_parent = this;
+      chunk.m_layer_filter = m_layer_filter;
+      chunk.m_thread_count = 1;
+   }
+   depthmapX::parallelFor( chunks.size(), m_thread_count, [&](size_t index, size_t thread) {
+      if (thread == 0 && m_communicator) {
+         if (m_communicator->IsCancelled()) {
+            throw Communicator::CancelledException();
+         }
+         m_communicator->CommPostMessage( Communicator::CURRENT_RECORD,
+                                          static_cast<long>(m_size + size_t(starts[index] - stream.current())) );
+      }
+      // each chunk reads on to the first token of the next, as that ends its last entity
+      const char *chunk_end = section_end;
+      if (index + 1 < starts.size()) {
+         DxfTokenStream next_start( starts[index + 1], section_end );
+         DxfToken next_token;
+         next_start >> next_token;
+         chunk_end = next_start.current();
+      }
+      DxfTokenStream chunk_stream( starts[index], chunk_end );
+      DxfToken chunk_token;
+      chunks[index].openEntities( chunk_stream, chunk_token );
+   });
+
+   for (auto& chunk : chunks) {
+      mergeChunk( chunk );
+   }
+   m_size += size_t(section_end - stream.current());
+   stream.seek( section_end );
+   token = end_token;
+}
+
+void DxfParser::flattenBlocks()
+{
+   for (auto& block : m_blocks) {
+      DxfBlock& flattened = block.second;
+      for (size_t i = 0; i < flattened.m_inserts.size(); i++) {
+         flattened.insert( flattened.m_inserts[i], this );
+      }
+      flattened.m_inserts.clear();
+   }
+}
+
+void DxfParser::mergeChunk( DxfParser& chunk )
+{
+   for (auto& chunk_layer : chunk.m_layers) {
+      DxfLayer *layer = getLayer( chunk_layer.first );
+      DxfLayer& from = chunk_layer.second;
+      mergeEntities( layer->m_points, from.m_points );
+      mergeEntities( layer->m_lines, from.m_lines );
+      mergeEntities( layer->m_poly_lines, from.m_poly_lines );
+      mergeEntities( layer->m_arcs, from.m_arcs );
+      mergeEntities( layer->m_ellipses, from.m_ellipses );
+      mergeEntities( layer->m_circles, from.m_circles );
+      mergeEntities( layer->m_splines, from.m_splines );
+      layer->m_total_point_count += from.m_total_point_count;
+      layer->m_total_line_count += from.m_total_line_count;
+      if (!from.empty()) {
+         layer->merge( from );
+      }
+   }
+   for (auto& chunk_line_type : chunk.m_line_types) {
+      getLineType( chunk_line_type.first );
+   }
+}
+
+template <typename T>
+void DxfParser::mergeEntities( std::vector<T>& entities, std::vector<T>& chunk_entities )
+{
+   entities.reserve( entities.size() + chunk_entities.size() );
+   for (T& chunk_entity : chunk_entities) {
+      // point the entity at the layer and line type of the same name here, rather than in the chunk
+      DxfEntity& entity = chunk_entity;
+      if (entity.m_p_layer != NULL) {
+         entity.m_p_layer = getLayer( entity.m_p_layer->m_name );
+      }
+      if (entity.m_p_line_type != NULL) {
+         entity.m_p_line_type = getLineType( entity.m_p_line_type->m_name );
+      }
+      entities.push_back( std::move(chunk_entity) );
+   }
+   chunk_entities.clear();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Individual parsing of the types
@@ -682,11 +858,15 @@ bool DxfTableRow::parse( const DxfToken& token, DxfParser * )
 DxfEntity::DxfEntity(int tag)
 {
    m_tag = tag;
+   m_p_layer = NULL;
+   m_p_line_type = NULL;
 }
 
 void DxfEntity::clear()
 {
    m_tag = -1;
+   m_p_layer = NULL;
+   m_p_line_type = NULL;
 }
 
 bool DxfEntity::parse( const DxfToken& token, DxfParser *parser )
@@ -695,7 +875,7 @@ bool DxfEntity::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 5:
-         m_tag = std::stoi(std::string("0x") + token.data);   // tag is in hex
+         std::from_chars(token.data.data(), token.data.data() + token.data.size(), m_tag, 16);   // tag is in hex
          break;
       case 6:
          m_p_line_type = parser->getLineType( token.data );
@@ -746,13 +926,13 @@ bool DxfVertex::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 10:
-         x = std::stod(token.data);
+         x = token.toDouble();
          break;
       case 20:
-         y = std::stod(token.data);
+         y = token.toDouble();
          break;
       case 30:
-         z = std::stod(token.data);
+         z = token.toDouble();
          break;
       case 0: case 9:   // 0 is standard vertex, 9 is for header section variables
          parsed = true;
@@ -782,22 +962,22 @@ bool DxfLine::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 10:
-         m_start.x = std::stod(token.data);
+         m_start.x = token.toDouble();
          break;
       case 20:
-         m_start.y = std::stod(token.data);
+         m_start.y = token.toDouble();
          break;
       case 30:
-         m_start.z = std::stod(token.data);
+         m_start.z = token.toDouble();
          break;
       case 11:
-         m_end.x = std::stod(token.data);
+         m_end.x = token.toDouble();
          break;
       case 21:
-         m_end.y = std::stod(token.data);
+         m_end.y = token.toDouble();
          break;
       case 31:
-         m_end.z = std::stod(token.data);
+         m_end.z = token.toDouble();
          break;
       case 0:
          add(m_start);  // <- add to region
@@ -822,6 +1002,7 @@ void DxfPolyLine::clear()
 {
    m_vertex_count = 0;
    m_vertices.clear();
+   m_current_vertex.clear();
    m_attributes = 0;
 
    DxfRegion::clear();
@@ -832,15 +1013,13 @@ bool DxfPolyLine::parse( const DxfToken& token, DxfParser *parser )
 {
    bool parsed = false;
 
-   static DxfVertex vertex;
-
    if (m_vertex_count) {
-      if ( vertex.parse( token, parser ) ) {
-         add(vertex); // <- add to region
+      if ( m_current_vertex.parse( token, parser ) ) {
+         add(m_current_vertex); // <- add to region
          if (m_min.x == 0) {
             std::cerr << "problem" << std::endl;
          }
-         m_vertices.push_back( vertex );
+         m_vertices.push_back( m_current_vertex );
          if ( token.data == "VERTEX" ) {  // Another vertex...
             m_vertex_count++;
          }
@@ -860,7 +1039,7 @@ bool DxfPolyLine::parse( const DxfToken& token, DxfParser *parser )
             }
             break;
          case 70:
-            m_attributes = std::stoi(token.data);
+            m_attributes = token.toInt();
          default:
             DxfEntity::parse( token, parser ); // base class parse
             break;
@@ -902,36 +1081,34 @@ bool DxfLwPolyLine::parse( const DxfToken& token, DxfParser *parser )
 {
    bool parsed = false;
 
-   static DxfVertex vertex;
-
    switch (token.code) {
       case 0:
          // push final vertex
          if (m_vertex_count) {
-            add(vertex); // <- add vertex to region
-            m_vertices.push_back( vertex );
+            add(m_current_vertex); // <- add vertex to region
+            m_vertices.push_back( m_current_vertex );
          }
          parsed = true;
          break;
       case 10:
          if (m_vertex_count) {
             // push last vertex
-            add(vertex); // <- add vertex to region
-            m_vertices.push_back( vertex );
+            add(m_current_vertex); // <- add vertex to region
+            m_vertices.push_back( m_current_vertex );
          }
          m_vertex_count++;
-         vertex.clear();
-         vertex.parse( token, parser );
+         m_current_vertex.clear();
+         m_current_vertex.parse( token, parser );
          break;
       case 20:
       case 30:
          // continue last vertex:
-         vertex.parse( token, parser );
+         m_current_vertex.parse( token, parser );
          break;
       case 70:
-         m_attributes = std::stoi(token.data);
+         m_attributes = token.toInt();
       case 90:
-         m_expected_vertex_count = std::stoi(token.data);
+         m_expected_vertex_count = token.toInt();
       default:
          DxfEntity::parse( token, parser ); // base class parse
          break;
@@ -961,22 +1138,22 @@ bool DxfArc::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 10:
-         m_centre.x = std::stod(token.data);
+         m_centre.x = token.toDouble();
          break;
       case 20:
-         m_centre.y = std::stod(token.data);
+         m_centre.y = token.toDouble();
          break;
       case 30:
-         m_centre.z = std::stod(token.data);
+         m_centre.z = token.toDouble();
          break;
       case 40:
-         m_radius = std::stod(token.data);
+         m_radius = token.toDouble();
          break;
       case 50:
-         m_start = std::stod(token.data);
+         m_start = token.toDouble();
          break;
       case 51:
-         m_end = std::stod(token.data);
+         m_end = token.toDouble();
          break;
       case 0:
          {
@@ -1071,40 +1248,40 @@ bool DxfEllipse::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 10:
-         m_centre.x = std::stod(token.data);
+         m_centre.x = token.toDouble();
          break;
       case 20:
-         m_centre.y = std::stod(token.data);
+         m_centre.y = token.toDouble();
          break;
       case 30:
-         m_centre.z = std::stod(token.data);
+         m_centre.z = token.toDouble();
          break;
       case 11:
-         m_majorAxisEndPoint.x = std::stod(token.data);
+         m_majorAxisEndPoint.x = token.toDouble();
          break;
       case 21:
-         m_majorAxisEndPoint.y = std::stod(token.data);
+         m_majorAxisEndPoint.y = token.toDouble();
          break;
       case 31:
-         m_majorAxisEndPoint.z = std::stod(token.data);
+         m_majorAxisEndPoint.z = token.toDouble();
          break;
       case 210:
-         m_extrusionDirection.x = std::stod(token.data);
+         m_extrusionDirection.x = token.toDouble();
          break;
       case 220:
-         m_extrusionDirection.y = std::stod(token.data);
+         m_extrusionDirection.y = token.toDouble();
          break;
       case 230:
-         m_extrusionDirection.z = std::stod(token.data);
+         m_extrusionDirection.z = token.toDouble();
          break;
       case 40:
-         m_minorMajorAxisRatio = std::stod(token.data);
+         m_minorMajorAxisRatio = token.toDouble();
          break;
       case 41:
-         m_start = std::stod(token.data);
+         m_start = token.toDouble();
          break;
       case 42:
-         m_end = std::stod(token.data);
+         m_end = token.toDouble();
          break;
       case 0:
          {
@@ -1207,16 +1384,16 @@ bool DxfCircle::parse( const DxfToken& token, DxfParser *parser )
 
    switch (token.code) {
       case 10:
-         m_centre.x = std::stod(token.data);
+         m_centre.x = token.toDouble();
          break;
       case 20:
-         m_centre.y = std::stod(token.data);
+         m_centre.y = token.toDouble();
          break;
       case 30:
-         m_centre.z = std::stod(token.data);
+         m_centre.z = token.toDouble();
          break;
       case 40:
-         m_radius = std::stod(token.data);
+         m_radius = token.toDouble();
          break;
       case 0:
          {
@@ -1276,6 +1453,7 @@ void DxfSpline::clear()
    m_knot_count = 0;
    m_ctrl_pts.clear();
    m_knots.clear();
+   m_current_vertex.clear();
    m_attributes = 0;
 
    DxfRegion::clear();
@@ -1286,33 +1464,31 @@ bool DxfSpline::parse( const DxfToken& token, DxfParser *parser )
 {
    bool parsed = false;
 
-   static DxfVertex vertex;
-
    switch (token.code) {
       case 0:
          parsed = true;
          break;
       case 70:
-         m_attributes = std::stoi(token.data);
+         m_attributes = token.toInt();
          break;
       case 72:
-         m_knot_count = std::stoi(token.data);
+         m_knot_count = token.toInt();
          break;
       case 73:
-         m_ctrl_pt_count = std::stoi(token.data);
+         m_ctrl_pt_count = token.toInt();
          break;
       case 40:
-         m_knots.push_back( std::stod(token.data) );
+         m_knots.push_back( token.toDouble() );
       case 10:
-         vertex.x = std::stod(token.data);
+         m_current_vertex.x = token.toDouble();
          m_xyz |= 0x0001;
          break;
       case 20:
-         vertex.y = std::stod(token.data);
+         m_current_vertex.y = token.toDouble();
          m_xyz |= 0x0010;
          break;
       case 30:
-         vertex.z = std::stod(token.data);
+         m_current_vertex.z = token.toDouble();
          m_xyz |= 0x0100;
          break;
       default:
@@ -1321,8 +1497,8 @@ bool DxfSpline::parse( const DxfToken& token, DxfParser *parser )
    }
 
    if (m_xyz == 0x0111) {
-      add(vertex); // <- add vertex to region
-      m_ctrl_pts.push_back( vertex );
+      add(m_current_vertex); // <- add vertex to region
+      m_ctrl_pts.push_back( m_current_vertex );
       m_xyz = 0;
    }
 
@@ -1384,25 +1560,25 @@ bool DxfInsert::parse( const DxfToken& token, DxfParser *parser )
          m_blockName = token.data;
          break;
       case 10:
-         m_translation.x = std::stod(token.data);
+         m_translation.x = token.toDouble();
          break;
       case 20:
-         m_translation.y = std::stod(token.data);
+         m_translation.y = token.toDouble();
          break;
       case 30:
-         m_translation.z = std::stod(token.data);
+         m_translation.z = token.toDouble();
          break;
       case 41:
-         m_scale.x = std::stod(token.data);
+         m_scale.x = token.toDouble();
          break;
       case 42:
-         m_scale.y = std::stod(token.data);
+         m_scale.y = token.toDouble();
          break;
       case 43:
-         m_scale.z = std::stod(token.data);
+         m_scale.z = token.toDouble();
          break;
       case 50:
-         m_rotation = std::stod(token.data);
+         m_rotation = token.toDouble();
          break;
       default:
          DxfEntity::parse( token, parser ); // base class parse
@@ -1545,18 +1721,23 @@ void DxfLayer::insert(DxfInsert& insert, DxfParser *parser)
    }
 
    // lookup in blocks table
-   if (!parser->m_blocks.count(insert.m_blockName)) {
-       // throw exception
+   DxfBlock *found_block = parser->findBlock( insert.m_blockName );
+   if (found_block == NULL) {
+       // nothing to insert
+       return;
    }
-   DxfBlock &block = parser->m_blocks[insert.m_blockName];
+   DxfBlock &block = *found_block;
 
-   // unwind deeper inserts
-   for(i = 0; i < block.m_inserts.size(); i++) {
-       block.insert( block.m_inserts[i], parser);
+   // unwind deeper inserts (checking first, as the blocks are only read from once they
+   // have all been unwound, possibly by several threads at once)
+   if (!block.m_inserts.empty()) {
+      for(i = 0; i < block.m_inserts.size(); i++) {
+          block.insert( block.m_inserts[i], parser);
+      }
+      // delete inserts at this level to avoid re-inserting them
+      // if the block is re-inserted
+      block.m_inserts.clear();
    }
-   // delete inserts at this level to avoid re-inserting them
-   // if the block is re-inserted
-   block.m_inserts.clear();
 
    for (i = 0; i < block.m_lines.size(); i++) {
       m_lines.push_back(block.m_lines[i]);
@@ -1651,20 +1832,89 @@ DxfToken::DxfToken()
    code = -1;
 }
 
-std::istream& operator >> (std::istream& stream, DxfToken& token)
-{
-    std::string codeInputLine;
-    std::getline(stream,codeInputLine);
-    token.code = std::stoi(codeInputLine);
-    std::string dataInputLine;
-    std::getline(stream,dataInputLine);
-    dXstring::ltrim(dataInputLine,'\r');
-    dXstring::ltrim(dataInputLine,'\n');
-    dXstring::rtrim(dataInputLine,'\r');
-    dXstring::rtrim(dataInputLine,'\n');
-    token.data = dataInputLine;
-    token.size = codeInputLine.length() + token.data.length() + 2;   // might be missing a few end line characters --- never mind
-    return stream;
+namespace {
+   // the number at the start of the text (after any white space), read as std::stoi and
+   // std::stod would read it
+   template <typename T>
+   T readNumber( std::string_view text )
+   {
+      const char *first = text.data();
+      const char *last = text.data() + text.size();
+      while (first != last && isspace(static_cast<unsigned char>(*first))) {
+         first++;
+      }
+      if (first != last && *first == '+' && first + 1 != last && *(first + 1) != '-') {
+         first++;
+      }
+      T value = T();
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+      std::from_chars_result result = std::from_chars(first, last, value);
+      if (result.ec == std::errc::invalid_argument) {
+         throw std::invalid_argument("Not a number: " + std::string(text));
+      }
+      if (result.ec == std::errc::result_out_of_range) {
+         throw std::out_of_range("Number out of range: " + std::string(text));
+      }
+#else
+      // standard libraries without floating point from_chars fall back to the C library
+      std::string number(first, last);
+      if constexpr (std::is_integral<T>::value) {
+         value = std::stoi(number);
+      }
+      else {
+         value = std::stod(number);
+      }
+#endif
+      return value;
+   }
+
+   // the end of the line starting at first (before its '\n'), and the start of the next
+   const char *lineEnd( const char *first, const char *last, const char *& next )
+   {
+      const char *end = static_cast<const char *>(memchr(first, '\n', size_t(last - first)));
+      if (end == NULL) {
+         next = last;
+         return last;
+      }
+      next = end + 1;
+      return end;
+   }
+}
+
+int DxfToken::toInt() const
+{
+   return readNumber<int>( data );
+}
+
+double DxfToken::toDouble() const
+{
+   return readNumber<double>( data );
+}
+
+DxfTokenStream& operator >> (DxfTokenStream& stream, DxfToken& token)
+{
+   const char *start = stream.m_pos;
+   if (stream.eof()) {
+      token.code = -1;
+      token.data = std::string_view();
+      token.size = 0;
+      return stream;
+   }
+   const char *next;
+   const char *code_end = lineEnd( stream.m_pos, stream.m_end, next );
+   token.code = readNumber<int>( std::string_view(stream.m_pos, size_t(code_end - stream.m_pos)) );
+   const char *data_start = next;
+   const char *data_end = lineEnd( data_start, stream.m_end, next );
+   while (data_start != data_end && *data_start == '\r') {
+      data_start++;
+   }
+   while (data_end != data_start && *(data_end - 1) == '\r') {
+      data_end--;
+   }
+   token.data = std::string_view(data_start, size_t(data_end - data_start));
+   stream.m_pos = next;
+   token.size = size_t(next - start);
+   return stream;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
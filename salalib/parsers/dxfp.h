@@ -25,11 +25,19 @@
 // The parser reads in vertices, lines and polylines, and stores them in the
 // defined layers.  It also reads in any line types defined.
 
+#include "genlib/mappedblock.h"
+
 #include <math.h>
+#include <functional>
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
 class DxfToken;
+class DxfTokenStream;
 
 class DxfTableRow;
 class DxfEntity;
@@ -55,16 +63,41 @@ const double DXF_PI = 3.1415926535897932384626433832795;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-// Tokens read from file
+// Tokens read from file, their data a view of the text being parsed (so only valid for as long as it is)
 
 class DxfToken {
 public:
    int code;
    size_t size;
-   std::string data;
+   std::string_view data;
    //
    DxfToken();
-   friend std::istream& operator >> (std::istream& stream, DxfToken& token);
+   // the data as a number, throwing std::invalid_argument or std::out_of_range (as std::stoi and
+   // std::stod would) if it is not one
+   int toInt() const;
+   double toDouble() const;
+};
+
+// Splits the text of a DXF file into tokens where it lies, without copying any of it
+
+class DxfTokenStream {
+   const char *m_begin;
+   const char *m_pos;
+   const char *m_end;
+public:
+   DxfTokenStream( const char *begin = nullptr, const char *end = nullptr )
+      : m_begin(begin), m_pos(begin), m_end(end) {}
+   bool eof() const
+      { return m_pos >= m_end; }
+   // how far into the text the next token starts
+   size_t position() const
+      { return size_t(m_pos - m_begin); }
+   const char *current() const
+      { return m_pos; }
+   void seek( const char *pos )
+      { m_pos = pos; }
+   // reads the next token, throwing std::invalid_argument if its group code is not a number
+   friend DxfTokenStream& operator >> (DxfTokenStream& stream, DxfToken& token);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -239,6 +272,7 @@ protected:
    int m_attributes;
    int m_vertex_count;
    std::vector<DxfVertex> m_vertices;
+   DxfVertex m_current_vertex;   // the vertex being read
 public:
    DxfPolyLine( int tag = -1 );
    void clear();  // for reuse when parsing
@@ -437,6 +471,7 @@ protected:
    int m_knot_count;
    std::vector<DxfVertex> m_ctrl_pts;
    std::vector<double> m_knots;
+   DxfVertex m_current_vertex;   // the control point being read
 public:
    DxfSpline( int tag = -1 );
    void clear();  // for reuse when parsing
@@ -576,33 +611,62 @@ protected:
    time_t            m_time;
 protected:
    DxfRegion              m_region;
-   std::map<std::string, DxfLayer>     m_layers;
+   std::map<std::string, DxfLayer, std::less<>>     m_layers;
    std::map<std::string, DxfBlock>     m_blocks;
-   std::map<std::string, DxfLineType>  m_line_types;
+   std::map<std::string, DxfLineType, std::less<>>  m_line_types;
    //
    size_t m_size;
    Communicator *m_communicator;
+   //
+   // only the entities on these layers are read (all of them if there are none), the rest are
+   // skipped over as soon as they are come across
+   std::set<std::string, std::less<>> m_layer_filter;
+   size_t m_thread_count;
+   // the parser a chunk of the entities section is read for, whose blocks are used
+   DxfParser *m_parent = NULL;
 public:
    DxfParser(Communicator *comm = NULL);
    //
-   std::istream& open( std::istream& stream );
+   // the text is parsed where it lies, mapped from the file if it is given and can be, otherwise
+   // read from the stream in one go
+   std::istream& open( std::istream& stream, const std::string& filename = std::string() );
+   void open( DxfTokenStream& stream );
    //
-   void openHeader( std::istream& stream );
-   void openTables( std::istream& stream );
-   void openBlocks( std::istream& stream );
-   void openEntities( std::istream& stream, DxfToken& token, DxfBlock *block = NULL ); // cannot have a default token: it's a reference.  Removed default to DxfToken() AT 29.04.11
+   void openHeader( DxfTokenStream& stream );
+   void openTables( DxfTokenStream& stream );
+   void openBlocks( DxfTokenStream& stream );
+   void openEntities( DxfTokenStream& stream, DxfToken& token, DxfBlock *block = NULL ); // cannot have a default token: it's a reference.  Removed default to DxfToken() AT 29.04.11
+   // the entities section read in chunks over the threads (when it is big enough to be worth it)
+   void openEntitiesInChunks( DxfTokenStream& stream, DxfToken& token );
+   //
+   void setLayerFilter( const std::set<std::string>& layers )
+      { m_layer_filter.clear(); m_layer_filter.insert(layers.begin(), layers.end()); }
+   void setThreadCount( size_t thread_count )
+      { m_thread_count = thread_count; }
    //
    const DxfVertex& getExtMin() const;
    const DxfVertex& getExtMax() const;
-   DxfLayer *getLayer( const std::string& layer_name ); // const; <- removed as will have to add layer when DXF hasn't declared one
-   DxfLineType *getLineType( const std::string& line_type_name ); // const;
+   DxfLayer *getLayer( std::string_view layer_name ); // const; <- removed as will have to add layer when DXF hasn't declared one
+   DxfLineType *getLineType( std::string_view line_type_name ); // const;
+   DxfBlock *findBlock( const std::string& block_name );
    //
    size_t numLayers() const;
    size_t numLineTypes() const;
    //
    friend std::istream& operator >> (std::istream& stream, DxfParser& dxfp);
 
-   std::map<std::string, DxfLayer> getLayers() { return m_layers; }
+   const std::map<std::string, DxfLayer, std::less<>>& getLayers() const { return m_layers; }
+protected:
+   // the layer an entity read in the entities section goes on
+   DxfLayer *entityLayer( const DxfEntity& entity );
+   // whether the entity starting at the stream is on a layer to be read
+   bool isOnFilteredLayer( DxfTokenStream stream ) const;
+   // unwinds the inserts within blocks, so that the blocks are only read from when inserted
+   void flattenBlocks();
+   // moves the entities of a chunk read by another parser to the end of the layers of this one
+   void mergeChunk( DxfParser& chunk );
+   template <typename T>
+   void mergeEntities( std::vector<T>& entities, std::vector<T>& chunk_entities );
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -22,7 +22,7 @@ float Point::getBinDistance(int i)
    return m_node->bindistance(i);
 }
 
-std::istream& Point::read(std::istream& stream)
+std::istream& Point::read(std::istream& stream, bool withNode)
 {
    stream.read( (char *) &m_state, sizeof(m_state) );
    // block is the same size as m_noderef used to be for ease of replacement:
@@ -40,7 +40,12 @@ std::istream& Point::read(std::istream& stream)
    stream.read( (char *) &ngraph, sizeof(ngraph) );
    if (ngraph) {
        m_node = std::unique_ptr<Node>(new Node());
-       m_node->read(stream);
+       if (withNode) {
+           m_node->read(stream);
+       }
+   }
+   else {
+       m_node = nullptr;
    }
 
    stream.read((char *) &m_location, sizeof(m_location));
@@ -58,16 +63,8 @@ std::ostream &Point::write(std::ostream& stream)
    stream.write( (char *) &dummy, sizeof(dummy) );
    stream.write( (char *) &m_grid_connections, sizeof(m_grid_connections) );
    stream.write( (char *) &m_merge, sizeof(m_merge) );
-   bool ngraph;
-   if (m_node) {
-      ngraph = true;
-      stream.write( (char *) &ngraph, sizeof(ngraph) );
-      m_node->write(stream);
-   }
-   else {
-      ngraph = false;
-      stream.write( (char *) &ngraph, sizeof(ngraph) );
-   }
+   bool ngraph = m_node != nullptr;
+   stream.write( (char *) &ngraph, sizeof(ngraph) );
    stream.write((char *) &m_location, sizeof(m_location));
    return stream;
 }
@@ -170,7 +170,9 @@ public:
        return m_location;
    }
 public:
-   std::istream &read(std::istream &stream);
+   // the node is only kept with the point in files from before VERSION_VISIBILITY_GRAPH_BLOCK, after
+   // that only whether there is one, all the nodes of a map are kept together (see Node::writeBlock)
+   std::istream &read(std::istream &stream, bool withNode = true);
    std::ostream& write(std::ostream &stream);
    //
 protected:
@@ -32,6 +32,9 @@
 #include "genlib/comm.h"  // for communicator
 #include "genlib/stringutils.h"
 #include "genlib/containerutils.h"
+#include "genlib/bufferedtextwriter.h"
+#include "genlib/columnarwriter.h"
+#include "genlib/trace.h"
 
 #include <math.h>
 #include <unordered_set>
@@ -516,10 +519,10 @@ int PointMap::expand( const PixelRef p1, const PixelRef p2, PixelRefVector& list
 
 void PointMap::outputPoints(std::ostream& stream, char delim)
 {
-   stream << "Ref" << delim << "x" << delim << "y" << std::endl;
-   stream.precision(12);
+   depthmapX::BufferedTextWriter writer(stream);
+   writer << "Ref" << delim << "x" << delim << "y" << '\n';
+   writer.setPrecision(12);
 
-   int count = 0;
    for (size_t i = 0; i < m_cols; i++) {
       for (size_t j = 0; j < m_rows; j++) {
 
@@ -528,8 +531,7 @@ void PointMap::outputPoints(std::ostream& stream, char delim)
          if ( getPoint(curs).filled() ) {
 
             Point2f p = depixelate(curs);
-            stream << curs << delim << p.x << delim << p.y << std::endl;
-            count++;
+            writer << int(curs) << delim << p.x << delim << p.y << '\n';
          }
       }
    }
@@ -553,7 +555,8 @@ void PointMap::outputMergeLines(std::ostream& stream, char delim)
 
 void PointMap::outputSummary(std::ostream& myout, char delimiter)
 {
-   myout << "Ref" << delimiter << "x" << delimiter << "y";
+   depthmapX::BufferedTextWriter writer(myout);
+   writer << "Ref" << delimiter << "x" << delimiter << "y";
 
    // TODO: For compatibility write the columns in alphabetical order
    // but the physical columns in the order inserted
@@ -566,24 +569,84 @@ void PointMap::outputSummary(std::ostream& myout, char delimiter)
        return m_attributes->getColumnName(a) < m_attributes->getColumnName(b);
    });
    for (int idx: indices) {
-       myout << delimiter << m_attributes->getColumnName(idx);
+       writer << delimiter << m_attributes->getColumnName(idx);
    }
 
-   myout << std::endl;
-   myout.precision(8);
+   writer << '\n';
+   writer.setPrecision(8);
 
-   for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++) {
-       PixelRef pix = iter->getKey().value;
+   // the visible rows and the values of the columns, read up front so that wide tables can be
+   // formatted a column per thread
+   std::vector<std::pair<PixelRef, size_t>> rows;
+   size_t rowIndex = 0;
+   for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++, rowIndex++) {
+      if (isObjectVisible(m_layers, iter->getRow())) {
+         rows.push_back(std::make_pair(PixelRef(iter->getKey().value), rowIndex));
+      }
+   }
+   // compact columns are decoded for the export only, the table keeps them compact
+   const AttributeTable& attributes = *m_attributes;
+   std::vector<std::vector<float>> decoded(indices.size());
+   std::vector<depthmapX::Span<const float>> columns;
+   for (size_t i = 0; i < indices.size(); i++) {
+      columns.push_back(attributes.readColumn(indices[i], decoded[i]));
+   }
+
+   writer.writeRows(rows.size(), columns.size() + 3, delimiter,
+       [&](size_t row, size_t column, depthmapX::BufferedTextWriter& cell) {
+      PixelRef pix = rows[row].first;
+      if (column == 0) {
+         cell << int(pix);
+      }
+      else if (column < 3) {
+         Point2f p = depixelate(pix);
+         cell << (column == 1 ? p.x : p.y);
+      }
+      else {
+         cell << columns[column - 3][rows[row].second];
+      }
+   });
+}
+
+void PointMap::outputSummaryColumnar(std::ostream& stream)
+{
+   // the columns in the same order as outputSummary
+   std::vector<size_t> indices(m_attributes->getNumColumns());
+   std::iota(indices.begin(), indices.end(), static_cast<size_t>(0));
+   std::sort(indices.begin(), indices.end(),
+       [&](size_t a, size_t b) {
+       return m_attributes->getColumnName(a) < m_attributes->getColumnName(b);
+   });
+
+   depthmapX::ColumnarWriter writer(stream);
+   writer.addColumn("Ref", depthmapX::ColumnarWriter::Type::INT32);
+   writer.addColumn("x", depthmapX::ColumnarWriter::Type::FLOAT64);
+   writer.addColumn("y", depthmapX::ColumnarWriter::Type::FLOAT64);
+   for (size_t idx: indices) {
+      writer.addColumn(m_attributes->getColumnName(idx), depthmapX::ColumnarWriter::Type::FLOAT32);
+   }
+   // compact columns are decoded for the export only, the table keeps them compact
+   const AttributeTable& attributes = *m_attributes;
+   std::vector<std::vector<float>> decoded(indices.size());
+   std::vector<depthmapX::Span<const float>> columns;
+   for (size_t i = 0; i < indices.size(); i++) {
+      columns.push_back(attributes.readColumn(indices[i], decoded[i]));
+   }
+
+   size_t rowIndex = 0;
+   for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++, rowIndex++) {
+      PixelRef pix = iter->getKey().value;
       if (isObjectVisible(m_layers, iter->getRow())) {
-         myout << pix << delimiter;
+         writer.add(int32_t(pix));
          Point2f p = depixelate(pix);
-         myout << p.x << delimiter << p.y;
-         for (int idx: indices) {
-             myout << delimiter << iter->getRow().getValue(idx);
+         writer.add(p.x);
+         writer.add(p.y);
+         for (const auto& column: columns) {
+            writer.add(column[rowIndex]);
          }
-         myout << std::endl;
       }
    }
+   writer.finish();
 }
 
 void PointMap::outputMif( std::ostream& miffile, std::ostream& midfile )
@@ -655,8 +718,10 @@ void PointMap::outputConnections(std::ostream& myout)
 
 void PointMap::outputConnectionsAsCSV(std::ostream& myout, std::string delim)
 {
-    myout << "RefFrom" << delim << "RefTo";
+    depthmapX::BufferedTextWriter writer(myout);
+    writer << "RefFrom" << delim << "RefTo";
     std::unordered_set<PixelRef, hashPixelRef> seenPix;
+    PixelRefVector hood;
     for (size_t i = 0; i < m_cols; i++)
     {
         for (size_t j = 0; j < m_rows; j++)
@@ -666,13 +731,13 @@ void PointMap::outputConnectionsAsCSV(std::ostream& myout, std::string delim)
             {
                 PixelRef pix(i,j);
                 seenPix.insert(pix);
-                PixelRefVector hood;
+                hood.clear();
                 pnt.m_node->contents(hood);
                 for(PixelRef &p: hood)
                 {
-                    if(!(std::find(seenPix.begin(), seenPix.end(), p) != seenPix.end()) && getPoint(p).filled())
+                    if(seenPix.find(p) == seenPix.end() && getPoint(p).filled())
                     {
-                        myout << std::endl << pix << delim << p;
+                        writer << '\n' << int(pix) << delim << int(p);
                     }
                 }
             }
@@ -682,7 +747,8 @@ void PointMap::outputConnectionsAsCSV(std::ostream& myout, std::string delim)
 
 void PointMap::outputLinksAsCSV(std::ostream& myout, std::string delim)
 {
-    myout << "RefFrom" << delim << "RefTo";
+    depthmapX::BufferedTextWriter writer(myout);
+    writer << "RefFrom" << delim << "RefTo";
     std::unordered_set<PixelRef, hashPixelRef> seenPix;
     for (size_t i = 0; i < m_cols; i++)
     {
@@ -697,7 +763,7 @@ void PointMap::outputLinksAsCSV(std::ostream& myout, std::string delim)
                     if(seenPix.insert(pix).second)
                     {
                         seenPix.insert(mergePixelRef);
-                        myout << std::endl << pix << delim << mergePixelRef;
+                        writer << '\n' << int(pix) << delim << int(mergePixelRef);
                     }
                 }
             }
@@ -1070,7 +1136,7 @@ bool PointMap::blockedAdjacent( const PixelRef p ) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool PointMap::read(std::istream& stream )
+bool PointMap::read(std::istream& stream, const std::string& filename )
 {
    m_name = dXstring::readString(stream);
 
@@ -1083,6 +1149,12 @@ bool PointMap::read(std::istream& stream )
    int rows, cols;
    stream.read( reinterpret_cast<char *>(&rows), sizeof(rows) );
    stream.read( reinterpret_cast<char *>(&cols), sizeof(cols) );
+   // from VERSION_VISIBILITY_GRAPH_BLOCK the rows are negated to mark the visibility graph being kept
+   // as one block after the points rather than with each
+   bool graphBlock = rows < 0;
+   if (graphBlock) {
+      rows = -rows - 1;
+   }
    m_rows = static_cast<size_t>(rows);
    m_cols = static_cast<size_t>(cols);
 
@@ -1105,18 +1177,7 @@ bool PointMap::read(std::istream& stream )
    
    for (size_t j = 0; j < m_cols; j++) {
       for (size_t k = 0; k < m_rows; k++) {
-         m_points(k, j).read(stream);
-
-         // check if occdistance of any pixel's bin is set, meaning that
-         // the isovist analysis was done
-         if(!m_hasIsovistAnalysis) {
-             for(int b = 0; b < 32; b++) {
-                if(m_points(k, j).m_node && m_points(k, j).m_node->occdistance(b) > 0) {
-                    m_hasIsovistAnalysis = true;
-                    break;
-                }
-             }
-         }
+         m_points(k, j).read(stream, !graphBlock);
       }
 
 
@@ -1147,6 +1208,29 @@ bool PointMap::read(std::istream& stream )
    stream.read((char *) &m_processed, sizeof(m_processed));
    stream.read((char *) &m_boundarygraph, sizeof(m_boundarygraph));
 
+   m_visibilityGraphBlock.reset();
+   m_compactRuns.clear();
+   if (graphBlock) {
+      std::vector<Node *> nodes;
+      for (auto& point: m_points) {
+         if (point.m_node) {
+            nodes.push_back(point.m_node.get());
+         }
+      }
+      m_visibilityGraphBlock = Node::readBlock(stream, nodes, filename);
+   }
+
+   // check if occdistance of any pixel's bin is set, meaning that
+   // the isovist analysis was done
+   for (auto iter = m_points.begin(); iter != m_points.end() && !m_hasIsovistAnalysis; ++iter) {
+      for(int b = 0; b < 32; b++) {
+         if(iter->m_node && iter->m_node->occdistance(b) > 0) {
+            m_hasIsovistAnalysis = true;
+            break;
+         }
+      }
+   }
+
    // now, as soon as loaded, must recalculate our screen display:
    // note m_displayed_attribute should be -2 in order to force recalc...
    m_displayed_attribute = -2;
@@ -1161,7 +1245,8 @@ bool PointMap::write( std::ostream& stream )
 
    stream.write( (char *) &m_spacing, sizeof(m_spacing) );
 
-   int rows = static_cast<int>(m_rows);
+   // negated to mark the visibility graph block, see read
+   int rows = -static_cast<int>(m_rows) - 1;
    int cols = static_cast<int>(m_cols);
    stream.write( reinterpret_cast<char *>(&rows), sizeof(rows) );
    stream.write( reinterpret_cast<char *>(&cols), sizeof(cols) );
@@ -1184,9 +1269,28 @@ bool PointMap::write( std::ostream& stream )
    stream.write((char *) &m_processed, sizeof(m_processed));
    stream.write((char *) &m_boundarygraph, sizeof(m_boundarygraph));
 
+   std::vector<const Node *> nodes;
+   for (auto& point: m_points) {
+      if (point.m_node) {
+         nodes.push_back(point.m_node.get());
+      }
+   }
+   Node::writeBlock(stream, nodes);
+
    return false;
 }
 
+void PointMap::ownVisibilityGraph()
+{
+   for (auto& point: m_points) {
+      if (point.m_node) {
+         point.m_node->ownBlock();
+      }
+   }
+   m_visibilityGraphBlock.reset();
+   m_compactRuns.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Now what this class is actually for: making a visibility graph!
@@ -1243,11 +1347,14 @@ int PointMap::tagState(bool settag)
 // Then wouldn't have to 'test twice' for the grid point being blocked...
 // ...perhaps a tweak for a later date!
 
-bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdist )
+bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdist, bool compact )
 {
    // Note, graph must be fixed (i.e., having blocking pixels filled in)
 
+   depthmapX::TracePhase phase("Make visibility graph");
+
    if (!m_blockedlines) {
+      depthmapX::TracePhase blockPhase("Block lines");
       blockLines();
    }
 
@@ -1282,6 +1389,7 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
 
    count = 0;
 
+   depthmapX::TracePhase sparkPhase("Spark pixels");
    for (size_t i = 0; i < m_cols; i++) {
 
       for (size_t j = 0; j < m_rows; j++) {
@@ -1295,6 +1403,9 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
 
             sparkPixel2(curs,1,maxdist); // make flag of 1 suggests make this node, don't set reciprocral process flags on those you can see
                                          // maxdist controls how far to see out to
+            if (compact) {
+               compactNode(*getPoint( curs ).m_node);
+            }
 
             count++;    // <- increment count
 
@@ -1318,6 +1429,12 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
       } // rows
    } // cols
 
+   sparkPhase.addCount("nodes made", count);
+   if (compact) {
+      sparkPhase.addCount("compact run chunks", int64_t(m_compactRuns.size()));
+   }
+   sparkPhase.end();
+
    tagState( false );  // <- the state field has been used for tagging visited nodes... set back to a state variable
 
    // keeping lines blocked now is wasteful of memory... free the memory involved
@@ -1325,7 +1442,9 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
 
    // and add grid connections
    // (this is easier than trying to work it out per pixel as we calculate visibility)
+   depthmapX::TracePhase gridPhase("Add grid connections");
    addGridConnections();
+   gridPhase.end();
 
    // the graph is processed:
    m_processed = true;
@@ -1358,6 +1477,7 @@ bool PointMap::unmake(bool removeLinks) {
     }
 
     m_blockedlines = false;
+    m_compactRuns.clear();
 
     if(removeLinks) {
         m_merge_lines.clear();
@@ -1373,6 +1493,54 @@ bool PointMap::unmake(bool removeLinks) {
     return true;
 }
 
+// the runs of a compact graph are kept in chunks of at least this many
+static const size_t COMPACT_RUNS_CHUNK = 1 << 16;
+
+void PointMap::compactNode(Node& node)
+{
+   size_t runCount = node.runCount();
+   if (m_compactRuns.empty() || m_compactRuns.back().capacity() - m_compactRuns.back().size() < runCount) {
+      m_compactRuns.emplace_back();
+      m_compactRuns.back().reserve(std::max(COMPACT_RUNS_CHUNK, runCount));
+   }
+   node.moveRunsInto(m_compactRuns.back());
+}
+
+depthmapX::GraphMemoryEstimate PointMap::estimateGraphMemory(bool boundarygraph, double maxdist, size_t sampleCount)
+{
+   if (!m_blockedlines) {
+      blockLines();
+   }
+
+   std::vector<PixelRef> nodes;
+   for (size_t i = 0; i < m_cols; i++) {
+      for (size_t j = 0; j < m_rows; j++) {
+         PixelRef curs = PixelRef( static_cast<short>(i), static_cast<short>(j) );
+         if (getPoint( curs ).filled() && (!boundarygraph || getPoint( curs ).edge())) {
+            nodes.push_back(curs);
+         }
+      }
+   }
+
+   // spread evenly over the map, so that both open and cluttered parts are in the sample
+   std::vector<std::unique_ptr<Node>> sample;
+   std::vector<PixelRef> bins[32];
+   float far_bin_dists[32];
+   size_t step = std::max(size_t(1), (nodes.size() + sampleCount - 1) / std::max(size_t(1), sampleCount));
+   for (size_t n = 0; n < nodes.size(); n += step) {
+      Point& pt = getPoint( nodes[n] );
+      int processflag = pt.m_processflag;
+      pt.m_processflag = 0x00FF;
+      int neighbourhood_size = 0;
+      double total_dist = 0.0, total_dist_sqr = 0.0;
+      sparkBins(nodes[n], 1, maxdist, bins, far_bin_dists, neighbourhood_size, total_dist, total_dist_sqr);
+      pt.m_processflag = processflag;
+      sample.push_back(std::unique_ptr<Node>(new Node()));
+      sample.back()->make(nodes[n], bins, far_bin_dists, 0x00FF);
+   }
+   return depthmapX::estimateGraphMemory(sample, nodes.size(), m_rows * m_cols);
+}
+
 // 'make' construct types are: 
 // 1 -- build this node
 // 2 -- register the reciprocal q octant in nodes you can see as requiring processing
@@ -1381,13 +1549,41 @@ bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist)
 {
    static std::vector<PixelRef> bins_b[32];
    static float far_bin_dists[32];
-   for (int i = 0; i < 32; i++) {
-      far_bin_dists[i] = 0.0f;
-   }
    int neighbourhood_size = 0;
    double total_dist = 0.0;
    double total_dist_sqr = 0.0;
 
+   sparkBins(curs, make, maxdist, bins_b, far_bin_dists, neighbourhood_size, total_dist, total_dist_sqr);
+
+   if (make & 1) {
+      // The bins are cleared in the make function!
+      Point& pt = getPoint( curs );
+      pt.m_node->make(curs, bins_b, far_bin_dists, pt.m_processflag);   // note: make clears bins!
+      AttributeRow& row = m_attributes->getRow( AttributeKey(curs) );
+      row.setValue( "Connectivity", float(neighbourhood_size) );
+      row.setValue( "Point First Moment", float(total_dist) );
+      row.setValue( "Point Second Moment", float(total_dist_sqr) );
+   }
+   else {
+      // Clear bins by hand if not using them to make
+      for (int i = 0; i < 32; i++) {
+         bins_b[i].clear();
+      }
+   }
+
+   // reset process flag
+   getPoint(curs).m_processflag = 0;
+
+   return true;
+}
+
+void PointMap::sparkBins(PixelRef curs, int make, double maxdist, std::vector<PixelRef> *bins_b,
+                         float *far_bin_dists, int& neighbourhood_size, double& total_dist, double& total_dist_sqr)
+{
+   for (int i = 0; i < 32; i++) {
+      far_bin_dists[i] = 0.0f;
+   }
+
    Point2f centre0 = depixelate(curs);
 
    for (int q = 0; q < 8; q++) {
@@ -1486,27 +1682,6 @@ bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist)
       }  // <- for (depth = 1; sieve.hasgaps(); depth++)
 
    }  // <- for (int q = 0; q < 8; q++)
-
-   if (make & 1) {
-      // The bins are cleared in the make function!
-      Point& pt = getPoint( curs );
-      pt.m_node->make(curs, bins_b, far_bin_dists, pt.m_processflag);   // note: make clears bins!
-      AttributeRow& row = m_attributes->getRow( AttributeKey(curs) );
-      row.setValue( "Connectivity", float(neighbourhood_size) );
-      row.setValue( "Point First Moment", float(total_dist) );
-      row.setValue( "Point Second Moment", float(total_dist_sqr) );
-   }
-   else {
-      // Clear bins by hand if not using them to make
-      for (int i = 0; i < 32; i++) {
-         bins_b[i].clear();
-      }
-   }
-
-   // reset process flag
-   getPoint(curs).m_processflag = 0;
-
-   return true;
 }
 
 bool PointMap::sieve2(sparkSieve2& sieve, std::vector<PixelRef>& addlist, int q, int depth, PixelRef curs)
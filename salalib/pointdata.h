@@ -20,9 +20,11 @@
 
 #include "salalib/spacepixfile.h"
 #include "genlib/exceptions.h"
+#include "genlib/mappedblock.h"
 #include "salalib/point.h"
 #include "salalib/options.h"
 #include "salalib/attributetable.h"
+#include "salalib/graphmemory.h"
 #include <vector>
 #include <set>
 #include <deque>
@@ -104,6 +106,11 @@ private:
    std::unique_ptr<AttributeTable> m_attributes;
    std::unique_ptr<AttributeTableHandle> m_attribHandle;
    LayerManagerImpl m_layers;
+   // the block of the file the visibility graph was read from, which the nodes may still be viewing
+   std::shared_ptr<depthmapX::MappedBlock> m_visibilityGraphBlock;
+   // the runs of the nodes of a compact graph, which they view, in chunks that are never grown
+   std::vector<std::vector<PixelVec>> m_compactRuns;
+   void compactNode(Node& node);
 public:
    PointMap(const QtRegion& parentRegion, const std::vector<SpacePixelFile>& drawingFiles,
             const std::string& name = std::string("VGA Map"));
@@ -118,7 +125,9 @@ public:
               m_points(std::move(other.m_points)),
               m_attributes(std::move(other.m_attributes)),
               m_attribHandle(std::move(other.m_attribHandle)),
-              m_layers(std::move(other.m_layers)) {
+              m_layers(std::move(other.m_layers)),
+              m_visibilityGraphBlock(std::move(other.m_visibilityGraphBlock)),
+              m_compactRuns(std::move(other.m_compactRuns)) {
        copy(other);
    }
    PointMap& operator =(PointMap&& other) {
@@ -128,6 +137,8 @@ public:
        m_attributes = std::move(other.m_attributes);
        m_attribHandle = std::move(other.m_attribHandle);
        m_layers = std::move(other.m_layers);
+       m_visibilityGraphBlock = std::move(other.m_visibilityGraphBlock);
+       m_compactRuns = std::move(other.m_compactRuns);
        copy(other);
        return *this;
    }
@@ -168,9 +179,19 @@ public:
    void outputPoints(std::ostream& stream, char delim );
    void outputMergeLines(std::ostream& stream, char delim);
    int  tagState(bool settag);
-   bool sparkGraph2(Communicator *comm, bool boundarygraph, double maxdist );
+   // a compact graph keeps the runs of all its nodes together rather than those of every bin in an
+   // allocation of its own, which takes less memory but has the bins copy their runs out if changed
+   bool sparkGraph2(Communicator *comm, bool boundarygraph, double maxdist, bool compact = false );
    bool unmake(bool removeLinks);
    bool sparkPixel2(PixelRef curs, int make, double maxdist = -1.0);
+   // the pixels each bin of curs sees (into bins, cleared first by make) with the stats of the point
+   void sparkBins(PixelRef curs, int make, double maxdist, std::vector<PixelRef> *bins, float *far_bin_dists,
+                  int& neighbourhood_size, double& total_dist, double& total_dist_sqr);
+   // what the graph sparkGraph2 would make is expected to take up in memory, from the nodes of up to
+   // sampleCount of its pixels made on their own. The lines are blocked as sparkGraph2 would, so it does
+   // not have to again. For a boundary graph the runs are overestimated, as the edge pixels sampled see
+   // the pixels inside too
+   depthmapX::GraphMemoryEstimate estimateGraphMemory(bool boundarygraph, double maxdist, size_t sampleCount = 256);
    bool sieve2(sparkSieve2& sieve, std::vector<PixelRef>& addlist, int q, int depth, PixelRef curs);
    // bool makeGraph( Graph& graph, int optimization_level = 0, Communicator *comm = NULL);
    //
@@ -183,6 +204,8 @@ public:
    bool isPixelMerged(const PixelRef &a);
 
    void outputSummary(std::ostream& myout, char delimiter = '\t');
+   // the same as outputSummary, as typed binary columns (see depthmapX::ColumnarWriter)
+   void outputSummaryColumnar(std::ostream& stream);
    void outputMif(std::ostream& miffile, std::ostream& midfile );
    void outputNet(std::ostream& netfile );
    void outputConnections(std::ostream& myout);
@@ -341,8 +364,14 @@ public:
    // this is an odd helper function, value in range 0 to 1
    PixelRef pickPixel(double value) const;
 public:
-   bool read(std::istream &stream);
+   // given the file the stream is of, the visibility graph is mapped from it rather than read
+   bool read(std::istream &stream, const std::string& filename = std::string());
    bool write(std::ostream &stream);
+   // whether the visibility graph is mapped from the file given, which then can only be replaced
+   // (see depthmapX::replaceFile) and not written over in place before the graph is owned again
+   bool isVisibilityGraphMappedFrom(const std::string& filename) const
+   { return m_visibilityGraphBlock && m_visibilityGraphBlock->isMappedFrom(filename); }
+   void ownVisibilityGraph();
    void addGridConnections(); // adds grid connections where graph does not include them
    void outputConnectionsAsCSV(std::ostream &myout, std::string delim = ",");
    void outputLinksAsCSV(std::ostream &myout, std::string delim = ",");
@@ -19,6 +19,7 @@
 #include "salalib/segmmodules/segmangular.h"
 #include "salalib/options.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
@@ -29,11 +30,10 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
 
     AttributeTable &attributes = map.getAttributeTable();
 
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getConnections().size());
     }
+    depthmapX::ProgressReporter progress(comm);
 
     // note: radius must be sorted lowest to highest, but if -1 occurs ("radius n") it needs to be last...
     // ...to ensure no mess ups, we'll re-sort here:
@@ -153,14 +153,8 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
             }
         }
         //
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
-                }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
-            }
-        }
+        progress.update(i);
+        progress.checkCancelled();
         i++;
     }
 
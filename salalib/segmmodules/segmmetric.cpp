@@ -18,6 +18,7 @@
 
 #include "salalib/segmmodules/segmmetric.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 bool SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
@@ -26,13 +27,11 @@ bool SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
 
     bool retvar = true;
 
-    time_t atime = 0;
-
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS,
                               (m_sel_only ? map.getSelSet().size() : map.getConnections().size()));
     }
+    depthmapX::ProgressReporter progress(comm);
     int reccount = 0;
 
     // record axial line refs for topological analysis
@@ -40,10 +39,12 @@ bool SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
     // quick through to find the longest seg length
     std::vector<float> seglengths;
     float maxseglength = 0.0f;
+    // the rows are in shape index order
+    auto axialRefColumn = attributes.readColumn(attributes.getColumnIndex("Axial Line Ref"));
+    auto segLengthColumn = attributes.readColumn(attributes.getColumnIndex("Segment Length"));
     for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
-        AttributeRow& row = map.getAttributeRowFromShapeIndex(cursor);
-        axialrefs.push_back(row.getValue(attributes.getColumnIndex("Axial Line Ref")));
-        seglengths.push_back(row.getValue(attributes.getColumnIndex("Segment Length")));
+        axialrefs.push_back(axialRefColumn[cursor]);
+        seglengths.push_back(segLengthColumn[cursor]);
         if (seglengths.back() > maxseglength) {
             maxseglength = seglengths.back();
         }
@@ -176,22 +177,17 @@ bool SegmentMetric::run(Communicator *comm, ShapeGraph &map, bool) {
         row.setValue(totalcol.c_str(), total);
         row.setValue(wtotalcol.c_str(), wtotal);
         //
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
-                }
-            }
-            comm->CommPostMessage(Communicator::CURRENT_RECORD, reccount);
-        }
+        progress.update(reccount);
+        progress.checkCancelled();
         reccount++;
     }
     if (!m_sel_only) {
         // note, I've stopped sel only from calculating choice values:
+        auto choiceColumn = attributes.writeColumn(attributes.getColumnIndex(choicecol));
+        auto wchoiceColumn = attributes.writeColumn(attributes.getColumnIndex(wchoicecol));
         for (size_t cursor = 0; cursor < map.getShapeCount(); cursor++) {
-            AttributeRow& row = map.getAttributeRowFromShapeIndex(cursor);
-            row.setValue(choicecol.c_str(), choicevals[cursor].choice);
-            row.setValue(wchoicecol.c_str(), choicevals[cursor].wchoice);
+            choiceColumn[cursor] = choicevals[cursor].choice;
+            wchoiceColumn[cursor] = choicevals[cursor].wchoice;
         }
     }
 
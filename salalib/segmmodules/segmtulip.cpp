@@ -17,8 +17,11 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "salalib/segmmodules/segmtulip.h"
+#include "salalib/analysischeckpoint.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
+#include "genlib/trace.h"
 
 bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
@@ -26,6 +29,9 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         return false;
     }
 
+    depthmapX::TracePhase phase("Segment tulip analysis");
+    int64_t segmentsPopped = 0, segmentsPushed = 0;
+
     // TODO: Understand what these parameters do. They were never truly provided in the original function
     int weighting_col2 = m_weighted_measure_col2;
     int routeweight_col = m_routeweight_col;
@@ -35,13 +41,11 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     int processed_rows = 0;
 
-    time_t atime = 0;
-
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS,
                               (m_sel_only ? map.getSelSet().size() : map.getConnections().size()));
     }
+    depthmapX::ProgressReporter progress(comm);
 
     // note: radius must be sorted lowest to highest, but if -1 occurs ("radius n") it needs to be last...
     // ...to ensure no mess ups, we'll re-sort here:
@@ -67,9 +71,9 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     if (m_weighted_measure_col != -1) {
         weighting_col_text = attributes.getColumnName(m_weighted_measure_col);
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
-            weights.push_back(map.getAttributeRowFromShapeIndex(i).getValue(m_weighted_measure_col));
-        }
+        // the rows are in shape index order
+        auto weightColumn = attributes.readColumn(m_weighted_measure_col);
+        weights.assign(weightColumn.begin(), weightColumn.begin() + map.getConnections().size());
     } else { // Normal run // TV
         for (size_t i = 0; i < map.getConnections().size(); i++) {
             weights.push_back(1.0f);
@@ -82,9 +86,9 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         // cost' - similar to the angular cost
         double max_value = attributes.getColumn(routeweight_col).getStats().max;
         routeweight_col_text = attributes.getColumnName(routeweight_col);
+        auto routeweightColumn = attributes.readColumn(routeweight_col);
         for (size_t i = 0; i < map.getConnections().size(); i++) {
-            routeweights.push_back(1.0 - (map.getAttributeRowFromShapeIndex(i).getValue(routeweight_col) /
-                                          max_value)); // scale and revert!
+            routeweights.push_back(1.0 - (routeweightColumn[i] / max_value)); // scale and revert!
         }
     } else { // Normal run // TV
         for (size_t i = 0; i < map.getConnections().size(); i++) {
@@ -99,9 +103,8 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     std::string weighting_col_text2;
     if (weighting_col2 != -1) {
         weighting_col_text2 = attributes.getColumnName(weighting_col2);
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
-            weights2.push_back(map.getAttributeRowFromShapeIndex(i).getValue(weighting_col2));
-        }
+        auto weightColumn2 = attributes.readColumn(weighting_col2);
+        weights2.assign(weightColumn2.begin(), weightColumn2.begin() + map.getConnections().size());
     } else { // Normal run // TV
         for (size_t i = 0; i < map.getConnections().size(); i++) {
             weights2.push_back(1.0f);
@@ -329,10 +332,8 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     int length_col = attributes.getColumnIndex("Segment Length");
     std::vector<float> lengths;
     if (length_col != -1) {
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
-            AttributeRow& row = map.getAttributeRowFromShapeIndex(i);
-            lengths.push_back(row.getValue(length_col));
-        }
+        auto lengthColumn = attributes.readColumn(length_col);
+        lengths.assign(lengthColumn.begin(), lengthColumn.begin() + map.getConnections().size());
     }
 
     int radiussize = radius.size();
@@ -341,9 +342,60 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         radiusmask |= (1 << i);
     }
 
-    for (size_t cursor = 0; cursor < map.getConnections().size(); cursor++) {
+    // the choice totals, as kept in the checkpoint
+    auto choiceTotals = [&]() {
+        std::vector<double> totals;
+        totals.reserve(map.getConnections().size() * radiussize * 2 * 3);
+        for (size_t i = 0; i < map.getConnections().size(); i++) {
+            for (int k = 0; k < radiussize; k++) {
+                for (int dir = 0; dir < 2; dir++) {
+                    totals.push_back(audittrail[i][k][dir].choice);
+                    totals.push_back(audittrail[i][k][dir].weighted_choice);
+                    totals.push_back(audittrail[i][k][dir].weighted_choice2);
+                }
+            }
+        }
+        return totals;
+    };
+    size_t start = 0;
+    if (m_checkpoint) {
+        std::string analysis = "Segment tulip " + tulip_text + " radius type " + std::to_string(m_radius_type);
+        for (double r : radius_unconverted) {
+            analysis += " R" + std::to_string(r);
+        }
+        analysis += (m_sel_only ? " selected" : "") + std::string(m_choice ? " choice" : "") + " weights " +
+                    std::to_string(m_weighted_measure_col) + " " + std::to_string(weighting_col2) + " " +
+                    std::to_string(routeweight_col) + " " + std::to_string(map.getConnections().size());
+        start = m_checkpoint->begin(analysis);
+        for (const auto &value : m_checkpoint->getValues()) {
+            map.getAttributeRowFromShapeIndex(size_t(value.row)).setValue(value.column, value.value);
+        }
+        const std::vector<double> &totals = m_checkpoint->getTotals();
+        if (!totals.empty()) {
+            auto total = totals.begin();
+            for (size_t i = 0; i < map.getConnections().size(); i++) {
+                for (int k = 0; k < radiussize; k++) {
+                    for (int dir = 0; dir < 2; dir++) {
+                        audittrail[i][k][dir].choice = *total++;
+                        audittrail[i][k][dir].weighted_choice = *total++;
+                        audittrail[i][k][dir].weighted_choice2 = *total++;
+                    }
+                }
+            }
+        }
+        processed_rows = int(m_checkpoint->getProcessed());
+    }
+
+    for (size_t cursor = start; cursor < map.getConnections().size(); cursor++) {
         AttributeRow &row =
             map.getAttributeRowFromShapeIndex(cursor);
+        // all the values go through here so the checkpoint can set them again
+        auto setValue = [this, &row, cursor](int col, float value) {
+            row.setValue(col, value);
+            if (m_checkpoint) {
+                m_checkpoint->recordValue(int(cursor), col, value);
+            }
+        };
 
         if (m_sel_only) {
             // could use m_selection_set.searchindex(rowid) to find
@@ -394,6 +446,7 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
             bins[currentbin].pop_back();
             //
             opencount--;
+            segmentsPopped++;
 
             int ref = lineindex.ref;
             int dir = (lineindex.dir == 1) ? 0 : 1;
@@ -467,6 +520,7 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                                 size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
                                 depthmapX::insert_sorted(bins[bin], sd);
                                 opencount++;
+                                segmentsPushed++;
                             }
                         }
                     }
@@ -515,6 +569,7 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                                 size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
                                 depthmapX::insert_sorted(bins[bin], sd);
                                 opencount++;
+                                segmentsPushed++;
                             }
                         }
                     }
@@ -612,66 +667,65 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
             double total_depth_conv = curs_total_depth / ((tulip_bins - 1.0f) * 0.5f);
             double total_weighted_depth_conv = curs_total_weighted_depth / ((tulip_bins - 1.0f) * 0.5f);
             //
-            row.setValue(count_col[k], float(curs_node_count));
+            setValue(count_col[k], float(curs_node_count));
             if (curs_node_count > 1) {
                 // for dmap 8 and above, mean depth simply isn't calculated as for radius measures it is meaningless
-                row.setValue(td_col[k], total_depth_conv);
+                setValue(td_col[k], total_depth_conv);
                 if (m_weighted_measure_col != -1) {
-                    row.setValue(total_weight_col[k], float(curs_total_weight));
-                    row.setValue(w_td_col[k], float(total_weighted_depth_conv));
+                    setValue(total_weight_col[k], float(curs_total_weight));
+                    setValue(w_td_col[k], float(total_weighted_depth_conv));
                 }
             } else {
-                row.setValue(td_col[k], -1);
+                setValue(td_col[k], -1);
                 if (m_weighted_measure_col != -1) {
-                    row.setValue(total_weight_col[k], -1.0f);
-                    row.setValue(w_td_col[k], -1.0f);
+                    setValue(total_weight_col[k], -1.0f);
+                    setValue(w_td_col[k], -1.0f);
                 }
             }
             // for dmap 10 an above, integration is included!
             if (total_depth_conv > 1e-9) {
-                row.setValue(integ_col[k], (float)(curs_node_count * curs_node_count / total_depth_conv));
+                setValue(integ_col[k], (float)(curs_node_count * curs_node_count / total_depth_conv));
                 if (m_weighted_measure_col != -1) {
-                    row.setValue(w_integ_col[k],
+                    setValue(w_integ_col[k],
                                  (float)(curs_total_weight * curs_total_weight / total_weighted_depth_conv));
                 }
             } else {
-                row.setValue(integ_col[k], -1);
+                setValue(integ_col[k], -1);
                 if (m_weighted_measure_col != -1) {
-                    row.setValue(w_integ_col[k], -1.0f);
+                    setValue(w_integ_col[k], -1.0f);
                 }
             }
         }
         //
         processed_rows++;
         //
-        if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    // interactive is usual Depthmap: throw an exception if cancelled
-                    if (interactive) {
-                        for (size_t i = 0; i < map.getConnections().size(); i++) {
-                            for (size_t j = 0; j < size_t(radiussize); j++) {
-                                delete[] audittrail[i][j];
-                            }
-                            delete[] audittrail[i];
-                            delete[] uncovered[i];
-                        }
-                        delete[] audittrail;
-                        delete[] uncovered;
-                        throw Communicator::CancelledException();
-                    } else {
-                        // in non-interactive mode, retain what's been processed already
-                        break;
+        if (m_checkpoint && m_checkpoint->isDue()) {
+            m_checkpoint->save(cursor + 1, size_t(processed_rows), m_choice ? choiceTotals() : std::vector<double>());
+        }
+        progress.update(cursor);
+        if (progress.isCancelled()) {
+            // interactive is usual Depthmap: throw an exception if cancelled
+            if (interactive) {
+                for (size_t i = 0; i < map.getConnections().size(); i++) {
+                    for (size_t j = 0; j < size_t(radiussize); j++) {
+                        delete[] audittrail[i][j];
                     }
+                    delete[] audittrail[i];
+                    delete[] uncovered[i];
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, cursor);
+                delete[] audittrail;
+                delete[] uncovered;
+                throw Communicator::CancelledException();
+            } else {
+                // in non-interactive mode, retain what's been processed already
+                break;
             }
         }
     }
     if (m_choice) {
         for (size_t cursor = 0; cursor < map.getConnections().size(); cursor++) {
             AttributeRow &row =
-                attributes.getRow(AttributeKey(depthmapX::getMapAtIndex(map.getAllShapes(), cursor)->first));
+                attributes.getRow(AttributeKey(map.getShapeRefFromIndex(cursor)->first));
             for (size_t r = 0; r < radius.size(); r++) {
                 // according to Eva's correction, total choice and total weighted choice
                 // should already have been accumulated by radius at this stage
@@ -714,6 +768,10 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     delete[] audittrail;
     delete[] uncovered;
 
+    phase.addCount("origins", processed_rows);
+    phase.addCount("segments popped", segmentsPopped);
+    phase.addCount("segments pushed", segmentsPushed);
+
     map.setDisplayedAttribute(-2); // <- override if it's already showing
     if (m_choice) {
         map.setDisplayedAttribute(choice_col.back());
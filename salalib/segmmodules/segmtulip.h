@@ -20,6 +20,10 @@
 
 #include "salalib/isegment.h"
 
+namespace depthmapX {
+    class AnalysisCheckpoint;
+}
+
 class SegmentTulip : ISegment {
   private:
     std::set<double> m_radius_set;
@@ -31,6 +35,7 @@ class SegmentTulip : ISegment {
     int m_radius_type;
     bool m_choice;
     bool m_interactive;
+    depthmapX::AnalysisCheckpoint *m_checkpoint = nullptr;
 
   public:
     std::string getAnalysisName() const override { return "Tulip Analysis"; }
@@ -41,4 +46,6 @@ class SegmentTulip : ISegment {
           m_weighted_measure_col(weighted_measure_col), m_radius_type(radius_type), m_choice(choice),
           m_interactive(interactive), m_weighted_measure_col2(weighted_measure_col2),
           m_routeweight_col(routeweight_col) {}
+    // keep the progress in the checkpoint, and carry on from it if it is resuming
+    void setCheckpoint(depthmapX::AnalysisCheckpoint *checkpoint) { m_checkpoint = checkpoint; }
 };
@@ -22,6 +22,8 @@
 #include "salalib/mgraph.h"              // purely for the version info --- as phased out should replace
 #include "salalib/parsers/mapinfodata.h" // for mapinfo interface
 
+#include "genlib/bufferedtextwriter.h"
+#include "genlib/columnarwriter.h"
 #include "genlib/comm.h" // for communicator
 #include "genlib/containerutils.h"
 #include "genlib/exceptions.h"
@@ -165,6 +167,29 @@ ShapeMap::~ShapeMap() {
     }
 }
 
+void ShapeMap::rebuildShapeRows() {
+    m_shape_rows.clear();
+    m_shape_rows.reserve(m_shapes.size());
+    m_shape_key_rows.clear();
+    m_shape_key_rows.reserve(m_shapes.size());
+    for (auto iter = m_shapes.begin(); iter != m_shapes.end(); ++iter) {
+        m_shape_key_rows[iter->first] = int(m_shape_rows.size());
+        m_shape_rows.push_back(iter);
+    }
+    m_shape_rows_valid = true;
+}
+
+void ShapeMap::indexInsertedShape(std::map<int, SalaShape>::iterator shapeIter) {
+    // appending at the end does not move any other shape to a different row,
+    // anything else moves the rows after it so rebuild the whole index
+    if (m_shape_rows_valid && m_shape_rows.size() + 1 == m_shapes.size() && std::next(shapeIter) == m_shapes.end()) {
+        m_shape_key_rows[shapeIter->first] = int(m_shape_rows.size());
+        m_shape_rows.push_back(shapeIter);
+    } else {
+        rebuildShapeRows();
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 // this can be reinit as well
@@ -189,6 +214,7 @@ void ShapeMap::init(int size, const QtRegion &r) {
 void ShapeMap::copy(const ShapeMap &sourcemap, int copyflags) {
     if ((copyflags & ShapeMap::COPY_GEOMETRY) == ShapeMap::COPY_GEOMETRY) {
         m_shapes.clear();
+        rebuildShapeRows();
         init(sourcemap.m_shapes.size(), sourcemap.m_region);
         for (auto shape : sourcemap.m_shapes) {
             // using makeShape is actually easier than thinking about a total copy:
@@ -251,6 +277,7 @@ void ShapeMap::clearAll() {
     m_display_shapes.clear();
 
     m_shapes.clear();
+    rebuildShapeRows();
     m_undobuffer.clear();
     m_connectors.clear();
     m_attributes->clear();
@@ -273,7 +300,7 @@ int ShapeMap::makePointShapeWithRef(const Point2f &point, int shape_ref, bool te
         init(m_shapes.size(), QtRegion(point, point));
     }
 
-    m_shapes.insert(std::make_pair(shape_ref, SalaShape(point)));
+    indexInsertedShape(m_shapes.insert(std::make_pair(shape_ref, SalaShape(point))).first);
 
     if (bounds_good) {
         // note: also sets polygon bounding box:
@@ -315,7 +342,7 @@ int ShapeMap::makeLineShapeWithRef(const Line &line, int shape_ref, bool through
     }
 
     // note, shape constructor sets centroid, length etc
-    m_shapes.insert(std::make_pair(shape_ref, SalaShape(line)));
+    indexInsertedShape(m_shapes.insert(std::make_pair(shape_ref, SalaShape(line))).first);
 
     if (bounds_good) {
         // note: also sets polygon bounding box:
@@ -338,7 +365,7 @@ int ShapeMap::makeLineShapeWithRef(const Line &line, int shape_ref, bool through
     if (through_ui) {
         // manually add connections:
         if (m_hasgraph) {
-            int rowid = depthmapX::findIndexFromKey(m_shapes, shape_ref);
+            int rowid = getShapeIndexFromKey(shape_ref);
             if (isAxialMap()) {
                 connectIntersected(rowid, true); // "true" means line-line intersections only will be applied
             } else {
@@ -403,9 +430,11 @@ int ShapeMap::makePolyShapeWithRef(const std::vector<Point2f> &points, bool open
     // not sure if it matters if the polygon is clockwise or anticlockwise... we'll soon tell!
 
     if (open) {
-        m_shapes.insert(std::make_pair(shape_ref, SalaShape(SalaShape::SHAPE_POLY)));
+        indexInsertedShape(m_shapes.insert(std::make_pair(shape_ref, SalaShape(SalaShape::SHAPE_POLY))).first);
     } else {
-        m_shapes.insert(std::make_pair(shape_ref, SalaShape(SalaShape::SHAPE_POLY | SalaShape::SHAPE_CLOSED)));
+        indexInsertedShape(
+            m_shapes.insert(std::make_pair(shape_ref, SalaShape(SalaShape::SHAPE_POLY | SalaShape::SHAPE_CLOSED)))
+                .first);
     }
     for (i = 0; i < len; i++) {
         m_shapes.rbegin()->second.m_points.push_back(points[i]);
@@ -460,7 +489,7 @@ int ShapeMap::makeShape(const SalaShape &poly, int override_shape_ref, const std
         shape_ref = override_shape_ref;
     }
 
-    m_shapes.insert(std::make_pair(shape_ref, poly));
+    indexInsertedShape(m_shapes.insert(std::make_pair(shape_ref, poly)).first);
 
     if (bounds_good) {
         // note: also sets polygon bounding box:
@@ -541,7 +570,7 @@ int ShapeMap::makeShapeFromPointSet(const PointMap &pointmap) {
     poly.setCentroidAreaPerim();
 
     int new_shape_ref = getNextShapeKey();
-    m_shapes.insert(std::make_pair(new_shape_ref, poly));
+    indexInsertedShape(m_shapes.insert(std::make_pair(new_shape_ref, poly)).first);
 
     if (bounds_good) {
         // note: also sets polygon bounding box:
@@ -668,7 +697,7 @@ bool ShapeMap::moveShape(int shaperef, const Line &line, bool undoing) {
         }
     }
 
-    int rowid = std::distance(m_shapes.begin(), shapeIter);
+    int rowid = getShapeIndexFromKey(shapeIter->first);
     AttributeRow &row = m_attributes->getRow(AttributeKey(shapeIter->first));
     // change connections:
     if (m_hasgraph) {
@@ -691,7 +720,7 @@ bool ShapeMap::moveShape(int shaperef, const Line &line, bool undoing) {
         row.setValue(conn_col, float(newconnections.size()));
         if (isAxialMap()) {
             leng_col = m_attributes->getOrInsertLockedColumn("Line Length");
-            row.setValue(leng_col, (float)depthmapX::getMapAtIndex(m_shapes, rowid)->second.getLength());
+            row.setValue(leng_col, (float)getShapeRefFromIndex(rowid)->second.getLength());
         }
         //
         // now go through our old connections, and remove ourself:
@@ -774,7 +803,7 @@ int ShapeMap::polyBegin(const Line &line) {
     }
 
     int new_shape_ref = getNextShapeKey();
-    m_shapes.insert(std::make_pair(new_shape_ref, SalaShape(line)));
+    indexInsertedShape(m_shapes.insert(std::make_pair(new_shape_ref, SalaShape(line))).first);
     m_shapes.rbegin()->second.m_centroid = line.getCentre();
 
     if (bounds_good) {
@@ -917,7 +946,7 @@ void ShapeMap::removeShape(int shaperef, bool undoing) {
     removePolyPixels(shaperef); // done first, as all interface references use this list
 
     auto shapeIter = m_shapes.find(shaperef);
-    size_t rowid = std::distance(m_shapes.begin(), shapeIter);
+    size_t rowid = shapeIter == m_shapes.end() ? m_shapes.size() : getShapeIndexFromKey(shaperef);
 
     if (!undoing) { // <- if not currently undoing another event, then add to the undo buffer:
         m_undobuffer.push_back(SalaEvent(SalaEvent::SALA_DELETED, shaperef));
@@ -978,6 +1007,7 @@ void ShapeMap::removeShape(int shaperef, bool undoing) {
 
     if (shapeIter != m_shapes.end()) {
         shapeIter = m_shapes.erase(shapeIter);
+        rebuildShapeRows();
     }
     // n.b., shaperef should have been used to create the row in the first place:
     const AttributeKey shapeRefKey(shaperef);
@@ -1003,7 +1033,7 @@ void ShapeMap::undo() {
     } else if (event.m_action == SalaEvent::SALA_DELETED) {
 
         makeShape(event.m_geometry, event.m_shape_ref);
-        int rowid = std::distance(m_shapes.begin(), m_shapes.find(event.m_shape_ref));
+        int rowid = getShapeIndexFromKey(event.m_shape_ref);
         auto &row = m_attributes->getRow(AttributeKey(event.m_shape_ref));
 
         if (rowid != -1 && m_hasgraph) {
@@ -1048,7 +1078,7 @@ void ShapeMap::undo() {
             //
             if (event.m_geometry.isLine()) {
                 int leng_col = m_attributes->getOrInsertLockedColumn("Line Length");
-                row.setValue(leng_col, (float)depthmapX::getMapAtIndex(m_shapes, rowid)->second.getLength());
+                row.setValue(leng_col, (float)getShapeRefFromIndex(rowid)->second.getLength());
             }
             //
             // now go through our connections, and add ourself:
@@ -1500,7 +1530,7 @@ std::vector<int> ShapeMap::lineInPolyList(const Line &li_orig, size_t lineref, d
                         if (intersect_region(li, poly.m_region)) {
                             // note: in this case m_region is stored as a line:
                             if (intersect_line(li, poly.m_region, tolerance)) {
-                                shapeindexlist.push_back(int(std::distance(m_shapes.begin(), shapeIter)));
+                                shapeindexlist.push_back(getShapeIndexFromKey(shapeIter->first));
                             }
                         }
                         break;
@@ -1510,7 +1540,7 @@ std::vector<int> ShapeMap::lineInPolyList(const Line &li_orig, size_t lineref, d
                                               poly.m_points[((shape.m_polyrefs[k] + 1) % poly.m_points.size())]);
                             if (intersect_region(li, lineb)) {
                                 if (intersect_line(li, lineb, tolerance)) {
-                                    shapeindexlist.push_back(int(std::distance(m_shapes.begin(), shapeIter)));
+                                    shapeindexlist.push_back(getShapeIndexFromKey(shapeIter->first));
                                 }
                             }
                         }
@@ -1553,8 +1583,7 @@ std::vector<int> ShapeMap::polyInPolyList(int polyref, double tolerance) const {
                             auto iter = depthmapX::findBinary(testedlist, shapeRef.m_shape_ref);
                             if (iter == testedlist.end()) {
                                 testedlist.insert(iter, shapeRef.m_shape_ref);
-                                shapeindexlist.push_back(
-                                    int(depthmapX::findIndexFromKey(m_shapes, int(shapeRef.m_shape_ref))));
+                                shapeindexlist.push_back(getShapeIndexFromKey(int(shapeRef.m_shape_ref)));
                             }
                         }
                     }
@@ -1575,7 +1604,7 @@ std::vector<int> ShapeMap::polyInPolyList(int polyref, double tolerance) const {
                             auto iter = depthmapX::findBinary(testedlist, shaperefb.m_shape_ref);
                             if (shaperef != shaperefb && iter == testedlist.end()) {
                                 auto shapeIter = m_shapes.find(shaperefb.m_shape_ref);
-                                size_t indexb = std::distance(m_shapes.begin(), shapeIter);
+                                size_t indexb = getShapeIndexFromKey(shapeIter->first);
                                 const SalaShape &polyb = shapeIter->second;
                                 if (polyb.isPoint()) {
                                     if (testPointInPoly(polyb.getPoint(), shaperef) != -1) {
@@ -1700,6 +1729,7 @@ std::vector<int> ShapeMap::shapeInPolyList(const SalaShape &shape) // note: no c
         // clean up:
         removePolyPixels(ref);
         m_shapes.erase(m_shapes.find(ref));
+        rebuildShapeRows();
     }
     return shapeindexlist;
 }
@@ -1852,7 +1882,7 @@ int ShapeMap::testPointInPoly(const Point2f &p, const ShapeRef &shape) const {
             }
         }
     }
-    return (shapeIter == m_shapes.end()) ? -1 : std::distance(m_shapes.begin(), shapeIter); // note convert to -1
+    return (shapeIter == m_shapes.end()) ? -1 : getShapeIndexFromKey(shapeIter->first); // note convert to -1
 }
 
 // also note that you may want to find a close poly line or point
@@ -1901,7 +1931,7 @@ int ShapeMap::getClosestOpenGeom(const Point2f &p) const {
         }
     }
 
-    return (shapeIter == m_shapes.end()) ? -1 : std::distance(m_shapes.begin(), shapeIter); // note conversion to -1
+    return (shapeIter == m_shapes.end()) ? -1 : getShapeIndexFromKey(shapeIter->first); // note conversion to -1
 }
 
 Point2f ShapeMap::getClosestVertex(const Point2f &p) const {
@@ -1986,7 +2016,7 @@ int ShapeMap::getClosestLine(const Point2f &p) const {
 
 // code to add intersections when shapes are added to the graph one by one:
 int ShapeMap::connectIntersected(int rowid, bool linegraph) {
-    auto shaperefIter = depthmapX::getMapAtIndex(m_shapes, rowid);
+    auto shaperefIter = getShapeRefFromIndex(rowid);
     int conn_col = m_attributes->getOrInsertLockedColumn("Connectivity");
     int leng_col = -1;
     if (linegraph) {
@@ -2057,8 +2087,7 @@ std::vector<int> ShapeMap::getLineConnections(int lineref, double tolerance) {
                 // n.b. originally this followed the logic that we must normalise intersect_line properly: tolerance *
                 // line length one * line length two in fact, works better if it's just line.length() * tolerance...
                 if (intersect_line(line, l, line.length() * tolerance)) {
-                    depthmapX::insert_sorted(connections,
-                                             depthmapX::findIndexFromKey(m_shapes, int(shape.m_shape_ref)));
+                    depthmapX::insert_sorted(connections, getShapeIndexFromKey(int(shape.m_shape_ref)));
                 }
             }
         }
@@ -2067,6 +2096,82 @@ std::vector<int> ShapeMap::getLineConnections(int lineref, double tolerance) {
     return connections;
 }
 
+std::vector<std::vector<int>> ShapeMap::getAllLineConnections(
+    double tolerance, std::vector<std::vector<std::pair<double, int>>> *linebreaks) {
+    std::vector<std::vector<int>> connections(m_shapes.size());
+    if (linebreaks) {
+        linebreaks->assign(m_shapes.size(), std::vector<std::pair<double, int>>());
+    }
+
+    // a shape is registered in exactly the pixels of its own pixelated line, so two lines share a
+    // pixel in one direction only if they do in the other. Each pair of lines is therefore only
+    // tested from the lower row, once in each direction (the tolerance depends on the tested line)
+    std::vector<size_t> lastTested(m_shapes.size(), size_t(-1));
+
+    size_t i = 0;
+    for (auto shapeIter = m_shapes.begin(); shapeIter != m_shapes.end(); ++shapeIter, ++i) {
+        const SalaShape &poly = shapeIter->second;
+        if (!poly.isLine()) {
+            continue;
+        }
+        const Line &l = poly.getLine();
+        // self-connections are not added (see getLineConnections)
+        lastTested[i] = i;
+        // breaks are ordered from the start to the end of the line along its major axis
+        int axis = l.width() >= l.height() ? XAXIS : YAXIS;
+        int parity = (axis == XAXIS) ? 1 : l.sign();
+
+        PixelRefVector list = pixelateLine(l);
+        for (const PixelRef &pix : list) {
+            const std::vector<ShapeRef> &shapeRefs = m_pixel_shapes(static_cast<size_t>(pix.y), static_cast<size_t>(pix.x));
+            for (const ShapeRef &shape : shapeRefs) {
+                if ((shape.m_tags & ShapeRef::SHAPE_OPEN) != ShapeRef::SHAPE_OPEN) {
+                    continue;
+                }
+                size_t j = size_t(getShapeIndexFromKey(int(shape.m_shape_ref)));
+                if (lastTested[j] == i) {
+                    continue;
+                }
+                lastTested[j] = i;
+                const SalaShape &other = getShapeRefFromIndex(j)->second;
+                if (other.isLine() && j < i) {
+                    // already tested both ways from the other line
+                    continue;
+                }
+                const Line &line = other.getLine();
+                if (intersect_region(line, l, line.length() * tolerance) &&
+                    intersect_line(line, l, line.length() * tolerance)) {
+                    connections[i].push_back(int(j));
+                    if (linebreaks && other.isLine()) {
+                        (*linebreaks)[i].push_back(
+                            std::make_pair(parity * l.intersection_point(line, axis, TOLERANCE_A), int(j)));
+                    }
+                }
+                if (other.isLine() && intersect_region(l, line, l.length() * tolerance) &&
+                    intersect_line(l, line, l.length() * tolerance)) {
+                    connections[j].push_back(int(i));
+                    if (linebreaks) {
+                        int otherAxis = line.width() >= line.height() ? XAXIS : YAXIS;
+                        int otherParity = (otherAxis == XAXIS) ? 1 : line.sign();
+                        (*linebreaks)[j].push_back(std::make_pair(
+                            otherParity * line.intersection_point(l, otherAxis, TOLERANCE_A), int(i)));
+                    }
+                }
+            }
+        }
+    }
+    for (auto &lineConnections : connections) {
+        std::sort(lineConnections.begin(), lineConnections.end());
+    }
+    if (linebreaks) {
+        for (auto &breaks : *linebreaks) {
+            std::sort(breaks.begin(), breaks.end());
+        }
+    }
+
+    return connections;
+}
+
 // this is only problematic as there is lots of legacy code with shape-in-shape testing,
 std::vector<int> ShapeMap::getShapeConnections(int shaperef, double tolerance) {
     // In versions prior to 10, note that unlike getLineConnections, self-connection is excluded by all of the
@@ -2283,6 +2388,7 @@ bool ShapeMap::read(std::istream &stream) {
     // clear old:
     m_display_shapes.clear();
     m_shapes.clear();
+    rebuildShapeRows();
     m_attributes->clear();
     m_connectors.clear();
     m_links.clear();
@@ -2322,6 +2428,7 @@ bool ShapeMap::read(std::istream &stream) {
         stream.read((char *)&key, sizeof(key));
         auto iter = m_shapes.insert(std::make_pair(key, SalaShape())).first;
         iter->second.read(stream);
+        indexInsertedShape(iter);
     }
 
     // read object data (currently unused)
@@ -2449,11 +2556,12 @@ bool ShapeMap::write(std::ofstream &stream) {
 }
 
 bool ShapeMap::output(std::ofstream &stream, char delimiter) {
-    stream << "Ref";
+    depthmapX::BufferedTextWriter writer(stream);
+    writer << "Ref";
     if ((m_map_type & LINEMAP) == 0) {
-        stream << delimiter << "cx" << delimiter << "cy";
+        writer << delimiter << "cx" << delimiter << "cy";
     } else {
-        stream << delimiter << "x1" << delimiter << "y1" << delimiter << "x2" << delimiter << "y2";
+        writer << delimiter << "x1" << delimiter << "y1" << delimiter << "x2" << delimiter << "y2";
     }
 
     // TODO: For compatibility write the columns in alphabetical order
@@ -2465,31 +2573,112 @@ bool ShapeMap::output(std::ofstream &stream, char delimiter) {
     std::sort(indices.begin(), indices.end(),
               [&](size_t a, size_t b) { return m_attributes->getColumnName(a) < m_attributes->getColumnName(b); });
     for (int idx : indices) {
-        stream << delimiter << m_attributes->getColumnName(idx);
+        writer << delimiter << m_attributes->getColumnName(idx);
     }
 
-    stream << std::endl;
+    writer << '\n';
 
-    for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++) {
+    // the visible rows and the values of the columns, read up front so that wide tables can be
+    // formatted a column per thread
+    struct OutputRow {
+        int key;
+        size_t rowIndex;
+        const SalaShape *shape;
+    };
+    std::vector<OutputRow> rows;
+    size_t rowIndex = 0;
+    for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++, rowIndex++) {
         int key = iter->getKey().value;
         if (isObjectVisible(m_layers, iter->getRow())) {
-            stream << key;
-            auto shape = m_shapes[key];
-            if ((m_map_type & LINEMAP) == 0) {
-                stream << delimiter << shape.m_centroid.x << delimiter << shape.m_centroid.y;
-            } else {
-                stream.precision(12); // TODO: Here for compatibility with old version
+            rows.push_back(OutputRow{key, rowIndex, &m_shapes.at(key)});
+        }
+    }
+    // compact columns are decoded for the export only, the table keeps them compact
+    const AttributeTable &attributes = *m_attributes;
+    std::vector<std::vector<float>> decoded(indices.size());
+    std::vector<depthmapX::Span<const float>> columns;
+    for (size_t i = 0; i < indices.size(); i++) {
+        columns.push_back(attributes.readColumn(indices[i], decoded[i]));
+    }
+
+    // TODO: Here for compatibility with old version, line coordinates are written with 12 digits and
+    // the values with 8, as are centroids, except for those of the first row which are written with the
+    // precision the stream came with
+    bool lines = (m_map_type & LINEMAP) != 0;
+    size_t coordCount = lines ? 4 : 2;
+    int firstPrecision = writer.getPrecision();
+    writer.setPrecision(8);
+    writer.writeRows(rows.size(), 1 + coordCount + columns.size(), delimiter,
+                     [&](size_t row, size_t column, depthmapX::BufferedTextWriter &cell) {
+                         const OutputRow &outputRow = rows[row];
+                         if (column == 0) {
+                             cell << outputRow.key;
+                         } else if (column <= coordCount) {
+                             if (lines) {
+                                 const Line &li = outputRow.shape->getLine();
+                                 Point2f point = column <= 2 ? li.start() : li.end();
+                                 cell.setPrecision(12);
+                                 cell << (column % 2 == 1 ? point.x : point.y);
+                             } else {
+                                 const Point2f &centroid = outputRow.shape->m_centroid;
+                                 cell.setPrecision(row == 0 ? firstPrecision : 8);
+                                 cell << (column == 1 ? centroid.x : centroid.y);
+                             }
+                             cell.setPrecision(8);
+                         } else {
+                             cell << columns[column - 1 - coordCount][outputRow.rowIndex];
+                         }
+                     });
+    return true;
+}
+
+bool ShapeMap::outputColumnar(std::ostream &stream) {
+    // the columns in the same order as output
+    std::vector<size_t> indices(m_attributes->getNumColumns());
+    std::iota(indices.begin(), indices.end(), static_cast<size_t>(0));
+    std::sort(indices.begin(), indices.end(),
+              [&](size_t a, size_t b) { return m_attributes->getColumnName(a) < m_attributes->getColumnName(b); });
+
+    bool lines = (m_map_type & LINEMAP) != 0;
+    depthmapX::ColumnarWriter writer(stream);
+    writer.addColumn("Ref", depthmapX::ColumnarWriter::Type::INT32);
+    for (const char *name : lines ? std::vector<const char *>{"x1", "y1", "x2", "y2"}
+                                  : std::vector<const char *>{"cx", "cy"}) {
+        writer.addColumn(name, depthmapX::ColumnarWriter::Type::FLOAT64);
+    }
+    for (size_t idx : indices) {
+        writer.addColumn(m_attributes->getColumnName(idx), depthmapX::ColumnarWriter::Type::FLOAT32);
+    }
+    // compact columns are decoded for the export only, the table keeps them compact
+    const AttributeTable &attributes = *m_attributes;
+    std::vector<std::vector<float>> decoded(indices.size());
+    std::vector<depthmapX::Span<const float>> columns;
+    for (size_t i = 0; i < indices.size(); i++) {
+        columns.push_back(attributes.readColumn(indices[i], decoded[i]));
+    }
+
+    size_t rowIndex = 0;
+    for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++, rowIndex++) {
+        int key = iter->getKey().value;
+        if (isObjectVisible(m_layers, iter->getRow())) {
+            writer.add(int32_t(key));
+            const SalaShape &shape = m_shapes.at(key);
+            if (lines) {
                 const Line &li = shape.getLine();
-                stream << delimiter << li.start().x << delimiter << li.start().y << delimiter << li.end().x
-                       << delimiter << li.end().y;
+                writer.add(li.start().x);
+                writer.add(li.start().y);
+                writer.add(li.end().x);
+                writer.add(li.end().y);
+            } else {
+                writer.add(shape.m_centroid.x);
+                writer.add(shape.m_centroid.y);
             }
-            stream.precision(8); // TODO: Here for compatibility with old version
-            for (int idx : indices) {
-                stream << delimiter << iter->getRow().getValue(idx);
+            for (const auto &column : columns) {
+                writer.add(column[rowIndex]);
             }
-            stream << std::endl;
         }
     }
+    writer.finish();
     return true;
 }
 
@@ -2613,42 +2802,10 @@ bool ShapeMap::importData(const depthmapX::Table &data, std::vector<int> shape_r
             continue;
         }
 
-        std::unordered_map<std::string, size_t> colcodes;
-
-        for (size_t i = 0; i < column.second.size(); i++) {
-            std::string cellValue = column.second[i];
-            double value = 0;
-            if (dXstring::isDouble(cellValue)) {
-                value = stod(cellValue);
-            } else {
-                std::unordered_map<std::string, size_t>::iterator cellAt = colcodes.find(cellValue);
-                if (cellAt == colcodes.end()) {
-
-                    // TODO:
-                    // It seems that the original intention here was that if we are past 32 unique
-                    // values, we should stop trying to make the column categorical and fill the rest
-                    // of the values with -1.0f. It's not possible to test the original implementation
-                    // because the app crashes if we load a file with more than 32 unique values. When
-                    // and if we have a robust implementation of an attribute table that allows for
-                    // both categorical and plain string attributes this should be re-examined for a
-                    // better way to classify the column as either. Meanwhile after this threshold (32)
-                    // we set the whole column to -1 so that it does not give the impression it worked
-                    // when it's actually half-baked
-
-                    if (colcodes.size() >= 32) {
-                        for (size_t j = 0; j < column.second.size(); j++) {
-                            m_attributes->getRow(AttributeKey(shape_refs[j])).setValue(colIndex, -1.0f);
-                        }
-                        continue;
-                    } else {
-                        value = colcodes.size();
-                        colcodes.insert(std::make_pair(cellValue, colcodes.size()));
-                    }
-                } else {
-                    value = cellAt->second;
-                }
-            }
-            m_attributes->getRow(AttributeKey(shape_refs[i])).setValue(colIndex, value);
+        // the values have been read as they are to be stored (text as category numbers)
+        size_t rowCount = std::min(column.second.size(), shape_refs.size());
+        for (size_t i = 0; i < rowCount; i++) {
+            m_attributes->getRow(AttributeKey(shape_refs[i])).setValue(colIndex, column.second[i]);
         }
     }
     return true;
@@ -2693,7 +2850,7 @@ void ShapeMap::makeViewportShapes(const QtRegion &viewport) const {
             const std::vector<ShapeRef> &shapeRefs = m_pixel_shapes(static_cast<size_t>(j), static_cast<size_t>(i));
             for (const ShapeRef &shape : shapeRefs) {
                 // copy the index to the correct draworder position (draworder is formatted on display attribute)
-                int x = std::distance(m_shapes.begin(), m_shapes.find(shape.m_shape_ref));
+                int x = getShapeIndexFromKey(shape.m_shape_ref);
                 AttributeKey shapeRefKey(shape.m_shape_ref);
                 if (isObjectVisible(m_layers, m_attributes->getRow(shapeRefKey))) {
                     m_display_shapes[m_attribHandle->findInIndex(shapeRefKey)] = x;
@@ -2727,7 +2884,7 @@ bool ShapeMap::findNextShape(bool &nextlayer) const {
 const SalaShape &ShapeMap::getNextShape() const {
     int x = m_display_shapes[m_current]; // x has display order in it
     m_display_shapes[m_current] = -1;    // you've drawn it
-    return depthmapX::getMapAtIndex(m_shapes, x)->second;
+    return getShapeRefFromIndex(x)->second;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -2832,7 +2989,7 @@ bool ShapeMap::linkShapes(const Point2f &p) {
     if (m_selection_set.size() != 1) {
         return false;
     }
-    int index1 = std::distance(m_shapes.begin(), m_shapes.find(*m_selection_set.begin()));
+    int index1 = getShapeIndexFromKey(*m_selection_set.begin());
     // note: uses rowid not key
     int index2 = pointInPoly(p);
     if (index2 == -1) {
@@ -2850,8 +3007,8 @@ bool ShapeMap::linkShapes(const Point2f &p) {
 }
 
 bool ShapeMap::linkShapesFromRefs(int ref1, int ref2, bool refresh) {
-    int index1 = depthmapX::findIndexFromKey(m_shapes, ref1);
-    int index2 = depthmapX::findIndexFromKey(m_shapes, ref2);
+    int index1 = getShapeIndexFromKey(ref1);
+    int index2 = getShapeIndexFromKey(ref2);
     return linkShapes(index1, index2, refresh);
 }
 
@@ -2924,7 +3081,7 @@ bool ShapeMap::unlinkShapes(const Point2f &p) {
     if (m_selection_set.size() != 1) {
         return false;
     }
-    int index1 = std::distance(m_shapes.begin(), m_shapes.find(*m_selection_set.begin()));
+    int index1 = getShapeIndexFromKey(*m_selection_set.begin());
     int index2 = pointInPoly(p);
     if (index2 == -1) {
         // try looking for a polyline instead
@@ -2941,8 +3098,8 @@ bool ShapeMap::unlinkShapes(const Point2f &p) {
 }
 
 bool ShapeMap::unlinkShapesFromRefs(int ref1, int ref2, bool refresh) {
-    int index1 = depthmapX::findIndexFromKey(m_shapes, ref1);
-    int index2 = depthmapX::findIndexFromKey(m_shapes, ref2);
+    int index1 = getShapeIndexFromKey(ref1);
+    int index2 = getShapeIndexFromKey(ref2);
     return unlinkShapes(index1, index2, refresh);
 }
 
@@ -2992,8 +3149,8 @@ bool ShapeMap::unlinkShapesByKey(int key1, int key2, bool refresh) {
     int conn_col = m_attributes->getColumnIndex("Connectivity");
     bool update = false;
 
-    int index1 = std::distance(m_shapes.begin(), m_shapes.find(key1));
-    int index2 = std::distance(m_shapes.begin(), m_shapes.find(key2));
+    int index1 = getShapeIndexFromKey(key1);
+    int index2 = getShapeIndexFromKey(key2);
 
     if (key1 != key2) {
         // unlink these shapes...
@@ -3074,18 +3231,21 @@ bool ShapeMap::unlinkShapeSet(std::istream &idset, int refcol) {
     } while (!idset.eof());
 
     if (refcol != -1) {
-        // not using the standard "Ref", find the proper key
-        std::vector<AttributeIndexItem> idx =
-            refcol != -1 ? makeAttributeIndex(*m_attributes, refcol) : std::vector<AttributeIndexItem>();
-
-        AttributeKey dummykey(-1);
-        AttributeRowImpl dummyrow(*m_attributes);
+        // not using the standard "Ref", find the proper key through the value order of the column
+        const std::vector<size_t> &order = m_attributes->getColumnOrder(refcol);
+        std::vector<int> keys;
+        keys.reserve(m_attributes->getNumRows());
+        for (auto &item : *m_attributes) {
+            keys.push_back(item.getKey().value);
+        }
+        auto keyWithValue = [&](int value) {
+            auto range = m_attributes->getColumnOrderRange(refcol, float(value), float(value));
+            return range.first == range.second ? -1 : keys[order[range.first]];
+        };
 
         for (size_t i = 0; i < unlinks.size(); i++) {
-            auto iter = depthmapX::findBinary(idx, AttributeIndexItem(dummykey, unlinks[i].first, dummyrow));
-            unlinks[i].first = (iter == idx.end()) ? -1 : iter->key.value;
-            iter = depthmapX::findBinary(idx, AttributeIndexItem(dummykey, unlinks[i].second, dummyrow));
-            unlinks[i].second = (iter == idx.end()) ? -1 : iter->key.value;
+            unlinks[i].first = keyWithValue(unlinks[i].first);
+            unlinks[i].second = keyWithValue(unlinks[i].second);
         }
     }
     for (size_t i = 0; i < unlinks.size(); i++) {
@@ -3113,8 +3273,8 @@ bool ShapeMap::findNextLinkLine() const {
 Line ShapeMap::getNextLinkLine() const {
     // note, links are stored directly by rowid, not by key:
     if (m_curlinkline < (int)m_links.size()) {
-        return Line(depthmapX::getMapAtIndex(m_shapes, m_links[m_curlinkline].a)->second.getCentroid(),
-                    depthmapX::getMapAtIndex(m_shapes, m_links[m_curlinkline].b)->second.getCentroid());
+        return Line(getShapeRefFromIndex(m_links[m_curlinkline].a)->second.getCentroid(),
+                    getShapeRefFromIndex(m_links[m_curlinkline].b)->second.getCentroid());
     }
     return Line();
 }
@@ -3122,8 +3282,8 @@ Line ShapeMap::getNextLinkLine() const {
 std::vector<SimpleLine> ShapeMap::getAllLinkLines() {
     std::vector<SimpleLine> linkLines;
     for (size_t i = 0; i < m_links.size(); i++) {
-        linkLines.push_back(SimpleLine(depthmapX::getMapAtIndex(m_shapes, m_links[i].a)->second.getCentroid(),
-                                       depthmapX::getMapAtIndex(m_shapes, m_links[i].b)->second.getCentroid()));
+        linkLines.push_back(SimpleLine(getShapeRefFromIndex(m_links[i].a)->second.getCentroid(),
+                                       getShapeRefFromIndex(m_links[i].b)->second.getCentroid()));
     }
     return linkLines;
 }
@@ -3140,8 +3300,8 @@ bool ShapeMap::findNextUnlinkPoint() const {
 Point2f ShapeMap::getNextUnlinkPoint() const {
     // note, links are stored directly by rowid, not by key:
     if (m_curunlinkpoint < (int)m_unlinks.size()) {
-        return intersection_point(depthmapX::getMapAtIndex(m_shapes, m_unlinks[m_curunlinkpoint].a)->second.getLine(),
-                                  depthmapX::getMapAtIndex(m_shapes, m_unlinks[m_curunlinkpoint].b)->second.getLine(),
+        return intersection_point(getShapeRefFromIndex(m_unlinks[m_curunlinkpoint].a)->second.getLine(),
+                                  getShapeRefFromIndex(m_unlinks[m_curunlinkpoint].b)->second.getLine(),
                                   TOLERANCE_A);
     }
     return Point2f();
@@ -3149,8 +3309,8 @@ Point2f ShapeMap::getNextUnlinkPoint() const {
 std::vector<Point2f> ShapeMap::getAllUnlinkPoints() {
     std::vector<Point2f> unlinkPoints;
     for (size_t i = 0; i < m_unlinks.size(); i++) {
-        unlinkPoints.push_back(intersection_point(depthmapX::getMapAtIndex(m_shapes, m_unlinks[i].a)->second.getLine(),
-                                                  depthmapX::getMapAtIndex(m_shapes, m_unlinks[i].b)->second.getLine(),
+        unlinkPoints.push_back(intersection_point(getShapeRefFromIndex(m_unlinks[i].a)->second.getLine(),
+                                                  getShapeRefFromIndex(m_unlinks[i].b)->second.getLine(),
                                                   TOLERANCE_A));
     }
     return unlinkPoints;
@@ -3163,8 +3323,8 @@ void ShapeMap::outputUnlinkPoints(std::ofstream &stream, char delim) {
     for (size_t i = 0; i < m_unlinks.size(); i++) {
         // note, links are stored directly by rowid, not by key:
         Point2f p =
-            intersection_point(depthmapX::getMapAtIndex(m_shapes, m_unlinks[i].a)->second.getLine(),
-                               depthmapX::getMapAtIndex(m_shapes, m_unlinks[i].b)->second.getLine(), TOLERANCE_A);
+            intersection_point(getShapeRefFromIndex(m_unlinks[i].a)->second.getLine(),
+                               getShapeRefFromIndex(m_unlinks[i].b)->second.getLine(), TOLERANCE_A);
         stream << p.x << delim << p.y << std::endl;
     }
 }
@@ -3274,9 +3434,8 @@ int findwinner(double *bins, int bincount, int &difficult, int &impossible) {
 
 std::vector<SimpleLine> ShapeMap::getAllShapesAsLines() const {
     std::vector<SimpleLine> lines;
-    const std::map<int, SalaShape> &allShapes = getAllShapes();
-    for (auto refShape : allShapes) {
-        SalaShape &shape = refShape.second;
+    for (const auto &refShape : m_shapes) {
+        const SalaShape &shape = refShape.second;
         if (shape.isLine()) {
             lines.push_back(SimpleLine(shape.getLine()));
         } else if (shape.isPolyLine() || shape.isPolygon()) {
@@ -3293,11 +3452,10 @@ std::vector<SimpleLine> ShapeMap::getAllShapesAsLines() const {
 
 std::vector<std::pair<SimpleLine, PafColor>> ShapeMap::getAllLinesWithColour() {
     std::vector<std::pair<SimpleLine, PafColor>> colouredLines;
-    std::map<int, SalaShape> &allShapes = getAllShapes();
     int k = -1;
-    for (auto &refShape : allShapes) {
+    for (const auto &refShape : m_shapes) {
         k++;
-        SalaShape &shape = refShape.second;
+        const SalaShape &shape = refShape.second;
         PafColor colour(dXreimpl::getDisplayColor(AttributeKey(refShape.first),
                                                   m_attributes->getRow(AttributeKey(refShape.first)),
                                                   *m_attribHandle.get(), true));
@@ -3315,9 +3473,8 @@ std::vector<std::pair<SimpleLine, PafColor>> ShapeMap::getAllLinesWithColour() {
 
 std::vector<std::pair<std::vector<Point2f>, PafColor>> ShapeMap::getAllPolygonsWithColour() {
     std::vector<std::pair<std::vector<Point2f>, PafColor>> colouredPolygons;
-    std::map<int, SalaShape> &allShapes = getAllShapes();
-    for (auto &refShape : allShapes) {
-        SalaShape &shape = refShape.second;
+    for (const auto &refShape : m_shapes) {
+        const SalaShape &shape = refShape.second;
         if (shape.isPolygon()) {
             std::vector<Point2f> vertices;
             for (size_t n = 0; n < shape.m_points.size(); n++) {
@@ -3335,9 +3492,8 @@ std::vector<std::pair<std::vector<Point2f>, PafColor>> ShapeMap::getAllPolygonsW
 
 std::vector<std::pair<Point2f, PafColor>> ShapeMap::getAllPointsWithColour() {
     std::vector<std::pair<Point2f, PafColor>> colouredPoints;
-    std::map<int, SalaShape> &allShapes = getAllShapes();
-    for (auto &refShape : allShapes) {
-        SalaShape &shape = refShape.second;
+    for (const auto &refShape : m_shapes) {
+        const SalaShape &shape = refShape.second;
         if (shape.isPoint()) {
             PafColor colour(dXreimpl::getDisplayColor(AttributeKey(refShape.first),
                                                       m_attributes->getRow(AttributeKey(refShape.first)),
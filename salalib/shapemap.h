@@ -36,6 +36,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // each pixel has various lists of information:
@@ -246,6 +247,17 @@ class ShapeMap : public PixelBase {
     //
     std::map<int, SalaShape> m_shapes;
     //
+    // row lookups: large parts of the code address the shapes by row (their position in m_shapes)
+    // so keep a dense row -> shape and key -> row index. Every change to m_shapes made here updates
+    // it straight away: appending in key order (the common case) extends it, anything else rebuilds
+    // it. Handing out the shapes for editing leaves it invalid until the next change, and the
+    // lookups walk m_shapes meanwhile. The lookups themselves never change it
+    std::vector<std::map<int, SalaShape>::iterator> m_shape_rows;
+    std::unordered_map<int, int> m_shape_key_rows;
+    bool m_shape_rows_valid = true;
+    void rebuildShapeRows();
+    void indexInsertedShape(std::map<int, SalaShape>::iterator shapeIter);
+    //
     std::vector<SalaEvent> m_undobuffer;
     //
     std::unique_ptr<AttributeTable> m_attributes;
@@ -267,7 +279,13 @@ class ShapeMap : public PixelBase {
 private:
     void moveData(ShapeMap& other) {
         m_show = other.isShown();
+        // moving the map keeps its nodes, so the row index still points at them
         m_shapes = std::move(other.m_shapes);
+        m_shape_rows = std::move(other.m_shape_rows);
+        m_shape_key_rows = std::move(other.m_shape_key_rows);
+        m_shape_rows_valid = other.m_shape_rows_valid;
+        other.m_shapes.clear();
+        other.rebuildShapeRows();
         m_hasgraph = other.m_hasgraph;
         m_connectors = std::move(other.m_connectors);
         m_links = std::move(other.m_links);
@@ -312,7 +330,18 @@ private:
     // that still use them are the connections of the axial/segment maps and the point
     // in polygon functions.
     const std::map<int, SalaShape>::const_iterator getShapeRefFromIndex(size_t index) const {
-        return depthmapX::getMapAtIndex(m_shapes, index);
+        if (!m_shape_rows_valid) {
+            return index < m_shapes.size() ? depthmapX::getMapAtIndex(m_shapes, index) : m_shapes.end();
+        }
+        return index < m_shape_rows.size() ? m_shape_rows[index] : m_shapes.end();
+    }
+    // the row of a shape given its key, -1 if there is no such shape
+    int getShapeIndexFromKey(int key) const {
+        if (!m_shape_rows_valid) {
+            return depthmapX::findIndexFromKey(m_shapes, key);
+        }
+        auto iter = m_shape_key_rows.find(key);
+        return iter == m_shape_key_rows.end() ? -1 : iter->second;
     }
     AttributeRow &getAttributeRowFromShapeIndex(size_t index) {
         return m_attributes->getRow(AttributeKey(getShapeRefFromIndex(index)->first));
@@ -326,11 +355,9 @@ private:
     size_t getShapeCount() const { return m_shapes.size(); }
     // num shapes for this object (note, request by object rowid
     // -- on interrogation, this is what you will usually receive)
-    size_t getShapeCount(int rowid) const {
-        return depthmapX::getMapAtIndex(m_shapes, rowid)->second.m_points.size();
-    }
+    size_t getShapeCount(int rowid) const { return getShapeRefFromIndex(rowid)->second.m_points.size(); }
     //
-    int getIndex(int rowid) const { return depthmapX::getMapAtIndex(m_shapes, rowid)->first; }
+    int getIndex(int rowid) const { return getShapeRefFromIndex(rowid)->first; }
     //
     // add shape tools
     void makePolyPixels(int shaperef);
@@ -414,6 +441,12 @@ private:
     int connectIntersected(int rowid, bool linegraph);
     // Get the connections for a particular line
     std::vector<int> getLineConnections(int lineref, double tolerance);
+    // Get the connections of all the lines in one sweep over the pixels (indexed by rowid, the same
+    // result as calling getLineConnections for each line, but every pair of lines is tested only once).
+    // If linebreaks is given it is filled in the same pass with where each line is crossed by the lines
+    // it connects to, in the form of ShapeGraph::getLineBreaks
+    std::vector<std::vector<int>> getAllLineConnections(
+        double tolerance, std::vector<std::vector<std::pair<double, int>>> *linebreaks = nullptr);
     // Get arbitrary shape connections for a particular shape
     std::vector<int> getShapeConnections(int polyref, double tolerance);
     // Make all connections
@@ -554,7 +587,7 @@ private:
         ;
     }
     bool getShapeSelected() const {
-        return depthmapX::getMapAtIndex(m_shapes, m_display_shapes[m_current])->second.m_selected;
+        return getShapeRefFromIndex(m_display_shapes[m_current])->second.m_selected;
     }
     //
     double getLocationValue(const Point2f &point) const;
@@ -569,9 +602,16 @@ private:
         return __max(m_region.width(), m_region.height()) / (10 * log((double)10 + m_shapes.size()));
     }
     //
-    // dangerous: accessor for the shapes themselves:
+    // dangerous: accessor for the shapes themselves
     const std::map<int, SalaShape> &getAllShapes() const { return m_shapes; }
-    std::map<int, SalaShape> &getAllShapes() { return m_shapes; }
+    // the caller may add or remove shapes, so this marks the row index invalid: until the next shape is
+    // added or removed through the map (which rebuilds it), the row lookups search the shapes instead
+    std::map<int, SalaShape> &getAllShapes() {
+        m_shape_rows_valid = false;
+        return m_shapes;
+    }
+    SalaShape &getShape(int key) { return m_shapes.at(key); }
+    const SalaShape &getShape(int key) const { return m_shapes.at(key); }
     // required for PixelBase, have to implement your own version of pixelate
     PixelRef pixelate(const Point2f &p, bool constrain = true, int = 1) const;
     //
@@ -581,6 +621,8 @@ private:
     bool write(std::ofstream &stream);
     //
     bool output(std::ofstream &stream, char delimiter = '\t');
+    // the same as output, as typed binary columns (see depthmapX::ColumnarWriter)
+    bool outputColumnar(std::ostream &stream);
     //
     // links and unlinks
   protected:
@@ -0,0 +1,409 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/syntheticplans.h"
+
+#include "salalib/importtypedefs.h"
+#include "salalib/mgraph.h"
+#include "genlib/exceptions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace depthmapX {
+
+    namespace {
+        // the distributions of the standard library are not the same on every platform, so the
+        // numbers are made from the raw output of the generator, which is
+        double unitRandom(std::mt19937 &generator) { return generator() / 4294967296.0; }
+
+        double symmetricRandom(std::mt19937 &generator) { return unitRandom(generator) * 2.0 - 1.0; }
+
+        double normalRandom(std::mt19937 &generator) {
+            double u = 1.0 - unitRandom(generator);
+            return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * unitRandom(generator));
+        }
+
+        void checkParameters(int size, double complexity) {
+            if (size < 1) {
+                throw depthmapX::RuntimeException("The size of a synthetic plan has to be at least 1");
+            }
+            if (complexity < 0.0 || complexity > 1.0) {
+                throw depthmapX::RuntimeException("The complexity of a synthetic plan has to be from 0 to 1");
+            }
+        }
+
+        void addRectangle(std::vector<Line> &lines, double minX, double minY, double maxX, double maxY) {
+            lines.emplace_back(Point2f(minX, minY), Point2f(maxX, minY));
+            lines.emplace_back(Point2f(maxX, minY), Point2f(maxX, maxY));
+            lines.emplace_back(Point2f(maxX, maxY), Point2f(minX, maxY));
+            lines.emplace_back(Point2f(minX, maxY), Point2f(minX, minY));
+        }
+
+        // a wall from fromX to toX along y, with the door gaps in it (each given by where it starts)
+        void addWallWithDoors(std::vector<Line> &lines, double y, double fromX, double toX,
+                              const std::vector<double> &doorStarts, double doorWidth) {
+            double x = fromX;
+            for (double doorStart : doorStarts) {
+                if (doorStart > x) {
+                    lines.emplace_back(Point2f(x, y), Point2f(doorStart, y));
+                }
+                x = doorStart + doorWidth;
+            }
+            if (toX > x) {
+                lines.emplace_back(Point2f(x, y), Point2f(toX, y));
+            }
+        }
+
+        // the points as one line for each run of them that keeps going the same way
+        void addChain(std::vector<Line> &lines, const std::vector<Point2f> &points) {
+            if (points.size() < 2) {
+                return;
+            }
+            size_t start = 0;
+            for (size_t i = 1; i + 1 < points.size(); i++) {
+                Point2f in = points[i] - points[start];
+                Point2f out = points[i + 1] - points[i];
+                if (std::fabs(in.x * out.y - in.y * out.x) > 1e-9 * in.length() * out.length() ||
+                    dot(in, out) < 0.0) {
+                    lines.emplace_back(points[start], points[i]);
+                    start = i;
+                }
+            }
+            lines.emplace_back(points[start], points.back());
+        }
+
+        // a convex polygon with the neighbour on the other side of each edge (-1 for the bounds)
+        struct VoronoiCell {
+            std::vector<Point2f> vertices;
+            // neighbours[k] is across the edge from vertices[k] to vertices[k + 1]
+            std::vector<int> neighbours;
+        };
+
+        // cuts off the part of the cell nearer to other than to site
+        void clipCell(VoronoiCell &cell, const Point2f &site, const Point2f &other, int otherIndex) {
+            Point2f normal = other - site;
+            double offset = dot(normal, 0.5 * (site + other));
+            std::vector<double> sides(cell.vertices.size());
+            bool anyOutside = false;
+            for (size_t k = 0; k < cell.vertices.size(); k++) {
+                sides[k] = dot(normal, cell.vertices[k]) - offset;
+                anyOutside = anyOutside || sides[k] > 0.0;
+            }
+            if (!anyOutside) {
+                return;
+            }
+            VoronoiCell clipped;
+            for (size_t k = 0; k < cell.vertices.size(); k++) {
+                size_t next = (k + 1) % cell.vertices.size();
+                bool inside = sides[k] <= 0.0;
+                bool nextInside = sides[next] <= 0.0;
+                if (inside) {
+                    clipped.vertices.push_back(cell.vertices[k]);
+                    clipped.neighbours.push_back(cell.neighbours[k]);
+                }
+                if (inside != nextInside) {
+                    double t = sides[k] / (sides[k] - sides[next]);
+                    clipped.vertices.push_back(cell.vertices[k] + t * (cell.vertices[next] - cell.vertices[k]));
+                    // leaving the cell the new edge runs along the cut, coming back in it is what is
+                    // left of the old one
+                    clipped.neighbours.push_back(inside ? otherIndex : cell.neighbours[k]);
+                }
+            }
+            cell = std::move(clipped);
+        }
+    } // namespace
+
+    SyntheticPlan generateFloorplate(int rooms, unsigned int seed, double complexity) {
+        checkParameters(rooms, complexity);
+        const double roomDepth = 4.0;
+        const double corridorWidth = 2.0;
+        const double meanRoomWidth = 4.5;
+        const double doorWidth = 1.0;
+        const double doorMargin = 0.3;
+        const double deskLength = 1.2;
+        const double deskWidth = 0.6;
+        const double deskMargin = 0.6;
+
+        std::mt19937 generator(seed);
+        SyntheticPlan plan;
+
+        // bands of a corridor with a row of rooms on either side, as many as make the plate about square
+        int bands = std::max(1, int(std::round(std::sqrt(0.225 * rooms))));
+        int rows = bands * 2;
+        int roomsPerRow = (rooms + rows - 1) / rows;
+        double bandDepth = 2.0 * roomDepth + corridorWidth;
+        double width = corridorWidth + roomsPerRow * meanRoomWidth;
+        double height = bands * bandDepth;
+        int desksPerRoom = int(std::round(complexity * 3.0));
+
+        addRectangle(plan.lines, 0.0, 0.0, width, height);
+        for (int band = 0; band < bands; band++) {
+            double bandY = band * bandDepth;
+            if (band > 0) {
+                plan.lines.emplace_back(Point2f(corridorWidth, bandY), Point2f(width, bandY));
+            }
+            // the spine wall, open to the corridor
+            plan.lines.emplace_back(Point2f(corridorWidth, bandY), Point2f(corridorWidth, bandY + roomDepth));
+            plan.lines.emplace_back(Point2f(corridorWidth, bandY + roomDepth + corridorWidth),
+                                    Point2f(corridorWidth, bandY + bandDepth));
+
+            for (int side = 0; side < 2; side++) {
+                int row = band * 2 + side;
+                int roomsInRow = rooms / rows + (row < rooms % rows ? 1 : 0);
+                double roomsY = bandY + side * (roomDepth + corridorWidth);
+                double corridorY = side == 0 ? roomsY + roomDepth : roomsY;
+
+                std::vector<double> roomWidths(roomsInRow);
+                double totalWidth = 0.0;
+                for (double &roomWidth : roomWidths) {
+                    roomWidth = meanRoomWidth * (1.0 + 0.6 * complexity * symmetricRandom(generator));
+                    totalWidth += roomWidth;
+                }
+                std::vector<double> doorStarts;
+                double roomX = corridorWidth;
+                for (int room = 0; room < roomsInRow; room++) {
+                    double roomWidth = roomWidths[room] * (width - corridorWidth) / totalWidth;
+                    if (room > 0) {
+                        plan.lines.emplace_back(Point2f(roomX, roomsY), Point2f(roomX, roomsY + roomDepth));
+                    }
+                    double doorRange = roomWidth - doorWidth - 2.0 * doorMargin;
+                    doorStarts.push_back(roomX + doorMargin + std::max(0.0, doorRange) * unitRandom(generator));
+
+                    for (int desk = 0; desk < desksPerRoom; desk++) {
+                        bool across = unitRandom(generator) < 0.5;
+                        double deskX = across ? deskWidth : deskLength;
+                        double deskY = across ? deskLength : deskWidth;
+                        double freeX = roomWidth - deskX - 2.0 * deskMargin;
+                        double freeY = roomDepth - deskY - 2.0 * deskMargin;
+                        double u = unitRandom(generator);
+                        double v = unitRandom(generator);
+                        if (freeX > 0.0 && freeY > 0.0) {
+                            double minX = roomX + deskMargin + freeX * u;
+                            double minY = roomsY + deskMargin + freeY * v;
+                            addRectangle(plan.lines, minX, minY, minX + deskX, minY + deskY);
+                        }
+                    }
+                    roomX += roomWidth;
+                }
+                addWallWithDoors(plan.lines, corridorY, corridorWidth, width, doorStarts, doorWidth);
+            }
+        }
+        plan.region = QtRegion(Point2f(0.0, 0.0), Point2f(width, height));
+        plan.openPoint = Point2f(corridorWidth * 0.5, roomDepth + corridorWidth * 0.5);
+        return plan;
+    }
+
+    SyntheticPlan generateStreetGrid(int blocks, unsigned int seed, double complexity) {
+        checkParameters(blocks, complexity);
+        const double blockSpacing = 100.0;
+        const double maxJunctionShift = 30.0;
+        const double maxMissingStreets = 0.25;
+
+        std::mt19937 generator(seed);
+        SyntheticPlan plan;
+
+        // the junctions on the edge only move along it
+        int side = blocks + 1;
+        std::vector<Point2f> junctions(size_t(side) * side);
+        for (int j = 0; j < side; j++) {
+            for (int i = 0; i < side; i++) {
+                double dx = symmetricRandom(generator) * maxJunctionShift * complexity;
+                double dy = symmetricRandom(generator) * maxJunctionShift * complexity;
+                junctions[size_t(j) * side + i] = Point2f(i * blockSpacing + (i == 0 || i == blocks ? 0.0 : dx),
+                                                          j * blockSpacing + (j == 0 || j == blocks ? 0.0 : dy));
+            }
+        }
+        // each street of the grid is followed junction to junction and broken where a stretch of it
+        // is missing (never on the edge, so that the grid stays in one piece)
+        for (int direction = 0; direction < 2; direction++) {
+            for (int street = 0; street < side; street++) {
+                bool edge = street == 0 || street == blocks;
+                std::vector<Point2f> chain;
+                for (int along = 0; along < side; along++) {
+                    size_t index = direction == 0 ? size_t(street) * side + along : size_t(along) * side + street;
+                    chain.push_back(junctions[index]);
+                    bool missing = unitRandom(generator) < maxMissingStreets * complexity;
+                    if (along + 1 < side && missing && !edge) {
+                        addChain(plan.lines, chain);
+                        chain.clear();
+                    }
+                }
+                addChain(plan.lines, chain);
+            }
+        }
+        plan.region = QtRegion(Point2f(0.0, 0.0), Point2f(blocks * blockSpacing, blocks * blockSpacing));
+        plan.openPoint = plan.region.getCentre();
+        return plan;
+    }
+
+    SyntheticPlan generateVoronoiStreets(int cells, unsigned int seed, double complexity) {
+        checkParameters(cells, complexity);
+        const double cellSpacing = 100.0;
+
+        std::mt19937 generator(seed);
+        SyntheticPlan plan;
+        double extent = cellSpacing * std::sqrt(double(cells));
+
+        // some of the points are thrown around cluster centres instead of anywhere
+        std::vector<Point2f> clusters(std::max(1, int(std::round(std::sqrt(double(cells)) * 0.5))));
+        for (Point2f &cluster : clusters) {
+            cluster = Point2f(unitRandom(generator) * extent, unitRandom(generator) * extent);
+        }
+        double clusterSpread = 0.15 * extent / std::sqrt(double(clusters.size()));
+        std::vector<Point2f> sites(cells);
+        for (Point2f &site : sites) {
+            if (unitRandom(generator) < complexity) {
+                const Point2f &cluster = clusters[generator() % clusters.size()];
+                do {
+                    site = Point2f(cluster.x + normalRandom(generator) * clusterSpread,
+                                   cluster.y + normalRandom(generator) * clusterSpread);
+                } while (site.x < 0.0 || site.x > extent || site.y < 0.0 || site.y > extent);
+            } else {
+                site = Point2f(unitRandom(generator) * extent, unitRandom(generator) * extent);
+            }
+        }
+
+        // the points in buckets of about one cell each, so that each cell is cut only by the points
+        // near enough to matter
+        int buckets = std::max(1, int(std::sqrt(double(cells))));
+        double bucketSize = extent / buckets;
+        std::vector<std::vector<int>> bucketSites(size_t(buckets) * buckets);
+        auto bucketOf = [&](double coordinate) {
+            return std::min(buckets - 1, std::max(0, int(coordinate / bucketSize)));
+        };
+        for (int i = 0; i < cells; i++) {
+            bucketSites[size_t(bucketOf(sites[i].y)) * buckets + bucketOf(sites[i].x)].push_back(i);
+        }
+
+        addRectangle(plan.lines, 0.0, 0.0, extent, extent);
+        double minEdge = extent * 1e-9;
+        for (int i = 0; i < cells; i++) {
+            const Point2f &site = sites[i];
+            VoronoiCell cell;
+            cell.vertices = {Point2f(0.0, 0.0), Point2f(extent, 0.0), Point2f(extent, extent), Point2f(0.0, extent)};
+            cell.neighbours = {-1, -1, -1, -1};
+            int bucketX = bucketOf(site.x);
+            int bucketY = bucketOf(site.y);
+            for (int ring = 0; ring <= buckets; ring++) {
+                // nothing in this ring or further out is nearer than twice the furthest corner
+                double reach = 0.0;
+                for (const Point2f &vertex : cell.vertices) {
+                    reach = std::max(reach, dist(site, vertex));
+                }
+                if ((ring - 1) * bucketSize > 2.0 * reach) {
+                    break;
+                }
+                for (int y = bucketY - ring; y <= bucketY + ring; y++) {
+                    for (int x = bucketX - ring; x <= bucketX + ring; x++) {
+                        bool onRing = y == bucketY - ring || y == bucketY + ring || x == bucketX - ring ||
+                                      x == bucketX + ring;
+                        if (!onRing || x < 0 || y < 0 || x >= buckets || y >= buckets) {
+                            continue;
+                        }
+                        for (int j : bucketSites[size_t(y) * buckets + x]) {
+                            if (j != i && !(sites[j] == site)) {
+                                clipCell(cell, site, sites[j], j);
+                            }
+                        }
+                    }
+                }
+            }
+            // each edge between two cells is added by the first of the two
+            for (size_t k = 0; k < cell.vertices.size(); k++) {
+                const Point2f &start = cell.vertices[k];
+                const Point2f &end = cell.vertices[(k + 1) % cell.vertices.size()];
+                if (cell.neighbours[k] > i && dist(start, end) > minEdge) {
+                    plan.lines.emplace_back(start, end);
+                }
+            }
+        }
+        plan.region = QtRegion(Point2f(0.0, 0.0), Point2f(extent, extent));
+        plan.openPoint = plan.region.getCentre();
+        return plan;
+    }
+
+    SyntheticPlan generateCityBlocks(int blocks, unsigned int seed, double complexity, double density) {
+        checkParameters(blocks, complexity);
+        if (density < 0.0 || density > 1.0) {
+            throw depthmapX::RuntimeException("The density of a synthetic plan has to be from 0 to 1");
+        }
+        const double blockSpacing = 100.0;
+        const double streetWidth = 15.0;
+        const double minAlley = 1.0;
+        const double minBuilding = 1.0;
+
+        std::mt19937 generator(seed);
+        SyntheticPlan plan;
+        double extent = blocks * blockSpacing + streetWidth;
+        int plotsPerSide = 1 + int(std::round(complexity * 3.0));
+        double plotSize = (blockSpacing - streetWidth) / plotsPerSide;
+        double buildingSize = std::min(plotSize * std::sqrt(density), plotSize - minAlley);
+
+        addRectangle(plan.lines, 0.0, 0.0, extent, extent);
+        for (int blockY = 0; blockY < blocks; blockY++) {
+            for (int blockX = 0; blockX < blocks; blockX++) {
+                for (int plotY = 0; plotY < plotsPerSide; plotY++) {
+                    for (int plotX = 0; plotX < plotsPerSide; plotX++) {
+                        double sizeX = std::min(buildingSize * (1.0 + 0.2 * complexity * symmetricRandom(generator)),
+                                                plotSize - minAlley);
+                        double sizeY = std::min(buildingSize * (1.0 + 0.2 * complexity * symmetricRandom(generator)),
+                                                plotSize - minAlley);
+                        double u = unitRandom(generator);
+                        double v = unitRandom(generator);
+                        if (sizeX < minBuilding || sizeY < minBuilding) {
+                            continue;
+                        }
+                        double minX = blockX * blockSpacing + streetWidth + plotX * plotSize +
+                                      minAlley * 0.5 + (plotSize - minAlley - sizeX) * u;
+                        double minY = blockY * blockSpacing + streetWidth + plotY * plotSize +
+                                      minAlley * 0.5 + (plotSize - minAlley - sizeY) * v;
+                        addRectangle(plan.lines, minX, minY, minX + sizeX, minY + sizeY);
+                    }
+                }
+            }
+        }
+        plan.region = QtRegion(Point2f(0.0, 0.0), Point2f(extent, extent));
+        plan.openPoint = Point2f(streetWidth * 0.5, streetWidth * 0.5);
+        return plan;
+    }
+
+    SyntheticPlan generateSyntheticPlan(const SyntheticPlanParameters &parameters) {
+        switch (parameters.type) {
+        case SyntheticPlanType::FLOORPLATE:
+            return generateFloorplate(parameters.size, parameters.seed, parameters.complexity);
+        case SyntheticPlanType::STREET_GRID:
+            return generateStreetGrid(parameters.size, parameters.seed, parameters.complexity);
+        case SyntheticPlanType::VORONOI_STREETS:
+            return generateVoronoiStreets(parameters.size, parameters.seed, parameters.complexity);
+        case SyntheticPlanType::CITY_BLOCKS:
+            return generateCityBlocks(parameters.size, parameters.seed, parameters.complexity, parameters.density);
+        }
+        throw depthmapX::RuntimeException("Unknown synthetic plan type");
+    }
+
+    ShapeMap &addSyntheticDrawing(MetaGraph &graph, const SyntheticPlan &plan, const std::string &name) {
+        graph.m_drawingFiles.emplace_back(name);
+        ShapeMap &shapeMap = graph.createNewShapeMap(DRAWINGMAP, name);
+        shapeMap.init(plan.lines.size(), plan.region);
+        shapeMap.importLines(plan.lines, Table());
+        graph.updateParentRegions(shapeMap);
+        graph.setState(graph.getState() | MetaGraph::LINEDATA);
+        graph.setViewClass(MetaGraph::SHOWSHAPETOP);
+        return shapeMap;
+    }
+
+} // namespace depthmapX
@@ -0,0 +1,76 @@
+// Copyright (C) 2020 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "genlib/p2dpoly.h"
+#include <string>
+#include <vector>
+
+class MetaGraph;
+class ShapeMap;
+
+// Plans made up on the spot for benchmarks and stress tests, so that maps of any size can be had
+// without shipping them. The same parameters always give the same plan, on any platform
+
+namespace depthmapX {
+
+    enum class SyntheticPlanType {
+        // a floorplate of rooms off corridors, the corridors joined by a spine at one side
+        FLOORPLATE,
+        // street centrelines on a grid, bent and with streets missing as complexity grows
+        STREET_GRID,
+        // street centrelines along the edges of the voronoi cells of random points
+        VORONOI_STREETS,
+        // building outlines in blocks between streets
+        CITY_BLOCKS
+    };
+
+    struct SyntheticPlanParameters {
+        SyntheticPlanType type = SyntheticPlanType::FLOORPLATE;
+        // the number of rooms (floorplate), blocks on each side (street grid, city blocks) or cells
+        // (voronoi streets)
+        int size = 16;
+        unsigned int seed = 0;
+        // from 0 to 1, how far the plan is from a regular one
+        double complexity = 0.5;
+        // from 0 to 1, how much of each block is built on (city blocks only)
+        double density = 0.5;
+    };
+
+    struct SyntheticPlan {
+        // walls for floorplates and city blocks, street centrelines for the street networks
+        std::vector<Line> lines;
+        QtRegion region;
+        // a point in the open space of the floorplates and city blocks, to fill a VGA grid from
+        Point2f openPoint;
+    };
+
+    // rooms of 4m by about 4.5m off 2m corridors, with desks in them as complexity grows
+    SyntheticPlan generateFloorplate(int rooms, unsigned int seed, double complexity);
+    // 100m blocks, the junctions moved by up to 30m and up to a quarter of the inner streets taken out
+    // as complexity goes to 1
+    SyntheticPlan generateStreetGrid(int blocks, unsigned int seed, double complexity);
+    // cells of about 100m across, clustered around centres as complexity goes to 1
+    SyntheticPlan generateVoronoiStreets(int cells, unsigned int seed, double complexity);
+    // 85m blocks between 15m streets, split into more plots as complexity grows
+    SyntheticPlan generateCityBlocks(int blocks, unsigned int seed, double complexity, double density);
+
+    SyntheticPlan generateSyntheticPlan(const SyntheticPlanParameters &parameters);
+
+    // adds the plan as a new drawing file with one layer, as importing it from a file would
+    ShapeMap &addSyntheticDrawing(MetaGraph &graph, const SyntheticPlan &plan, const std::string &name);
+
+} // namespace depthmapX
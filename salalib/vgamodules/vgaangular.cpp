@@ -18,14 +18,14 @@
 
 #include "salalib/vgamodules/vgaangular.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
 
     std::string radius_text;
     if (m_radius != -1.0) {
@@ -53,6 +53,9 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
 
     int count = 0;
 
+    // the values are written in row order, so the stats only need to be worked out at the end
+    AttributeStatsBatch statsBatch(attributes);
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
@@ -115,17 +118,12 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
 
                 count++; // <- increment count
             }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
-            }
+            progress.update(count);
+            progress.checkCancelled();
         }
     }
 
+    statsBatch.end();
     map.setDisplayedAttribute(-2);
     map.setDisplayedAttribute(mean_depth_col);
 
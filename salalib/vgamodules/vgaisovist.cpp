@@ -19,6 +19,7 @@
 #include "salalib/vgamodules/vgaisovist.h"
 #include "salalib/isovist.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
@@ -35,13 +36,15 @@ bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
 
     if(comm) comm->CommPostMessage(Communicator::CURRENT_STEP, 2);
 
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
     int count = 0;
 
+    // the values are written in row order, so the stats only need to be worked out at the end
+    AttributeStatsBatch statsBatch(attributes);
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
@@ -74,14 +77,8 @@ bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
                     node.bin(bin).setOccDistance(static_cast<float>(pointdist.m_dist));
                 }
             }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
-            }
+            progress.update(count);
+            progress.checkCancelled();
         }
     }
     map.m_hasIsovistAnalysis = true;
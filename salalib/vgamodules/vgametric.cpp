@@ -18,17 +18,19 @@
 
 #include "salalib/vgamodules/vgametric.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
+#include "genlib/trace.h"
 
 // This is a slow algorithm, but should give the correct answer
 // for demonstrative purposes
 
 bool VGAMetric::run(Communicator *comm, PointMap &map, bool) {
-    time_t atime = 0;
+    depthmapX::TracePhase phase("VGA metric analysis");
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
 
     std::string radius_text;
     if (m_radius != -1.0) {
@@ -53,6 +55,10 @@ bool VGAMetric::run(Communicator *comm, PointMap &map, bool) {
     int count_col = attributes.insertOrResetColumn(count_col_text.c_str());
 
     int count = 0;
+    int64_t pops = 0, nodesVisited = 0;
+
+    // the values are written in row order, so the stats only need to be worked out at the end
+    AttributeStatsBatch statsBatch(attributes);
 
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
@@ -86,6 +92,7 @@ bool VGAMetric::run(Communicator *comm, PointMap &map, bool) {
                     std::set<MetricTriple>::iterator it = search_list.begin();
                     MetricTriple here = *it;
                     search_list.erase(it);
+                    pops++;
                     if (m_radius != -1.0 && (here.dist * map.getSpacing()) > m_radius) {
                         break;
                     }
@@ -115,20 +122,22 @@ bool VGAMetric::run(Communicator *comm, PointMap &map, bool) {
                 row.setValue(mspl_col, float(double(total_depth) / double(total_nodes)));
                 row.setValue(dist_col, float(double(euclid_depth) / double(total_nodes)));
                 row.setValue(count_col, float(total_nodes));
+                nodesVisited += total_nodes;
 
                 count++; // <- increment count
             }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
-            }
+            progress.update(count);
+            progress.checkCancelled();
         }
     }
 
+    phase.addCount("origins", count);
+    phase.addCount("queue pops", pops);
+    phase.addCount("nodes visited", nodesVisited);
+
+    depthmapX::TracePhase statsPhase("Attribute stats");
+    statsBatch.end();
+    statsPhase.end();
     map.overrideDisplayedAttribute(-2);
     map.setDisplayedAttribute(mspl_col);
 
@@ -19,17 +19,17 @@
 #include "salalib/vgamodules/vgathroughvision.h"
 #include "salalib/agents/agenthelpers.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 // This is a slow algorithm, but should give the correct answer
 // for demonstrative purposes
 
 bool VGAThroughVision::run(Communicator *comm, PointMap &map, bool) {
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
 
     AttributeTable &attributes = map.getAttributeTable();
 
@@ -78,14 +78,8 @@ bool VGAThroughVision::run(Communicator *comm, PointMap &map, bool) {
                 // only increment count for actual filled points
                 count++;
             }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
-            }
+            progress.update(count);
+            progress.checkCancelled();
         }
     }
 
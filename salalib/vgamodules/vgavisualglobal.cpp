@@ -17,15 +17,18 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "salalib/vgamodules/vgavisualglobal.h"
+#include "salalib/analysischeckpoint.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
+#include "genlib/trace.h"
 
 bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version) {
-    time_t atime = 0;
+    depthmapX::TracePhase phase("VGA visual global analysis");
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
     AttributeTable &attributes = map.getAttributeTable();
 
     int entropy_col = -1, rel_entropy_col = -1, integ_dv_col = -1, integ_pv_col = -1, integ_tk_col = -1,
@@ -63,13 +66,33 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
 #endif
 
     int count = 0;
+    int64_t nodesVisited = 0;
+
+    // the values are written in row order, so the stats only need to be worked out at the end
+    AttributeStatsBatch statsBatch(attributes);
 
     depthmapX::RowMatrix<int> miscs(map.getRows(), map.getCols());
     depthmapX::RowMatrix<PixelRef> extents(map.getRows(), map.getCols());
 
+    // the origins are numbered in the order they are gone through
+    size_t start = 0;
+    if (m_checkpoint) {
+        start = m_checkpoint->begin("VGA visual global R" + std::to_string(m_radius) + (m_gates_only ? " gates" : "") +
+                                    (simple_version ? " simple" : "") + " " + std::to_string(map.getCols()) + "x" +
+                                    std::to_string(map.getRows()) + " " + std::to_string(map.getFilledPointCount()));
+        for (const auto &value : m_checkpoint->getValues()) {
+            attributes.getRow(AttributeKey(value.row)).setValue(value.column, value.value);
+        }
+        count = int(m_checkpoint->getProcessed());
+    }
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(i, j);
+            size_t origin = i * map.getRows() + j;
+            if (origin < start) {
+                continue;
+            }
             if (map.getPoint(curs).filled()) {
 
                 if ((map.getPoint(curs).contextfilled() && !curs.iseven()) || (m_gates_only)) {
@@ -128,17 +151,25 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
                     }
                     level++;
                 }
+                nodesVisited += total_nodes;
                 AttributeRow &row = attributes.getRow(AttributeKey(curs));
+                // all the values go through here so the checkpoint can set them again
+                auto setValue = [this, &row, curs](int col, float value) {
+                    row.setValue(col, value);
+                    if (m_checkpoint) {
+                        m_checkpoint->recordValue(curs, col, value);
+                    }
+                };
                 // only set to single float precision after divide
                 // note -- total_nodes includes this one -- mean depth as per p.108 Social Logic of Space
                 if (!simple_version) {
-                    row.setValue(count_col, float(total_nodes)); // note: total nodes includes this one
+                    setValue(count_col, float(total_nodes)); // note: total nodes includes this one
                 }
                 // ERROR !!!!!!
                 if (total_nodes > 1) {
                     double mean_depth = double(total_depth) / double(total_nodes - 1);
                     if (!simple_version) {
-                        row.setValue(depth_col, float(mean_depth));
+                        setValue(depth_col, float(mean_depth));
                     }
                     // total nodes > 2 to avoid divide by 0 (was > 3)
                     if (total_nodes > 2 && mean_depth > 1.0) {
@@ -147,24 +178,24 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
                         double rra_d = ra / dvalue(total_nodes);
                         double rra_p = ra / pvalue(total_nodes);
                         double integ_tk = teklinteg(total_nodes, total_depth);
-                        row.setValue(integ_dv_col, float(1.0 / rra_d));
+                        setValue(integ_dv_col, float(1.0 / rra_d));
                         if (!simple_version) {
-                            row.setValue(integ_pv_col, float(1.0 / rra_p));
+                            setValue(integ_pv_col, float(1.0 / rra_p));
                         }
                         if (total_depth - total_nodes + 1 > 1) {
                             if (!simple_version) {
-                                row.setValue(integ_tk_col, float(integ_tk));
+                                setValue(integ_tk_col, float(integ_tk));
                             }
                         } else {
                             if (!simple_version) {
-                                row.setValue(integ_tk_col, -1.0f);
+                                setValue(integ_tk_col, -1.0f);
                             }
                         }
                     } else {
-                        row.setValue(integ_dv_col, (float)-1);
+                        setValue(integ_dv_col, (float)-1);
                         if (!simple_version) {
-                            row.setValue(integ_pv_col, (float)-1);
-                            row.setValue(integ_tk_col, (float)-1);
+                            setValue(integ_pv_col, (float)-1);
+                            setValue(integ_tk_col, (float)-1);
                         }
                     }
                     double entropy = 0.0, rel_entropy = 0.0, factorial = 1.0;
@@ -181,25 +212,23 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
                         }
                     }
                     if (!simple_version) {
-                        row.setValue(entropy_col, float(entropy));
-                        row.setValue(rel_entropy_col, float(rel_entropy));
+                        setValue(entropy_col, float(entropy));
+                        setValue(rel_entropy_col, float(rel_entropy));
                     }
                 } else {
                     if (!simple_version) {
-                        row.setValue(depth_col, (float)-1);
-                        row.setValue(entropy_col, (float)-1);
-                        row.setValue(rel_entropy_col, (float)-1);
+                        setValue(depth_col, (float)-1);
+                        setValue(entropy_col, (float)-1);
+                        setValue(rel_entropy_col, (float)-1);
                     }
                 }
                 count++; // <- increment count
-                if (comm) {
-                    if (qtimer(atime, 500)) {
-                        if (comm->IsCancelled()) {
-                            throw Communicator::CancelledException();
-                        }
-                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                    }
+                progress.update(count);
+                // saved before checking for cancellation, so that the work done is kept either way
+                if (m_checkpoint && m_checkpoint->isDue()) {
+                    m_checkpoint->save(origin + 1, size_t(count));
                 }
+                progress.checkCancelled();
             }
         }
     }
@@ -210,6 +239,12 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
             map.getPoint(curs).m_extent = extents(j, i);
         }
     }
+    phase.addCount("origins", count);
+    phase.addCount("nodes visited", nodesVisited);
+
+    depthmapX::TracePhase statsPhase("Attribute stats");
+    statsBatch.end();
+    statsPhase.end();
     map.setDisplayedAttribute(integ_dv_col);
 
     return true;
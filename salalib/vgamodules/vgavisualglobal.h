@@ -24,10 +24,15 @@
 
 #include "genlib/simplematrix.h"
 
+namespace depthmapX {
+    class AnalysisCheckpoint;
+}
+
 class VGAVisualGlobal : IVGA {
   private:
     double m_radius;
     bool m_gates_only;
+    depthmapX::AnalysisCheckpoint *m_checkpoint = nullptr;
 
   public:
     std::string getAnalysisName() const override { return "Global Visibility Analysis"; }
@@ -35,4 +40,6 @@ class VGAVisualGlobal : IVGA {
     void extractUnseen(Node &node, PixelRefVector &pixels, depthmapX::RowMatrix<int> &miscs,
                        depthmapX::RowMatrix<PixelRef> &extents);
     VGAVisualGlobal(double radius, bool gates_only) : m_radius(radius), m_gates_only(gates_only) {}
+    // keep the progress in the checkpoint, and carry on from it if it is resuming
+    void setCheckpoint(depthmapX::AnalysisCheckpoint *checkpoint) { m_checkpoint = checkpoint; }
 };
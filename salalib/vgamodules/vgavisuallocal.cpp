@@ -18,14 +18,14 @@
 
 #include "salalib/vgamodules/vgavisuallocal.h"
 
+#include "genlib/progressreporter.h"
 #include "genlib/stringutils.h"
 
 bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version) {
-    time_t atime = 0;
     if (comm) {
-        qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
+    depthmapX::ProgressReporter progress(comm);
 
     int cluster_col = -1, control_col = -1, controllability_col = -1;
     if (!simple_version) {
@@ -36,6 +36,9 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
 
     int count = 0;
 
+    // the values are written in row order, so the stats only need to be worked out at the end
+    AttributeStatsBatch statsBatch(map.getAttributeTable());
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
@@ -97,16 +100,11 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
 #endif
                 count++; // <- increment count
             }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
-            }
+            progress.update(count);
+            progress.checkCancelled();
         }
     }
+    statsBatch.end();
 
 #ifndef _COMPILE_dX_SIMPLE_VERSION
     if (!simple_version)
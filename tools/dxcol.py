@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# Copyright (C) 2020 depthmapX contributors
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Reads the files written by the columnar EXPORT modes of depthmapXcli
+(pointmap-data-columnar, shapegraph-map-columnar). The layout is described in
+docs/commandline.md. Only the standard library is needed:
+
+    import dxcol
+    columns = dxcol.read("map.dxcol")   # {column name: array.array}
+
+    # with pandas
+    frame = pandas.DataFrame({name: numpy.asarray(values) for name, values in columns.items()})
+
+Run as a script it writes the table out as csv, which R (or anything else) can read:
+
+    python3 dxcol.py map.dxcol > map.csv
+"""
+
+import array
+import csv
+import struct
+import sys
+
+MAGIC = b"DXCOL001"
+# the type codes of the file, as array type codes and sizes in bytes
+TYPES = {1: ("i", 4), 2: ("f", 4), 3: ("d", 8)}
+
+
+def read(filename):
+    """Returns the columns of the file in order, by name, each as an array.array of all its rows"""
+    with open(filename, "rb") as stream:
+        data = stream.read()
+    if len(data) < 28 or data[:8] != MAGIC or data[-8:] != MAGIC:
+        raise ValueError(filename + " is not a columnar export")
+
+    # the schema
+    position = 8
+    (columnCount,) = struct.unpack_from("<I", data, position)
+    position += 4
+    names = []
+    types = []
+    for _ in range(columnCount):
+        columnType, length = struct.unpack_from("<BI", data, position)
+        position += 5
+        if columnType not in TYPES:
+            raise ValueError("Unknown column type " + str(columnType) + " in " + filename)
+        names.append(data[position:position + length].decode("utf-8", errors="replace"))
+        position += length
+        types.append(columnType)
+
+    # the footer, found from its length just before the closing magic
+    (footerLength,) = struct.unpack_from("<I", data, len(data) - 12)
+    footerStart = len(data) - 12 - footerLength
+    endOfChunks, chunkCount = struct.unpack_from("<qq", data, footerStart)
+    if endOfChunks != -1:
+        raise ValueError(filename + " has a damaged footer")
+    offsets = struct.unpack_from("<%dq" % chunkCount, data, footerStart + 16)
+    (rowCount,) = struct.unpack_from("<q", data, footerStart + 16 + 8 * chunkCount)
+
+    # the chunks, each column of a chunk padded to 8 bytes
+    columns = [array.array(TYPES[columnType][0]) for columnType in types]
+    for offset in offsets:
+        (rows,) = struct.unpack_from("<q", data, offset)
+        position = offset + 8
+        for column, columnType in zip(columns, types):
+            size = TYPES[columnType][1] * rows
+            values = array.array(TYPES[columnType][0])
+            values.frombytes(data[position:position + size])
+            if sys.byteorder == "big":
+                values.byteswap()
+            column.extend(values)
+            position += (size + 7) // 8 * 8
+    if any(len(column) != rowCount for column in columns):
+        raise ValueError(filename + " does not have as many rows as its footer says")
+    return dict(zip(names, columns))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("Usage: dxcol.py <file> (writes it out as csv)")
+    columns = read(sys.argv[1])
+    writer = csv.writer(sys.stdout, lineterminator="\n")
+    writer.writerow(columns.keys())
+    writer.writerows(zip(*columns.values()))